@@ -9,6 +9,7 @@
 #define	CONFIG_H
 
 #define PB_FRQ  40000000
+#define SYS_FRQ 80000000    // the core timer (CP0 Count) is incremented at SYS_FRQ / 2
 
 #define macro_enable_interrupts() \
 {  unsigned int val = 0;\
@@ -21,6 +22,12 @@ __builtin_enable_interrupts(); }
 //#define macro_enable_interrupts INTEnableSystemMultiVectoredInt()
 
 #define macro_disable_interrupts __builtin_disable_interrupts()
+
+// uncomment to enable the interrupt handlers profiling (PROF library, prof.c)
+//#define PROF_ENABLE
+
+// uncomment to enable the event trace instrumentation (TRACE library, trace.c)
+//#define TRACE_ENABLE
 //#define macro_disable_interrupts INTDisableInterrupts()
 
 
@@ -261,6 +268,15 @@ extern "C" {
 // ACL
 #define tris_ACL_INT2   TRISGbits.TRISG0
 #define lat_ACL_INT2    LATGbits.LATG0
+#define prt_ACL_INT2    PORTGbits.RG0
+
+// I2C1, the pins are used as digital I/O only for the bus recovery
+#define tris_I2C_SCL    TRISGbits.TRISG2
+#define lat_I2C_SCL     LATGbits.LATG2
+#define prt_I2C_SCL     PORTGbits.RG2
+#define tris_I2C_SDA    TRISGbits.TRISG3
+#define lat_I2C_SDA     LATGbits.LATG3
+#define prt_I2C_SDA     PORTGbits.RG3
 
 
 // UART
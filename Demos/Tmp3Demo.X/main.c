@@ -13,6 +13,7 @@
 #include "config.h"
 
 #include "lcd.h"
+#include "softtmr.h"
 #include "pmodtmp3.h"
 
 
@@ -60,29 +61,36 @@ int main(int argc, char** argv)
 **		
 **
 **	Description:
-**		This function configures the PmodTMP3 and calls specific function for reading the temperature value.
-**      The float value of temperature, in Celsius, is displayed on the LCD
+**		This function configures the PmodTMP3 in one-shot mode and starts the temperature conversions.
+**      The conversions complete in the background (soft timer and asynchronous I2C read), the main loop
+**      only polls the result. The temperature, in Celsius, is displayed on the LCD with 2 decimals.
 **          
 */
 void Tmp3Demo(){
-    float fVal;  
+    short sVal;
+    unsigned char bStatus;
     char strMsg[80];    
-    unsigned int baseCnt = 0;
     LCD_Init(); 
     LCD_WriteStringAtPos("PmodTMP3 Demo", 0, 0);
     LCD_WriteStringAtPos("Digilent", 1, 0);
-    PMODTMP3_Init(TMP3_RES12);
+    SOFTTMR_Init(SOFTTMR_CTX_ISR);
+    PMODTMP3_Init(TMP3_RES12 | TMP3_ONESHOT);
+    PMODTMP3_StartConversion();
     while(1)
     {
-       //perform temperature readings only once in a while, to be able to visualize the results
-        if(++baseCnt == 400000)
-       {
-            baseCnt = 0;        
-            fVal = PMODTMP3_GetTemp();
+        bStatus = PMODTMP3_GetResult(&sVal);
+        if(bStatus == I2C_PENDING)
+        {
+            continue;
+        }
+        if(bStatus == I2C_OK)
+        {
             //display on the LCD screen the temperature value, on second row
-            sprintf(strMsg, "Temp = %6.3f  C", fVal);
+            sprintf(strMsg, "Temp =%c%3d.%02d  C", sVal < 0 ? '-' : ' ', abs(sVal) / 100, abs(sVal) % 100);
             strMsg[14] = (unsigned char)223;    // extended ASCII code for degree sign
             LCD_WriteStringAtPos(strMsg, 1, 0);     
         }
+        // start the next conversion
+        PMODTMP3_StartConversion();
     }  
 }
\ No newline at end of file
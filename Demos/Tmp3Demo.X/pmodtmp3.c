@@ -5,15 +5,22 @@
     Digilent
 
   @File Name
-    acl.c
+    pmodtmp3.c
 
   @Description
         This file groups the functions that implement the PmodTMP3 functionality.
-        The PmodTMP3 is accessed using I2C1 access using the I2C library, 
-        delivered in BasysMX3 library pack. 
- 
+        The PmodTMP3 is accessed using I2C1 access using the I2C library,
+        delivered in BasysMX3 library pack.
+        The pointer register of the TCN75A is kept on the temperature register (it is restored after
+        each configuration write), so a temperature read is a single 2 bytes I2C read, without pointer write.
+        The temperature is returned in hundredths of degree Celsius, computed with integer operations.
+        In one-shot mode (TMP3_ONESHOT), PMODTMP3_StartConversion triggers a conversion and starts a soft timer
+        (SOFTTMR library) for the conversion time of the selected resolution. When it expires, the temperature
+        is read asynchronously (I2C_Submit), and the result is available with PMODTMP3_GetResult, without blocking.
+        Include the file in the project, together with i2c.c, utils.c and softtmr.c, when this library is needed.
+
   @Author
-    Cristian Fatu 
+    Cristian Fatu
     cristian.fatu@digilent.ro
 */
 /* ************************************************************************** */
@@ -26,36 +33,62 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "i2c.h"
+#include "softtmr.h"
 #include "pmodtmp3.h"
 
 /* ************************************************************************** */
 
+#define TMP3_REG_TEMP   0x00    // the temperature register
+#define TMP3_REG_CONFIG 0x01    // the configuration register
+
+// the conversion time for 9, 10, 11 and 12 bits resolution, in ms: the typical times (30, 60, 120, 240 ms) + 25%
+const unsigned short rgTmp3ConvMs[4] = {38, 75, 150, 300};
+
+unsigned char bTmp3Cfg = TMP3_CONF_DEFAULT;
+unsigned char rgTmp3CfgVals[2] = {TMP3_REG_CONFIG, TMP3_CONF_DEFAULT};
+unsigned char bTmp3TempReg = TMP3_REG_TEMP;
+unsigned char rgTmp3TempVals[2];
+I2C_XFER xferTmp3Cfg, xferTmp3Park, xferTmp3Read;
+SOFTTMR_TIMER tmrTmp3Conv;
+volatile unsigned char bTmp3Status = PMODTMP3_NO_DATA;
+short sTmp3Centi;
 
 /* ------------------------------------------------------------ */
 /***	PMODTMP3_Init
 **
 **	Parameters:
-**		unsigned char bCfg - One byte containing combinations (OR-ed) 
+**		unsigned char bCfg - One byte containing combinations (OR-ed)
 **                                  of predefined configuration setting
 **
 **	Return Value:
 **		none
 **
 **	Description:
-**		Configures temperature sensor, using a nbyte containing combinations 
+**		Configures temperature sensor, using a nbyte containing combinations
 **      (OR-ed) of predefined configuration setting defined in "pmodtmp3.h".
-**          
+**      When TMP3_ONESHOT is used, the sensor is also put in shutdown mode (required by the one-shot mode),
+**      and a conversion is done only when PMODTMP3_StartConversion is called.
+**      The pointer register is then parked on the temperature register.
+**      For the asynchronous functions, the SOFTTMR library must be initialized (SOFTTMR_Init).
+**
 */
 void PMODTMP3_Init(unsigned char bCfg)
 {
 	unsigned char rgCfg[2] = {0};
 	I2C_Init(400000);   // configures I2C to work at 400 kHz.
-    rgCfg[0] = 0x01;
-	rgCfg[1] = bCfg;
+    if(bCfg & TMP3_ONESHOT)
+    {
+        bCfg |= TMP3_SHUTDOWN;
+    }
+    bTmp3Cfg = bCfg;
+    rgCfg[0] = TMP3_REG_CONFIG;
+	rgCfg[1] = bCfg & ~TMP3_ONESHOT;
 	I2C_Write(TMP3Addr, rgCfg, 2, 1);
+    rgCfg[0] = TMP3_REG_TEMP;
+    I2C_Write(TMP3Addr, rgCfg, 1, 1);   // park the pointer on the temperature register
+    bTmp3Status = PMODTMP3_NO_DATA;
 }
 
-
 /* ------------------------------------------------------------ */
 /***	PMODTMP3_GetTemp
 **
@@ -68,24 +101,233 @@ void PMODTMP3_Init(unsigned char bCfg)
 **
 **	Description:
 **		Retrieves data from temp sensor and returns the corresponding value
-**		as a floating point value in Celsius. 
-**          
+**		as a floating point value in Celsius.
+**      Use PMODTMP3_GetTempCenti to avoid the floating point operations.
+**
 */
 float PMODTMP3_GetTemp()
 {
-	float fResult;
-	unsigned short wResult = 0;
-	unsigned char rgVals[2] = {0, 0};
-	I2C_Write(TMP3Addr, rgVals, 1, 1); // send 0 as the pointer of the temperature register
+	return PMODTMP3_GetTempCenti() / 100.0;
+}
 
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_GetTempCenti
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		short	- The temperature, in hundredths of degree Celsius
+**
+**	Description:
+**		Reads the last converted temperature (a single 2 bytes read, the pointer register being parked
+**		on the temperature register) and returns it in hundredths of degree Celsius.
+**      In one-shot mode, the value is the one of the last conversion started by PMODTMP3_StartConversion.
+**
+*/
+short PMODTMP3_GetTempCenti()
+{
+	unsigned char rgVals[2] = {0, 0};
 	I2C_Read(TMP3Addr, rgVals, 2); // requests 2 bytes over I2C
+	return PMODTMP3_ConvertToCenti(rgVals);
+}
+
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_StartConversion
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		unsigned char	- I2C_OK        the conversion is started
+**                        I2C_PENDING   a conversion is already in progress
+**                        I2C_ERR_FULL  the I2C queue is full
+**
+**	Description:
+**		In one-shot mode, this function triggers a conversion (configuration write, followed by
+**      the pointer write that parks it back on the temperature register), then starts a soft timer
+**      for the conversion time of the selected resolution. When the timer expires, the temperature
+**      is read asynchronously. In continuous mode, the temperature is read asynchronously right away.
+**      The function does not block: the result is retrieved by PMODTMP3_GetResult.
+**
+*/
+unsigned char PMODTMP3_StartConversion()
+{
+    unsigned char bResult;
+    if(bTmp3Status == I2C_PENDING)
+    {
+        return I2C_PENDING;
+    }
+    bTmp3Status = I2C_PENDING;
+    if(!(bTmp3Cfg & TMP3_ONESHOT))
+    {
+        bResult = PMODTMP3_SubmitRead();
+    }
+    else
+    {
+        rgTmp3CfgVals[1] = bTmp3Cfg;
+        xferTmp3Cfg.bAddr = TMP3Addr;
+        xferTmp3Cfg.pbWr = rgTmp3CfgVals;
+        xferTmp3Cfg.cbWr = 2;
+        xferTmp3Cfg.cbRd = 0;
+        xferTmp3Cfg.pfCallback = 0;
+        xferTmp3Park.bAddr = TMP3Addr;
+        xferTmp3Park.pbWr = &bTmp3TempReg;
+        xferTmp3Park.cbWr = 1;
+        xferTmp3Park.cbRd = 0;
+        xferTmp3Park.pfCallback = 0;
+        bResult = I2C_Submit(&xferTmp3Cfg);
+        if(bResult == I2C_OK)
+        {
+            bResult = I2C_Submit(&xferTmp3Park);
+        }
+        if(bResult == I2C_OK)
+        {
+            SOFTTMR_Start(&tmrTmp3Conv, PMODTMP3_GetConversionMs(), 0, PMODTMP3_ConversionDone, 0);
+        }
+    }
+    if(bResult != I2C_OK)
+    {
+        bTmp3Status = bResult;
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_GetResult
+**
+**	Parameters:
+**		short *psCenti	- the variable where the temperature is copied, in hundredths of degree Celsius
+**
+**	Return Value:
+**		unsigned char	- I2C_OK            the temperature is copied
+**                        I2C_PENDING       the conversion or the read is in progress
+**                        PMODTMP3_NO_DATA  no conversion was started
+**                        other values      the I2C error of the last conversion (see i2c.h)
+**
+**	Description:
+**		This function returns the result of the last conversion started by PMODTMP3_StartConversion.
+**      It does not access the I2C bus, so it can be polled.
+**
+*/
+unsigned char PMODTMP3_GetResult(short *psCenti)
+{
+    unsigned char bStatus = bTmp3Status;
+    if(bStatus == I2C_OK)
+    {
+        *psCenti = sTmp3Centi;
+    }
+    return bStatus;
+}
+
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_GetConversionMs
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		unsigned int	- the conversion time, in ms
+**
+**	Description:
+**		This function returns the conversion time of the resolution selected in the configuration,
+**      with a margin over the typical value.
+**
+*/
+unsigned int PMODTMP3_GetConversionMs()
+{
+    return rgTmp3ConvMs[(bTmp3Cfg >> 5) & 3];
+}
+
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_ConvertToCenti
+**
+**	Parameters:
+**		unsigned char *rgVals	- the 2 bytes of the temperature register
+**
+**	Return Value:
+**		short	- The temperature, in hundredths of degree Celsius
+**
+**	Description:
+**		Converts the temperature register (signed, 1/16 degree units in the 12 most significant bits)
+**      to hundredths of degree Celsius: T * 100 / 16 = T * 25 / 4.
+**
+*/
+short PMODTMP3_ConvertToCenti(unsigned char *rgVals)
+{
+    short sRaw = (short)((rgVals[0] << 8) | rgVals[1]) >> 4;    // to correctly process the (max) 12 bits of the reading
+    return (sRaw * 25) >> 2;
+}
+
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_SubmitRead
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		unsigned char	- I2C_OK        the read is queued
+**                        I2C_ERR_FULL  the I2C queue is full
+**
+**	Description:
+**		Queues the asynchronous read of the temperature register (2 bytes, no pointer write).
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char PMODTMP3_SubmitRead()
+{
+    xferTmp3Read.bAddr = TMP3Addr;
+    xferTmp3Read.cbWr = 0;
+    xferTmp3Read.pbRd = rgTmp3TempVals;
+    xferTmp3Read.cbRd = 2;
+    xferTmp3Read.pfCallback = PMODTMP3_ReadDone;
+    return I2C_Submit(&xferTmp3Read);
+}
 
-	
-	// Convert the result
-	wResult = (rgVals[1] | (rgVals[0] << 8)) >> 4;  // to correctly process the (max) 12 bits of the reading
-	fResult = wResult/16.0;             // according to the equation from TCN75A datasheet
-	
-	return fResult;
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_ConversionDone
+**
+**	Parameters:
+**		void *pArg	- not used
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		The soft timer callback, called when the one-shot conversion is complete: the read is queued.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void PMODTMP3_ConversionDone(void *pArg)
+{
+    unsigned char bResult = PMODTMP3_SubmitRead();
+    if(bResult != I2C_OK)
+    {
+        bTmp3Status = bResult;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	PMODTMP3_ReadDone
+**
+**	Parameters:
+**		I2C_XFER *pXfer	- the completed transaction
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		The completion callback of the temperature read: the temperature is converted and the result is published.
+**      This is a low-level function called from the I2C interrupt, so user should avoid calling it directly.
+**
+*/
+void PMODTMP3_ReadDone(I2C_XFER *pXfer)
+{
+    if(pXfer->bStatus == I2C_OK)
+    {
+        sTmp3Centi = PMODTMP3_ConvertToCenti(rgTmp3TempVals);
+    }
+    bTmp3Status = pXfer->bStatus;
 }
 
 
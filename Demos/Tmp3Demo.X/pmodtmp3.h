@@ -5,7 +5,7 @@
     Digilent
 
   @File Name
-    acl.h
+    pmodtmp3.h
 
   @Description
         This file groups the declarations of the functions that implement
@@ -18,6 +18,8 @@
 #ifndef _PMODTMP3_H    /* Guard against multiple inclusion */
 #define _PMODTMP3_H
 
+#include "i2c.h"
+
 #define TMP3Addr	0x48	//based on jumpers JP1, JP2, and JP3
 							//a table explaining the various
 							//address configurations is available
@@ -40,10 +42,21 @@
 #define	TMP3_STARTUP	0x00 //Shutdown Disabled
 #define TMP3_CONF_DEFAULT	(TMP3_RES9 | TMP3_FAULT1 | TMP3_ALERTLOW | TMP3_CMPMODE)
 
+// PMODTMP3_GetResult status, besides the I2C status codes (see i2c.h)
+#define PMODTMP3_NO_DATA	2	//no conversion was started
 
-
-void PMODTMP3_Config(unsigned char bCfg);
+void PMODTMP3_Init(unsigned char bCfg);
 float PMODTMP3_GetTemp();
+short PMODTMP3_GetTempCenti();
+unsigned char PMODTMP3_StartConversion();
+unsigned char PMODTMP3_GetResult(short *psCenti);
+unsigned int PMODTMP3_GetConversionMs();
+short PMODTMP3_ConvertToCenti(unsigned char *rgVals);
+
+//private functions:
+unsigned char PMODTMP3_SubmitRead();
+void PMODTMP3_ConversionDone(void *pArg);
+void PMODTMP3_ReadDone(I2C_XFER *pXfer);
 
 
 //#ifdef __cplusplus
@@ -0,0 +1,86 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    prof.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the PROF library (defined in prof.c), and the macros used to instrument the interrupt handlers.
+        The library is enabled by defining PROF_ENABLE in config.h. When it is not defined,
+        the macros expand to nothing and the library adds no code.
+        Include the file in the project when this library is needed.
+        Use #include "prof.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _PROF_H    /* Guard against multiple inclusion */
+#define _PROF_H
+
+// the profiled interrupt handlers
+#define PROF_ID_TMR1        0   // Timer1ISR (SSD)
+#define PROF_ID_TMR3        1   // Timer3ISR (AUDIO)
+#define PROF_ID_TMR4        2   // Timer4SR (statemachine)
+#define PROF_ID_TMR5        3   // Timer5ISR (RGBLED)
+#define PROF_ID_UART4       4   // Uart4Handler (UART)
+#define PROF_ID_UART1       5   // Uart1Handler (UARTJB)
+#define PROF_ID_CORETMR     6   // CoreTimerISR (SOFTTMR)
+#define PROF_ID_USER        7   // available for the user
+#define PROF_NO_IDS         8
+
+// the number of log2 histogram bins: bin i counts the values between 2^(i-1) and 2^i - 1 core timer ticks,
+// the last bin counts all the larger values
+#define PROF_HIST_BINS      16
+
+#ifdef PROF_ENABLE
+
+// the statistics of an interrupt handler. Times are in core timer ticks (SYS_FRQ / 2).
+typedef struct {
+    unsigned int cntCalls;
+    unsigned int uiDurMin, uiDurMax;
+    unsigned long long ullDurSum;
+    unsigned int cntLat;
+    unsigned int uiLatMin, uiLatMax;
+    unsigned long long ullLatSum;
+    unsigned short rgDurHist[PROF_HIST_BINS];
+    unsigned short rgLatHist[PROF_HIST_BINS];
+} PROF_STATS;
+
+// place at the beginning of the interrupt handler, after the local variables declarations
+#define PROF_ISR_ENTER(id)              unsigned int uiProfEntry = _CP0_GET_COUNT()
+// same as PROF_ISR_ENTER, also records the entry latency (core timer ticks since the interrupt was requested)
+#define PROF_ISR_ENTER_LAT(id, cntLat)  unsigned int uiProfEntry = _CP0_GET_COUNT(); PROF_RecordLatency(id, cntLat)
+// for the timers period interrupts: the latency is the timer count scaled by the prescaler
+// (one peripheral bus tick is one core timer tick, as PB_FRQ = SYS_FRQ / 2)
+#define PROF_ISR_ENTER_TMR(id, tmr, prescaler)  PROF_ISR_ENTER_LAT(id, (tmr) * (prescaler))
+// place at the end of the interrupt handler
+#define PROF_ISR_EXIT(id)               PROF_RecordDuration(id, _CP0_GET_COUNT() - uiProfEntry)
+
+void PROF_Reset();
+void PROF_GetStats(unsigned char idVector, PROF_STATS *pStats);
+void PROF_Dump(void (*pfPutString)(char *));
+
+//private functions:
+void PROF_RecordLatency(unsigned char idVector, unsigned int cntTicks);
+void PROF_RecordDuration(unsigned char idVector, unsigned int cntTicks);
+unsigned char PROF_GetHistBin(unsigned int cntTicks);
+
+#else
+
+#define PROF_ISR_ENTER(id)
+#define PROF_ISR_ENTER_LAT(id, cntLat)
+#define PROF_ISR_ENTER_TMR(id, tmr, prescaler)
+#define PROF_ISR_EXIT(id)
+#define PROF_Reset()
+#define PROF_Dump(pfPutString)
+
+#endif /* PROF_ENABLE */
+
+#endif /* _PROF_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,64 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    softtmr.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the SOFTTMR library (defined in softtmr.c).
+        Include the file in the project when this library is needed.
+        Use #include "softtmr.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _SOFTTMR_H    /* Guard against multiple inclusion */
+#define _SOFTTMR_H
+
+// the soft timers tick, in milliseconds
+#define SOFTTMR_TICK_MS         1
+
+// the number of slots of the timing wheel (must be a power of 2)
+#define SOFTTMR_WHEEL_SIZE      32
+
+// the context where the callbacks are called, parameter of SOFTTMR_Init
+#define SOFTTMR_CTX_ISR         0   // the callbacks are called from the core timer interrupt
+#define SOFTTMR_CTX_DEFERRED    1   // the callbacks are called from the low priority core software interrupt 0
+
+typedef void (*SOFTTMR_CALLBACK)(void *pArg);
+
+// the wheel slots and the timers are linked in circular doubly linked lists
+typedef struct SOFTTMR_NODE {
+    struct SOFTTMR_NODE *pNext;
+    struct SOFTTMR_NODE *pPrev;
+} SOFTTMR_NODE;
+
+// a soft timer. The memory is provided by the user (usually a global variable, so it is zero-initialized), the fields are private.
+typedef struct {
+    SOFTTMR_NODE node;              // must be the first field
+    unsigned int cntRounds;         // the number of full wheel rotations left until expiration
+    unsigned int msPeriod;          // the period for periodic timers, 0 for one-shot timers
+    SOFTTMR_CALLBACK pfCallback;    // the function called when the timer expires
+    void *pArg;                     // the argument of the callback
+} SOFTTMR_TIMER;
+
+void SOFTTMR_Init(unsigned char bCtx);
+void SOFTTMR_Start(SOFTTMR_TIMER *pTmr, unsigned int msDelay, unsigned int msPeriod, SOFTTMR_CALLBACK pfCallback, void *pArg);
+void SOFTTMR_Stop(SOFTTMR_TIMER *pTmr);
+unsigned char SOFTTMR_IsActive(SOFTTMR_TIMER *pTmr);
+unsigned int SOFTTMR_GetTicks();
+void SOFTTMR_Close();
+
+//private functions:
+void SOFTTMR_Insert(SOFTTMR_TIMER *pTmr, unsigned int cntTicks);
+void SOFTTMR_Unlink(SOFTTMR_NODE *pNode);
+void SOFTTMR_ProcessTick();
+
+#endif /* _SOFTTMR_H */
+
+/* *****************************************************************************
+ End of File
+ */
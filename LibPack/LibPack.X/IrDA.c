@@ -13,7 +13,8 @@
         interface over the IRDA transmit and receive pins.
         So, in order to send a byte over IRDA, the byte is transmitted over UART5, 
         thus it serializes each bit to be transmitted over IRDA. Receiving bits from IRDA are accumulated in a byte in UART5 receive buffer.
-        Include the file together with utils.c and utils.h in the project when this library is needed.	
+        UART5 is the UARTDRV_5 instance of the UARTDRV library, the received bytes are stored in its receive queue.
+        Include the file together with utils.c, utils.h, uartdrv.c, hwres.c and softtmr.c in the project when this library is needed.	
 
   @Author
     Cristian Ignat 
@@ -25,9 +26,9 @@
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
 #include <xc.h>
-#include <sys/attribs.h>
 #include "config.h"
 #include "IrDA.h"
+#include "uartdrv.h"
 
 /* ************************************************************************** */
 
@@ -38,7 +39,7 @@
 **          unsigned int baud - the baud rate for the UART interface
 **
 **	Return Value:
-**		
+**		unsigned char   - the IRDA_ConfigureIRDAOverUART5 return value
 **
 **	Description:
 **		This function initializes the hardware involved in the IRDA module: 
@@ -49,11 +50,11 @@
 **      to work at the specified baud.
 **          
 */
-void IRDA_Init(unsigned int baud)
+unsigned char IRDA_Init(unsigned int baud)
 {
     IRDA_ConfigurePins();
     IRDA_Set_SMIR_Mode();   
-    IRDA_ConfigureIRDAOverUART5(baud);
+    return IRDA_ConfigureIRDAOverUART5(baud);
 }
 
 
@@ -154,16 +155,20 @@ void IRDA_Set_SMIR_Mode()
 **                              for example 9600 corresponds to 9600 baud.
 **
 **	Return Value:
-**		
+**		unsigned char   - UARTDRV_OK
+**                        UARTDRV_ERR_PARAM if the baud rate cannot be generated within UARTDRV_MAX_ERR_PERMILLE
+**                        (the UART5 is then left closed)
 **
 **	Description:
 **		This function initializes the UART5 to work in conjuction with IRDA module. 
 **      The IRDA_TX and IRDA_RX are mapped over UART5 interface pins.
-**      UART5 is configured to work at the specified baud rate
+**      UART5 is configured to work at the specified baud rate, using the DMA channels of the UARTDRV library when they are available.
 **      In order to compute the baud rate value, it uses the peripheral bus frequency definition (PB_FRQ, located in config.h)
+**      When UART5 is already initialized, the queued bytes are transmitted, then it is closed and initialized again
+**      at the new baud rate.
 **          
 */
-void IRDA_ConfigureIRDAOverUART5(unsigned int baud)
+unsigned char IRDA_ConfigureIRDAOverUART5(unsigned int baud)
 {
     // IRDA RX will be connected to U5RX 
     // configure IR_RX (RB6) -> U5RX
@@ -172,32 +177,10 @@ void IRDA_ConfigureIRDAOverUART5(unsigned int baud)
     // IRDA TX will be connected to U5TX 
     //configure IR_TX (RB7) -> U5TX
     RPB7R = 4; //0100 = U5TX
-    // configure UART5
-    U5MODEbits.ON     = 0;
-    U5MODEbits.SIDL   = 0;
-    U5MODEbits.RTSMD  = 0;
-    U5MODEbits.UEN0   = 0; 
-    U5MODEbits.UEN1   = 0;
-    U5MODEbits.WAKE   = 0;
-    U5MODEbits.LPBACK = 0; 
-    U5MODEbits.ABAUD  = 0;
-    U5MODEbits.RXINV  = 0; 
-    U5MODEbits.BRGH   = 0; 
-    U5MODEbits.PDSEL1 = 0; 
-    U5MODEbits.PDSEL0 = 0; 
-    U5MODEbits.STSEL  = 0;  
-
-
-    U5BRG = (int)(((float)PB_FRQ/(16*baud) - 1) + 0.5); // add 0.5 just in order to implement the round using the floor approach
-
-
-    U5MODEbits.ON      = 1; 
-    U5STAbits.UTXEN    = 1;
-    U5STAbits.URXEN    = 1;    
-
-    // IRDA related
-    U5MODEbits.IREN   = 1;     // IrDA Encoder and Decoder Enable bit: 1 = IrDA is enabled
-    U5STAbits.UTXINV   = 1;    // Transmit Polarity Inversion bit: 1 = IrDA encoded UxTX Idle state is "1"
+    // configure UART5, with the IrDA encoder and decoder (IREN) and the IrDA encoded UxTX Idle state "1" (UTXINV)
+    UARTDRV_Flush(UARTDRV_5);
+    UARTDRV_Close(UARTDRV_5);
+    return UARTDRV_Open(UARTDRV_5, baud, UARTDRV_F_DMA | UARTDRV_F_IRDA);
 }
 
 /* ------------------------------------------------------------ */
@@ -211,13 +194,12 @@ void IRDA_ConfigureIRDAOverUART5(unsigned int baud)
 **
 **	Description:
 **		This function transmits a character over IRDA, by transmitting it over UART5. 
-**      
+**      It waits while the transmit queue is full.
 **          
 */
 void IRDA_UARTPutChar(char ch)
 {
-    while(U5STAbits.UTXBF == 1);
-    U5TXREG = ch;
+    while(!UARTDRV_Write(UARTDRV_5, &ch, 1));
 }
 
 /* ------------------------------------------------------------ */
@@ -232,7 +214,7 @@ void IRDA_UARTPutChar(char ch)
 **                                      1 - timeout
 **
 **	Return Value:
-**          - unsigned char - the byte received over IRDA, by receiving it from UART5
+**          - unsigned char - the byte received over IRDA, by receiving it from UART5, 0 on timeout
 **		
 **
 **	Description:
@@ -246,6 +228,7 @@ void IRDA_UARTPutChar(char ch)
 unsigned char IRDA_UART_GetChar(unsigned int timeout, char *error) 
 {
     unsigned int timeout_cnt = 0;
+    unsigned char bVal;
     
     if(timeout == 0)
     {
@@ -263,7 +246,9 @@ unsigned char IRDA_UART_GetChar(unsigned int timeout, char *error)
             *error = 0;
     }
     
-    return U5RXREG;
+    bVal = 0;
+    UARTDRV_Read(UARTDRV_5, &bVal, 1);
+    return bVal;
 }
 
 /* ------------------------------------------------------------ */
@@ -273,21 +258,20 @@ unsigned char IRDA_UART_GetChar(unsigned int timeout, char *error)
 **          
 **
 **	Return Value:
-**          - unsigned char - Receive Buffer Data Available bit on UART5 
-                    1 = Receive buffer has data, at least one more character can be read
-                    0 = Receive buffer is empty
+**          - unsigned char - receive data available on UART5
+                    1 = the receive queue has data, at least one more character can be read
+                    0 = the receive queue is empty
 **		
 **
 **	Description:
-**		This function returns UART5 Receive Buffer Data Available bit.
-**      It returns 1 if the receive buffer has data (at least one more character can be read).
-**      It returns 0 if the receive buffer is empty.
+**		This function returns 1 if the UART5 receive queue has data (at least one more character can be read).
+**      It returns 0 if the receive queue is empty.
 **      
 **          
 */
 unsigned char IRDA_UART_AvaliableRx()
 {
-    return U5STAbits.URXDA;
+    return UARTDRV_GetRxCount(UARTDRV_5) != 0;
 }
 
 /* ------------------------------------------------------------ */
@@ -307,7 +291,7 @@ unsigned char IRDA_UART_AvaliableRx()
 */
 void IRDA_Close()
 {
-      U5MODEbits.ON = 0;   
+    UARTDRV_Close(UARTDRV_5);
 }
 /* *****************************************************************************
  End of File
@@ -23,14 +23,15 @@
 #define IRDA_PDOWN      lat_IRDA_PDOWN
 #define IRDA_RX         prt_IRDA_RX
 
-void IRDA_Init(unsigned int baud);
+unsigned char IRDA_Init(unsigned int baud);
 void IRDA_Set_FIR_Mode();
 void IRDA_Set_SMIR_Mode();
-void IRDA_ConfigureIRDAOverUART5(unsigned int baud);
+unsigned char IRDA_ConfigureIRDAOverUART5(unsigned int baud);
 void IRDA_UARTPutChar(char ch);
 
 unsigned char IRDA_UART_AvaliableRx();
 unsigned char IRDA_UART_GetChar(unsigned int timeout, char *error);
+void IRDA_Close();
 
 //private
 void IRDA_ConfigurePins();
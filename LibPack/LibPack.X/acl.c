@@ -12,7 +12,16 @@
         The library implements basic functions to configure the accelerometer 
         and read the accelerometer values (raw values and g values).
         The library uses I2C functions provided by I2C library.
-        Include the file as well as i2c.c, i2c.h and config.h in the project 
+        In streaming mode, the data ready interrupt of the accelerometer (INT2 pin) triggers,
+        through the CN library, an asynchronous read of each sample. The samples are timestamped
+        and stored in a ring buffer, read by the application with ACL_GetSample.
+        The embedded detection engines of the accelerometer (pulse / tap, portrait / landscape orientation,
+        freefall / motion) can also be routed to INT2: their source registers are read asynchronously
+        and the events are stored in an event queue, read by the application with ACL_GetEvent.
+        When the shared I2C queue is full, the interrupt read is submitted again by a soft timer (INT2 stays
+        active until the read is done, so no new edge would restart it): the SOFTTMR library must be
+        initialized (SOFTTMR_Init) before the streaming mode or an event source is enabled.
+        Include the file as well as i2c.c, i2c.h, cn.c, cn.h, utils.c, softtmr.c and config.h in the project 
         when this library is needed.
  
   @Author
@@ -30,10 +39,50 @@
 #include "config.h"
 #include "i2c.h"
 #include "acl.h"
+#include "cn.h"
+#include "utils.h"
+#include "softtmr.h"
 
 /* ************************************************************************** */
 
 float fGRangeLSB;   // global variable used to pre-compute the value in g corresponding to each count of the raw value
+unsigned char bAclMilliGShift = 10; // global variable used to pre-compute the shift converting raw values to milli-g
+unsigned char bAclOutXMsb = ACL_OUT_X_MSB;   // the register address written by the asynchronous reads
+
+// streaming mode: the samples ring buffer, written by the I2C callback and read by the application
+ACL_SAMPLE rgAclRing[ACL_RING_SIZE];
+volatile unsigned int idxAclHead = 0, idxAclTail = 0;
+volatile unsigned int cntAclLost = 0;
+volatile unsigned char fAclStreaming = 0;
+volatile unsigned char fAclReadBusy = 0;
+unsigned char idAclCN = CN_ERR_FULL;
+unsigned int uiAclSampleTime;
+unsigned char rgAclStreamVals[1 + 6 * ACL_FIFO_SIZE];   // F_STATUS and the samples
+I2C_XFER xferAclStream;
+unsigned char bAclStreamWmrk = 0;       // 0 for the data ready mode, the FIFO watermark otherwise
+unsigned int uiAclSamplePeriod;         // in core timer ticks
+unsigned char bAclFStatus = ACL_F_STATUS;
+// the retry of an interrupt read that could not be submitted: the INT_SOURCE read (1) or the next source (0)
+SOFTTMR_TIMER tmrAclRetry;
+unsigned char fAclRetryStart;
+
+// events: the interrupt sources enabled on INT2 (CTRL_REG4 bits), besides the streaming ones
+volatile unsigned char bAclEventSrc = 0;
+unsigned char bAclIntSourceReg = ACL_INT_SOURCE;
+unsigned char bAclIntSrc, bAclPendingSrc, bAclEvtVal, bAclEvtType;
+I2C_XFER xferAclEvent;
+ACL_EVENT rgAclEvents[ACL_EVENT_QUEUE_SIZE];
+volatile unsigned int idxAclEvtHead = 0, idxAclEvtTail = 0;
+volatile unsigned int cntAclEventsLost = 0;
+
+// the event sources: the CTRL_REG4 / INT_SOURCE bit, the source register read to get (and clear) the event, the event type
+#define ACL_NO_EVENT_SOURCES    3
+const unsigned char rgAclEvtSrcBits[ACL_NO_EVENT_SOURCES] = {ACL_INT_EN_PULSE, ACL_INT_EN_LNDPRT, ACL_INT_EN_FF_MT};
+unsigned char rgAclEvtSrcRegs[ACL_NO_EVENT_SOURCES] = {ACL_PULSE_SRC, ACL_PL_STATUS, ACL_FF_MT_SRC};
+const unsigned char rgAclEvtTypes[ACL_NO_EVENT_SOURCES] = {ACL_EVT_TAP, ACL_EVT_ORIENTATION, ACL_EVT_MOTION};
+
+// the output data rates selected by the CTRL_REG1 DR bits, in hundredths of Hz
+const unsigned int rgAclOdrCentiHz[8] = {80000, 40000, 20000, 10000, 5000, 1250, 625, 156};
 
 /* ------------------------------------------------------------ */
 /***	ACL_Init
@@ -177,7 +226,8 @@ unsigned char ACL_GetDeviceID()
 **	Description:
 **		This function sets the full scale range. It sets the according bits in the 
 **      0x0E: XYZ_DATA_CFG register. The function also pre-computes the fGRangeLSB 
-**      to be used when converting raw values to g values.
+**      to be used when converting raw values to g values, and the bAclMilliGShift
+**      to be used when converting raw values to milli-g values.
 **      It returns the status of the operation: success or I2C errors (the slave address 
 **      was not acknowledged by the device or timeout error).
  */
@@ -195,6 +245,8 @@ unsigned char ACL_SetRange(unsigned char bRange)
     // set fGRangeLSB according to the selected range
     unsigned char bValRange = 1<<(bRange + 2);
     fGRangeLSB = ((float)bValRange)/(1<<12);     // the range is divided to the resolution corresponding to number of bits (12)
+    // 1 g is 2^(10 - bRange) counts
+    bAclMilliGShift = 10 - bRange;
     return bResult;
 }
 
@@ -231,6 +283,37 @@ void ACL_ReadRawValues(unsigned char *rgRawVals)
     I2C_Read(ACL_I2C_ADDR, rgRawVals, 6);
 }
 
+/* ------------------------------------------------------------ */
+/***	ACL_ReadRawValuesAsync
+**
+**	Parameters:
+**      I2C_XFER *pXfer              - the transaction (memory provided by the caller, valid until completion)
+**      unsigned char *rgRawVals     - Pointer to a buffer where the 6 received bytes will be placed,
+**                                      in the same format as for ACL_ReadRawValues.
+**      void (*pfCallback)(I2C_XFER *pXfer) - the function called when the values are read (may be 0)
+**
+**	Return Value:
+**      unsigned char   I2C_OK          the read was queued
+**                      I2C_ERR_FULL    the I2C queue is full
+**
+**	Description:
+**		This function queues the read of the module raw values for the three axes, and returns immediately.
+**      The values are available when pXfer->bStatus is no longer I2C_PENDING (I2C_OK means success),
+**      or in the callback, called from the I2C1 interrupt handler.
+**      Meanwhile the CPU can do other work.
+**
+*/
+unsigned char ACL_ReadRawValuesAsync(I2C_XFER *pXfer, unsigned char *rgRawVals, void (*pfCallback)(I2C_XFER *pXfer))
+{
+    pXfer->bAddr = ACL_I2C_ADDR;
+    pXfer->pbWr = &bAclOutXMsb;
+    pXfer->cbWr = 1;
+    pXfer->pbRd = rgRawVals;
+    pXfer->cbRd = 6;
+    pXfer->pfCallback = pfCallback;
+    return I2C_Submit(pXfer);
+}
+
 /* ------------------------------------------------------------ */
 /***	ACL_ConvertRawToValueG
 **
@@ -253,7 +336,8 @@ void ACL_ReadRawValues(unsigned char *rgRawVals)
 **      Computing the acceleration in terms of g is done with this formula:
 **      (<full scale range> / 2^12)*<raw value>. The (<full scale range> / 2^12) term is 
 **      pre-computed every time the range is set, using global variable fGRangeLSB.
-**      This function involves float values computing, so avoid using it intensively when performance is an issue.
+**      This function involves float values computing, so avoid using it intensively when performance is an issue
+**      (see ACL_ConvertRawToMilliG).
 **      
 */
 float ACL_ConvertRawToValueG(unsigned char *rgRawVals)
@@ -273,6 +357,77 @@ float ACL_ConvertRawToValueG(unsigned char *rgRawVals)
     return fResult;
 }
 
+/* ------------------------------------------------------------ */
+/***	ACL_ConvertRawToMilliG
+**
+**	Parameters:
+**      unsigned char *rgRawVals     - Pointer to a buffer that contains the 2 bytes corresponding to the raw value,
+**                                      in the format described for ACL_ConvertRawToValueG.
+**
+**	Return Value:
+**          short   the acceleration value in milli-g
+**
+**	Description:
+**		This function returns the acceleration value in milli-g, computed with integer operations only:
+**      <milli-g> = (<raw value> * 1000) >> (10 - <range>), the shift being pre-computed every time
+**      the range is set, using global variable bAclMilliGShift.
+**      It is much faster than ACL_ConvertRawToValueG, that uses software floating point.
+**
+*/
+short ACL_ConvertRawToMilliG(unsigned char *rgRawVals)
+{
+    return (short)((ACL_GetRawValue(rgRawVals) * 1000) >> bAclMilliGShift);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_ConvertRawToMilliGBatch
+**
+**	Parameters:
+**      const short *rgRaw          - the raw values, sign extended (for example the rgRaw fields of ACL_SAMPLE,
+**                                      or values returned by ACL_GetRawValue)
+**      short *rgMilliG             - the buffer where the values in milli-g are placed (may be the same as rgRaw)
+**      unsigned int cntVals        - the number of values (3 for each sample)
+**
+**	Return Value:
+**
+**	Description:
+**		This function converts an array of raw values to milli-g, using the same integer formula as
+**      ACL_ConvertRawToMilliG. The shift is loaded once for the whole array, so the loop is only
+**      a multiply and a shift per value; it is aimed at the samples acquired in streaming mode.
+**
+*/
+void ACL_ConvertRawToMilliGBatch(const short *rgRaw, short *rgMilliG, unsigned int cntVals)
+{
+    unsigned char bShift = bAclMilliGShift;
+    while(cntVals--)
+    {
+        *rgMilliG++ = (short)((*rgRaw++ * 1000) >> bShift);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_ReadMilliGValues
+**
+**	Parameters:
+**      short *rgMilliGVals     - Pointer to a buffer where the 3 acceleration values in milli-g will be placed
+**                                  (X, Y and Z axes).
+**
+**	Return Value:
+**
+**	Description:
+**		This function provides the acceleration values for the three axes, as integer values in milli-g.
+**      It is the integer counterpart of ACL_ReadGValues.
+**
+*/
+void ACL_ReadMilliGValues(short *rgMilliGVals)
+{
+    unsigned char rgRawVals[6];
+    ACL_ReadRawValues(rgRawVals);
+    rgMilliGVals[0] = ACL_ConvertRawToMilliG(rgRawVals);
+    rgMilliGVals[1] = ACL_ConvertRawToMilliG(rgRawVals + 2);
+    rgMilliGVals[2] = ACL_ConvertRawToMilliG(rgRawVals + 4);
+}
+
 /* ------------------------------------------------------------ */
 /***	ACL_ReadGValues
 **
@@ -303,6 +458,1014 @@ void ACL_ReadGValues(float *rgGVals)
 }
 
 
+/* ------------------------------------------------------------ */
+/***	ACL_StartStream
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      CN_ERR_FULL no change notification handler is available
+**
+**	Description:
+**		This function starts the streaming mode: the data ready interrupt is enabled and routed to the INT2 pin
+**      (CTRL_REG4 and CTRL_REG5), and the INT2 pin changes are notified by the CN library.
+**      On each data ready interrupt, the sample is read asynchronously and stored in the ring buffer,
+**      with the core timer value (see TimeGetTicks) of the interrupt as timestamp.
+**      So every sample is acquired, at the output data rate (800 Hz after ACL_Init), without polling.
+**      If the ring buffer is full, the new samples are dropped and counted (see ACL_GetLostSamples).
+**      ACL_Init must be called first.
+**
+*/
+unsigned char ACL_StartStream()
+{
+    return ACL_BeginStream(0);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_StartStreamFifo
+**
+**	Parameters:
+**      unsigned char bWatermark    - the number of samples read at once, 1 - 32
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      CN_ERR_FULL no change notification handler is available
+**                      ACL_ERR_PARAM the watermark is not valid
+**
+**	Description:
+**		This function starts the streaming mode using the accelerometer FIFO: the FIFO is set in circular mode
+**      with the specified watermark, and the FIFO interrupt is routed to the INT2 pin.
+**      When bWatermark samples are in the FIFO, they are read in a single I2C transaction (the F_STATUS register
+**      followed by the FIFO data) and stored in the ring buffer. The timestamps are computed from the interrupt time
+**      (the newest sample) and the output data rate.
+**      Compared with ACL_StartStream, the bus overhead per sample and the number of interrupts are divided by bWatermark.
+**      ACL_Init must be called first, the output data rate must not be changed while streaming.
+**
+*/
+unsigned char ACL_StartStreamFifo(unsigned char bWatermark)
+{
+    if(bWatermark < 1 || bWatermark > ACL_FIFO_SIZE)
+    {
+        return ACL_ERR_PARAM;
+    }
+    return ACL_BeginStream(bWatermark);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_SetFifo
+**
+**	Parameters:
+**      unsigned char bMode         - the FIFO mode:
+**                          ACL_FIFO_DISABLED   the FIFO is disabled
+**                          ACL_FIFO_CIRCULAR   the oldest samples are overwritten when the FIFO is full
+**                          ACL_FIFO_FILL       the FIFO stops accepting new samples when it is full
+**      unsigned char bWatermark    - the watermark, 0 - 32 samples (0 disables the watermark event)
+**
+**	Return Value:
+**      unsigned char   0          success
+**                      0xFF       the slave address was not acknowledged by the device.
+**                      0xFE       timeout error
+**
+**	Description:
+**		This function configures the accelerometer FIFO (F_SETUP register), in standby mode.
+**      The samples can then be read with ACL_ReadFifo, for example after sleeping for up to 32 sample periods.
+**
+*/
+unsigned char ACL_SetFifo(unsigned char bMode, unsigned char bWatermark)
+{
+    unsigned char bResult;
+    // the mode can only be changed from / to disabled
+    bResult = ACL_UpdateRegister(ACL_F_SETUP, 0xFF, 0);
+    if(!bResult && bMode != ACL_FIFO_DISABLED)
+    {
+        bResult = ACL_UpdateRegister(ACL_F_SETUP, 0xFF, (bMode << 6) | (bWatermark & ACL_F_CNT_MASK));
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_ReadFifo
+**
+**	Parameters:
+**      unsigned char *rgRawVals    - Pointer to a buffer where the samples are placed, 6 bytes for each sample,
+**                                      in the format described for ACL_ReadRawValues (oldest sample first).
+**      unsigned char cntMax        - the maximum number of samples to be read, 1 - 32
+**
+**	Return Value:
+**      unsigned char   the number of samples read
+**
+**	Description:
+**		This function drains the accelerometer FIFO: the number of samples is read from F_STATUS,
+**      then all of them (up to cntMax) are read in a single burst from the FIFO data register.
+**      The FIFO must be enabled with ACL_SetFifo. This function must not be used while streaming.
+**
+*/
+unsigned char ACL_ReadFifo(unsigned char *rgRawVals, unsigned char cntMax)
+{
+    unsigned char bVal = ACL_OUT_X_MSB;
+    unsigned char cntSamples = ACL_GetRegister(ACL_F_STATUS) & ACL_F_CNT_MASK;
+    if(cntSamples > cntMax)
+    {
+        cntSamples = cntMax;
+    }
+    if(cntSamples)
+    {
+        I2C_Write(ACL_I2C_ADDR, &bVal, 1, 0);
+        if(I2C_Read(ACL_I2C_ADDR, rgRawVals, cntSamples * 6))
+        {
+            cntSamples = 0;
+        }
+    }
+    return cntSamples;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_BeginStream
+**
+**	Parameters:
+**      unsigned char bWatermark    - 0 for the data ready interrupt, 1 - 32 for the FIFO watermark interrupt
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      CN_ERR_FULL no change notification handler is available
+**
+**	Description:
+**		This function implements ACL_StartStream and ACL_StartStreamFifo: the accelerometer interrupt
+**      is enabled and routed to INT2, and the INT2 pin changes are notified by the CN library.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char ACL_BeginStream(unsigned char bWatermark)
+{
+    unsigned char bResult, bIntSrc;
+    if(fAclStreaming)
+    {
+        return 0;
+    }
+    idxAclHead = 0;
+    idxAclTail = 0;
+    cntAclLost = 0;
+    bAclStreamWmrk = bWatermark;
+    uiAclSamplePeriod = (unsigned int)((unsigned long long)SYS_FRQ / 2 * 100 /
+                            rgAclOdrCentiHz[(ACL_GetRegister(ACL_CTRL_REG1) >> 3) & 7]);
+    bIntSrc = bWatermark ? ACL_INT_EN_FIFO : ACL_INT_EN_DRDY;
+    bResult = bWatermark ? ACL_SetFifo(ACL_FIFO_CIRCULAR, bWatermark) : ACL_SetFifo(ACL_FIFO_DISABLED, 0);
+    if(!bResult)
+    {
+        bResult = ACL_UpdateRegister(ACL_CTRL_REG4, ACL_INT_EN_DRDY | ACL_INT_EN_FIFO, bIntSrc);
+    }
+    if(!bResult)
+    {
+        bResult = ACL_UpdateRegister(ACL_CTRL_REG5, bIntSrc, 0);    // route to INT2
+    }
+    if(bResult)
+    {
+        return bResult;
+    }
+    fAclStreaming = 1;
+    bResult = ACL_UpdateIntPin();
+    if(bResult)
+    {
+        fAclStreaming = 0;
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_StopStream
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function stops the streaming mode: the INT2 notifications are disabled (unless events are enabled),
+**      the read in progress (if any) is completed, and the data ready interrupt of the accelerometer is disabled.
+**      The samples already in the ring buffer can still be read. The FIFO is disabled.
+**
+*/
+void ACL_StopStream()
+{
+    if(!fAclStreaming)
+    {
+        return;
+    }
+    fAclStreaming = 0;
+    ACL_UpdateIntPin();
+    ACL_UpdateRegister(ACL_CTRL_REG4, ACL_INT_EN_DRDY | ACL_INT_EN_FIFO, 0);
+    if(bAclStreamWmrk)
+    {
+        ACL_SetFifo(ACL_FIFO_DISABLED, 0);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_EnableTap
+**
+**	Parameters:
+**      unsigned char bAxes         - the axes where taps are detected: ACL_AXIS_X, ACL_AXIS_Y, ACL_AXIS_Z (OR-ed)
+**      unsigned char bTapMode      - ACL_TAP_SINGLE, ACL_TAP_DOUBLE or both
+**      unsigned char bThreshold    - the acceleration threshold, 0 - 127, in 0.063 g units
+**      unsigned char bTimeLimit    - the maximum duration of a pulse (PULSE_TMLT)
+**      unsigned char bLatency      - the time after a pulse when other pulses are ignored (PULSE_LTCY)
+**      unsigned char bWindow       - the time after the latency when the second pulse of a double tap is expected (PULSE_WIND)
+**                                    The time units depend on the output data rate, 0.625 ms for the time limit
+**                                    and 1.25 ms for the latency and the window at 800 Hz (see the MMA8652 datasheet).
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      CN_ERR_FULL no change notification handler is available
+**
+**	Description:
+**		This function configures the pulse detection engine of the accelerometer and routes its interrupt to INT2.
+**      Each detected tap is stored in the event queue as an ACL_EVT_TAP event, the value being the
+**      PULSE_SRC register (axis, polarity and double tap bits: ACL_TAP_xxx).
+**
+*/
+unsigned char ACL_EnableTap(unsigned char bAxes, unsigned char bTapMode, unsigned char bThreshold,
+                    unsigned char bTimeLimit, unsigned char bLatency, unsigned char bWindow)
+{
+    unsigned char bCfg = ACL_PULSE_CFG_ELE;
+    unsigned char rgRegVals[14];
+    int i;
+    for(i = 0; i < 3; i++)
+    {
+        // PULSE_CFG: single pulse enable bits 0, 2, 4, double pulse enable bits 1, 3, 5 for X, Y, Z
+        if(bAxes & (1 << i))
+        {
+            if(bTapMode & ACL_TAP_SINGLE)
+            {
+                bCfg |= 1 << (2 * i);
+            }
+            if(bTapMode & ACL_TAP_DOUBLE)
+            {
+                bCfg |= 2 << (2 * i);
+            }
+        }
+    }
+    rgRegVals[0] = ACL_PULSE_CFG;   rgRegVals[1] = bCfg;
+    rgRegVals[2] = ACL_PULSE_THSX;  rgRegVals[3] = bThreshold & 0x7F;
+    rgRegVals[4] = ACL_PULSE_THSY;  rgRegVals[5] = bThreshold & 0x7F;
+    rgRegVals[6] = ACL_PULSE_THSZ;  rgRegVals[7] = bThreshold & 0x7F;
+    rgRegVals[8] = ACL_PULSE_TMLT;  rgRegVals[9] = bTimeLimit;
+    rgRegVals[10] = ACL_PULSE_LTCY; rgRegVals[11] = bLatency;
+    rgRegVals[12] = ACL_PULSE_WIND; rgRegVals[13] = bWindow;
+    return ACL_EnableEventSource(ACL_INT_EN_PULSE, rgRegVals, 7);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_EnableOrientation
+**
+**	Parameters:
+**      unsigned char bDebounce     - the number of samples the new orientation must be stable before the event
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      CN_ERR_FULL no change notification handler is available
+**
+**	Description:
+**		This function enables the portrait / landscape detection engine of the accelerometer (with the default
+**      angles and thresholds) and routes its interrupt to INT2. Each orientation change is stored in the event queue
+**      as an ACL_EVT_ORIENTATION event, the value being the PL_STATUS register (see ACL_PL_GET_ORIENTATION and ACL_PL_BACK).
+**
+*/
+unsigned char ACL_EnableOrientation(unsigned char bDebounce)
+{
+    unsigned char rgRegVals[4];
+    rgRegVals[0] = ACL_PL_CFG;      rgRegVals[1] = ACL_PL_CFG_DBCNTM | ACL_PL_CFG_PL_EN;
+    rgRegVals[2] = ACL_PL_COUNT;    rgRegVals[3] = bDebounce;
+    return ACL_EnableEventSource(ACL_INT_EN_LNDPRT, rgRegVals, 2);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_EnableMotion
+**
+**	Parameters:
+**      unsigned char bAxes         - the axes considered: ACL_AXIS_X, ACL_AXIS_Y, ACL_AXIS_Z (OR-ed)
+**      unsigned char fFreefall     - 1 for freefall detection (all the axes below the threshold),
+**                                    0 for motion detection (any axis above the threshold)
+**      unsigned char bThreshold    - the acceleration threshold, 0 - 127, in 0.063 g units
+**      unsigned char bDebounce     - the number of samples the condition must be true before the event
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      CN_ERR_FULL no change notification handler is available
+**
+**	Description:
+**		This function configures the freefall / motion detection engine of the accelerometer and routes
+**      its interrupt to INT2. Each detection is stored in the event queue as an ACL_EVT_MOTION event,
+**      the value being the FF_MT_SRC register (axis and polarity bits).
+**
+*/
+unsigned char ACL_EnableMotion(unsigned char bAxes, unsigned char fFreefall, unsigned char bThreshold, unsigned char bDebounce)
+{
+    unsigned char rgRegVals[6];
+    rgRegVals[0] = ACL_FF_MT_CFG;   rgRegVals[1] = ACL_FF_MT_CFG_ELE | (fFreefall ? 0 : ACL_FF_MT_CFG_OAE) | ((bAxes & 7) << 3);
+    rgRegVals[2] = ACL_FF_MT_THS;   rgRegVals[3] = ACL_FF_MT_THS_DBCNTM | (bThreshold & 0x7F);
+    rgRegVals[4] = ACL_FF_MT_COUNT; rgRegVals[5] = bDebounce;
+    return ACL_EnableEventSource(ACL_INT_EN_FF_MT, rgRegVals, 3);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_DisableEvents
+**
+**	Parameters:
+**      unsigned char bSources      - the event sources to be disabled: ACL_INT_EN_PULSE, ACL_INT_EN_LNDPRT, ACL_INT_EN_FF_MT (OR-ed)
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**
+**	Description:
+**		This function disables the interrupts of the detection engines. The INT2 notifications are disabled
+**      when no event source and no streaming mode are enabled. The events already queued can still be read.
+**
+*/
+unsigned char ACL_DisableEvents(unsigned char bSources)
+{
+    bSources &= ACL_INT_EN_PULSE | ACL_INT_EN_LNDPRT | ACL_INT_EN_FF_MT;
+    bAclEventSrc &= ~bSources;
+    ACL_UpdateIntPin();
+    return ACL_UpdateRegister(ACL_CTRL_REG4, bSources, 0);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_GetEvent
+**
+**	Parameters:
+**      ACL_EVENT *pEvent       - the structure where the oldest event is copied
+**
+**	Return Value:
+**      unsigned char   1 if an event was copied, 0 if the event queue is empty
+**
+**	Description:
+**		This function removes the oldest event from the event queue. It must be called only from the main loop.
+**
+*/
+unsigned char ACL_GetEvent(ACL_EVENT *pEvent)
+{
+    if(idxAclEvtTail == idxAclEvtHead)
+    {
+        return 0;
+    }
+    *pEvent = rgAclEvents[idxAclEvtTail & (ACL_EVENT_QUEUE_SIZE - 1)];
+    __sync_synchronize();
+    idxAclEvtTail++;
+    return 1;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_GetLostEvents
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned int    the number of events lost
+**
+**	Description:
+**		This function returns the number of events dropped because the event queue was full or the I2C read failed.
+**
+*/
+unsigned int ACL_GetLostEvents()
+{
+    return cntAclEventsLost;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_GetSample
+**
+**	Parameters:
+**      ACL_SAMPLE *pSample     - the structure where the oldest sample is copied
+**
+**	Return Value:
+**      unsigned char   1 if a sample was copied, 0 if the ring buffer is empty
+**
+**	Description:
+**		This function removes the oldest sample from the ring buffer. It must be called only from the main loop.
+**      Each sample contains the timestamp and the raw values of the three axes (signed 12 bits values).
+**
+*/
+unsigned char ACL_GetSample(ACL_SAMPLE *pSample)
+{
+    if(idxAclTail == idxAclHead)
+    {
+        return 0;
+    }
+    *pSample = rgAclRing[idxAclTail & (ACL_RING_SIZE - 1)];
+    __sync_synchronize();
+    idxAclTail++;
+    return 1;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_GetSampleCount
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned int    the number of samples in the ring buffer
+**
+**	Description:
+**		This function returns the number of samples waiting in the ring buffer.
+**
+*/
+unsigned int ACL_GetSampleCount()
+{
+    return idxAclHead - idxAclTail;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_GetLostSamples
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned int    the number of samples lost
+**
+**	Description:
+**		This function returns the number of samples dropped since the streaming mode was started,
+**      because the ring buffer was full or the I2C read failed.
+**
+*/
+unsigned int ACL_GetLostSamples()
+{
+    return cntAclLost;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_GetRawValue
+**
+**	Parameters:
+**      unsigned char *rgRawVals     - Pointer to a buffer that contains the 2 bytes corresponding to the raw value,
+**                                      in the format described for ACL_ConvertRawToValueG.
+**
+**	Return Value:
+**      short   the raw value, sign extended from 12 bits
+**
+**	Description:
+**		This function converts the 2 bytes of a raw value to a signed integer.
+**
+*/
+short ACL_GetRawValue(unsigned char *rgRawVals)
+{
+    return ((short)((rgRawVals[0] << 8) | rgRawVals[1])) >> 4;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_UpdateRegister
+**
+**	Parameters:
+**      unsigned char bAddress  - The register address.
+**      unsigned char bMask     - The bits to be changed.
+**      unsigned char bValue    - The new value of the bits.
+**
+**	Return Value:
+**      unsigned char   0          success
+**                      0xFF       the slave address was not acknowledged by the device.
+**                      0xFE       timeout error
+**
+**	Description:
+**		This function changes some bits of a control register. The accelerometer is placed in standby mode
+**      (CTRL_REG1 ACTIVE bit) while the register is written, as required for the control registers,
+**      then the previous mode is restored.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char ACL_UpdateRegister(unsigned char bAddress, unsigned char bMask, unsigned char bValue)
+{
+    unsigned char bCtrl1, bVal, bResult;
+    bCtrl1 = ACL_GetRegister(ACL_CTRL_REG1);
+    bResult = ACL_SetRegister(ACL_CTRL_REG1, bCtrl1 & ~ACL_CTRL_REG1_ACTIVE);
+    if(bResult)
+    {
+        return bResult;
+    }
+    bVal = ACL_GetRegister(bAddress);
+    bVal = (bVal & ~bMask) | (bValue & bMask);
+    bResult = ACL_SetRegister(bAddress, bVal);
+    ACL_SetRegister(ACL_CTRL_REG1, bCtrl1);
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_SetRegistersStandby
+**
+**	Parameters:
+**      unsigned char *rgRegVals    - pairs of register address and value
+**      unsigned char cntRegs       - the number of pairs
+**
+**	Return Value:
+**      unsigned char   0          success
+**                      0xFF       the slave address was not acknowledged by the device.
+**                      0xFE       timeout error
+**
+**	Description:
+**		This function writes several control registers, with the accelerometer in standby mode,
+**      then restores the previous mode.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char ACL_SetRegistersStandby(unsigned char *rgRegVals, unsigned char cntRegs)
+{
+    unsigned char bCtrl1, bResult;
+    bCtrl1 = ACL_GetRegister(ACL_CTRL_REG1);
+    bResult = ACL_SetRegister(ACL_CTRL_REG1, bCtrl1 & ~ACL_CTRL_REG1_ACTIVE);
+    while(!bResult && cntRegs--)
+    {
+        bResult = ACL_SetRegister(rgRegVals[0], rgRegVals[1]);
+        rgRegVals += 2;
+    }
+    ACL_SetRegister(ACL_CTRL_REG1, bCtrl1);
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_EnableEventSource
+**
+**	Parameters:
+**      unsigned char bSource       - the CTRL_REG4 bit of the detection engine
+**      unsigned char *rgRegVals    - pairs of register address and value configuring the engine
+**      unsigned char cntRegs       - the number of pairs
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      CN_ERR_FULL no change notification handler is available
+**
+**	Description:
+**		This function configures a detection engine, enables its interrupt and routes it to INT2.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char ACL_EnableEventSource(unsigned char bSource, unsigned char *rgRegVals, unsigned char cntRegs)
+{
+    unsigned char bResult = ACL_SetRegistersStandby(rgRegVals, cntRegs);
+    if(!bResult)
+    {
+        bResult = ACL_UpdateRegister(ACL_CTRL_REG5, bSource, 0);        // route to INT2
+    }
+    if(!bResult)
+    {
+        bResult = ACL_UpdateRegister(ACL_CTRL_REG4, bSource, bSource);
+    }
+    if(bResult)
+    {
+        return bResult;
+    }
+    bAclEventSrc |= bSource;
+    bResult = ACL_UpdateIntPin();
+    if(bResult)
+    {
+        bAclEventSrc &= ~bSource;
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_UpdateIntPin
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      CN_ERR_FULL no change notification handler is available
+**
+**	Description:
+**		This function registers the INT2 change notification handler when the streaming mode or an event
+**      source is enabled, and unregisters it (after the read in progress completes) when none is enabled.
+**      When the handler is registered, a read is started if INT2 is already active, because no edge will be notified.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char ACL_UpdateIntPin()
+{
+    unsigned int uiStatus;
+    if((fAclStreaming || bAclEventSrc) && idAclCN == CN_ERR_FULL)
+    {
+        idAclCN = CN_Register(CN_PORT_G, ACL_INT2_CN_MASK, ACL_INT2Handler, 0);
+        if(idAclCN == CN_ERR_FULL)
+        {
+            return CN_ERR_FULL;
+        }
+        uiStatus = __builtin_disable_interrupts();
+        if(!prt_ACL_INT2 && !fAclReadBusy)
+        {
+            ACL_IntStart();
+        }
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+    }
+    else if(!fAclStreaming && !bAclEventSrc && idAclCN != CN_ERR_FULL)
+    {
+        CN_Unregister(idAclCN);
+        idAclCN = CN_ERR_FULL;
+        while(fAclReadBusy)
+        {
+            I2C_CheckTimeout();
+        }
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_INT2Handler
+**
+**	Parameters:
+**      void *pCtx              - not used
+**      unsigned int uiPort     - the value of port G
+**      unsigned int uiChanged  - the changed pins (INT2)
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the change notification handler of the INT2 pin. On the falling edge (INT2 is active low),
+**      the interrupt handling is started, if it is not already in progress.
+**      This is a low-level function called from the CN interrupt, so user should avoid calling it directly.
+**
+*/
+void ACL_INT2Handler(void *pCtx, unsigned int uiPort, unsigned int uiChanged)
+{
+    if(!(uiPort & ACL_INT2_CN_MASK) && (fAclStreaming || bAclEventSrc) && !fAclReadBusy)
+    {
+        ACL_IntStart();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_IntStart
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function starts the handling of an accelerometer interrupt: the time is recorded (it is the timestamp
+**      of the sample and of the events) and, when event sources are enabled, the INT_SOURCE register is read
+**      asynchronously. Otherwise the only possible source is the streaming one, so the samples are read directly.
+**      When the read cannot be submitted, it is retried later.
+**      It is called from interrupt handlers or with interrupts disabled.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void ACL_IntStart()
+{
+    uiAclSampleTime = TimeGetTicks();
+    fAclReadBusy = 1;
+    if(!bAclEventSrc)
+    {
+        bAclPendingSrc = ACL_INT_EN_DRDY | ACL_INT_EN_FIFO;
+        ACL_IntNext();
+        return;
+    }
+    xferAclEvent.bAddr = ACL_I2C_ADDR;
+    xferAclEvent.pbWr = &bAclIntSourceReg;
+    xferAclEvent.cbWr = 1;
+    xferAclEvent.pbRd = &bAclIntSrc;
+    xferAclEvent.cbRd = 1;
+    xferAclEvent.pfCallback = ACL_IntSourceDone;
+    if(I2C_Submit(&xferAclEvent) != I2C_OK)
+    {
+        ACL_Retry(1);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_IntSourceDone
+**
+**	Parameters:
+**      I2C_XFER *pXfer         - the completed transaction
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the completion callback of the INT_SOURCE register read: the active sources are handled one by one.
+**      This is a low-level function called from the I2C interrupt, so user should avoid calling it directly.
+**
+*/
+void ACL_IntSourceDone(I2C_XFER *pXfer)
+{
+    if(pXfer->bStatus != I2C_OK)
+    {
+        cntAclEventsLost++;
+        bAclPendingSrc = 0;
+    }
+    else
+    {
+        bAclPendingSrc = bAclIntSrc;
+    }
+    ACL_IntNext();
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_IntNext
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function handles the next pending interrupt source: for an event source, its source register
+**      is read asynchronously (which also clears the interrupt); for the streaming source, the samples are read.
+**      When the read cannot be submitted, the source stays pending and the read is retried later.
+**      When no source is pending, the interrupt handling ends.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void ACL_IntNext()
+{
+    unsigned char bResult, bStreamSrc;
+    int i;
+    for(i = 0; i < ACL_NO_EVENT_SOURCES; i++)
+    {
+        if(bAclPendingSrc & bAclEventSrc & rgAclEvtSrcBits[i])
+        {
+            bAclPendingSrc &= ~rgAclEvtSrcBits[i];
+            bAclEvtType = rgAclEvtTypes[i];
+            xferAclEvent.bAddr = ACL_I2C_ADDR;
+            xferAclEvent.pbWr = &rgAclEvtSrcRegs[i];
+            xferAclEvent.cbWr = 1;
+            xferAclEvent.pbRd = &bAclEvtVal;
+            xferAclEvent.cbRd = 1;
+            xferAclEvent.pfCallback = ACL_EventReadDone;
+            if(I2C_Submit(&xferAclEvent) != I2C_OK)
+            {
+                bAclPendingSrc |= rgAclEvtSrcBits[i];
+                ACL_Retry(0);
+            }
+            return;
+        }
+    }
+    if(fAclStreaming && (bAclPendingSrc & (ACL_INT_EN_DRDY | ACL_INT_EN_FIFO)))
+    {
+        bStreamSrc = bAclPendingSrc & (ACL_INT_EN_DRDY | ACL_INT_EN_FIFO);
+        bAclPendingSrc &= ~bStreamSrc;
+        bResult = ACL_StreamRead();
+        if(bResult != I2C_OK)
+        {
+            bAclPendingSrc |= bStreamSrc;
+            ACL_Retry(0);
+        }
+        return;
+    }
+    ACL_IntEnd();
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_IntEnd
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function ends the handling of an accelerometer interrupt. If INT2 is still active
+**      (a new sample or event arrived meanwhile), the handling is restarted, because no new edge will be notified.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void ACL_IntEnd()
+{
+    if((fAclStreaming || bAclEventSrc) && !prt_ACL_INT2)
+    {
+        ACL_IntStart();
+    }
+    else
+    {
+        fAclReadBusy = 0;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_StreamRead
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned char   I2C_OK          the read was queued
+**                      I2C_ERR_FULL    the I2C queue is full
+**
+**	Description:
+**		This function queues the asynchronous read of the sample (data ready mode),
+**      or of F_STATUS and bAclStreamWmrk samples in the same transaction (FIFO mode).
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char ACL_StreamRead()
+{
+    if(bAclStreamWmrk)
+    {
+        xferAclStream.bAddr = ACL_I2C_ADDR;
+        xferAclStream.pbWr = &bAclFStatus;
+        xferAclStream.cbWr = 1;
+        xferAclStream.pbRd = rgAclStreamVals;
+        xferAclStream.cbRd = 1 + 6 * bAclStreamWmrk;
+        xferAclStream.pfCallback = ACL_StreamReadDone;
+        return I2C_Submit(&xferAclStream);
+    }
+    return ACL_ReadRawValuesAsync(&xferAclStream, rgAclStreamVals, ACL_StreamReadDone);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_StreamReadDone
+**
+**	Parameters:
+**      I2C_XFER *pXfer         - the completed transaction
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the completion callback of the sample read: the sample is stored in the ring buffer,
+**      with the time of the interrupt as timestamp.
+**      In FIFO mode, the valid samples (at most the watermark, as counted by F_STATUS) are stored,
+**      the timestamps being computed back from the newest one using the output data rate,
+**      and a FIFO overflow is counted as a lost sample.
+**      This is a low-level function called from the I2C interrupt, so user should avoid calling it directly.
+**
+*/
+void ACL_StreamReadDone(I2C_XFER *pXfer)
+{
+    unsigned char *pbVals = rgAclStreamVals;
+    unsigned char cntSamples = 1, i;
+    if(pXfer->bStatus != I2C_OK)
+    {
+        cntAclLost++;
+        cntSamples = 0;
+    }
+    else if(bAclStreamWmrk)
+    {
+        if(pbVals[0] & ACL_F_OVF)
+        {
+            cntAclLost++;
+        }
+        cntSamples = pbVals[0] & ACL_F_CNT_MASK;
+        if(cntSamples > bAclStreamWmrk)
+        {
+            cntSamples = bAclStreamWmrk;
+        }
+        pbVals++;
+    }
+    for(i = 0; i < cntSamples; i++, pbVals += 6)
+    {
+        // the last sample read is the newest
+        ACL_StoreSample(uiAclSampleTime - (cntSamples - 1 - i) * uiAclSamplePeriod, pbVals);
+    }
+    ACL_IntNext();
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_EventReadDone
+**
+**	Parameters:
+**      I2C_XFER *pXfer         - the completed transaction
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the completion callback of an event source register read: the event is stored in the event queue.
+**      If the queue is full, the event is counted as lost.
+**      This is a low-level function called from the I2C interrupt, so user should avoid calling it directly.
+**
+*/
+void ACL_EventReadDone(I2C_XFER *pXfer)
+{
+    ACL_EVENT *pEvent;
+    if(pXfer->bStatus != I2C_OK || idxAclEvtHead - idxAclEvtTail >= ACL_EVENT_QUEUE_SIZE)
+    {
+        cntAclEventsLost++;
+    }
+    else
+    {
+        pEvent = &rgAclEvents[idxAclEvtHead & (ACL_EVENT_QUEUE_SIZE - 1)];
+        pEvent->uiTimestamp = uiAclSampleTime;
+        pEvent->bType = bAclEvtType;
+        pEvent->bValue = bAclEvtVal;
+        __sync_synchronize();
+        idxAclEvtHead++;
+    }
+    ACL_IntNext();
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_Retry
+**
+**	Parameters:
+**      unsigned char fStart    - 1 to restart the interrupt handling (INT_SOURCE read), 0 to handle the next pending source
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function schedules the retry of an interrupt read that could not be submitted (the I2C queue is
+**      shared with other drivers and may be full). The read stays pending (fAclReadBusy stays set),
+**      because INT2 stays active until the accelerometer registers are read.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void ACL_Retry(unsigned char fStart)
+{
+    fAclRetryStart = fStart;
+    SOFTTMR_Start(&tmrAclRetry, ACL_RETRY_MS, 0, ACL_RetryExpired, 0);
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_RetryExpired
+**
+**	Parameters:
+**      void *pArg              - not used
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the callback of the retry soft timer: the interrupt read is submitted again. When the streaming
+**      mode and the event sources were disabled meanwhile, the interrupt handling ends.
+**      This is a low-level function called by the SOFTTMR library, so user should avoid calling it directly.
+**
+*/
+void ACL_RetryExpired(void *pArg)
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    if(fAclRetryStart && (fAclStreaming || bAclEventSrc))
+    {
+        ACL_IntStart();
+    }
+    else
+    {
+        ACL_IntNext();
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	ACL_StoreSample
+**
+**	Parameters:
+**      unsigned int uiTimestamp    - the sample timestamp
+**      unsigned char *rgRawVals    - the 6 bytes of the sample
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function stores a sample in the ring buffer. If the ring buffer is full, the sample is counted as lost.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void ACL_StoreSample(unsigned int uiTimestamp, unsigned char *rgRawVals)
+{
+    ACL_SAMPLE *pSample;
+    if(idxAclHead - idxAclTail >= ACL_RING_SIZE)
+    {
+        cntAclLost++;
+        return;
+    }
+    pSample = &rgAclRing[idxAclHead & (ACL_RING_SIZE - 1)];
+    pSample->uiTimestamp = uiTimestamp;
+    pSample->rgRaw[0] = ACL_GetRawValue(&rgRawVals[0]);
+    pSample->rgRaw[1] = ACL_GetRawValue(&rgRawVals[2]);
+    pSample->rgRaw[2] = ACL_GetRawValue(&rgRawVals[4]);
+    __sync_synchronize();
+    idxAclHead++;
+}
+
 /* ------------------------------------------------------------ */
 /***	ACL_Close
 **
@@ -314,12 +1477,14 @@ void ACL_ReadGValues(float *rgGVals)
 **
 **	Description:
 **		This functions releases the hardware involved in the ACL library: 
-**      it closes the I2C1 interface.
+**      it stops the streaming mode, disables the events and closes the I2C1 interface.
 **      
 **          
 */
 void ACL_Close()
 {
+    ACL_StopStream();
+    ACL_DisableEvents(ACL_INT_EN_PULSE | ACL_INT_EN_LNDPRT | ACL_INT_EN_FF_MT);
     I2C1CONbits.ON = 0;     //Disable the I2C module 
 }
 
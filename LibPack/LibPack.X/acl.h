@@ -18,6 +18,8 @@
 #ifndef _ACL_H    /* Guard against multiple inclusion */
 #define _ACL_H
 
+#include "i2c.h"
+
 
 
 #define ACL_I2C_ADDR        0x1D
@@ -25,18 +27,162 @@
 #define ACL_CTRL_REG1       0x2A
 #define ACL_DEVICE_ID       0x0D 
 #define ACL_XYZDATACFG      0x0E 
+#define ACL_F_STATUS        0x00    // FIFO status
+#define ACL_F_SETUP         0x09    // FIFO setup
+#define ACL_CTRL_REG4       0x2D    // interrupt enable register
+#define ACL_CTRL_REG5       0x2E    // interrupt routing register: 1 - INT1, 0 - INT2
+#define ACL_INT_SOURCE      0x0C    // interrupt source
+#define ACL_PL_STATUS       0x10    // portrait / landscape status
+#define ACL_PL_CFG          0x11    // portrait / landscape configuration
+#define ACL_PL_COUNT        0x12    // portrait / landscape debounce counter
+#define ACL_FF_MT_CFG       0x15    // freefall / motion configuration
+#define ACL_FF_MT_SRC       0x16    // freefall / motion source
+#define ACL_FF_MT_THS       0x17    // freefall / motion threshold
+#define ACL_FF_MT_COUNT     0x18    // freefall / motion debounce counter
+#define ACL_PULSE_CFG       0x21    // pulse configuration
+#define ACL_PULSE_SRC       0x22    // pulse source
+#define ACL_PULSE_THSX      0x23    // pulse X threshold
+#define ACL_PULSE_THSY      0x24    // pulse Y threshold
+#define ACL_PULSE_THSZ      0x25    // pulse Z threshold
+#define ACL_PULSE_TMLT      0x26    // pulse time limit
+#define ACL_PULSE_LTCY      0x27    // pulse latency
+#define ACL_PULSE_WIND      0x28    // pulse window
+
+// CTRL_REG1 bits
+#define ACL_CTRL_REG1_ACTIVE    0x01
+// CTRL_REG4 and CTRL_REG5 bits
+#define ACL_INT_EN_DRDY         0x01    // data ready interrupt
+#define ACL_INT_CFG_DRDY        0x01
+#define ACL_INT_EN_FIFO         0x40    // FIFO interrupt
+#define ACL_INT_CFG_FIFO        0x40
+#define ACL_INT_EN_FF_MT        0x04    // freefall / motion interrupt
+#define ACL_INT_EN_PULSE        0x08    // pulse (tap) interrupt
+#define ACL_INT_EN_LNDPRT       0x10    // portrait / landscape interrupt
+// PL_CFG bits
+#define ACL_PL_CFG_DBCNTM       0x80    // debounce counter cleared when the condition is not met
+#define ACL_PL_CFG_PL_EN        0x40    // portrait / landscape detection enable
+// PL_STATUS bits (the value of the ACL_EVT_ORIENTATION events)
+#define ACL_PL_NEWLP            0x80    // orientation changed
+#define ACL_PL_LO               0x40    // Z-tilt lockout
+#define ACL_PL_BACK             0x01    // back facing
+#define ACL_PL_GET_ORIENTATION(b)   (((b) >> 1) & 3)    // ACL_PL_PORTRAIT_UP, ...
+#define ACL_PL_PORTRAIT_UP      0
+#define ACL_PL_PORTRAIT_DOWN    1
+#define ACL_PL_LANDSCAPE_RIGHT  2
+#define ACL_PL_LANDSCAPE_LEFT   3
+// FF_MT_CFG and FF_MT_THS bits
+#define ACL_FF_MT_CFG_ELE       0x80    // event latched until FF_MT_SRC is read
+#define ACL_FF_MT_CFG_OAE       0x40    // motion (OR of the axes above threshold), 0 for freefall (AND of the axes below threshold)
+#define ACL_FF_MT_THS_DBCNTM    0x80    // debounce counter cleared when the condition is not met
+// PULSE_CFG bits
+#define ACL_PULSE_CFG_ELE       0x40    // event latched until PULSE_SRC is read
+// PULSE_SRC bits (the value of the ACL_EVT_TAP events)
+#define ACL_TAP_AXZ             0x40    // Z event
+#define ACL_TAP_AXY             0x20    // Y event
+#define ACL_TAP_AXX             0x10    // X event
+#define ACL_TAP_DPE             0x08    // double pulse event
+#define ACL_TAP_POLZ            0x04    // Z polarity (1 - negative)
+#define ACL_TAP_POLY            0x02    // Y polarity (1 - negative)
+#define ACL_TAP_POLX            0x01    // X polarity (1 - negative)
+// F_STATUS bits
+#define ACL_F_OVF               0x80    // FIFO overflow
+#define ACL_F_WMRK_FLAG         0x40    // watermark reached
+#define ACL_F_CNT_MASK          0x3F    // the number of samples in the FIFO (also the F_SETUP watermark field)
+
+// FIFO modes (F_SETUP F_MODE field)
+#define ACL_FIFO_DISABLED       0
+#define ACL_FIFO_CIRCULAR       1
+#define ACL_FIFO_FILL           2
+// the FIFO size, in samples
+#define ACL_FIFO_SIZE           32
+
+#define ACL_ERR_PARAM           0xFC
+
+// axes, for ACL_EnableTap and ACL_EnableMotion
+#define ACL_AXIS_X              0x01
+#define ACL_AXIS_Y              0x02
+#define ACL_AXIS_Z              0x04
+// tap modes, for ACL_EnableTap
+#define ACL_TAP_SINGLE          0x01
+#define ACL_TAP_DOUBLE          0x02
+
+// event types
+#define ACL_EVT_TAP             1   // value: PULSE_SRC
+#define ACL_EVT_ORIENTATION     2   // value: PL_STATUS
+#define ACL_EVT_MOTION          3   // value: FF_MT_SRC
+
+// the INT2 pin (RG0), for the CN library
+#define ACL_INT2_CN_MASK        (1 << 0)
+
+// the number of samples of the streaming mode ring buffer (must be a power of 2)
+#define ACL_RING_SIZE       64
+
+// a sample acquired in streaming mode
+typedef struct {
+    unsigned int uiTimestamp;       // the core timer value (SYS_FRQ / 2) at the data ready interrupt
+    short rgRaw[3];                 // the X, Y, Z raw values, signed 12 bits values
+} ACL_SAMPLE;
+
+// the number of events of the event queue (must be a power of 2)
+#define ACL_EVENT_QUEUE_SIZE    16
+
+// the delay before an interrupt read is submitted again, when the I2C queue is full, in ms
+#define ACL_RETRY_MS            1
+
+// an event detected by the embedded functions of the accelerometer
+typedef struct {
+    unsigned int uiTimestamp;       // the core timer value (SYS_FRQ / 2) at the interrupt
+    unsigned char bType;            // ACL_EVT_xxx
+    unsigned char bValue;           // the source register of the event
+} ACL_EVENT;
 
 // function prototypes
 void ACL_Init();
 void ACL_ReadRawValues(unsigned char *rgRawVals);
+unsigned char ACL_ReadRawValuesAsync(I2C_XFER *pXfer, unsigned char *rgRawVals, void (*pfCallback)(I2C_XFER *pXfer));
 void ACL_ReadGValues(float *rgGVals);
 unsigned char ACL_SetRange(unsigned char bRange);
 float ACL_ConvertRawToValueG(unsigned char *rgRawVals);
+short ACL_ConvertRawToMilliG(unsigned char *rgRawVals);
+void ACL_ConvertRawToMilliGBatch(const short *rgRaw, short *rgMilliG, unsigned int cntVals);
+void ACL_ReadMilliGValues(short *rgMilliGVals);
 unsigned char ACL_SetRegister(unsigned char bAddress, unsigned char bValue);
 unsigned char ACL_GetRegister(unsigned char bAddress);
+unsigned char ACL_StartStream();
+unsigned char ACL_StartStreamFifo(unsigned char bWatermark);
+unsigned char ACL_SetFifo(unsigned char bMode, unsigned char bWatermark);
+unsigned char ACL_ReadFifo(unsigned char *rgRawVals, unsigned char cntMax);
+void ACL_StopStream();
+unsigned char ACL_GetSample(ACL_SAMPLE *pSample);
+unsigned int ACL_GetSampleCount();
+unsigned int ACL_GetLostSamples();
+short ACL_GetRawValue(unsigned char *rgRawVals);
+unsigned char ACL_EnableTap(unsigned char bAxes, unsigned char bTapMode, unsigned char bThreshold,
+                    unsigned char bTimeLimit, unsigned char bLatency, unsigned char bWindow);
+unsigned char ACL_EnableOrientation(unsigned char bDebounce);
+unsigned char ACL_EnableMotion(unsigned char bAxes, unsigned char fFreefall, unsigned char bThreshold, unsigned char bDebounce);
+unsigned char ACL_DisableEvents(unsigned char bSources);
+unsigned char ACL_GetEvent(ACL_EVENT *pEvent);
+unsigned int ACL_GetLostEvents();
  
 //private functions:
 void ACL_ConfigurePins();
+unsigned char ACL_UpdateRegister(unsigned char bAddress, unsigned char bMask, unsigned char bValue);
+void ACL_INT2Handler(void *pCtx, unsigned int uiPort, unsigned int uiChanged);
+unsigned char ACL_BeginStream(unsigned char bWatermark);
+unsigned char ACL_SetRegistersStandby(unsigned char *rgRegVals, unsigned char cntRegs);
+unsigned char ACL_EnableEventSource(unsigned char bSource, unsigned char *rgRegVals, unsigned char cntRegs);
+unsigned char ACL_UpdateIntPin();
+void ACL_IntStart();
+void ACL_IntSourceDone(I2C_XFER *pXfer);
+void ACL_IntNext();
+void ACL_IntEnd();
+unsigned char ACL_StreamRead();
+void ACL_StoreSample(unsigned int uiTimestamp, unsigned char *rgRawVals);
+void ACL_StreamReadDone(I2C_XFER *pXfer);
+void ACL_EventReadDone(I2C_XFER *pXfer);
+void ACL_Retry(unsigned char fStart);
+void ACL_RetryExpired(void *pArg);
 void I2C_Init(unsigned int clockFreq);
 unsigned char I2C_Write(unsigned char slaveAddress,
                         unsigned char* dataBuffer,
@@ -44,6 +44,9 @@
 #include "config.h"
 #include "audio.h"
 #include "mic.h"
+#include "hwres.h"
+#include "prof.h"
+#include "trace.h"
 
 
 #define RECORD_SIZE 2*30720
@@ -91,7 +94,8 @@ unsigned short rgSinSamples[] = {
 void __ISR(_TIMER_3_VECTOR, IPL7AUTO) Timer3ISR(void) 
 {  
     unsigned short v;
-    
+    PROF_ISR_ENTER_TMR(PROF_ID_TMR3, TMR3, 1);
+    TRACE_BEGIN(TRACE_SRC_TMR3, 0);
     
     if(bAudioMode == 0)
     {   // play sine
@@ -122,6 +126,8 @@ void __ISR(_TIMER_3_VECTOR, IPL7AUTO) Timer3ISR(void)
     }
     
     IFS0bits.T3IF = 0;      // clear Timer3 interrupt flag
+    TRACE_END(TRACE_SRC_TMR3, 0);
+    PROF_ISR_EXIT(PROF_ID_TMR3);
 }
 
 
@@ -136,7 +142,8 @@ void __ISR(_TIMER_3_VECTOR, IPL7AUTO) Timer3ISR(void)
 **              3 - Play recorded. 
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if the initialization succeeded
+**                        HWRES_ERR_CONFLICT if Timer3 or OC1 are used by another library with an incompatible configuration
 **
 **	Description:
 **		This function initializes the AUDIO module, in the mode indicated by parameter bMode. 
@@ -149,14 +156,27 @@ void __ISR(_TIMER_3_VECTOR, IPL7AUTO) Timer3ISR(void)
 **      OC1 module is configured to work with Timer3.
 **      The timer period constant is computed using TMR_FREQ_SINE and TMR_FREQ_SOUND definitions (located in this source file)
 **      and peripheral bus frequency definition (PB_FRQ, located in config.h).
+**      Timer3 is allocated using the HWRES library. It can be shared with the MOT library, that adapts its PWM
+**      to the Timer3 period set by the AUDIO library. If Timer3 or OC1 are used by another library
+**      with an incompatible configuration, the AUDIO module is not initialized.
 */
-void AUDIO_Init(unsigned char bMode)
+unsigned char AUDIO_Init(unsigned char bMode)
 {   
+    unsigned int uiPR3;
+    unsigned char bResult;
     // close the timer and OC if the AUDIO_Init function is called when the AUDIO is already initialized
-    if(bAudioMode != -1)
+    if(bAudioMode != (unsigned char)-1)
     {
         AUDIO_Close();
     }
+    uiPR3 = (int)((float)((float)PB_FRQ/(bMode ? TMR_FREQ_SOUND : TMR_FREQ_SINE)) + 0.5);
+    bResult = HWRES_AllocTimer(3, HWRES_OWNER_AUDIO, HWRES_SHARED, 0, uiPR3);
+    if(bResult == HWRES_ERR_CONFLICT || HWRES_AllocOC(1, HWRES_OWNER_AUDIO, 3) != HWRES_OK)
+    {
+        HWRES_ReleaseTimer(3, HWRES_OWNER_AUDIO);
+        bAudioMode = -1;
+        return HWRES_ERR_CONFLICT;
+    }
     bAudioMode = bMode;
     AUDIO_ConfigurePins();
     // configuration is specific to each mode: 
@@ -164,31 +184,32 @@ void AUDIO_Init(unsigned char bMode)
     {
         case 0:
             // play sine
-            PR3 = (int)((float)((float)PB_FRQ/TMR_FREQ_SINE) + 0.5);               
             AUDIO_InitPlayBack(rgSinSamples, RGSIN_SIZE);
             break;
         case 1:
             // mirror
             MIC_Init();
-            PR3 = (int)((float)((float)PB_FRQ/TMR_FREQ_SOUND) + 0.5);  
             break;
         case 2:
             // record sound           
             MIC_Init();
-            PR3 = (int)(((float)(float)PB_FRQ/TMR_FREQ_SOUND) + 0.5);  
             AUDIO_InitRecord(rgAudioBuf, RECORD_SIZE);
             break;        
         case 3:
             // playback sound
-            PR3 = (int)((float)((float)PB_FRQ/TMR_FREQ_SOUND) + 0.5);  
             AUDIO_InitPlayBack(rgAudioBuf, RECORD_SIZE);
             break;        
     }
-    TMR3 = 0;
-    T3CONbits.TCKPS = 0;     //1:1 prescale value
-    T3CONbits.TGATE = 0;     //not gated input (the default)
-    T3CONbits.TCS = 0;       //PCBLK input (the default)
-    T3CONbits.ON = 1;        //turn on Timer3
+    if(bResult == HWRES_OK)
+    {
+        // Timer3 is not already running with the same period
+        PR3 = uiPR3;
+        TMR3 = 0;
+        T3CONbits.TCKPS = 0;     //1:1 prescale value
+        T3CONbits.TGATE = 0;     //not gated input (the default)
+        T3CONbits.TCS = 0;       //PCBLK input (the default)
+        T3CONbits.ON = 1;        //turn on Timer3
+    }
  
     OC1CONbits.ON = 0;       // Turn off OC1 while doing setup.
     OC1CONbits.OCM = 6;      // PWM mode on OC1; Fault pin is disabled
@@ -201,6 +222,7 @@ void AUDIO_Init(unsigned char bMode)
     IFS0bits.T3IF = 0;      // clear Timer3 interrupt flag
     
     macro_enable_interrupts();  // enable interrupts at CPU
+    return HWRES_OK;
 }
 
 /* ------------------------------------------------------------ */
@@ -310,14 +332,22 @@ void AUDIO_InitRecord(unsigned short *pAudioSamples1, int cntBuf1)
 **	Description:
 **		This functions releases the hardware involved in AUDIO library: 
 **      it turns off the Timer3 and OC1 modules.
-**      
+**      Timer3 is turned off only if it is not used by other libraries (MOT).
 **          
 */
 void AUDIO_Close()
 {
-        T3CONbits.ON = 0;       // turn off Timer3
+    if(HWRES_GetOCOwner(1) == HWRES_OWNER_AUDIO)
+    {
+        IEC0bits.T3IE = 0;      // disable Timer3 interrupt
         OC1CONbits.ON = 0;      // Turn off OC1
-        
+        HWRES_ReleaseOC(1, HWRES_OWNER_AUDIO);
+    }
+    if((HWRES_GetTimerOwners(3) & HWRES_OWNER_AUDIO) && !HWRES_ReleaseTimer(3, HWRES_OWNER_AUDIO))
+    {
+        T3CONbits.ON = 0;       // turn off Timer3
+    }
+    bAudioMode = -1;
 }
 
 /* *****************************************************************************
@@ -18,7 +18,7 @@
 #define _AUDIO_H
 
 void AUDIO_ConfigurePins();
-void AUDIO_Init(unsigned char bMode);
+unsigned char AUDIO_Init(unsigned char bMode);
 void AUDIO_Close();
 
 
@@ -11,7 +11,7 @@
   @Description
         This file groups the functions that implement the BTN library.
         The functions implement basic digital input functionality needed for the onboard buttons.
-        Include the file in the project, together with config.h, when this library is needed.
+        Include the file in the project, together with config.h and gpio.c, when this library is needed.
  
   @Author
     Cristian Fatu 
@@ -27,10 +27,15 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "btn.h"
+#include "gpio.h"
 
 
 /* ************************************************************************** */
 
+// the button pins, in the order of the button numbers (U, L, C, R, D)
+const GPIO_PIN rgBtnPins[5] = {pin_BTN_BTNU, pin_BTN_BTNL, pin_BTN_BTNC, pin_BTN_BTNR, pin_BTN_BTND};
+const char szBtnNames[] = "ULCRD";
+
 /* ------------------------------------------------------------ */
 /***	BTN_Init
 **
@@ -106,38 +111,19 @@ void BTN_ConfigurePins()
 */
 unsigned char BTN_GetValue(unsigned char btn)
 {
-    unsigned bResult = 0xFF;
-    
-    switch (btn)
+    int i;
+    if(btn >= 'a' && btn <= 'z')
     {
-        case 'U': 
-        case 'u': 
-        case 0:
-            bResult = prt_BTN_BTNU;
-            break;
-        case 'L': 
-        case 'l': 
-        case 1:
-            bResult = prt_BTN_BTNL;
-            break;
-        case 'C': 
-        case 'c': 
-        case 2:
-            bResult = prt_BTN_BTNC;
-            break;
-        case 'R': 
-        case 'r': 
-        case 3:
-            bResult = prt_BTN_BTNR;
-            break;
-        case 'D': 
-        case 'd': 
-        case 4:
-            bResult = prt_BTN_BTND;
-            break;
+        btn -= 'a' - 'A';
     }
-
-    return bResult;
+    for(i = 0; i < 5; i++)
+    {
+        if(btn == i || btn == szBtnNames[i])
+        {
+            return GPIO_GetValue(rgBtnPins[i]);
+        }
+    }
+    return 0xFF;
 }
 
 /* ------------------------------------------------------------ */
@@ -167,16 +153,11 @@ unsigned char BTN_GetValue(unsigned char btn)
 **      bit 2 corresponds to BTNC, 
 **      bit 3 corresponds to BTNR, 
 **      bit 4 corresponds to BTND (see return value description).          
+**      The ports are read once (see GPIO_GetGroupValue).
 */
 unsigned char BTN_GetGroupValue()
 {
-    unsigned char bResult = 0;
-    int i;
-    for(i = 0; i < 5; i++)
-    {
-        bResult |= (BTN_GetValue(i) << i);
-    }
-    return bResult;
+    return GPIO_GetGroupValue(rgBtnPins, 5);
 }
 
 
@@ -0,0 +1,243 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    cn.c
+
+  @Description
+        This file groups the functions that implement the CN library.
+        The library shares the change notification interrupt between the libraries that need pin change events
+        (for example ACL for the accelerometer interrupt pin, or the buttons): each library registers a handler
+        for some pins of a port. In the interrupt, the port is read (which ends the mismatch condition)
+        and the handlers of the pins that changed are called.
+        The pins must be configured as digital inputs by the caller.
+        Include the file in the project, together with config.h, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include "config.h"
+#include "cn.h"
+#include "prof.h"
+
+/* ************************************************************************** */
+
+// the registers of a port involved in change notification
+typedef struct {
+    volatile unsigned int *pCNCON;
+    volatile unsigned int *pCNEN;
+    volatile unsigned int *pCNSTAT;
+    volatile unsigned int *pPORT;
+    unsigned int uiIntMask;             // the interrupt flag and enable bit, in IFS1 and IEC1
+} CN_PORT_REGS;
+
+// a registered handler
+typedef struct {
+    CN_HANDLER pfHandler;               // 0 for a free entry
+    void *pCtx;
+    unsigned char bPort;
+    unsigned int uiMask;
+} CN_ENTRY;
+
+const CN_PORT_REGS rgCNPorts[CN_NO_PORTS] = {
+    {&CNCONA, &CNENA, &CNSTATA, &PORTA, _IFS1_CNAIF_MASK},
+    {&CNCONB, &CNENB, &CNSTATB, &PORTB, _IFS1_CNBIF_MASK},
+    {&CNCONC, &CNENC, &CNSTATC, &PORTC, _IFS1_CNCIF_MASK},
+    {&CNCOND, &CNEND, &CNSTATD, &PORTD, _IFS1_CNDIF_MASK},
+    {&CNCONE, &CNENE, &CNSTATE, &PORTE, _IFS1_CNEIF_MASK},
+    {&CNCONF, &CNENF, &CNSTATF, &PORTF, _IFS1_CNFIF_MASK},
+    {&CNCONG, &CNENG, &CNSTATG, &PORTG, _IFS1_CNGIF_MASK}
+};
+
+CN_ENTRY rgCNHandlers[CN_NO_HANDLERS];
+
+/* ------------------------------------------------------------ */
+/***	ChangeNoticeISR
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the change notification interrupt handler. For each port having its flag set,
+**      the status and the port are read, the flag is cleared, and the handlers of the changed pins are called.
+**      The priority is CN_IPL (the IPL value below must match it).
+**
+*/
+void __ISR(_CHANGE_NOTICE_VECTOR, IPL3AUTO) ChangeNoticeISR(void)
+{
+    const CN_PORT_REGS *pRegs;
+    CN_ENTRY *pEntry;
+    unsigned int uiStat, uiPort;
+    int i, j;
+    PROF_ISR_ENTER(PROF_ID_CN);
+
+    for(i = 0; i < CN_NO_PORTS; i++)
+    {
+        pRegs = &rgCNPorts[i];
+        if(!(IFS1 & pRegs->uiIntMask))
+        {
+            continue;
+        }
+        uiStat = *pRegs->pCNSTAT;
+        uiPort = *pRegs->pPORT;         // reading the port ends the mismatch condition
+        IFS1CLR = pRegs->uiIntMask;     // clear interrupt flag
+        for(j = 0; j < CN_NO_HANDLERS; j++)
+        {
+            pEntry = &rgCNHandlers[j];
+            if(pEntry->pfHandler && pEntry->bPort == i && (pEntry->uiMask & uiStat))
+            {
+                (*pEntry->pfHandler)(pEntry->pCtx, uiPort, pEntry->uiMask & uiStat);
+            }
+        }
+    }
+    PROF_ISR_EXIT(PROF_ID_CN);
+}
+
+/* ------------------------------------------------------------ */
+/***	CN_Register
+**
+**	Parameters:
+**		unsigned char bPort         - the port, one of CN_PORT_xxx
+**		unsigned int uiMask         - the pins of the port (bit i for pin i)
+**		CN_HANDLER pfHandler        - the function called when one of the pins changes
+**		void *pCtx                  - the context pointer passed to the handler
+**
+**	Return Value:
+**		unsigned char   - the handler id, to be used with CN_Unregister
+**                        CN_ERR_FULL if CN_NO_HANDLERS handlers are already registered
+**                        CN_ERR_PARAM if the parameters are not valid
+**
+**	Description:
+**		This function registers a handler for the changes of some pins of a port, and enables
+**      the change notification for these pins. The handler is called from the change notification
+**      interrupt, on both edges. Several handlers can be registered for the same port.
+**
+*/
+unsigned char CN_Register(unsigned char bPort, unsigned int uiMask, CN_HANDLER pfHandler, void *pCtx)
+{
+    CN_ENTRY *pEntry;
+    unsigned int uiStatus;
+    int i;
+
+    if(bPort >= CN_NO_PORTS || !uiMask || !pfHandler)
+    {
+        return CN_ERR_PARAM;
+    }
+    uiStatus = __builtin_disable_interrupts();
+    for(i = 0; i < CN_NO_HANDLERS; i++)
+    {
+        pEntry = &rgCNHandlers[i];
+        if(!pEntry->pfHandler)
+        {
+            pEntry->pCtx = pCtx;
+            pEntry->bPort = bPort;
+            pEntry->uiMask = uiMask;
+            pEntry->pfHandler = pfHandler;
+            CN_UpdatePort(bPort);
+            break;
+        }
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    if(i == CN_NO_HANDLERS)
+    {
+        return CN_ERR_FULL;
+    }
+    IPC8bits.CNIP = CN_IPL;
+    IPC8bits.CNIS = 0;
+    macro_enable_interrupts();          // enable interrupts at CPU
+    return i;
+}
+
+/* ------------------------------------------------------------ */
+/***	CN_Unregister
+**
+**	Parameters:
+**		unsigned char idHandler     - the handler id, returned by CN_Register
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function removes a handler. The change notification is disabled for the pins
+**      not used by other handlers.
+**
+*/
+void CN_Unregister(unsigned char idHandler)
+{
+    unsigned int uiStatus;
+    unsigned char bPort;
+    if(idHandler >= CN_NO_HANDLERS || !rgCNHandlers[idHandler].pfHandler)
+    {
+        return;
+    }
+    uiStatus = __builtin_disable_interrupts();
+    bPort = rgCNHandlers[idHandler].bPort;
+    rgCNHandlers[idHandler].pfHandler = 0;
+    CN_UpdatePort(bPort);
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	CN_UpdatePort
+**
+**	Parameters:
+**		unsigned char bPort         - the port, one of CN_PORT_xxx
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function enables the change notification for the pins of the port used by the registered handlers.
+**      The port module and its interrupt are enabled only when at least one pin is used.
+**      It must be called with interrupts disabled.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void CN_UpdatePort(unsigned char bPort)
+{
+    const CN_PORT_REGS *pRegs = &rgCNPorts[bPort];
+    unsigned int uiPins = 0;
+    int i;
+
+    for(i = 0; i < CN_NO_HANDLERS; i++)
+    {
+        if(rgCNHandlers[i].pfHandler && rgCNHandlers[i].bPort == bPort)
+        {
+            uiPins |= rgCNHandlers[i].uiMask;
+        }
+    }
+    *pRegs->pCNEN = uiPins;
+    if(uiPins)
+    {
+        *pRegs->pCNCON = _CNCONA_ON_MASK;
+        (void)*pRegs->pPORT;                // read the port, so that only the next changes are notified
+        IFS1CLR = pRegs->uiIntMask;
+        IEC1SET = pRegs->uiIntMask;
+    }
+    else
+    {
+        IEC1CLR = pRegs->uiIntMask;
+        *pRegs->pCNCON = 0;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,53 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    cn.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the CN library (defined in cn.c).
+        Include the file in the project when this library is needed.
+        Use #include "cn.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _CN_H    /* Guard against multiple inclusion */
+#define _CN_H
+
+// ports, parameter of CN_Register
+#define CN_PORT_A           0
+#define CN_PORT_B           1
+#define CN_PORT_C           2
+#define CN_PORT_D           3
+#define CN_PORT_E           4
+#define CN_PORT_F           5
+#define CN_PORT_G           6
+#define CN_NO_PORTS         7
+
+// the maximum number of registered handlers
+#define CN_NO_HANDLERS      8
+// the priority of the change notification interrupt, the handlers are called at this priority
+#define CN_IPL              3
+
+#define CN_ERR_FULL         0xFE
+#define CN_ERR_PARAM        0xFC
+
+// a change notification handler: uiPort is the port value read in the interrupt,
+// uiChanged has the bits of the registered pins that changed since the previous interrupt
+typedef void (*CN_HANDLER)(void *pCtx, unsigned int uiPort, unsigned int uiChanged);
+
+unsigned char CN_Register(unsigned char bPort, unsigned int uiMask, CN_HANDLER pfHandler, void *pCtx);
+void CN_Unregister(unsigned char idHandler);
+
+//private functions:
+void CN_UpdatePort(unsigned char bPort);
+
+#endif /* _CN_H */
+
+/* *****************************************************************************
+ End of File
+ */
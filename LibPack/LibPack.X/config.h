@@ -9,6 +9,7 @@
 #define	CONFIG_H
 
 #define PB_FRQ  40000000
+#define SYS_FRQ 80000000    // the core timer (CP0 Count) is incremented at SYS_FRQ / 2
 
 #define macro_enable_interrupts() \
 {  unsigned int val = 0;\
@@ -21,6 +22,12 @@ __builtin_enable_interrupts(); }
 //#define macro_enable_interrupts INTEnableSystemMultiVectoredInt()
 
 #define macro_disable_interrupts __builtin_disable_interrupts()
+
+// uncomment to enable the interrupt handlers profiling (PROF library, prof.c)
+//#define PROF_ENABLE
+
+// uncomment to enable the event trace instrumentation (TRACE library, trace.c)
+//#define TRACE_ENABLE
 //#define macro_disable_interrupts INTDisableInterrupts()
 
 
@@ -47,53 +54,68 @@ extern "C" {
 #define  lat_LEDS_LED6  LATAbits.LATA6
 #define  lat_LEDS_LED7  LATAbits.LATA7
 
+// the pin_xxx definitions are pin descriptors (port, bit) for the GPIO library (see gpio.h)
+
 // SWT
 
 #define tris_SWT_SWT0   TRISFbits.TRISF3
 #define  prt_SWT_SWT0   PORTFbits.RF3
+#define  pin_SWT_SWT0   {GPIO_PORT_F, 3}
         
 #define tris_SWT_SWT1   TRISFbits.TRISF5
 #define  prt_SWT_SWT1   PORTFbits.RF5
+#define  pin_SWT_SWT1   {GPIO_PORT_F, 5}
 
 #define tris_SWT_SWT2   TRISFbits.TRISF4
 #define  prt_SWT_SWT2   PORTFbits.RF4
+#define  pin_SWT_SWT2   {GPIO_PORT_F, 4}
 
 #define tris_SWT_SWT3   TRISDbits.TRISD15
 #define  prt_SWT_SWT3   PORTDbits.RD15
+#define  pin_SWT_SWT3   {GPIO_PORT_D, 15}
 
 #define tris_SWT_SWT4   TRISDbits.TRISD14
 #define  prt_SWT_SWT4   PORTDbits.RD14
+#define  pin_SWT_SWT4   {GPIO_PORT_D, 14}
 
 #define tris_SWT_SWT5   TRISBbits.TRISB11
 #define  prt_SWT_SWT5   PORTBbits.RB11
+#define  pin_SWT_SWT5   {GPIO_PORT_B, 11}
 #define  ansel_SWT_SWT5 ANSELBbits.ANSB11
 
 #define tris_SWT_SWT6   TRISBbits.TRISB10
 #define  prt_SWT_SWT6   PORTBbits.RB10
+#define  pin_SWT_SWT6   {GPIO_PORT_B, 10}
 #define  ansel_SWT_SWT6 ANSELBbits.ANSB10
 
 #define tris_SWT_SWT7   TRISBbits.TRISB9
 #define  prt_SWT_SWT7   PORTBbits.RB9
+#define  pin_SWT_SWT7   {GPIO_PORT_B, 9}
 #define  ansel_SWT_SWT7 ANSELBbits.ANSB9
 
  // Buttons
 #define tris_BTN_BTNU   TRISBbits.TRISB1
 #define prt_BTN_BTNU    PORTBbits.RB1
+#define pin_BTN_BTNU    {GPIO_PORT_B, 1}
 #define ansel_BTN_BTNU  ANSELBbits.ANSB1
 
 #define tris_BTN_BTNL   TRISBbits.TRISB0
 #define prt_BTN_BTNL    PORTBbits.RB0
+#define pin_BTN_BTNL    {GPIO_PORT_B, 0}
 #define ansel_BTN_BTNL  ANSELBbits.ANSB0
 
 #define tris_BTN_BTNC   TRISFbits.TRISF0
 #define prt_BTN_BTNC    PORTFbits.RF0
+#define pin_BTN_BTNC    {GPIO_PORT_F, 0}
 
 #define tris_BTN_BTNR   TRISBbits.TRISB8
 #define prt_BTN_BTNR    PORTBbits.RB8
+#define pin_BTN_BTNR    {GPIO_PORT_B, 8}
 #define ansel_BTN_BTNR  ANSELBbits.ANSB8
 
 #define tris_BTN_BTND   TRISAbits.TRISA15
 #define  prt_BTN_BTND   PORTAbits.RA15
+#define  pin_BTN_BTND   {GPIO_PORT_A, 15}
 
  // SSD - Seven Segment Display
 
@@ -197,6 +219,7 @@ extern "C" {
 
 #define tris_SPIFLASH_CE    TRISFbits.TRISF8
 #define  lat_SPIFLASH_CE    LATFbits.LATF8
+#define  pin_SPIFLASH_CE    {GPIO_PORT_F, 8}
 
 
 #define tris_SPIFLASH_SCK   TRISFbits.TRISF6
@@ -261,6 +284,15 @@ extern "C" {
 // ACL
 #define tris_ACL_INT2   TRISGbits.TRISG0
 #define lat_ACL_INT2    LATGbits.LATG0
+#define prt_ACL_INT2    PORTGbits.RG0
+
+// I2C1, the pins are used as digital I/O only for the bus recovery
+#define tris_I2C_SCL    TRISGbits.TRISG2
+#define lat_I2C_SCL     LATGbits.LATG2
+#define prt_I2C_SCL     PORTGbits.RG2
+#define tris_I2C_SDA    TRISGbits.TRISG3
+#define lat_I2C_SDA     LATGbits.LATG3
+#define prt_I2C_SDA     PORTGbits.RG3
 
 
 // UART
@@ -284,6 +316,7 @@ extern "C" {
 #define   rp_PMODS_JA1   RPC2R
 #define  lat_PMODS_JA1   LATCbits.LATC2
 #define  prt_PMODS_JA1   PORTCbits.RC2
+#define  pin_PMODS_JA1   {GPIO_PORT_C, 2}
 #define cnpu_PMODS_JA1   CNPUCbits.CNPUC2
 #define cnpd_PMODS_JA1   CNPDCbits.CNPDC2
 
@@ -292,6 +325,7 @@ extern "C" {
 #define   rp_PMODS_JA2   RPC1R
 #define  lat_PMODS_JA2   LATCbits.LATC1
 #define  prt_PMODS_JA2   PORTCbits.RC1
+#define  pin_PMODS_JA2   {GPIO_PORT_C, 1}
 #define cnpu_PMODS_JA2   CNPUCbits.CNPUC1
 #define cnpd_PMODS_JA2   CNPDCbits.CNPDC1
 
@@ -300,6 +334,7 @@ extern "C" {
 #define   rp_PMODS_JA3   RPC4R
 #define  lat_PMODS_JA3   LATCbits.LATC4
 #define  prt_PMODS_JA3   PORTCbits.RC4
+#define  pin_PMODS_JA3   {GPIO_PORT_C, 4}
 #define cnpu_PMODS_JA3   CNPUCbits.CNPUC4
 #define cnpd_PMODS_JA3   CNPDCbits.CNPDC4
 
@@ -308,6 +343,7 @@ extern "C" {
 #define   rp_PMODS_JA4   RPG6R
 #define  lat_PMODS_JA4   LATGbits.LATG6
 #define  prt_PMODS_JA4   PORTGbits.RG6
+#define  pin_PMODS_JA4   {GPIO_PORT_G, 6}
 #define ansel_PMODS_JA4  ANSELGbits.ANSG6
 #define cnpu_PMODS_JA4   CNPUGbits.CNPUG6
 #define cnpd_PMODS_JA4   CNPDGbits.CNPDG6
@@ -317,6 +353,7 @@ extern "C" {
 #define   rp_PMODS_JA7   RPC3R
 #define  lat_PMODS_JA7   LATCbits.LATC3
 #define  prt_PMODS_JA7   PORTCbits.RC3
+#define  pin_PMODS_JA7   {GPIO_PORT_C, 3}
 #define cnpu_PMODS_JA7   CNPUCbits.CNPUC3
 #define cnpd_PMODS_JA7   CNPDCbits.CNPDC3
 
@@ -325,6 +362,7 @@ extern "C" {
 #define   rp_PMODS_JA8   RPG7R
 #define  lat_PMODS_JA8   LATGbits.LATG7
 #define  prt_PMODS_JA8   PORTGbits.RG7
+#define  pin_PMODS_JA8   {GPIO_PORT_G, 7}
 #define ansel_PMODS_JA8  ANSELGbits.ANSG7
 #define cnpu_PMODS_JA8   CNPUGbits.CNPUG7
 #define cnpd_PMODS_JA8   CNPDGbits.CNPDG7
@@ -334,6 +372,7 @@ extern "C" {
 #define   rp_PMODS_JA9   RPG8R
 #define  lat_PMODS_JA9   LATGbits.LATG8
 #define  prt_PMODS_JA9   PORTGbits.RG8
+#define  pin_PMODS_JA9   {GPIO_PORT_G, 8}
 #define ansel_PMODS_JA9  ANSELGbits.ANSG8
 #define cnpu_PMODS_JA9   CNPUGbits.CNPUG8
 #define cnpd_PMODS_JA9   CNPDGbits.CNPDG8
@@ -343,6 +382,7 @@ extern "C" {
 #define   rp_PMODS_JA10   RPG9R
 #define  lat_PMODS_JA10   LATGbits.LATG9
 #define  prt_PMODS_JA10   PORTGbits.RG9
+#define  pin_PMODS_JA10   {GPIO_PORT_G, 9}
 #define ansel_PMODS_JA10  ANSELGbits.ANSG9
 #define cnpu_PMODS_JA10   CNPUGbits.CNPUG9
 #define cnpd_PMODS_JA10   CNPDGbits.CNPDG9
@@ -353,6 +393,7 @@ extern "C" {
 #define   rp_PMODS_JB1   RPD9R
 #define  lat_PMODS_JB1   LATDbits.LATD9
 #define  prt_PMODS_JB1   PORTDbits.RD9
+#define  pin_PMODS_JB1   {GPIO_PORT_D, 9}
 #define cnpu_PMODS_JB1   CNPUDbits.CNPUD9
 #define cnpd_PMODS_JB1   CNPDDbits.CNPDD9
 #define  odc_PMODS_JB1   ODCDbits.ODCD9
@@ -362,6 +403,7 @@ extern "C" {
 #define   rp_PMODS_JB2   RPD11R
 #define  lat_PMODS_JB2   LATDbits.LATD11
 #define  prt_PMODS_JB2   PORTDbits.RD11
+#define  pin_PMODS_JB2   {GPIO_PORT_D, 11}
 #define cnpu_PMODS_JB2   CNPUDbits.CNPUD11
 #define cnpd_PMODS_JB2   CNPDDbits.CNPDD11
 #define  odc_PMODS_JB2   ODCDbits.ODCD11
@@ -371,6 +413,7 @@ extern "C" {
 #define   rp_PMODS_JB3   RPD10R
 #define  lat_PMODS_JB3   LATDbits.LATD10
 #define  prt_PMODS_JB3   PORTDbits.RD10
+#define  pin_PMODS_JB3   {GPIO_PORT_D, 10}
 #define cnpu_PMODS_JB3   CNPUDbits.CNPUD10
 #define cnpd_PMODS_JB3   CNPDDbits.CNPDD10
 #define  odc_PMODS_JB3   ODCDbits.ODCD10
@@ -380,6 +423,7 @@ extern "C" {
 #define   rp_PMODS_JB4   RPD8R
 #define  lat_PMODS_JB4   LATDbits.LATD8
 #define  prt_PMODS_JB4   PORTDbits.RD8
+#define  pin_PMODS_JB4   {GPIO_PORT_D, 8}
 #define cnpu_PMODS_JB4   CNPUDbits.CNPUD8
 #define cnpd_PMODS_JB4   CNPDDbits.CNPDD8
 #define  odc_PMODS_JB4   ODCDbits.ODCD8
@@ -389,6 +433,7 @@ extern "C" {
 #define   rp_PMODS_JB7   RPC14R
 #define  lat_PMODS_JB7   LATCbits.LATC14
 #define  prt_PMODS_JB7   PORTCbits.RC14
+#define  pin_PMODS_JB7   {GPIO_PORT_C, 14}
 #define cnpu_PMODS_JB7   CNPUCbits.CNPUC14
 #define cnpd_PMODS_JB7   CNPDCbits.CNPDC14
 
@@ -397,6 +442,7 @@ extern "C" {
 #define   rp_PMODS_JB8   RPD0R
 #define  lat_PMODS_JB8   LATDbits.LATD0
 #define  prt_PMODS_JB8   PORTDbits.RD0
+#define  pin_PMODS_JB8   {GPIO_PORT_D, 0}
 #define cnpu_PMODS_JB8   CNPUDbits.CNPUD0
 #define cnpd_PMODS_JB8   CNPDDbits.CNPDD0
 
@@ -405,6 +451,7 @@ extern "C" {
 #define   rp_PMODS_JB9   RPD1R
 #define  lat_PMODS_JB9   LATDbits.LATD1
 #define  prt_PMODS_JB9   PORTDbits.RD1
+#define  pin_PMODS_JB9   {GPIO_PORT_D, 1}
 #define ansel_PMODS_JB9  ANSELDbits.ANSD1
 #define cnpu_PMODS_JB9   CNPUDbits.CNPUD1
 #define cnpd_PMODS_JB9   CNPDDbits.CNPDD1
@@ -414,6 +461,7 @@ extern "C" {
 #define   rp_PMODS_JB10   RPC13R
 #define  lat_PMODS_JB10   LATCbits.LATC13
 #define  prt_PMODS_JB10   PORTCbits.RC13
+#define  pin_PMODS_JB10   {GPIO_PORT_C, 13}
 #define cnpu_PMODS_JB10   CNPUCbits.CNPUC13
 #define cnpd_PMODS_JB10   CNPDCbits.CNPDC13
 
@@ -422,6 +470,7 @@ extern "C" {
 // - 5V tol
 #define tris_SPIJA_CE    tris_PMODS_JA1
 #define  lat_SPIJA_CE    lat_PMODS_JA1
+#define  pin_SPIJA_CE    pin_PMODS_JA1
 
 // - 5V tol
 #define tris_SPIJA_SI   tris_PMODS_JA2 // JA2 - RC1
@@ -0,0 +1,252 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    frame.c
+
+  @Description
+        This file groups the functions that implement the FRAME library.
+        The library frames binary messages for the byte streams (UART, IrDA): the payload and its CRC-16
+        are COBS (Consistent Overhead Byte Stuffing) encoded, so that 0x00 only appears as the frame delimiter.
+        The overhead is at most 5 bytes for each frame, regardless of the payload bytes.
+        The decoder is incremental: the received bytes are passed one by one to FRAME_DecodeByte, which
+        reports the complete frames, so it can be called from the receive path without buffering the stream.
+        The library has no hardware dependencies. It is used by the IRDALINK library.
+        Include the file in the project when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include "frame.h"
+
+/* ************************************************************************** */
+
+/* ------------------------------------------------------------ */
+/***	FRAME_Crc16
+**
+**	Parameters:
+**		unsigned short wCrc         - the CRC of the previous bytes, FRAME_CRC_INIT for the first bytes
+**		const void *pData           - the bytes
+**		unsigned int cbLen          - the number of bytes
+**
+**	Return Value:
+**		unsigned short  - the CRC updated with the bytes
+**
+**	Description:
+**		This function computes the CRC-16/CCITT-FALSE of a buffer. It can be called several times to compute
+**      the CRC of non-contiguous data.
+**
+*/
+unsigned short FRAME_Crc16(unsigned short wCrc, const void *pData, unsigned int cbLen)
+{
+    const unsigned char *pbData = (const unsigned char *)pData;
+    unsigned char i;
+    while(cbLen--)
+    {
+        wCrc ^= (unsigned short)*pbData++ << 8;
+        for(i = 0; i < 8; i++)
+        {
+            wCrc = (wCrc & 0x8000) ? (wCrc << 1) ^ 0x1021 : wCrc << 1;
+        }
+    }
+    return wCrc;
+}
+
+/* ------------------------------------------------------------ */
+/***	FRAME_Encode
+**
+**	Parameters:
+**		const void *pPayload        - the payload
+**		unsigned int cbPayload      - the payload length, at most FRAME_MAX_PAYLOAD bytes
+**		unsigned char *pbOut        - the buffer for the encoded frame, at least FRAME_MAX_ENCODED bytes
+**
+**	Return Value:
+**		unsigned int    - the length of the encoded frame, including the delimiter, 0 if the payload is too long
+**
+**	Description:
+**		This function appends the CRC to the payload, COBS encodes them and appends the delimiter.
+**      The encoded frame is ready to be transmitted.
+**
+*/
+unsigned int FRAME_Encode(const void *pPayload, unsigned int cbPayload, unsigned char *pbOut)
+{
+    const unsigned char *pbPayload = (const unsigned char *)pPayload;
+    unsigned short wCrc;
+    unsigned char rgbCrc[2];
+    unsigned char bVal, bCode = 1;
+    unsigned int i, idxCode = 0, idxOut = 1;
+    if(cbPayload > FRAME_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+    wCrc = FRAME_Crc16(FRAME_CRC_INIT, pPayload, cbPayload);
+    rgbCrc[0] = wCrc >> 8;
+    rgbCrc[1] = wCrc & 0xFF;
+    for(i = 0; i < cbPayload + 2; i++)
+    {
+        bVal = (i < cbPayload) ? pbPayload[i] : rgbCrc[i - cbPayload];
+        if(bVal == 0)
+        {
+            // the zero ends the block, it is implied by the code byte
+            pbOut[idxCode] = bCode;
+            idxCode = idxOut++;
+            bCode = 1;
+        }
+        else
+        {
+            pbOut[idxOut++] = bVal;
+            if(++bCode == 0xFF)
+            {
+                // a full block (254 data bytes) is not followed by an implied zero
+                pbOut[idxCode] = bCode;
+                idxCode = idxOut++;
+                bCode = 1;
+            }
+        }
+    }
+    pbOut[idxCode] = bCode;
+    pbOut[idxOut++] = FRAME_DELIMITER;
+    return idxOut;
+}
+
+/* ------------------------------------------------------------ */
+/***	FRAME_InitDecoder
+**
+**	Parameters:
+**		FRAME_DECODER *pDec         - the decoder
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function resets a decoder: the bytes before the next delimiter are dropped only if they do not
+**      form a frame, so the decoder can be initialized in the middle of a stream.
+**
+*/
+void FRAME_InitDecoder(FRAME_DECODER *pDec)
+{
+    pDec->cbBuf = 0;
+    pDec->bCode = 0;
+    pDec->cbLeft = 0;
+    pDec->fOverflow = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	FRAME_DecodeByte
+**
+**	Parameters:
+**		FRAME_DECODER *pDec         - the decoder
+**		unsigned char bVal          - the received byte
+**
+**	Return Value:
+**		int     - the payload length (>= 0) when bVal completes a valid frame: the payload is returned
+**                by FRAME_GetPayload, until the next call
+**                FRAME_NONE if the frame is not complete (or bVal is an extra delimiter)
+**                FRAME_ERR_CRC if a frame was completed with a wrong CRC
+**                FRAME_ERR_FORMAT if a frame was completed, and it is not a valid COBS frame
+**
+**	Description:
+**		This function decodes a received byte. After a delimiter, the decoder is ready for the next frame,
+**      so a corrupted frame never affects the next one.
+**
+*/
+int FRAME_DecodeByte(FRAME_DECODER *pDec, unsigned char bVal)
+{
+    int cbPayload;
+    if(bVal == FRAME_DELIMITER)
+    {
+        if(!pDec->cbBuf && !pDec->bCode)
+        {
+            return FRAME_NONE;
+        }
+        if(pDec->fOverflow || pDec->cbLeft || pDec->cbBuf < 2)
+        {
+            cbPayload = FRAME_ERR_FORMAT;
+        }
+        else
+        {
+            cbPayload = pDec->cbBuf - 2;
+            if(FRAME_Crc16(FRAME_CRC_INIT, pDec->rgbBuf, cbPayload) !=
+                (((unsigned short)pDec->rgbBuf[cbPayload] << 8) | pDec->rgbBuf[cbPayload + 1]))
+            {
+                cbPayload = FRAME_ERR_CRC;
+            }
+        }
+        pDec->cbBuf = 0;
+        pDec->bCode = 0;
+        pDec->cbLeft = 0;
+        pDec->fOverflow = 0;
+        return cbPayload;
+    }
+    if(pDec->cbLeft)
+    {
+        FRAME_PutDecoded(pDec, bVal);
+        pDec->cbLeft--;
+    }
+    else
+    {
+        // code byte: the previous block (if not full) ends with an implied zero
+        if(pDec->bCode && pDec->bCode != 0xFF)
+        {
+            FRAME_PutDecoded(pDec, 0);
+        }
+        pDec->bCode = bVal;
+        pDec->cbLeft = bVal - 1;
+    }
+    return FRAME_NONE;
+}
+
+/* ------------------------------------------------------------ */
+/***	FRAME_GetPayload
+**
+**	Parameters:
+**		FRAME_DECODER *pDec         - the decoder
+**
+**	Return Value:
+**		const unsigned char *   - the payload of the frame completed by the last call of FRAME_DecodeByte
+**
+**	Description:
+**		This function returns the decoded payload. It is valid until FRAME_DecodeByte is called again.
+**
+*/
+const unsigned char *FRAME_GetPayload(FRAME_DECODER *pDec)
+{
+    return pDec->rgbBuf;
+}
+
+/* ------------------------------------------------------------ */
+/***	FRAME_PutDecoded
+**
+**	Parameters:
+**		FRAME_DECODER *pDec         - the decoder
+**		unsigned char bVal          - the decoded byte
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function stores a decoded byte, or marks the frame as too long.
+**      This is a low-level function called by FRAME_DecodeByte, so user should avoid calling it directly.
+**
+*/
+void FRAME_PutDecoded(FRAME_DECODER *pDec, unsigned char bVal)
+{
+    if(pDec->cbBuf < sizeof(pDec->rgbBuf))
+    {
+        pDec->rgbBuf[pDec->cbBuf++] = bVal;
+    }
+    else
+    {
+        pDec->fOverflow = 1;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
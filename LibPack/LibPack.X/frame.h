@@ -0,0 +1,62 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    frame.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the FRAME library (defined in frame.c).
+        Include the file in the project when this library is needed.
+        Use #include "frame.h" in the source files where the functions are needed.
+
+        Frame on the wire:
+            COBS encoded (payload, CRC-16 of the payload: high byte, low byte), followed by 0x00 (delimiter).
+        The encoded bytes never contain 0x00, so a receiver synchronizes on the next delimiter after a lost
+        or corrupted byte. CRC-16: CCITT polynomial 0x1021, initial value 0xFFFF, no reflection, no final XOR
+        (CRC-16/CCITT-FALSE, the CRC of "123456789" is 0x29B1).
+ */
+/* ************************************************************************** */
+
+#ifndef _FRAME_H    /* Guard against multiple inclusion */
+#define _FRAME_H
+
+// the maximum payload length, in bytes (the payload and the CRC fit in a single COBS block)
+#define FRAME_MAX_PAYLOAD   252
+// the maximum length of an encoded frame, including the delimiter
+#define FRAME_MAX_ENCODED   (FRAME_MAX_PAYLOAD + 5)
+
+#define FRAME_DELIMITER     0x00
+#define FRAME_CRC_INIT      0xFFFF
+
+// FRAME_DecodeByte return values (a value >= 0 is the payload length of a valid frame)
+#define FRAME_NONE          -1      // the frame is not complete
+#define FRAME_ERR_CRC       -2      // a frame was received, its CRC is wrong
+#define FRAME_ERR_FORMAT    -3      // a frame was received, it is truncated, too long or too short
+
+// the state of a frame decoder. The memory is provided by the user, the fields are private.
+typedef struct {
+    unsigned char rgbBuf[FRAME_MAX_PAYLOAD + 2];    // the decoded payload and CRC
+    unsigned int cbBuf;
+    unsigned char bCode;            // the code byte of the current COBS block, 0 before the first block
+    unsigned char cbLeft;           // the data bytes left in the current COBS block
+    unsigned char fOverflow;        // the frame is too long, it is dropped at the delimiter
+} FRAME_DECODER;
+
+unsigned short FRAME_Crc16(unsigned short wCrc, const void *pData, unsigned int cbLen);
+unsigned int FRAME_Encode(const void *pPayload, unsigned int cbPayload, unsigned char *pbOut);
+void FRAME_InitDecoder(FRAME_DECODER *pDec);
+int FRAME_DecodeByte(FRAME_DECODER *pDec, unsigned char bVal);
+const unsigned char *FRAME_GetPayload(FRAME_DECODER *pDec);
+
+//private functions:
+void FRAME_PutDecoded(FRAME_DECODER *pDec, unsigned char bVal);
+
+#endif /* _FRAME_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,208 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    gpio.c
+
+  @Description
+        This file groups the functions that implement the GPIO library.
+        The library accesses the digital pins through pin descriptors (port, bit), defined in config.h,
+        instead of one bit field per pin, so the board libraries (BTN, SWT, PMODS) can use constant pin tables:
+        - a group read takes a snapshot of each involved PORTx register once, then gathers the bits.
+        - the writes use the LATxSET / LATxCLR registers: no read-modify-write, so they are atomic
+          with respect to the interrupts. A group write is done with one SET and one CLR write per port.
+        Include the file in the project, together with config.h, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include "config.h"
+#include "gpio.h"
+
+/* ************************************************************************** */
+
+// the registers of a port
+typedef struct {
+    volatile unsigned int *pPORT;
+    volatile unsigned int *pLATSET;
+    volatile unsigned int *pLATCLR;
+    volatile unsigned int *pTRISSET;
+    volatile unsigned int *pTRISCLR;
+    volatile unsigned int *pANSELCLR;      // 0 for the ports without analog pins used on the board
+    volatile unsigned int *pCNPUSET;
+    volatile unsigned int *pCNPUCLR;
+    volatile unsigned int *pCNPDSET;
+    volatile unsigned int *pCNPDCLR;
+} GPIO_PORT_REGS;
+
+const GPIO_PORT_REGS rgGpioPorts[GPIO_NO_PORTS] = {
+    {&PORTA, &LATASET, &LATACLR, &TRISASET, &TRISACLR, 0, &CNPUASET, &CNPUACLR, &CNPDASET, &CNPDACLR},
+    {&PORTB, &LATBSET, &LATBCLR, &TRISBSET, &TRISBCLR, &ANSELBCLR, &CNPUBSET, &CNPUBCLR, &CNPDBSET, &CNPDBCLR},
+    {&PORTC, &LATCSET, &LATCCLR, &TRISCSET, &TRISCCLR, 0, &CNPUCSET, &CNPUCCLR, &CNPDCSET, &CNPDCCLR},
+    {&PORTD, &LATDSET, &LATDCLR, &TRISDSET, &TRISDCLR, &ANSELDCLR, &CNPUDSET, &CNPUDCLR, &CNPDDSET, &CNPDDCLR},
+    {&PORTE, &LATESET, &LATECLR, &TRISESET, &TRISECLR, &ANSELECLR, &CNPUESET, &CNPUECLR, &CNPDESET, &CNPDECLR},
+    {&PORTF, &LATFSET, &LATFCLR, &TRISFSET, &TRISFCLR, 0, &CNPUFSET, &CNPUFCLR, &CNPDFSET, &CNPDFCLR},
+    {&PORTG, &LATGSET, &LATGCLR, &TRISGSET, &TRISGCLR, &ANSELGCLR, &CNPUGSET, &CNPUGCLR, &CNPDGSET, &CNPDGCLR}
+};
+
+/* ------------------------------------------------------------ */
+/***	GPIO_GetValue
+**
+**	Parameters:
+**		GPIO_PIN pin        - the pin descriptor
+**
+**	Return Value:
+**		unsigned char   - the value of the pin (0 or 1)
+**
+**	Description:
+**		This function reads the value of a pin.
+**
+*/
+unsigned char GPIO_GetValue(GPIO_PIN pin)
+{
+    return (*rgGpioPorts[pin.bPort].pPORT >> pin.bBit) & 1;
+}
+
+/* ------------------------------------------------------------ */
+/***	GPIO_SetValue
+**
+**	Parameters:
+**		GPIO_PIN pin        - the pin descriptor
+**		unsigned char bVal  - the value: 0 - the pin is set to 0, other values - the pin is set to 1
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function sets the output latch of a pin, using the LATxSET / LATxCLR registers.
+**
+*/
+void GPIO_SetValue(GPIO_PIN pin, unsigned char bVal)
+{
+    if(bVal)
+    {
+        *rgGpioPorts[pin.bPort].pLATSET = 1 << pin.bBit;
+    }
+    else
+    {
+        *rgGpioPorts[pin.bPort].pLATCLR = 1 << pin.bBit;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	GPIO_GetGroupValue
+**
+**	Parameters:
+**		const GPIO_PIN *rgPins      - the pin descriptors
+**		unsigned char cntPins       - the number of pins, at most 32
+**
+**	Return Value:
+**		unsigned int    - the values of the pins: bit i is the value of rgPins[i]
+**
+**	Description:
+**		This function reads a group of pins. Each involved PORTx register is read only once,
+**      so the values are a consistent snapshot of each port.
+**
+*/
+unsigned int GPIO_GetGroupValue(const GPIO_PIN *rgPins, unsigned char cntPins)
+{
+    unsigned int rgPortVals[GPIO_NO_PORTS];
+    unsigned int uiRead = 0, uiResult = 0;
+    int i;
+    for(i = 0; i < cntPins; i++)
+    {
+        if(!(uiRead & (1 << rgPins[i].bPort)))
+        {
+            rgPortVals[rgPins[i].bPort] = *rgGpioPorts[rgPins[i].bPort].pPORT;
+            uiRead |= 1 << rgPins[i].bPort;
+        }
+        uiResult |= ((rgPortVals[rgPins[i].bPort] >> rgPins[i].bBit) & 1) << i;
+    }
+    return uiResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	GPIO_SetGroupValue
+**
+**	Parameters:
+**		const GPIO_PIN *rgPins      - the pin descriptors
+**		unsigned char cntPins       - the number of pins, at most 32
+**		unsigned int uiVal          - the values: bit i is assigned to rgPins[i]
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function sets the output latches of a group of pins. The set and clear masks are gathered
+**      for each port, then written with one LATxSET and one LATxCLR write per involved port.
+**
+*/
+void GPIO_SetGroupValue(const GPIO_PIN *rgPins, unsigned char cntPins, unsigned int uiVal)
+{
+    unsigned int rgSet[GPIO_NO_PORTS] = {0}, rgClr[GPIO_NO_PORTS] = {0};
+    int i;
+    for(i = 0; i < cntPins; i++, uiVal >>= 1)
+    {
+        if(uiVal & 1)
+        {
+            rgSet[rgPins[i].bPort] |= 1 << rgPins[i].bBit;
+        }
+        else
+        {
+            rgClr[rgPins[i].bPort] |= 1 << rgPins[i].bBit;
+        }
+    }
+    for(i = 0; i < GPIO_NO_PORTS; i++)
+    {
+        if(rgSet[i])
+        {
+            *rgGpioPorts[i].pLATSET = rgSet[i];
+        }
+        if(rgClr[i])
+        {
+            *rgGpioPorts[i].pLATCLR = rgClr[i];
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	GPIO_ConfigurePin
+**
+**	Parameters:
+**		GPIO_PIN pin                - the pin descriptor
+**		unsigned char bDir          - the direction: GPIO_DIR_OUTPUT or GPIO_DIR_INPUT
+**		unsigned char fPullup       - 1 to enable the pull-up, 0 to disable it
+**		unsigned char fPulldown     - 1 to enable the pull-down, 0 to disable it
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function configures a pin as digital input or output, with the specified pull-up and pull-down.
+**      The remappable peripheral output of the pin (RPxnR) is not changed.
+**
+*/
+void GPIO_ConfigurePin(GPIO_PIN pin, unsigned char bDir, unsigned char fPullup, unsigned char fPulldown)
+{
+    const GPIO_PORT_REGS *pRegs = &rgGpioPorts[pin.bPort];
+    unsigned int uiMask = 1 << pin.bBit;
+    if(pRegs->pANSELCLR)
+    {
+        *pRegs->pANSELCLR = uiMask;     // set pin as digital
+    }
+    *(bDir ? pRegs->pTRISSET : pRegs->pTRISCLR) = uiMask;
+    *(fPullup ? pRegs->pCNPUSET : pRegs->pCNPUCLR) = uiMask;
+    *(fPulldown ? pRegs->pCNPDSET : pRegs->pCNPDCLR) = uiMask;
+}
+
+/* *****************************************************************************
+ End of File
+ */
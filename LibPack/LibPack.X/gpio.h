@@ -0,0 +1,52 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    gpio.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the GPIO library (defined in gpio.c).
+        Include the file in the project when this library is needed.
+        Use #include "gpio.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _GPIO_H    /* Guard against multiple inclusion */
+#define _GPIO_H
+
+// ports, the same values as the CN library ports (CN_PORT_x)
+#define GPIO_PORT_A         0
+#define GPIO_PORT_B         1
+#define GPIO_PORT_C         2
+#define GPIO_PORT_D         3
+#define GPIO_PORT_E         4
+#define GPIO_PORT_F         5
+#define GPIO_PORT_G         6
+#define GPIO_NO_PORTS       7
+
+// pin directions, parameter of GPIO_ConfigurePin
+#define GPIO_DIR_OUTPUT     0
+#define GPIO_DIR_INPUT      1
+
+// a pin descriptor. The descriptors of the board pins are defined in config.h (pin_xxx),
+// to be used as initializers of constant tables: const GPIO_PIN rgPins[] = {pin_BTN_BTNU, ...};
+typedef struct {
+    unsigned char bPort;        // GPIO_PORT_x
+    unsigned char bBit;         // 0 - 15
+} GPIO_PIN;
+
+unsigned char GPIO_GetValue(GPIO_PIN pin);
+void GPIO_SetValue(GPIO_PIN pin, unsigned char bVal);
+unsigned int GPIO_GetGroupValue(const GPIO_PIN *rgPins, unsigned char cntPins);
+void GPIO_SetGroupValue(const GPIO_PIN *rgPins, unsigned char cntPins, unsigned int uiVal);
+void GPIO_ConfigurePin(GPIO_PIN pin, unsigned char bDir, unsigned char fPullup, unsigned char fPulldown);
+
+#endif /* _GPIO_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,399 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    hwres.c
+
+  @Description
+        This file groups the functions that implement the HWRES library.
+        The library keeps track of the hardware timers (Timer1 - Timer5), output compare
+        modules (OC1 - OC5) and DMA channels (DMA0 - DMA3) used by the other libraries, so that two libraries cannot
+        silently reprogram the same resource:
+        - a timer is allocated by each library using it, specifying the timebase (prescaler and period)
+          and whether the timer may be shared. Libraries requesting the same timebase may share the timer,
+          libraries adapting to any period (like MOT, that computes the PWM duty from PR3) share it as well.
+        - an output compare module is allocated by a single library, together with the timer it uses.
+        - a DMA channel is allocated by a single library. Each library uses fixed channels,
+          because it also defines the interrupt handlers of its channels.
+        Conflicts are detected at initialization and reported with an error code.
+        The library only does the bookkeeping, the timers, output compare modules and DMA channels
+        are still configured by the libraries that use them.
+        Include the file in the project, together with config.h, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include "config.h"
+#include "hwres.h"
+
+/* ************************************************************************** */
+
+// the timer allocation table
+typedef struct {
+    unsigned int uiOwners;          // the owners bits
+    unsigned int uiExclusive;       // the owners bits of the owners that do not accept sharing
+    unsigned int uiFixedPeriod;     // the owners bits of the owners that need the timebase below
+    unsigned char bPrescaler;       // the timebase: TCKPS value
+    unsigned int uiPeriod;          // the timebase: PR value
+} HWRES_TIMER;
+
+HWRES_TIMER rgTimers[HWRES_NO_TIMERS];
+
+// the output compare allocation table
+unsigned int rgOCOwners[HWRES_NO_OCS];
+unsigned char rgOCTimers[HWRES_NO_OCS];
+
+// the DMA channel allocation table
+unsigned int rgDMAOwners[HWRES_NO_DMAS];
+
+/* ------------------------------------------------------------ */
+/***	HWRES_AllocTimer
+**
+**	Parameters:
+**		unsigned char bTimer        - the timer number (1 - 5)
+**		unsigned int uiOwner        - the owner, one of HWRES_OWNER_xxx
+**		unsigned char bShare        - the sharing mode:
+**                                      HWRES_EXCLUSIVE - the timer is not shared
+**                                      HWRES_SHARED    - the timer is shared with owners requesting the same timebase
+**                                      HWRES_ANYPERIOD - the timer is shared with any non exclusive owner
+**		unsigned char bPrescaler    - the TCKPS value the owner will configure
+**		unsigned int uiPeriod       - the PR value the owner will configure
+**
+**	Return Value:
+**		unsigned char   HWRES_OK            - the timer was allocated, the caller configures it
+**                      HWRES_OK_SHARED     - the timer was allocated, it is already running with a compatible timebase
+**                                            configured by another owner, so the caller must not reconfigure it
+**                      HWRES_ERR_CONFLICT  - the timer is used by another owner with an incompatible configuration
+**                      HWRES_ERR_PARAM     - bTimer is not between 1 and 5
+**
+**	Description:
+**		This function allocates a timer to an owner. The allocation succeeds when:
+**      - the timer is not used by other owners, or
+**      - neither the caller nor the other owners require exclusive access, and either the caller
+**        adapts to any period (HWRES_ANYPERIOD), or the requested timebase is the one already in use,
+**        or all the other owners adapt to any period (in this case the caller sets the new timebase).
+**      If the owner already holds the timer, its previous allocation is replaced.
+**      The function is called by the libraries initialization functions, before the timer is configured.
+**
+*/
+unsigned char HWRES_AllocTimer(unsigned char bTimer, unsigned int uiOwner, unsigned char bShare, unsigned char bPrescaler, unsigned int uiPeriod)
+{
+    HWRES_TIMER *pTmr;
+    unsigned int uiOthers, uiStatus;
+    unsigned char bResult = HWRES_OK;
+
+    if(bTimer < 1 || bTimer > HWRES_NO_TIMERS)
+    {
+        return HWRES_ERR_PARAM;
+    }
+    pTmr = &rgTimers[bTimer - 1];
+
+    uiStatus = __builtin_disable_interrupts();
+    uiOthers = pTmr->uiOwners & ~uiOwner;
+    if(uiOthers)
+    {
+        if((bShare == HWRES_EXCLUSIVE) || (pTmr->uiExclusive & uiOthers))
+        {
+            bResult = HWRES_ERR_CONFLICT;
+        }
+        else if((bShare == HWRES_SHARED) &&
+                ((pTmr->bPrescaler != bPrescaler) || (pTmr->uiPeriod != uiPeriod)))
+        {
+            if(pTmr->uiFixedPeriod & uiOthers)
+            {
+                bResult = HWRES_ERR_CONFLICT;
+            }
+            else
+            {
+                // the other owners adapt to any period, the caller sets the timebase
+                pTmr->bPrescaler = bPrescaler;
+                pTmr->uiPeriod = uiPeriod;
+            }
+        }
+        else
+        {
+            bResult = HWRES_OK_SHARED;
+        }
+    }
+    else
+    {
+        // the caller is the only owner, it sets the timebase
+        pTmr->bPrescaler = bPrescaler;
+        pTmr->uiPeriod = uiPeriod;
+        pTmr->uiExclusive = 0;
+        pTmr->uiFixedPeriod = 0;
+    }
+
+    if(bResult != HWRES_ERR_CONFLICT)
+    {
+        pTmr->uiOwners |= uiOwner;
+        pTmr->uiExclusive &= ~uiOwner;
+        pTmr->uiFixedPeriod &= ~uiOwner;
+        if(bShare == HWRES_EXCLUSIVE)
+        {
+            pTmr->uiExclusive |= uiOwner;
+        }
+        if(bShare != HWRES_ANYPERIOD)
+        {
+            pTmr->uiFixedPeriod |= uiOwner;
+        }
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_ReleaseTimer
+**
+**	Parameters:
+**		unsigned char bTimer        - the timer number (1 - 5)
+**		unsigned int uiOwner        - the owner, one of HWRES_OWNER_xxx
+**
+**	Return Value:
+**		unsigned char   - the number of owners still using the timer
+**
+**	Description:
+**		This function releases a timer allocated by an owner.
+**      The caller should turn off the timer only if the function returns 0
+**      (no other owner uses the timer).
+**
+*/
+unsigned char HWRES_ReleaseTimer(unsigned char bTimer, unsigned int uiOwner)
+{
+    HWRES_TIMER *pTmr;
+    unsigned int uiOwners;
+    unsigned char cntOwners = 0;
+
+    if(bTimer < 1 || bTimer > HWRES_NO_TIMERS)
+    {
+        return 0;
+    }
+    pTmr = &rgTimers[bTimer - 1];
+    pTmr->uiOwners &= ~uiOwner;
+    pTmr->uiExclusive &= ~uiOwner;
+    pTmr->uiFixedPeriod &= ~uiOwner;
+
+    // count the remaining owners
+    for(uiOwners = pTmr->uiOwners; uiOwners; uiOwners &= uiOwners - 1)
+    {
+        cntOwners++;
+    }
+    return cntOwners;
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_GetTimerOwners
+**
+**	Parameters:
+**		unsigned char bTimer        - the timer number (1 - 5)
+**
+**	Return Value:
+**		unsigned int    - the owners bits (HWRES_OWNER_xxx) of the owners using the timer
+**                        0 if the timer is free or bTimer is not between 1 and 5
+**
+**	Description:
+**		This function returns the owners of a timer.
+**
+*/
+unsigned int HWRES_GetTimerOwners(unsigned char bTimer)
+{
+    if(bTimer < 1 || bTimer > HWRES_NO_TIMERS)
+    {
+        return 0;
+    }
+    return rgTimers[bTimer - 1].uiOwners;
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_AllocOC
+**
+**	Parameters:
+**		unsigned char bOC           - the output compare module number (1 - 5)
+**		unsigned int uiOwner        - the owner, one of HWRES_OWNER_xxx
+**		unsigned char bTimer        - the timer used as clock source (2 or 3).
+**                                      The timer must be allocated by the same owner.
+**
+**	Return Value:
+**		unsigned char   HWRES_OK            - the output compare module was allocated
+**                      HWRES_ERR_CONFLICT  - the output compare module is used by another owner,
+**                                            or the owner did not allocate the timer
+**                      HWRES_ERR_PARAM     - bOC is not between 1 and 5, or bTimer is not 2 or 3
+**
+**	Description:
+**		This function allocates an output compare module to an owner.
+**      Output compare modules are never shared.
+**
+*/
+unsigned char HWRES_AllocOC(unsigned char bOC, unsigned int uiOwner, unsigned char bTimer)
+{
+    unsigned int uiStatus;
+    unsigned char bResult = HWRES_OK;
+
+    if(bOC < 1 || bOC > HWRES_NO_OCS || (bTimer != 2 && bTimer != 3))
+    {
+        return HWRES_ERR_PARAM;
+    }
+
+    uiStatus = __builtin_disable_interrupts();
+    if((rgOCOwners[bOC - 1] & ~uiOwner) || !(rgTimers[bTimer - 1].uiOwners & uiOwner))
+    {
+        bResult = HWRES_ERR_CONFLICT;
+    }
+    else
+    {
+        rgOCOwners[bOC - 1] = uiOwner;
+        rgOCTimers[bOC - 1] = bTimer;
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_ReleaseOC
+**
+**	Parameters:
+**		unsigned char bOC           - the output compare module number (1 - 5)
+**		unsigned int uiOwner        - the owner, one of HWRES_OWNER_xxx
+**
+**	Return Value:
+**
+**	Description:
+**		This function releases an output compare module allocated by an owner.
+**
+*/
+void HWRES_ReleaseOC(unsigned char bOC, unsigned int uiOwner)
+{
+    if(bOC >= 1 && bOC <= HWRES_NO_OCS && rgOCOwners[bOC - 1] == uiOwner)
+    {
+        rgOCOwners[bOC - 1] = 0;
+        rgOCTimers[bOC - 1] = 0;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_GetOCOwner
+**
+**	Parameters:
+**		unsigned char bOC           - the output compare module number (1 - 5)
+**
+**	Return Value:
+**		unsigned int    - the owner (HWRES_OWNER_xxx) of the output compare module
+**                        0 if the output compare module is free or bOC is not between 1 and 5
+**
+**	Description:
+**		This function returns the owner of an output compare module.
+**
+*/
+unsigned int HWRES_GetOCOwner(unsigned char bOC)
+{
+    if(bOC < 1 || bOC > HWRES_NO_OCS)
+    {
+        return 0;
+    }
+    return rgOCOwners[bOC - 1];
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_AllocDMA
+**
+**	Parameters:
+**		unsigned char bChannel      - the DMA channel number (0 - 3)
+**		unsigned int uiOwner        - the owner, one of HWRES_OWNER_xxx
+**
+**	Return Value:
+**		unsigned char   HWRES_OK            - the DMA channel was allocated
+**                      HWRES_ERR_CONFLICT  - the DMA channel is used by another owner
+**                      HWRES_ERR_PARAM     - bChannel is not between 0 and 3
+**
+**	Description:
+**		This function allocates a DMA channel to an owner.
+**      DMA channels are never shared.
+**
+*/
+unsigned char HWRES_AllocDMA(unsigned char bChannel, unsigned int uiOwner)
+{
+    unsigned int uiStatus;
+    unsigned char bResult = HWRES_OK;
+
+    if(bChannel >= HWRES_NO_DMAS)
+    {
+        return HWRES_ERR_PARAM;
+    }
+
+    uiStatus = __builtin_disable_interrupts();
+    if(rgDMAOwners[bChannel] & ~uiOwner)
+    {
+        bResult = HWRES_ERR_CONFLICT;
+    }
+    else
+    {
+        rgDMAOwners[bChannel] = uiOwner;
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_ReleaseDMA
+**
+**	Parameters:
+**		unsigned char bChannel      - the DMA channel number (0 - 3)
+**		unsigned int uiOwner        - the owner, one of HWRES_OWNER_xxx
+**
+**	Return Value:
+**
+**	Description:
+**		This function releases a DMA channel allocated by an owner.
+**
+*/
+void HWRES_ReleaseDMA(unsigned char bChannel, unsigned int uiOwner)
+{
+    if(bChannel < HWRES_NO_DMAS && rgDMAOwners[bChannel] == uiOwner)
+    {
+        rgDMAOwners[bChannel] = 0;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	HWRES_GetDMAOwner
+**
+**	Parameters:
+**		unsigned char bChannel      - the DMA channel number (0 - 3)
+**
+**	Return Value:
+**		unsigned int    - the owner (HWRES_OWNER_xxx) of the DMA channel
+**                        0 if the DMA channel is free or bChannel is not between 0 and 3
+**
+**	Description:
+**		This function returns the owner of a DMA channel.
+**
+*/
+unsigned int HWRES_GetDMAOwner(unsigned char bChannel)
+{
+    if(bChannel >= HWRES_NO_DMAS)
+    {
+        return 0;
+    }
+    return rgDMAOwners[bChannel];
+}
+
+/* *****************************************************************************
+ End of File
+ */
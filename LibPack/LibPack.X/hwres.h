@@ -0,0 +1,63 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    hwres.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the HWRES library (defined in hwres.c).
+        Include the file in the project when this library is needed.
+        Use #include "hwres.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _HWRES_H    /* Guard against multiple inclusion */
+#define _HWRES_H
+
+// the number of hardware timers (Timer1 - Timer5) and output compare modules (OC1 - OC5)
+#define HWRES_NO_TIMERS     5
+#define HWRES_NO_OCS        5
+// the number of DMA channels (DMA0 - DMA3)
+#define HWRES_NO_DMAS       4
+
+// resource owners, one bit for each library
+#define HWRES_OWNER_SSD             0x0001
+#define HWRES_OWNER_SRV             0x0002
+#define HWRES_OWNER_AUDIO           0x0004
+#define HWRES_OWNER_MOT             0x0008
+#define HWRES_OWNER_RGBLED          0x0010
+#define HWRES_OWNER_STATEMACHINE    0x0020
+#define HWRES_OWNER_SPIBUS          0x0040
+#define HWRES_OWNER_UARTDRV         0x0080
+#define HWRES_OWNER_USER            0x8000
+
+// timer sharing modes
+#define HWRES_EXCLUSIVE     0   // the timer is not shared with any other owner
+#define HWRES_SHARED        1   // the timer is shared with owners requesting the same timebase (prescaler and period)
+#define HWRES_ANYPERIOD     2   // the timer is shared with any non exclusive owner, the owner adapts to the existing timebase
+
+// return values
+#define HWRES_OK            0x00    // the resource was allocated, the caller configures it
+#define HWRES_OK_SHARED     0x01    // the resource was allocated and is already configured by another owner, the caller must not reconfigure it
+#define HWRES_ERR_CONFLICT  0xFD    // the resource is used by another owner, with an incompatible configuration
+#define HWRES_ERR_PARAM     0xFC    // invalid resource number
+
+unsigned char HWRES_AllocTimer(unsigned char bTimer, unsigned int uiOwner, unsigned char bShare, unsigned char bPrescaler, unsigned int uiPeriod);
+unsigned char HWRES_ReleaseTimer(unsigned char bTimer, unsigned int uiOwner);
+unsigned int HWRES_GetTimerOwners(unsigned char bTimer);
+unsigned char HWRES_AllocOC(unsigned char bOC, unsigned int uiOwner, unsigned char bTimer);
+void HWRES_ReleaseOC(unsigned char bOC, unsigned int uiOwner);
+unsigned int HWRES_GetOCOwner(unsigned char bOC);
+unsigned char HWRES_AllocDMA(unsigned char bChannel, unsigned int uiOwner);
+void HWRES_ReleaseDMA(unsigned char bChannel, unsigned int uiOwner);
+unsigned int HWRES_GetDMAOwner(unsigned char bChannel);
+
+#endif /* _HWRES_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -11,8 +11,18 @@
         This file groups the functions that implement the I2C library.
         The library implements I2C access hardware interface I2C1. 
         The hardware interface I2C2 is not available on BasysMX3.
+        The timeouts are measured with the core timer (see utils.c): a bus event that does not complete
+        in I2C_TIMEOUT_US ends the transfer with a timeout error. After a timeout or a bus collision,
+        the bus is recovered (9 clock pulses and a stop condition), so a slave holding SDA low is released.
+        The results of the transfers are counted for each slave address.
         This library is used by ACL library, in order to implement I2C access.
-        Include the file in the project when this library is needed.
+        Two access modes are provided:
+        - asynchronous: the transactions (write, read, or write followed by a repeated start read) are queued
+          using I2C_Submit and executed by the I2C1 master interrupt handler, one event at a time.
+          The caller is notified by a callback and by the transaction status.
+        - blocking: I2C_Write and I2C_Read poll the I2C1 module. They wait for the queued transactions
+          to complete, then own the bus until the stop condition; meanwhile the new transactions stay queued.
+        Include the file in the project, together with utils.c, when this library is needed.
  
   @Author
     Cristian Fatu 
@@ -28,10 +38,131 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "i2c.h"
+#include "prof.h"
+#include "trace.h"
+#include "utils.h"
 
 /* ************************************************************************** */
 
-#define I2C_WAIT_TIMEOUT 0x0FFF
+#define I2C_QUEUE_MASK  (I2C_QUEUE_SIZE - 1)
+
+// states of the interrupt driven engine: the event expected by the interrupt handler
+#define I2C_ST_IDLE     0
+#define I2C_ST_START    1   // start or repeated start condition completed
+#define I2C_ST_ADDR     2   // address byte transmitted
+#define I2C_ST_WRITE    3   // data byte transmitted
+#define I2C_ST_READ     4   // data byte received
+#define I2C_ST_ACK      5   // acknowledge sequence completed
+#define I2C_ST_STOP     6   // stop condition completed
+#define I2C_ST_ABORT    7   // the transaction in progress timed out, it is being aborted
+
+// the transactions queue, the free running indexes are changed with interrupts disabled.
+// The transaction in progress is the one at the tail, it is removed when it completes.
+I2C_XFER *rgI2CQueue[I2C_QUEUE_SIZE];
+volatile unsigned int idxI2CHead = 0, idxI2CTail = 0;
+volatile unsigned char bI2CState = I2C_ST_IDLE;
+volatile unsigned char fI2CPolled = 0;      // the blocking functions own the bus
+unsigned char idxI2CByte, fI2CReadPhase, bI2CResult;
+unsigned int uiI2CDeadline;                 // the deadline of the bus event expected by the engine
+
+I2C_DEV_STATS rgI2CDevStats[I2C_NO_DEVICES];
+unsigned char cntI2CDevs = 0;
+unsigned int cntI2CRecoveries = 0;
+
+/* ------------------------------------------------------------ */
+/***	I2C1Handler
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the I2C1 interrupt handler. It is called after each master event (start, address or data byte
+**      transmitted, byte received, acknowledge, stop) and on bus collision, and advances the transaction
+**      in progress by one step. When the transaction completes, its callback is called from here.
+**      The priority is I2C_IPL (the IPL value below must match it).
+**
+*/
+void __ISR(_I2C_1_VECTOR, IPL4AUTO) I2C1Handler(void)
+{
+    I2C_XFER *pXfer = rgI2CQueue[idxI2CTail & I2C_QUEUE_MASK];
+    PROF_ISR_ENTER(PROF_ID_I2C1);
+    IFS1bits.I2C1MIF = 0;               // clear interrupt flag
+    if(I2C1STATbits.BCL)
+    {
+        // the module is idle after a bus collision, no stop condition is needed
+        I2C1STATbits.BCL = 0;
+        IFS1bits.I2C1BIF = 0;
+        I2C_Complete(I2C_ERR_BUSCOL);
+        PROF_ISR_EXIT(PROF_ID_I2C1);
+        return;
+    }
+    uiI2CDeadline = TimeDeadlineUs(I2C_TIMEOUT_US);
+    switch(bI2CState)
+    {
+        case I2C_ST_START:
+            I2C1TRN = (pXfer->bAddr << 1) | fI2CReadPhase;
+            bI2CState = I2C_ST_ADDR;
+            break;
+        case I2C_ST_ADDR:
+        case I2C_ST_WRITE:
+            if(I2C1STATbits.ACKSTAT)
+            {
+                bI2CResult = I2C_ERR_NACK;
+                I2C1CONbits.PEN = 1;    // initiate a stop condition
+                bI2CState = I2C_ST_STOP;
+            }
+            else if(fI2CReadPhase)
+            {
+                I2C1CONbits.RCEN = 1;   // receive the first byte
+                bI2CState = I2C_ST_READ;
+            }
+            else if(idxI2CByte < pXfer->cbWr)
+            {
+                I2C1TRN = pXfer->pbWr[idxI2CByte++];
+                bI2CState = I2C_ST_WRITE;
+            }
+            else if(pXfer->cbRd)
+            {
+                fI2CReadPhase = 1;
+                idxI2CByte = 0;
+                I2C1CONbits.RSEN = 1;   // initiate a repeated start condition
+                bI2CState = I2C_ST_START;
+            }
+            else
+            {
+                bI2CResult = I2C_OK;
+                I2C1CONbits.PEN = 1;
+                bI2CState = I2C_ST_STOP;
+            }
+            break;
+        case I2C_ST_READ:
+            pXfer->pbRd[idxI2CByte++] = I2C1RCV;
+            I2C1CONbits.ACKDT = (idxI2CByte == pXfer->cbRd);    // NACK the last byte
+            I2C1CONbits.ACKEN = 1;
+            bI2CState = I2C_ST_ACK;
+            break;
+        case I2C_ST_ACK:
+            if(idxI2CByte < pXfer->cbRd)
+            {
+                I2C1CONbits.RCEN = 1;
+                bI2CState = I2C_ST_READ;
+            }
+            else
+            {
+                bI2CResult = I2C_OK;
+                I2C1CONbits.PEN = 1;
+                bI2CState = I2C_ST_STOP;
+            }
+            break;
+        case I2C_ST_STOP:
+            I2C_Complete(bI2CResult);
+            break;
+    }
+    PROF_ISR_EXIT(PROF_ID_I2C1);
+}
 
 
 /* ------------------------------------------------------------ */
@@ -60,8 +191,220 @@ void I2C_Init(unsigned int i2cFreq)
     I2C1CONbits.ON = 1;     // Enable the I2C module and configure the SDA and 
                             //SCL pins as serial port pins
     I2C1CONbits.ACKEN = 1;
+
+    // the interrupts are enabled only while the queued transactions are executed
+    IEC1bits.I2C1MIE = 0;
+    IEC1bits.I2C1BIE = 0;
+    IPC8bits.I2C1IP = I2C_IPL;
+    IPC8bits.I2C1IS = 0;
+    IFS1bits.I2C1MIF = 0;
+    IFS1bits.I2C1BIF = 0;
+    macro_enable_interrupts();          // enable interrupts at CPU
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_Submit
+**
+**	Parameters:
+**		I2C_XFER *pXfer     - the transaction. The bAddr, pbWr, cbWr, pbRd, cbRd, pfCallback and pArg fields
+**                            must be filled by the caller.
+**
+**	Return Value:
+**      unsigned char   I2C_OK          the transaction was queued
+**                      I2C_ERR_FULL    the queue is full (I2C_QUEUE_SIZE transactions)
+**
+**	Description:
+**		This function queues a transaction, and starts it if the bus is idle. It returns immediately:
+**      the transaction status is I2C_PENDING until it completes, then the status is set to I2C_OK or to an error
+**      (I2C_ERR_NACK, I2C_ERR_BUSCOL) and the callback is called, from the I2C1 interrupt handler.
+**      A timeout (I2C_ERR_TIMEOUT) is detected by I2C_CheckTimeout, the callback is then called from its caller.
+**      The function can be called from the main context, from interrupt handlers and from the callbacks.
+**
+*/
+unsigned char I2C_Submit(I2C_XFER *pXfer)
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    if(idxI2CHead - idxI2CTail >= I2C_QUEUE_SIZE)
+    {
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+        return I2C_ERR_FULL;
+    }
+    pXfer->bStatus = I2C_PENDING;
+    rgI2CQueue[idxI2CHead++ & I2C_QUEUE_MASK] = pXfer;
+    if(bI2CState == I2C_ST_IDLE && !fI2CPolled)
+    {
+        I2C_StartNext();
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return I2C_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_Wait
+**
+**	Parameters:
+**		I2C_XFER *pXfer     - a transaction queued using I2C_Submit
+**
+**	Return Value:
+**      unsigned char   - the transaction status: I2C_OK, I2C_ERR_NACK, I2C_ERR_TIMEOUT or I2C_ERR_BUSCOL
+**
+**	Description:
+**		This function waits until the transaction completes, and returns its status.
+**      It must not be called from the callbacks or from interrupt handlers with priority I2C_IPL or higher.
+**
+*/
+unsigned char I2C_Wait(I2C_XFER *pXfer)
+{
+    while(pXfer->bStatus == I2C_PENDING)
+    {
+        I2C_CheckTimeout();
+    }
+    return pXfer->bStatus;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_IsIdle
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned char   - 1 if no transaction is queued or in progress, 0 otherwise
+**
+**	Description:
+**		This function checks if the asynchronous engine is idle.
+**
+*/
+unsigned char I2C_IsIdle()
+{
+    I2C_CheckTimeout();
+    return bI2CState == I2C_ST_IDLE && idxI2CHead == idxI2CTail;
 }
 
+/* ------------------------------------------------------------ */
+/***	I2C_CheckTimeout
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function aborts the transaction in progress if the expected bus event did not complete
+**      in I2C_TIMEOUT_US (for example a slave stretches the clock forever): the transaction ends with
+**      I2C_ERR_TIMEOUT, the bus is recovered and the next transaction is started.
+**      It is called by I2C_Wait and I2C_IsIdle. When only callbacks are used, it should be called periodically
+**      from the main loop (or from a SOFTTMR callback), so that a wedged slave does not stall the queue.
+**      It must not be called from interrupt handlers with priority I2C_IPL or higher.
+**
+*/
+void I2C_CheckTimeout()
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    if(bI2CState == I2C_ST_IDLE || bI2CState == I2C_ST_ABORT || !TimeDeadlineExpired(uiI2CDeadline))
+    {
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+        return;
+    }
+    // the interrupt handler is kept out until the next transaction is started
+    IEC1bits.I2C1MIE = 0;
+    IEC1bits.I2C1BIE = 0;
+    bI2CState = I2C_ST_ABORT;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    I2C_Complete(I2C_ERR_TIMEOUT);
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_GetDevStats
+**
+**	Parameters:
+**		unsigned char bAddr         - I2C address of the slave device
+**		I2C_DEV_STATS *pStats       - the structure where the counters are copied
+**
+**	Return Value:
+**      unsigned char   - 1 if the device was accessed since the counters were cleared, 0 otherwise
+**
+**	Description:
+**		This function copies the transfer counters of a slave device: the number of transfers, and the number
+**      of transfers that ended with NACK, timeout or bus collision.
+**      The first I2C_NO_DEVICES addresses accessed are counted.
+**
+*/
+unsigned char I2C_GetDevStats(unsigned char bAddr, I2C_DEV_STATS *pStats)
+{
+    unsigned char fFound = 0;
+    int i;
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    for(i = 0; i < cntI2CDevs; i++)
+    {
+        if(rgI2CDevStats[i].bAddr == bAddr)
+        {
+            *pStats = rgI2CDevStats[i];
+            fFound = 1;
+            break;
+        }
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return fFound;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_GetRecoveries
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned int    - the number of bus recoveries
+**
+**	Description:
+**		This function returns the number of bus recoveries done after timeouts and bus collisions.
+**
+*/
+unsigned int I2C_GetRecoveries()
+{
+    return cntI2CRecoveries;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_ClearStats
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function clears the counters of all the slave devices and the bus recoveries counter.
+**
+*/
+void I2C_ClearStats()
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    cntI2CDevs = 0;
+    cntI2CRecoveries = 0;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
 
 /* ------------------------------------------------------------ */
 /***	I2C_Write
@@ -78,11 +421,15 @@ void I2C_Init(unsigned int i2cFreq)
 **      unsigned char   0          success
 **                      0xFF        the slave address was not acknowledged by the device.
 **                      0xFE        timeout error
+**                      0xFD        bus collision
 **
 **	Description:
 **		This function writes a number of bytes to the specified I2C slave.
 **      It returns the status of the operation: success or I2C errors (the slave address 
 **      was not acknowledged by the device or timeout error).
+**      The function blocks until the transfer is done. It first waits for the queued transactions to complete,
+**      then owns the bus until the stop condition is sent (by this function or by I2C_Read),
+**      so it must not be called from interrupt handlers or from the I2C_Submit callbacks.
 **      This is a low-level function, so user should avoid calling it directly.
 **          
 */
@@ -90,22 +437,63 @@ unsigned char I2C_Write(unsigned char slaveAddress,
                         unsigned char* dataBuffer,
                         unsigned char bytesNumber,
                         unsigned char stopBit)
+{
+    unsigned char bResult;
+    I2C_AcquireBus();
+    bResult = I2C_WritePolled(slaveAddress, dataBuffer, bytesNumber, stopBit);
+    I2C_Account(slaveAddress, bResult);
+    if(bResult == I2C_ERR_TIMEOUT || bResult == I2C_ERR_BUSCOL)
+    {
+        I2C_RecoverBus();
+        I2C_ReleaseBus();
+    }
+    else if(stopBit)
+    {
+        I2C_ReleaseBus();
+    }
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_WritePolled
+**
+**	Parameters:
+**		unsigned char slaveAddress  - I2C address of the slave device.
+**      unsigned char* dataBuffer   - Pointer to a buffer storing the bytes to be transmitted.
+**      unsigned char bytesNumber   - Number of bytes to be transmitted.
+**      unsigned char stopBit       - Stop condition control.
+**
+**	Return Value:
+**      unsigned char   0           success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      0xFD        bus collision
+**
+**	Description:
+**		This function implements I2C_Write, by polling the I2C1 module.
+**      This is a low-level function called by I2C_Write, so user should avoid calling it directly.
+**          
+*/
+unsigned char I2C_WritePolled(unsigned char slaveAddress,
+                        unsigned char* dataBuffer,
+                        unsigned char bytesNumber,
+                        unsigned char stopBit)
 {
     unsigned char status = 0;
     unsigned char acknowledge = 0;
     unsigned char byte = 0;
-    int cnt_timeout;
     I2C1CONbits.SEN = 1;            //Initiate a start condition
-    cnt_timeout = 0;
-    while(I2C1CONbits.SEN && (++cnt_timeout < I2C_WAIT_TIMEOUT));   // Wait for start condition to complete
-    if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+    if(I2C_WaitClear(&I2C1CON, _I2C1CON_SEN_MASK))   // Wait for start condition to complete
     {
         return 0xFE;    // timeout error
     }            
+    if(I2C1STATbits.BCL)
+    {
+        I2C1STATbits.BCL = 0;
+        return 0xFD;    // bus collision
+    }
     I2C1TRN = slaveAddress << 1;    //RW bit set to 0
-    cnt_timeout = 0;
-    while(I2C1STATbits.TRSTAT && (++cnt_timeout < I2C_WAIT_TIMEOUT));   //Wait for transmission to complete 
-    if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+    if(I2C_WaitClear(&I2C1STAT, _I2C1STAT_TRSTAT_MASK))   //Wait for transmission to complete 
     {
         return 0xFE;    // timeout error
     }
@@ -115,9 +503,7 @@ unsigned char I2C_Write(unsigned char slaveAddress,
         for(byte = 0; byte < bytesNumber; byte++)
         {
             I2C1TRN = dataBuffer[byte];
-            cnt_timeout = 0;
-            while(I2C1STATbits.TRSTAT && (++cnt_timeout < I2C_WAIT_TIMEOUT)); // Wait for transmission to complete 
-            if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+            if(I2C_WaitClear(&I2C1STAT, _I2C1STAT_TRSTAT_MASK)) // Wait for transmission to complete 
             {
                 return 0xFE;    // timeout error
             }        
@@ -130,9 +516,7 @@ unsigned char I2C_Write(unsigned char slaveAddress,
     if(stopBit)
     {
         I2C1CONbits.PEN = 1;            //Initiate a stop condition
-        cnt_timeout = 0;
-        while(I2C1CONbits.PEN && (++cnt_timeout < I2C_WAIT_TIMEOUT));         //Wait for stop condition to complete
-        if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+        if(I2C_WaitClear(&I2C1CON, _I2C1CON_PEN_MASK))         //Wait for stop condition to complete
         {
             return 0xFE;    // timeout error
         }
@@ -153,33 +537,72 @@ unsigned char I2C_Write(unsigned char slaveAddress,
 **      unsigned char   0           Success
 **                      0xFF        the slave address was not acknowledged by the device.
 **                      0xFE        timeout error
+**                      0xFD        bus collision
 **
 **	Description:
 **		This function reads a number of bytes from the specified I2C slave.
 **      It returns the status of the operation: success or I2C errors (the slave address 
 **      was not acknowledged by the device or timeout error).
+**      The transfer starts with a repeated start condition, it is usually preceded by an I2C_Write call
+**      without stop condition. The function blocks until the stop condition is sent, then the queued
+**      transactions are started. It must not be called from interrupt handlers or from the I2C_Submit callbacks.
 **      This is a low-level function, so user should avoid calling it directly.
 **          
 */
 unsigned char I2C_Read(unsigned char slaveAddress,
                     unsigned char* dataBuffer,
                     unsigned char bytesNumber)
+{
+    unsigned char bResult;
+    I2C_AcquireBus();
+    bResult = I2C_ReadPolled(slaveAddress, dataBuffer, bytesNumber);
+    I2C_Account(slaveAddress, bResult);
+    if(bResult == I2C_ERR_TIMEOUT || bResult == I2C_ERR_BUSCOL)
+    {
+        I2C_RecoverBus();
+    }
+    I2C_ReleaseBus();
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_ReadPolled
+**
+**	Parameters:
+**		unsigned char slaveAddress  - I2C address of the slave device.
+**      unsigned char* dataBuffer   - Pointer to a buffer where received bytes will be placed.
+**      unsigned char bytesNumber   - Number of bytes to be read.
+**
+**	Return Value:
+**      unsigned char   0           Success
+**                      0xFF        the slave address was not acknowledged by the device.
+**                      0xFE        timeout error
+**                      0xFD        bus collision
+**
+**	Description:
+**		This function implements I2C_Read, by polling the I2C1 module.
+**      This is a low-level function called by I2C_Read, so user should avoid calling it directly.
+**          
+*/
+unsigned char I2C_ReadPolled(unsigned char slaveAddress,
+                    unsigned char* dataBuffer,
+                    unsigned char bytesNumber)
 {
     unsigned char status = 0;
     unsigned char acknowledge = 0;
     unsigned char byte = 0;
-    int cnt_timeout;
     I2C1CONbits.RSEN = 1;            // Initiate a start condition
-    cnt_timeout = 0;
-    while(I2C1CONbits.RSEN && (++cnt_timeout < I2C_WAIT_TIMEOUT));         //Wait for start condition to complete
-    if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+    if(I2C_WaitClear(&I2C1CON, _I2C1CON_RSEN_MASK))         //Wait for start condition to complete
     {
         return 0xFE;    // timeout error
     }
+    if(I2C1STATbits.BCL)
+    {
+        I2C1STATbits.BCL = 0;
+        return 0xFD;    // bus collision
+    }
     I2C1TRN = (slaveAddress << 1) + 1;
-    cnt_timeout = 0;
-    while(I2C1STATbits.TRSTAT && (++cnt_timeout < I2C_WAIT_TIMEOUT));     // Wait for reception to complete
-    if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+    if(I2C_WaitClear(&I2C1STAT, _I2C1STAT_TRSTAT_MASK))     // Wait for reception to complete
     {
         return 0xFE;    // timeout error
     }
@@ -197,17 +620,13 @@ unsigned char I2C_Read(unsigned char slaveAddress,
             {
                 I2C1CONbits.ACKDT = 0;
             }
-            cnt_timeout = 0;
-            while(I2C1CONbits.RCEN && (++cnt_timeout < I2C_WAIT_TIMEOUT));    //Wait for reception to complete
-            if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+            if(I2C_WaitClear(&I2C1CON, _I2C1CON_RCEN_MASK))    //Wait for reception to complete
             {
                 return 0xFE;    // timeout error
             }
             dataBuffer[byte] = I2C1RCV;
             I2C1CONbits.ACKEN = 1;
-            cnt_timeout = 0;
-            while(I2C1CONbits.ACKEN && (++cnt_timeout < I2C_WAIT_TIMEOUT));
-            if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+            if(I2C_WaitClear(&I2C1CON, _I2C1CON_ACKEN_MASK))
             {
                 return 0xFE;    // timeout error
             }
@@ -219,9 +638,7 @@ unsigned char I2C_Read(unsigned char slaveAddress,
     }
     I2C1CONbits.ACKEN = 1;          //Initiate Acknowledge sequence on SDAx and SCLx pins and transmit ACKDT data bit. Wait for Acknowledge sequence to complete 
     I2C1CONbits.PEN = 1;            //Initiate a stop condition 
-    cnt_timeout = 0;
-    while(I2C1CONbits.PEN && (++cnt_timeout < I2C_WAIT_TIMEOUT));         //Wait for stop condition to complete
-    if(cnt_timeout >= I2C_WAIT_TIMEOUT)
+    if(I2C_WaitClear(&I2C1CON, _I2C1CON_PEN_MASK))         //Wait for stop condition to complete
     {
         return 0xFE;    // timeout error
     }
@@ -248,9 +665,288 @@ unsigned char I2C_Read(unsigned char slaveAddress,
 */
 void I2C_Close()
 {
+    IEC1bits.I2C1MIE = 0;
+    IEC1bits.I2C1BIE = 0;
     I2C1CONbits.ON = 0;     //Disable the I2C module 
 }
 
+/* ------------------------------------------------------------ */
+/***	I2C_AcquireBus
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function waits until no queued transaction is in progress, then reserves the bus
+**      for the blocking functions. If the bus is already reserved, it returns immediately.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void I2C_AcquireBus()
+{
+    unsigned int uiStatus;
+    while(1)
+    {
+        I2C_CheckTimeout();
+        uiStatus = __builtin_disable_interrupts();
+        if(bI2CState == I2C_ST_IDLE)
+        {
+            fI2CPolled = 1;
+        }
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+        if(fI2CPolled)
+        {
+            return;
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_ReleaseBus
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function frees the bus reserved by I2C_AcquireBus, and starts the queued transactions.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void I2C_ReleaseBus()
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    fI2CPolled = 0;
+    I2C_StartNext();
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_StartNext
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function starts the transaction at the queue tail, by initiating a start condition.
+**      If the queue is empty, the engine becomes idle and the I2C1 interrupts are disabled.
+**      It is called when the engine is idle or when a transaction completes.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void I2C_StartNext()
+{
+    I2C_XFER *pXfer;
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    if(idxI2CHead == idxI2CTail || fI2CPolled)
+    {
+        bI2CState = I2C_ST_IDLE;
+        IEC1bits.I2C1MIE = 0;
+        IEC1bits.I2C1BIE = 0;
+    }
+    else
+    {
+        pXfer = rgI2CQueue[idxI2CTail & I2C_QUEUE_MASK];
+        TRACE_BEGIN(TRACE_SRC_I2C, pXfer->bAddr);
+        idxI2CByte = 0;
+        fI2CReadPhase = (!pXfer->cbWr && pXfer->cbRd);
+        bI2CState = I2C_ST_START;
+        uiI2CDeadline = TimeDeadlineUs(I2C_TIMEOUT_US);
+        IFS1bits.I2C1MIF = 0;
+        IFS1bits.I2C1BIF = 0;
+        IEC1bits.I2C1MIE = 1;
+        IEC1bits.I2C1BIE = 1;
+        I2C1CONbits.SEN = 1;            // initiate a start condition
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_Complete
+**
+**	Parameters:
+**		unsigned char bStatus       - the transaction status: I2C_OK or an I2C_ERR_xxx value
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function removes the transaction in progress from the queue, counts its result, recovers the bus
+**      after a timeout or a bus collision, sets the transaction status, calls its callback and starts the
+**      next transaction. It is called from the I2C1 interrupt handler, and from I2C_CheckTimeout.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void I2C_Complete(unsigned char bStatus)
+{
+    I2C_XFER *pXfer = rgI2CQueue[idxI2CTail & I2C_QUEUE_MASK];
+    idxI2CTail++;
+    TRACE_END(TRACE_SRC_I2C, bStatus);
+    I2C_Account(pXfer->bAddr, bStatus);
+    if(bStatus == I2C_ERR_TIMEOUT || bStatus == I2C_ERR_BUSCOL)
+    {
+        I2C_RecoverBus();
+    }
+    pXfer->bStatus = bStatus;
+    if(pXfer->pfCallback)
+    {
+        (*pXfer->pfCallback)(pXfer);
+    }
+    I2C_StartNext();
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_WaitClear
+**
+**	Parameters:
+**		volatile unsigned int *pReg - the I2C1 register (I2C1CON or I2C1STAT)
+**		unsigned int uiMask         - the bit(s) cleared by the hardware when the bus event completes
+**
+**	Return Value:
+**      unsigned char   - 0 if the bits were cleared, 1 if they are still set after I2C_TIMEOUT_US
+**
+**	Description:
+**		This function waits for a bus event of the blocking functions, with a core timer deadline.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char I2C_WaitClear(volatile unsigned int *pReg, unsigned int uiMask)
+{
+    unsigned int uiDeadline = TimeDeadlineUs(I2C_TIMEOUT_US);
+    while((*pReg & uiMask) && !TimeDeadlineExpired(uiDeadline));
+    return (*pReg & uiMask) != 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_RecoverBus
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**      unsigned char   - I2C_OK if both lines are high after the recovery, I2C_ERR_BUSCOL otherwise
+**
+**	Description:
+**		This function releases a slave that holds SDA low (for example after a transfer interrupted in the middle
+**      of a byte): the I2C1 module is disabled, and up to 9 clock pulses are generated on SCL (until SDA is released),
+**      followed by a stop condition. Then the module is enabled again. It takes about 100 us.
+**      The function uses pin related definitions from config.h file.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char I2C_RecoverBus()
+{
+    unsigned char i, bResult;
+    unsigned int uiDeadline;
+
+    I2C1CONbits.ON = 0;         // the pins are controlled by the port
+    lat_I2C_SCL = 0;
+    lat_I2C_SDA = 0;
+    tris_I2C_SCL = 1;           // the lines are driven low by making them outputs, released by making them inputs
+    tris_I2C_SDA = 1;
+    for(i = 0; i < 9 && !prt_I2C_SDA; i++)
+    {
+        tris_I2C_SCL = 0;
+        DelayUs(5);
+        tris_I2C_SCL = 1;
+        uiDeadline = TimeDeadlineUs(I2C_TIMEOUT_US);
+        while(!prt_I2C_SCL && !TimeDeadlineExpired(uiDeadline));   // the slave may stretch the clock
+        DelayUs(5);
+    }
+    // stop condition: SDA rises while SCL is high
+    tris_I2C_SCL = 0;
+    DelayUs(5);
+    tris_I2C_SDA = 0;
+    DelayUs(5);
+    tris_I2C_SCL = 1;
+    DelayUs(5);
+    tris_I2C_SDA = 1;
+    DelayUs(5);
+    bResult = (prt_I2C_SCL && prt_I2C_SDA) ? I2C_OK : I2C_ERR_BUSCOL;
+
+    I2C1STATbits.BCL = 0;
+    I2C1CONbits.ON = 1;
+    cntI2CRecoveries++;
+    return bResult;
+}
+
+/* ------------------------------------------------------------ */
+/***	I2C_Account
+**
+**	Parameters:
+**		unsigned char bAddr         - I2C address of the slave device
+**		unsigned char bStatus       - the result of the transfer
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function counts the result of a transfer in the counters of the slave device.
+**      If the device is not in the table and the table is full, the result is not counted.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void I2C_Account(unsigned char bAddr, unsigned char bStatus)
+{
+    I2C_DEV_STATS *pStats = 0;
+    int i;
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    for(i = 0; i < cntI2CDevs; i++)
+    {
+        if(rgI2CDevStats[i].bAddr == bAddr)
+        {
+            pStats = &rgI2CDevStats[i];
+            break;
+        }
+    }
+    if(!pStats && cntI2CDevs < I2C_NO_DEVICES)
+    {
+        pStats = &rgI2CDevStats[cntI2CDevs++];
+        pStats->bAddr = bAddr;
+        pStats->cntXfers = 0;
+        pStats->cntNack = 0;
+        pStats->cntTimeout = 0;
+        pStats->cntBusCol = 0;
+    }
+    if(pStats)
+    {
+        pStats->cntXfers++;
+        if(bStatus == I2C_ERR_NACK)
+        {
+            pStats->cntNack++;
+        }
+        else if(bStatus == I2C_ERR_TIMEOUT)
+        {
+            pStats->cntTimeout++;
+        }
+        else if(bStatus == I2C_ERR_BUSCOL)
+        {
+            pStats->cntBusCol++;
+        }
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
 /* *****************************************************************************
  End of File
  */
@@ -18,8 +18,54 @@
 #ifndef _I2C_H    /* Guard against multiple inclusion */
 #define _I2C_H
 
+// transaction status values
+#define I2C_OK              0
+#define I2C_PENDING         0x01    // the transaction is queued or in progress
+#define I2C_ERR_NACK        0xFF    // the slave address or a written byte was not acknowledged
+#define I2C_ERR_TIMEOUT     0xFE
+#define I2C_ERR_BUSCOL      0xFD    // bus collision (another master, or a stuck line)
+#define I2C_ERR_FULL        0xFC    // returned by I2C_Submit when the queue is full
+
+// the number of transactions that can be queued (must be a power of 2)
+#define I2C_QUEUE_SIZE      8
+// the priority of the I2C1 interrupt, the completion callbacks are called at this priority
+#define I2C_IPL             4
+// the maximum duration of a bus event (start, byte, acknowledge, stop), including clock stretching
+#define I2C_TIMEOUT_US      1000
+// the number of slave devices having transfer counters
+#define I2C_NO_DEVICES      8
+
+// an asynchronous transaction: the bytes of pbWr are written, then, after a repeated start,
+// the bytes of pbRd are read. One of the phases can be empty (cbWr or cbRd equal to 0).
+// The memory (including the buffers) is provided by the caller and must be valid until the transaction completes.
+typedef struct I2C_XFER {
+    unsigned char bAddr;                        // 7 bits slave address
+    unsigned char *pbWr;
+    unsigned char cbWr;
+    unsigned char *pbRd;
+    unsigned char cbRd;
+    void (*pfCallback)(struct I2C_XFER *pXfer); // called when the transaction completes (may be 0)
+    void *pArg;                                 // user data, not used by the library
+    volatile unsigned char bStatus;             // I2C_PENDING, then I2C_OK or an I2C_ERR_xxx value
+} I2C_XFER;
+
+// the transfer counters of a slave device
+typedef struct {
+    unsigned char bAddr;
+    unsigned int cntXfers;
+    unsigned int cntNack;
+    unsigned int cntTimeout;
+    unsigned int cntBusCol;
+} I2C_DEV_STATS;
 
 void I2C_Init(unsigned int clockFreq);
+unsigned char I2C_Submit(I2C_XFER *pXfer);
+unsigned char I2C_Wait(I2C_XFER *pXfer);
+unsigned char I2C_IsIdle();
+void I2C_CheckTimeout();
+unsigned char I2C_GetDevStats(unsigned char bAddr, I2C_DEV_STATS *pStats);
+unsigned int I2C_GetRecoveries();
+void I2C_ClearStats();
 unsigned char I2C_Write(unsigned char slaveAddress,
                         unsigned char* dataBuffer,
                         unsigned char bytesNumber,
@@ -30,6 +76,19 @@ unsigned char I2C_Read(unsigned char slaveAddress,
 
 void I2C_Close();
 
+//private functions:
+void I2C_AcquireBus();
+void I2C_ReleaseBus();
+void I2C_StartNext();
+void I2C_Complete(unsigned char bStatus);
+unsigned char I2C_WaitClear(volatile unsigned int *pReg, unsigned int uiMask);
+unsigned char I2C_RecoverBus();
+void I2C_Account(unsigned char bAddr, unsigned char bStatus);
+unsigned char I2C_WritePolled(unsigned char slaveAddress, unsigned char* dataBuffer,
+                        unsigned char bytesNumber, unsigned char stopBit);
+unsigned char I2C_ReadPolled(unsigned char slaveAddress, unsigned char* dataBuffer,
+                        unsigned char bytesNumber);
+
 //#ifdef __cplusplus
 //extern "C" {
 //#endif
@@ -0,0 +1,347 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    input.c
+
+  @Description
+        This file groups the functions that implement the INPUT library.
+        The library turns the buttons and switches into debounced events, without polling:
+        - the change notification interrupt (CN library) of the input pins restarts a debouncing soft timer
+          (SOFTTMR library), and records the time of the first edge.
+        - when the inputs are stable for INPUT_DEBOUNCE_MS, all the pins are sampled and a press or release
+          event is queued for each input that changed.
+        - while a button is held, a soft timer queues a long press event after INPUT_LONG_MS,
+          then a repeat event every INPUT_REPEAT_MS.
+        The events are queued from the soft timer callbacks only (single producer), and read by the main loop
+        using INPUT_GetEvent (single consumer), so the queue is lock-free. When no event is pending,
+        the main loop can wait for an interrupt (for example using _wait()) instead of polling the inputs.
+        The SOFTTMR library must be initialized (SOFTTMR_Init) before INPUT_Init is called.
+        Include the file in the project, together with btn.c, swt.c, gpio.c, cn.c, softtmr.c and utils.c, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include "config.h"
+#include "input.h"
+#include "btn.h"
+#include "swt.h"
+#include "cn.h"
+#include "gpio.h"
+#include "softtmr.h"
+#include "utils.h"
+
+/* ************************************************************************** */
+
+// the input pins, in the order of the inputs. The GPIO ports are the same as the CN ports.
+const GPIO_PIN rgInputPins[INPUT_NO_INPUTS] = {
+    pin_BTN_BTNU, pin_BTN_BTNL, pin_BTN_BTNC, pin_BTN_BTNR, pin_BTN_BTND,
+    pin_SWT_SWT0, pin_SWT_SWT1, pin_SWT_SWT2, pin_SWT_SWT3, pin_SWT_SWT4, pin_SWT_SWT5, pin_SWT_SWT6, pin_SWT_SWT7
+};
+
+// the input pins of each port, and the CN handlers registered for them
+unsigned int rgInputPortMasks[CN_NO_PORTS];
+unsigned char rgInputCN[CN_NO_PORTS];
+
+// the debounced state of the inputs (bit i for input i)
+volatile unsigned int uiInputState = 0;
+// the buttons that already sent the long press event
+volatile unsigned int uiInputLongSent = 0;
+// the time of the first edge since the last debouncing
+volatile unsigned int uiInputEdgeTime;
+
+SOFTTMR_TIMER tmrInputDebounce;
+SOFTTMR_TIMER rgInputHoldTmrs[INPUT_NO_BUTTONS];
+
+INPUT_EVENT rgInputEvents[INPUT_QUEUE_SIZE];
+volatile unsigned int idxInputHead = 0, idxInputTail = 0;
+volatile unsigned int cntInputLost = 0;
+
+/* ------------------------------------------------------------ */
+/***	INPUT_Init
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - 0 for success
+**                        CN_ERR_FULL if no change notification handler is available
+**
+**	Description:
+**		This function initializes the INPUT library: the buttons and switches pins are configured
+**      (BTN_Init, SWT_Init), the current state is sampled (no events are generated for it)
+**      and the change notifications of the input pins are enabled.
+**      The SOFTTMR library must be already initialized.
+**
+*/
+unsigned char INPUT_Init()
+{
+    int i;
+    BTN_Init();
+    SWT_Init();
+    for(i = 0; i < CN_NO_PORTS; i++)
+    {
+        rgInputPortMasks[i] = 0;
+        rgInputCN[i] = CN_ERR_FULL;
+    }
+    for(i = 0; i < INPUT_NO_INPUTS; i++)
+    {
+        rgInputPortMasks[rgInputPins[i].bPort] |= 1 << rgInputPins[i].bBit;
+    }
+    idxInputHead = 0;
+    idxInputTail = 0;
+    cntInputLost = 0;
+    uiInputLongSent = 0;
+    uiInputState = GPIO_GetGroupValue(rgInputPins, INPUT_NO_INPUTS);
+    for(i = 0; i < CN_NO_PORTS; i++)
+    {
+        if(rgInputPortMasks[i])
+        {
+            rgInputCN[i] = CN_Register(i, rgInputPortMasks[i], INPUT_CNHandler, 0);
+            if(rgInputCN[i] == CN_ERR_FULL)
+            {
+                INPUT_Close();
+                return CN_ERR_FULL;
+            }
+        }
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_GetEvent
+**
+**	Parameters:
+**		INPUT_EVENT *pEvent     - the structure where the oldest event is copied
+**
+**	Return Value:
+**		unsigned char   - 1 if an event was copied, 0 if the event queue is empty
+**
+**	Description:
+**		This function removes the oldest event from the event queue. It must be called only from the main loop.
+**
+*/
+unsigned char INPUT_GetEvent(INPUT_EVENT *pEvent)
+{
+    if(idxInputTail == idxInputHead)
+    {
+        return 0;
+    }
+    *pEvent = rgInputEvents[idxInputTail & (INPUT_QUEUE_SIZE - 1)];
+    __sync_synchronize();
+    idxInputTail++;
+    return 1;
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_GetState
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned int    - the debounced state of the inputs: bit i is 1 when input i (INPUT_BTNx, INPUT_SWT0 + i)
+**                        is pressed / on
+**
+**	Description:
+**		This function returns the debounced state of the inputs, without accessing the pins.
+**
+*/
+unsigned int INPUT_GetState()
+{
+    return uiInputState;
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_GetLostEvents
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned int    - the number of events dropped because the event queue was full
+**
+**	Description:
+**		This function returns the number of events that could not be queued.
+**
+*/
+unsigned int INPUT_GetLostEvents()
+{
+    return cntInputLost;
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_Close
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function disables the change notifications of the input pins and stops the soft timers.
+**      The events already queued can still be read.
+**
+*/
+void INPUT_Close()
+{
+    int i;
+    for(i = 0; i < CN_NO_PORTS; i++)
+    {
+        if(rgInputCN[i] != CN_ERR_FULL)
+        {
+            CN_Unregister(rgInputCN[i]);
+            rgInputCN[i] = CN_ERR_FULL;
+        }
+    }
+    SOFTTMR_Stop(&tmrInputDebounce);
+    for(i = 0; i < INPUT_NO_BUTTONS; i++)
+    {
+        SOFTTMR_Stop(&rgInputHoldTmrs[i]);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_CNHandler
+**
+**	Parameters:
+**		void *pCtx                  - not used
+**		unsigned int uiPort         - the port value
+**		unsigned int uiChanged      - the input pins that changed
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the change notification handler of the input pins. The time of the first edge is recorded,
+**      and the debouncing soft timer is (re)started, so it expires INPUT_DEBOUNCE_MS after the last edge.
+**      This is a low-level function called from the CN interrupt, so user should avoid calling it directly.
+**
+*/
+void INPUT_CNHandler(void *pCtx, unsigned int uiPort, unsigned int uiChanged)
+{
+    if(!SOFTTMR_IsActive(&tmrInputDebounce))
+    {
+        uiInputEdgeTime = TimeGetTicks();
+    }
+    SOFTTMR_Start(&tmrInputDebounce, INPUT_DEBOUNCE_MS, 0, INPUT_DebounceExpired, 0);
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_DebounceExpired
+**
+**	Parameters:
+**		void *pArg      - not used
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the callback of the debouncing soft timer: the inputs are sampled, and a press or release event
+**      is queued for each input that changed since the last debounced state. The hold timer of a pressed
+**      button is started, the one of a released button is stopped.
+**      This is a low-level function called by the SOFTTMR library, so user should avoid calling it directly.
+**
+*/
+void INPUT_DebounceExpired(void *pArg)
+{
+    unsigned int uiNew = GPIO_GetGroupValue(rgInputPins, INPUT_NO_INPUTS);
+    unsigned int uiChanged = uiNew ^ uiInputState;
+    int i;
+    uiInputState = uiNew;
+    for(i = 0; uiChanged; i++, uiChanged >>= 1)
+    {
+        if(!(uiChanged & 1))
+        {
+            continue;
+        }
+        INPUT_PushEvent(uiInputEdgeTime, (uiNew & (1 << i)) ? INPUT_EVT_PRESS : INPUT_EVT_RELEASE, i);
+        if(i < INPUT_NO_BUTTONS)
+        {
+            uiInputLongSent &= ~(1 << i);
+            if(uiNew & (1 << i))
+            {
+                SOFTTMR_Start(&rgInputHoldTmrs[i], INPUT_LONG_MS, INPUT_REPEAT_MS, INPUT_HoldExpired, (void *)i);
+            }
+            else
+            {
+                SOFTTMR_Stop(&rgInputHoldTmrs[i]);
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_HoldExpired
+**
+**	Parameters:
+**		void *pArg      - the button (INPUT_BTNx)
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the callback of the hold soft timer of a button: the first expiration queues
+**      the long press event, the next ones queue repeat events.
+**      This is a low-level function called by the SOFTTMR library, so user should avoid calling it directly.
+**
+*/
+void INPUT_HoldExpired(void *pArg)
+{
+    unsigned char bInput = (unsigned char)(unsigned int)pArg;
+    if(uiInputLongSent & (1 << bInput))
+    {
+        INPUT_PushEvent(TimeGetTicks(), INPUT_EVT_REPEAT, bInput);
+    }
+    else
+    {
+        uiInputLongSent |= 1 << bInput;
+        INPUT_PushEvent(TimeGetTicks(), INPUT_EVT_LONG, bInput);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	INPUT_PushEvent
+**
+**	Parameters:
+**		unsigned int uiTimestamp    - the time of the event, in core timer ticks
+**		unsigned char bType         - the event type (INPUT_EVT_xxx)
+**		unsigned char bInput        - the input
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function queues an event. If the queue is full, the event is counted as lost.
+**      It is called only from the soft timer callbacks, so there is a single producer.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void INPUT_PushEvent(unsigned int uiTimestamp, unsigned char bType, unsigned char bInput)
+{
+    INPUT_EVENT *pEvent;
+    if(idxInputHead - idxInputTail >= INPUT_QUEUE_SIZE)
+    {
+        cntInputLost++;
+        return;
+    }
+    pEvent = &rgInputEvents[idxInputHead & (INPUT_QUEUE_SIZE - 1)];
+    pEvent->uiTimestamp = uiTimestamp;
+    pEvent->bType = bType;
+    pEvent->bInput = bInput;
+    __sync_synchronize();
+    idxInputHead++;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,70 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    input.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the INPUT library (defined in input.c).
+        Include the file in the project when this library is needed.
+        Use #include "input.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _INPUT_H    /* Guard against multiple inclusion */
+#define _INPUT_H
+
+// the inputs: the bits of INPUT_GetState and the bInput field of the events
+#define INPUT_BTNU          0
+#define INPUT_BTNL          1
+#define INPUT_BTNC          2
+#define INPUT_BTNR          3
+#define INPUT_BTND          4
+#define INPUT_SWT0          5   // INPUT_SWT0 + i for switch i
+#define INPUT_NO_BUTTONS    5
+#define INPUT_NO_INPUTS     13
+
+// the debouncing time: the inputs must be stable this long after the last change, in ms
+#define INPUT_DEBOUNCE_MS   20
+// the time a button must be held before the long press event, in ms
+#define INPUT_LONG_MS       1000
+// the period of the repeat events, while a button is held after the long press event, in ms
+#define INPUT_REPEAT_MS     200
+
+// the number of events of the event queue (must be a power of 2)
+#define INPUT_QUEUE_SIZE    16
+
+// event types
+#define INPUT_EVT_PRESS     1   // a button is pressed, or a switch is turned on
+#define INPUT_EVT_RELEASE   2   // a button is released, or a switch is turned off
+#define INPUT_EVT_LONG      3   // a button is held for INPUT_LONG_MS
+#define INPUT_EVT_REPEAT    4   // a button is still held, every INPUT_REPEAT_MS after the long press event
+
+// an input event
+typedef struct {
+    unsigned int uiTimestamp;       // the core timer value (SYS_FRQ / 2): the first edge for press and release events
+    unsigned char bType;            // INPUT_EVT_xxx
+    unsigned char bInput;           // INPUT_BTNx, INPUT_SWT0 + i
+} INPUT_EVENT;
+
+unsigned char INPUT_Init();
+unsigned char INPUT_GetEvent(INPUT_EVENT *pEvent);
+unsigned int INPUT_GetState();
+unsigned int INPUT_GetLostEvents();
+void INPUT_Close();
+
+//private functions:
+void INPUT_CNHandler(void *pCtx, unsigned int uiPort, unsigned int uiChanged);
+void INPUT_DebounceExpired(void *pArg);
+void INPUT_HoldExpired(void *pArg);
+void INPUT_PushEvent(unsigned int uiTimestamp, unsigned char bType, unsigned char bInput);
+
+#endif /* _INPUT_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,641 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    irdalink.c
+
+  @Description
+        This file groups the functions that implement the IRDALINK library.
+        The library is a packet link over the IrDA module (UARTDRV_5 instance of the UARTDRV library, opened by
+        the IRDA library): the packets are framed by the FRAME library (COBS, CRC-16), numbered, acknowledged
+        and retransmitted (selective repeat):
+        - send: IRDALINK_Send copies a packet into the send window (IRDALINK_WINDOW packets), and returns
+          IRDALINK_ERR_FULL when the window is full. Each packet is transmitted, and transmitted again when it is
+          not acknowledged within the retransmit timeout. Only the packets that were not acknowledged are
+          transmitted again.
+        - receive: the packets received in the receive window are stored, acknowledged and delivered in order
+          by IRDALINK_Receive. The acknowledge contains the next expected sequence number and a bit for each
+          packet received after a missing one, so the sender does not retransmit them.
+        - reset: IRDALINK_Init sends IRDALINK_PKT_RESET packets, until the other board answers, and holds the
+          data packets meanwhile. A board that receives the reset maps the sequence numbers of the other board to
+          its receive window (the packets received in order and not delivered are kept), forgets the selective
+          acknowledges of its send window, and answers with its own send window position, so a board that runs
+          IRDALINK_Init again resumes the link without waiting for the other board to be reset.
+        The IrDA link is half duplex, and the receiver of a board also receives its own transmission: the frames
+        carry the address of the sender, the frames with the local address are dropped. The frames corrupted by
+        collisions are dropped by the CRC check and retransmitted.
+        A soft timer (SOFTTMR library) decodes the received bytes and transmits the packets every IRDALINK_POLL_MS,
+        so all the UARTDRV_5 accesses are done from the SOFTTMR context. The user functions only access the
+        windows.
+        The SOFTTMR library must be initialized (SOFTTMR_Init) before IRDALINK_Init is called.
+        Include the file in the project, together with IrDA.c, frame.c, uartdrv.c, hwres.c and softtmr.c, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <string.h>
+#include "config.h"
+#include "irdalink.h"
+#include "IrDA.h"
+#include "uartdrv.h"
+#include "frame.h"
+#include "softtmr.h"
+
+/* ************************************************************************** */
+
+#define IRDALINK_MASK       (IRDALINK_WINDOW - 1)
+// the header of the data packets: address, type, sequence number
+#define IRDALINK_HDR_BYTES  3
+
+// a packet of the send window or the receive window
+typedef struct {
+    unsigned char rgbData[IRDALINK_MAX_DATA];
+    unsigned char cbData;
+    volatile unsigned char fValid;  // send window: acknowledged, receive window: received and not delivered
+    unsigned char fSent;            // send window: transmitted at least once
+    unsigned int msSent;            // send window: the SOFTTMR ticks of the last transmission
+} IRDALINK_SLOT;
+
+// the send window holds the packets bIrdaLinkTxBase ... bIrdaLinkTxNext - 1, in the slot (sequence number & IRDALINK_MASK).
+// bIrdaLinkTxNext is changed by IRDALINK_Send, bIrdaLinkTxBase by the soft timer.
+IRDALINK_SLOT rgIrdaLinkTx[IRDALINK_WINDOW];
+volatile unsigned char bIrdaLinkTxBase, bIrdaLinkTxNext;
+
+// the receive window holds the packets bIrdaLinkRxDeliver ... bIrdaLinkRxDeliver + IRDALINK_WINDOW - 1.
+// bIrdaLinkRxNext is the first packet not received (the next expected), changed by the soft timer,
+// bIrdaLinkRxDeliver is the first packet not delivered, changed by IRDALINK_Receive.
+IRDALINK_SLOT rgIrdaLinkRx[IRDALINK_WINDOW];
+volatile unsigned char bIrdaLinkRxDeliver;
+unsigned char bIrdaLinkRxNext;
+unsigned char fIrdaLinkAckPending;
+// the received sequence numbers + bIrdaLinkRxOffset are the sequence numbers of the receive window
+unsigned char bIrdaLinkRxOffset;
+
+// IRDALINK_PKT_RESET is sent until it is answered, IRDALINK_PKT_RESET_ACK is pending after a reset is received
+unsigned char fIrdaLinkResetPending, fIrdaLinkResetSent, fIrdaLinkResetAckPending;
+unsigned int msIrdaLinkReset;
+
+unsigned char fIrdaLinkOpen;
+unsigned char bIrdaLinkAddr;
+unsigned int msIrdaLinkRetx;
+FRAME_DECODER decIrdaLink;
+unsigned char rgbIrdaLinkPkt[IRDALINK_HDR_BYTES + IRDALINK_MAX_DATA];
+unsigned char rgbIrdaLinkFrame[FRAME_MAX_ENCODED];
+IRDALINK_STATS statsIrdaLink;
+SOFTTMR_TIMER tmrIrdaLink;
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_Init
+**
+**	Parameters:
+**		unsigned int baud           - the baud rate of the IrDA link (for example 115200)
+**		unsigned char bAddr         - the address of this board, different from the address of the other board
+**
+**	Return Value:
+**		unsigned char   - IRDALINK_OK
+**                        IRDALINK_ERR_PARAM if the baud rate is not valid
+**
+**	Description:
+**		This function initializes the IRDA library (UARTDRV_5 instance, with DMA channels when available),
+**      resets the windows and the counters, and starts the soft timer of the link. The link is reset on the
+**      other board too (IRDALINK_PKT_RESET): the packets sent before it are transmitted once it answers.
+**      The packets of the other board not acknowledged before the reset are received again, including the ones
+**      this board received before IRDALINK_Init.
+**      The retransmit timeout is the time needed to transmit a full send window and an acknowledge at the
+**      baud rate, plus IRDALINK_RETX_MARGIN_MS.
+**
+*/
+unsigned char IRDALINK_Init(unsigned int baud, unsigned char bAddr)
+{
+    IRDALINK_Close();
+    if(IRDA_Init(baud) != UARTDRV_OK)
+    {
+        return IRDALINK_ERR_PARAM;
+    }
+    baud = UARTDRV_GetBaud(UARTDRV_5);
+    // 10 bits for each byte, the frame of a full packet is at most (header + data + 5) bytes
+    msIrdaLinkRetx = (IRDALINK_WINDOW + 1) * (IRDALINK_HDR_BYTES + IRDALINK_MAX_DATA + 5) * 10 * 1000 / baud +
+        IRDALINK_RETX_MARGIN_MS;
+    bIrdaLinkAddr = bAddr;
+    bIrdaLinkTxBase = 0;
+    bIrdaLinkTxNext = 0;
+    bIrdaLinkRxDeliver = 0;
+    bIrdaLinkRxNext = 0;
+    fIrdaLinkAckPending = 0;
+    bIrdaLinkRxOffset = 0;
+    fIrdaLinkResetPending = 1;
+    fIrdaLinkResetSent = 0;
+    fIrdaLinkResetAckPending = 0;
+    memset(rgIrdaLinkTx, 0, sizeof(rgIrdaLinkTx));
+    memset(rgIrdaLinkRx, 0, sizeof(rgIrdaLinkRx));
+    memset(&statsIrdaLink, 0, sizeof(statsIrdaLink));
+    FRAME_InitDecoder(&decIrdaLink);
+    fIrdaLinkOpen = 1;
+    SOFTTMR_Start(&tmrIrdaLink, IRDALINK_POLL_MS, IRDALINK_POLL_MS, IRDALINK_PollExpired, 0);
+    return IRDALINK_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_Send
+**
+**	Parameters:
+**		const void *pData           - the data of the packet
+**		unsigned int cbLen          - the data length, 1 to IRDALINK_MAX_DATA bytes
+**
+**	Return Value:
+**		unsigned char   - IRDALINK_OK if the packet was copied in the send window
+**                        IRDALINK_ERR_FULL if the send window is full (IRDALINK_WINDOW packets not acknowledged)
+**                        IRDALINK_ERR_PARAM if the length is not valid, or the link is not open
+**
+**	Description:
+**		This function queues a packet, it does not wait: the packet is transmitted by the soft timer, within
+**      IRDALINK_POLL_MS. The caller retries the packet when the window is full. A longer block (for example a
+**      configuration blob) is sent as consecutive packets, delivered in order by the other board.
+**
+*/
+unsigned char IRDALINK_Send(const void *pData, unsigned int cbLen)
+{
+    IRDALINK_SLOT *pSlot;
+    unsigned int uiStatus;
+    if(!fIrdaLinkOpen || !cbLen || cbLen > IRDALINK_MAX_DATA)
+    {
+        return IRDALINK_ERR_PARAM;
+    }
+    if((unsigned char)(bIrdaLinkTxNext - bIrdaLinkTxBase) >= IRDALINK_WINDOW)
+    {
+        return IRDALINK_ERR_FULL;
+    }
+    pSlot = &rgIrdaLinkTx[bIrdaLinkTxNext & IRDALINK_MASK];
+    memcpy(pSlot->rgbData, pData, cbLen);
+    pSlot->cbData = cbLen;
+    pSlot->fValid = 0;
+    pSlot->fSent = 0;
+    uiStatus = __builtin_disable_interrupts();
+    bIrdaLinkTxNext++;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return IRDALINK_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_GetFreeSlots
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - the number of packets that can be sent without waiting
+**
+**	Description:
+**		This function returns the free slots of the send window.
+**
+*/
+unsigned char IRDALINK_GetFreeSlots()
+{
+    return IRDALINK_WINDOW - (unsigned char)(bIrdaLinkTxNext - bIrdaLinkTxBase);
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_IsIdle
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - 1 if all the sent packets were acknowledged, 0 otherwise
+**
+**	Description:
+**		This function checks if the send window is empty.
+**
+*/
+unsigned char IRDALINK_IsIdle()
+{
+    return bIrdaLinkTxNext == bIrdaLinkTxBase;
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_Receive
+**
+**	Parameters:
+**		void *pData                 - the buffer for the data of the packet
+**		unsigned int cbMax          - the size of the buffer
+**
+**	Return Value:
+**		int     - the data length of the packet (> 0)
+**                IRDALINK_NONE if the next packet was not received
+**                IRDALINK_ERR_SIZE if the buffer is too small (the packet is kept)
+**
+**	Description:
+**		This function returns the next received packet, in the order of the sequence numbers. The slot is then
+**      free to receive the packet IRDALINK_WINDOW positions later, so the packets not read stop the sender
+**      when the receive window is full (the packets are not acknowledged, and retransmitted later).
+**
+*/
+int IRDALINK_Receive(void *pData, unsigned int cbMax)
+{
+    IRDALINK_SLOT *pSlot = &rgIrdaLinkRx[bIrdaLinkRxDeliver & IRDALINK_MASK];
+    unsigned int uiStatus;
+    int cbData;
+    if(!pSlot->fValid)
+    {
+        return IRDALINK_NONE;
+    }
+    cbData = pSlot->cbData;
+    if(cbData > cbMax)
+    {
+        return IRDALINK_ERR_SIZE;
+    }
+    memcpy(pData, pSlot->rgbData, cbData);
+    // the window moves and the slot is freed together, so the soft timer sees a consistent window
+    uiStatus = __builtin_disable_interrupts();
+    bIrdaLinkRxDeliver++;
+    pSlot->fValid = 0;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return cbData;
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_GetStats
+**
+**	Parameters:
+**		IRDALINK_STATS *pStats      - the structure filled with the counters
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function returns the counters of the link, since IRDALINK_Init.
+**
+*/
+void IRDALINK_GetStats(IRDALINK_STATS *pStats)
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    *pStats = statsIrdaLink;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_Close
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function stops the soft timer of the link and closes the IRDA library.
+**      The packets not acknowledged and the packets not delivered are dropped.
+**
+*/
+void IRDALINK_Close()
+{
+    if(!fIrdaLinkOpen)
+    {
+        return;
+    }
+    SOFTTMR_Stop(&tmrIrdaLink);
+    fIrdaLinkOpen = 0;
+    IRDA_Close();
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_PollExpired
+**
+**	Parameters:
+**		void *pArg      - not used
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the callback of the link soft timer: the received bytes are decoded and the packets processed,
+**      then the reset packets are transmitted (until the reset is answered, no acknowledge and no data packet
+**      is transmitted), then the pending acknowledge, then the data packets never transmitted or not acknowledged
+**      within the retransmit timeout. A frame is queued only when it fits in the transmit queue of UARTDRV_5,
+**      otherwise it is transmitted at the next call.
+**      This is a low-level function called by the SOFTTMR library, so user should avoid calling it directly.
+**
+*/
+void IRDALINK_PollExpired(void *pArg)
+{
+    unsigned char rgbRx[32];
+    unsigned int cb, i;
+    int cbPkt;
+    unsigned char bSeq, bSack;
+    IRDALINK_SLOT *pSlot;
+    unsigned int msNow = SOFTTMR_GetTicks() * SOFTTMR_TICK_MS;
+    while((cb = UARTDRV_Read(UARTDRV_5, rgbRx, sizeof(rgbRx))) != 0)
+    {
+        for(i = 0; i < cb; i++)
+        {
+            cbPkt = FRAME_DecodeByte(&decIrdaLink, rgbRx[i]);
+            if(cbPkt == FRAME_ERR_CRC)
+            {
+                statsIrdaLink.cntCrcErrors++;
+            }
+            else if(cbPkt == FRAME_ERR_FORMAT)
+            {
+                statsIrdaLink.cntFormatErrors++;
+            }
+            else if(cbPkt != FRAME_NONE)
+            {
+                IRDALINK_ProcessPacket(FRAME_GetPayload(&decIrdaLink), cbPkt);
+            }
+        }
+    }
+    if(fIrdaLinkResetAckPending && IRDALINK_SendPacket(IRDALINK_PKT_RESET_ACK, bIrdaLinkTxBase, 0, 0))
+    {
+        fIrdaLinkResetAckPending = 0;
+    }
+    if(fIrdaLinkResetPending)
+    {
+        if((!fIrdaLinkResetSent || msNow - msIrdaLinkReset >= msIrdaLinkRetx) &&
+            IRDALINK_SendPacket(IRDALINK_PKT_RESET, bIrdaLinkTxBase, 0, 0))
+        {
+            fIrdaLinkResetSent = 1;
+            msIrdaLinkReset = msNow;
+        }
+        return;
+    }
+    if(fIrdaLinkAckPending)
+    {
+        // bit i: the packet bIrdaLinkRxNext + 1 + i, if it is in the receive window
+        bSack = 0;
+        for(i = 0; i < 8; i++)
+        {
+            bSeq = bIrdaLinkRxNext + 1 + i;
+            if((unsigned char)(bSeq - bIrdaLinkRxDeliver) < IRDALINK_WINDOW && rgIrdaLinkRx[bSeq & IRDALINK_MASK].fValid)
+            {
+                bSack |= 1 << i;
+            }
+        }
+        if(IRDALINK_SendPacket(IRDALINK_PKT_ACK, bIrdaLinkRxNext - bIrdaLinkRxOffset, &bSack, 1))
+        {
+            fIrdaLinkAckPending = 0;
+        }
+    }
+    for(bSeq = bIrdaLinkTxBase; bSeq != bIrdaLinkTxNext; bSeq++)
+    {
+        pSlot = &rgIrdaLinkTx[bSeq & IRDALINK_MASK];
+        if(pSlot->fValid || (pSlot->fSent && msNow - pSlot->msSent < msIrdaLinkRetx))
+        {
+            continue;
+        }
+        if(!IRDALINK_SendPacket(IRDALINK_PKT_DATA, bSeq, pSlot->rgbData, pSlot->cbData))
+        {
+            break;
+        }
+        if(pSlot->fSent)
+        {
+            statsIrdaLink.cntRetransmits++;
+        }
+        else
+        {
+            statsIrdaLink.cntTxPackets++;
+        }
+        pSlot->fSent = 1;
+        pSlot->msSent = msNow;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_ProcessPacket
+**
+**	Parameters:
+**		const unsigned char *pbPkt  - the payload of a valid frame
+**		int cbPkt                   - the payload length
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function drops the packets sent by this board (the IrDA echo), and processes the other ones.
+**      The data and acknowledge packets are dropped until the reset of the link is answered, as their sequence
+**      numbers are not mapped yet.
+**      This is a low-level function called by IRDALINK_PollExpired, so user should avoid calling it directly.
+**
+*/
+void IRDALINK_ProcessPacket(const unsigned char *pbPkt, int cbPkt)
+{
+    if(cbPkt < 3)
+    {
+        statsIrdaLink.cntFormatErrors++;
+        return;
+    }
+    if(pbPkt[0] == bIrdaLinkAddr)
+    {
+        return;
+    }
+    if(pbPkt[1] == IRDALINK_PKT_RESET && cbPkt == 3)
+    {
+        // the other board answers with its send window position, and maps ours: the reset of this board is done
+        statsIrdaLink.cntResets++;
+        IRDALINK_ProcessReset(pbPkt[2]);
+        fIrdaLinkResetAckPending = 1;
+        fIrdaLinkResetPending = 0;
+    }
+    else if(pbPkt[1] == IRDALINK_PKT_RESET_ACK && cbPkt == 3)
+    {
+        // a late answer (to a reset already answered) is ignored: the mapping was done, and it is in use
+        if(fIrdaLinkResetPending)
+        {
+            IRDALINK_ProcessReset(pbPkt[2]);
+            fIrdaLinkResetPending = 0;
+        }
+    }
+    else if(fIrdaLinkResetPending)
+    {
+        return;
+    }
+    else if(pbPkt[1] == IRDALINK_PKT_DATA && cbPkt > IRDALINK_HDR_BYTES && cbPkt <= IRDALINK_HDR_BYTES + IRDALINK_MAX_DATA)
+    {
+        IRDALINK_ProcessData(pbPkt[2] + bIrdaLinkRxOffset, pbPkt + IRDALINK_HDR_BYTES, cbPkt - IRDALINK_HDR_BYTES);
+    }
+    else if(pbPkt[1] == IRDALINK_PKT_ACK && cbPkt == 4)
+    {
+        IRDALINK_ProcessAck(pbPkt[2], pbPkt[3]);
+    }
+    else
+    {
+        statsIrdaLink.cntFormatErrors++;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_ProcessAck
+**
+**	Parameters:
+**		unsigned char bNext         - the next sequence number expected by the other board
+**		unsigned char bSack         - the selective acknowledge bits
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function marks the acknowledged packets of the send window, and moves the window over the first
+**      acknowledged packets. An acknowledge outside the window (older than the window) is ignored.
+**      This is a low-level function called by IRDALINK_ProcessPacket, so user should avoid calling it directly.
+**
+*/
+void IRDALINK_ProcessAck(unsigned char bNext, unsigned char bSack)
+{
+    unsigned char bSeq, cbInFlight = bIrdaLinkTxNext - bIrdaLinkTxBase;
+    unsigned char i;
+    if((unsigned char)(bNext - bIrdaLinkTxBase) > cbInFlight)
+    {
+        return;
+    }
+    for(bSeq = bIrdaLinkTxBase; bSeq != bNext; bSeq++)
+    {
+        rgIrdaLinkTx[bSeq & IRDALINK_MASK].fValid = 1;
+    }
+    for(i = 0; i < 8; i++)
+    {
+        bSeq = bNext + 1 + i;
+        if((bSack & (1 << i)) && (unsigned char)(bSeq - bIrdaLinkTxBase) < cbInFlight)
+        {
+            rgIrdaLinkTx[bSeq & IRDALINK_MASK].fValid = 1;
+        }
+    }
+    while(bIrdaLinkTxBase != bIrdaLinkTxNext && rgIrdaLinkTx[bIrdaLinkTxBase & IRDALINK_MASK].fValid)
+    {
+        bIrdaLinkTxBase++;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_ProcessData
+**
+**	Parameters:
+**		unsigned char bSeq              - the sequence number of the packet
+**		const unsigned char *pbData     - the data
+**		unsigned int cbData             - the data length
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function stores a packet received in the receive window, and moves the next expected sequence
+**      number over the received packets. An acknowledge is transmitted for each data packet, including the
+**      duplicates, so that a lost acknowledge is repeated.
+**      This is a low-level function called by IRDALINK_ProcessPacket, so user should avoid calling it directly.
+**
+*/
+void IRDALINK_ProcessData(unsigned char bSeq, const unsigned char *pbData, unsigned int cbData)
+{
+    IRDALINK_SLOT *pSlot = &rgIrdaLinkRx[bSeq & IRDALINK_MASK];
+    fIrdaLinkAckPending = 1;
+    if((unsigned char)(bSeq - bIrdaLinkRxDeliver) >= IRDALINK_WINDOW)
+    {
+        // delivered, or beyond the window (the user did not read the packets)
+        if((unsigned char)(bIrdaLinkRxDeliver - bSeq) <= 128)
+        {
+            statsIrdaLink.cntDuplicates++;
+        }
+        return;
+    }
+    if(pSlot->fValid)
+    {
+        statsIrdaLink.cntDuplicates++;
+        return;
+    }
+    memcpy(pSlot->rgbData, pbData, cbData);
+    pSlot->cbData = cbData;
+    pSlot->fValid = 1;
+    statsIrdaLink.cntRxPackets++;
+    while((unsigned char)(bIrdaLinkRxNext - bIrdaLinkRxDeliver) < IRDALINK_WINDOW &&
+        rgIrdaLinkRx[bIrdaLinkRxNext & IRDALINK_MASK].fValid)
+    {
+        bIrdaLinkRxNext++;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_ProcessReset
+**
+**	Parameters:
+**		unsigned char bPeerBase         - the first packet of the send window of the other board
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function resynchronizes the link after the other board ran IRDALINK_Init (or answered the reset of
+**      this board). The sequence numbers of the other board are mapped to the next expected sequence number,
+**      so the packets received in order and not delivered are kept, and the packets received after a missing one
+**      are dropped (the other board will not retransmit them). The selective acknowledges of the send window are
+**      forgotten, so the packets not acknowledged in order are retransmitted.
+**      This is a low-level function called by IRDALINK_ProcessPacket, so user should avoid calling it directly.
+**
+*/
+void IRDALINK_ProcessReset(unsigned char bPeerBase)
+{
+    unsigned char bSeq;
+    for(bSeq = bIrdaLinkRxNext; (unsigned char)(bSeq - bIrdaLinkRxDeliver) < IRDALINK_WINDOW; bSeq++)
+    {
+        rgIrdaLinkRx[bSeq & IRDALINK_MASK].fValid = 0;
+    }
+    bIrdaLinkRxOffset = bIrdaLinkRxNext - bPeerBase;
+    for(bSeq = bIrdaLinkTxBase; bSeq != bIrdaLinkTxNext; bSeq++)
+    {
+        rgIrdaLinkTx[bSeq & IRDALINK_MASK].fValid = 0;
+    }
+    fIrdaLinkAckPending = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	IRDALINK_SendPacket
+**
+**	Parameters:
+**		unsigned char bType             - the packet type
+**		unsigned char bSeq              - the sequence number (data), the next expected sequence number (acknowledge)
+**                                        or the first packet of the send window (reset)
+**		const unsigned char *pbData     - the data, or the selective acknowledge byte (none for the reset)
+**		unsigned int cbData             - the data length
+**
+**	Return Value:
+**		unsigned char   - 1 if the frame was queued, 0 if the transmit queue of UARTDRV_5 has no room for it
+**
+**	Description:
+**		This function builds the packet, encodes the frame and queues it in UARTDRV_5, as a whole.
+**      This is a low-level function called by IRDALINK_PollExpired, so user should avoid calling it directly.
+**
+*/
+unsigned char IRDALINK_SendPacket(unsigned char bType, unsigned char bSeq, const unsigned char *pbData, unsigned int cbData)
+{
+    unsigned int cbFrame;
+    rgbIrdaLinkPkt[0] = bIrdaLinkAddr;
+    rgbIrdaLinkPkt[1] = bType;
+    rgbIrdaLinkPkt[2] = bSeq;
+    if(cbData)
+    {
+        memcpy(rgbIrdaLinkPkt + IRDALINK_HDR_BYTES, pbData, cbData);
+    }
+    cbFrame = FRAME_Encode(rgbIrdaLinkPkt, IRDALINK_HDR_BYTES + cbData, rgbIrdaLinkFrame);
+    if(UARTDRV_GetTxFree(UARTDRV_5) < cbFrame)
+    {
+        return 0;
+    }
+    UARTDRV_Write(UARTDRV_5, rgbIrdaLinkFrame, cbFrame);
+    return 1;
+}
+
+/* *****************************************************************************
+ End of File
+ */
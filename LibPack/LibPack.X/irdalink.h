@@ -0,0 +1,88 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    irdalink.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the IRDALINK library (defined in irdalink.c).
+        Include the file in the project when this library is needed.
+        Use #include "irdalink.h" in the source files where the functions are needed.
+
+        Packets (the payload of the FRAME library frames: COBS, CRC-16, 0x00 delimiter):
+            byte 0          the address of the sender (IRDALINK_Init), so that a board drops its own echoed frames
+            byte 1          packet type: IRDALINK_PKT_DATA, IRDALINK_PKT_ACK, IRDALINK_PKT_RESET or IRDALINK_PKT_RESET_ACK
+            IRDALINK_PKT_DATA:
+                byte 2          sequence number (modulo 256)
+                bytes 3 ..      the data, at most IRDALINK_MAX_DATA bytes
+            IRDALINK_PKT_ACK:
+                byte 2          the next expected sequence number: all the previous packets were received
+                byte 3          selective acknowledge: bit i is 1 if the packet (next expected + 1 + i) was received
+            IRDALINK_PKT_RESET (sent by IRDALINK_Init until it is answered), IRDALINK_PKT_RESET_ACK (the answer):
+                byte 2          the sequence number of the first packet of the send window of the sender: the other
+                                board maps it to its next expected sequence number
+ */
+/* ************************************************************************** */
+
+#ifndef _IRDALINK_H    /* Guard against multiple inclusion */
+#define _IRDALINK_H
+
+// the maximum data length of a packet, in bytes
+#define IRDALINK_MAX_DATA       128
+// the number of packets sent and not acknowledged (must be a power of 2, at most 8)
+#define IRDALINK_WINDOW         4
+// the period of the receive and retransmit processing, in ms
+#define IRDALINK_POLL_MS        1
+// added to the time needed to transmit a full window and the acknowledge, to get the retransmit timeout, in ms
+#define IRDALINK_RETX_MARGIN_MS 20
+
+// packet types
+#define IRDALINK_PKT_DATA       0x01
+#define IRDALINK_PKT_ACK        0x02
+#define IRDALINK_PKT_RESET      0x03
+#define IRDALINK_PKT_RESET_ACK  0x04
+
+// return values
+#define IRDALINK_OK             0
+#define IRDALINK_ERR_FULL       0xFC    // the send window is full
+#define IRDALINK_ERR_PARAM      0xFB    // invalid data length, or the link is not open
+// IRDALINK_Receive return values
+#define IRDALINK_NONE           -1      // no packet is available
+#define IRDALINK_ERR_SIZE       -2      // the buffer is too small for the next packet
+
+// the link counters
+typedef struct {
+    unsigned int cntTxPackets;      // the data packets sent for the first time
+    unsigned int cntRetransmits;    // the data packets sent again, because they were not acknowledged in time
+    unsigned int cntRxPackets;      // the data packets received in the window (stored to be delivered)
+    unsigned int cntDuplicates;     // the data packets received again (the acknowledge was lost)
+    unsigned int cntCrcErrors;      // the frames dropped because of the CRC
+    unsigned int cntFormatErrors;   // the frames dropped because they were truncated, too long or unknown
+    unsigned int cntResets;         // the link resets requested by the other board (IRDALINK_Init)
+} IRDALINK_STATS;
+
+unsigned char IRDALINK_Init(unsigned int baud, unsigned char bAddr);
+unsigned char IRDALINK_Send(const void *pData, unsigned int cbLen);
+unsigned char IRDALINK_GetFreeSlots();
+unsigned char IRDALINK_IsIdle();
+int IRDALINK_Receive(void *pData, unsigned int cbMax);
+void IRDALINK_GetStats(IRDALINK_STATS *pStats);
+void IRDALINK_Close();
+
+//private functions:
+void IRDALINK_PollExpired(void *pArg);
+void IRDALINK_ProcessPacket(const unsigned char *pbPkt, int cbPkt);
+void IRDALINK_ProcessAck(unsigned char bNext, unsigned char bSack);
+void IRDALINK_ProcessData(unsigned char bSeq, const unsigned char *pbData, unsigned int cbData);
+void IRDALINK_ProcessReset(unsigned char bPeerBase);
+unsigned char IRDALINK_SendPacket(unsigned char bType, unsigned char bSeq, const unsigned char *pbData, unsigned int cbData);
+
+#endif /* _IRDALINK_H */
+
+/* *****************************************************************************
+ End of File
+ */
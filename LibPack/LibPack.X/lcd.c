@@ -29,6 +29,7 @@
 #include <string.h>
 #include "config.h"
 #include "lcd.h"
+#include "utils.h"
 /* ************************************************************************** */
 
 /* ------------------------------------------------------------ */
@@ -116,10 +117,9 @@ void LCD_ConfigurePins()
 */
 void LCD_WriteByte(unsigned char bData)
 {
-    DelayAprox10Us(5);  
+    DelayUs(40);    // wait for the previous command to be executed (37 us)
 	// Configure IO Port data pins as output.
    tris_LCD_DATA &= ~msk_LCD_DATA;
-    DelayAprox10Us(5);  
 	// clear RW
 	lat_LCD_DISP_RW = 0;
 
@@ -127,16 +127,16 @@ void LCD_WriteByte(unsigned char bData)
     unsigned char *pLCDData = (unsigned char *)(0xBF886430);
     *pLCDData = bData;
 
-    DelayAprox10Us(10);   
+    DelayUs(1);     // address and data setup time
 
 	// Set En
 	lat_LCD_DISP_EN = 1;    
 
-    DelayAprox10Us(5);
+    DelayUs(1);     // enable pulse width (450 ns minimum)
 	// Clear En
 	lat_LCD_DISP_EN = 0;
 
-    DelayAprox10Us(5);
+    DelayUs(1);     // address and data hold time
 	// Set RW
 	lat_LCD_DISP_RW = 1;
 }
@@ -173,7 +173,7 @@ unsigned char LCD_ReadByte()
 	// Set En
 	lat_LCD_DISP_EN = 1;
 
-    DelayAprox10Us(50);   
+    DelayUs(1);     // data delay time (360 ns maximum)
 
     // Clear En
 	lat_LCD_DISP_EN = 0;
@@ -282,27 +282,21 @@ void LCD_WriteDataByte(unsigned char bData)
 void LCD_InitSequence(unsigned char bDisplaySetOptions)
 {
 	//	wait 40 ms
-
-	DelayAprox10Us(40000);
+	DelayMs(40);
 	// Function Set
 	LCD_WriteCommand(cmdLcdFcnInit);
-	// Wait ~100 us
-	DelayAprox10Us(10);
+	// Wait 100 us
+	DelayUs(100);
 	// Function Set
 	LCD_WriteCommand(cmdLcdFcnInit);
-	// Wait ~100 us
-	DelayAprox10Us(10);	// Display Set
+	// Wait 100 us
+	DelayUs(100);
+	// Display Set
 	LCD_DisplaySet(bDisplaySetOptions);
-	// Wait ~100 us
-	DelayAprox10Us(10);
-	// Display Clear
+	// Display Clear (waits 1.52 ms)
 	LCD_DisplayClear();
-	// Wait 1.52 ms
-	DelayAprox10Us(160);
     // Entry mode set
 	LCD_WriteCommand(cmdLcdEntryMode);
-    	// Wait 1.52 ms
-	DelayAprox10Us(160);
 }
 
 /* ------------------------------------------------------------ */
@@ -342,12 +336,13 @@ void LCD_DisplaySet(unsigned char bDisplaySetOptions)
 **		
 **	Description:
 **      Clears the display and returns the cursor home (upper left corner, position 0 on row 0). 
-**      
+**      The function waits for the command to be executed (1.52 ms).
 **          
 */
 void LCD_DisplayClear()
 {
 	LCD_WriteCommand(cmdLcdClear);
+	DelayUs(1520);
 }
 
 /* ------------------------------------------------------------ */
@@ -360,12 +355,13 @@ void LCD_DisplayClear()
 **		
 **	Description:
 **      Returns the cursor home (upper left corner, position 0 on row 0). 
-**      
+**      The function waits for the command to be executed (1.52 ms).
 **          
 */
 void LCD_ReturnHome()
 {
 	LCD_WriteCommand(cmdLcdRetHome);
+	DelayUs(1520);
 }
 
 /* ------------------------------------------------------------ */
@@ -0,0 +1,296 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    libpack.hpp
+
+  @Description
+        This file is an optional, header-only C++ layer over config.h, for C++ projects (xc32-g++, C++11).
+        The pins and peripherals are types, so everything known at compile time is resolved at compile time:
+        - Pin<Port, Bit>: each operation is a single SFR access (PORTx read, LATxSET / LATxCLR / LATxINV,
+          TRISxSET / TRISxCLR write). The board pins are declared from the config.h pin descriptors
+          using LIBPACK_PIN (for example LIBPACK_PIN(pin_BTN_BTNU)).
+        - Spi<N, Hz>: the SPI1 / SPI2 master, with the BRG value computed at compile time.
+        - Uart<N, Baud>: UART1 - UART5, with the BRG value and the BRGH bit computed at compile time,
+          and a static_assert when the baud rate error is above LIBPACK_UART_MAX_ERR_PERMILLE.
+        The remappable pins of the peripherals are not configured here: use the C libraries (for example
+        UART_ConfigurePins) or the rp_xxx definitions of config.h.
+        The C libraries can be used together with this layer.
+        Include the file in the C++ source files where it is needed. No source file needs to be added to the project.
+ */
+/* ************************************************************************** */
+
+#ifndef _LIBPACK_HPP    /* Guard against multiple inclusion */
+#define _LIBPACK_HPP
+
+#include <xc.h>
+#include "config.h"
+#include "gpio.h"
+
+// the maximum accepted UART baud rate error, in thousandths (the same as UARTDRV_MAX_ERR_PERMILLE)
+#define LIBPACK_UART_MAX_ERR_PERMILLE   25
+
+// a pin type from a config.h pin descriptor, for example: typedef LIBPACK_PIN(pin_BTN_BTNU) BtnU;
+#define LIBPACK_PIN(desc)   libpack::Pin<libpack::PinOf(desc).bPort, libpack::PinOf(desc).bBit>
+
+namespace libpack {
+
+/* ------------------------------------------------------------ */
+/*                          Pins                                */
+/* ------------------------------------------------------------ */
+
+// the registers of a port (P is GPIO_PORT_x). Each function is a single SFR access.
+template<unsigned char P> struct PortRegs;
+
+#define LIBPACK_PORT_REGS(x, ANSEL_CLR) \
+template<> struct PortRegs<GPIO_PORT_##x> { \
+    static unsigned int Read()                  { return PORT##x; } \
+    static void LatSet(unsigned int uiMask)     { LAT##x##SET = uiMask; } \
+    static void LatClr(unsigned int uiMask)     { LAT##x##CLR = uiMask; } \
+    static void LatInv(unsigned int uiMask)     { LAT##x##INV = uiMask; } \
+    static void TrisSet(unsigned int uiMask)    { TRIS##x##SET = uiMask; } \
+    static void TrisClr(unsigned int uiMask)    { TRIS##x##CLR = uiMask; } \
+    static void AnselClr(unsigned int uiMask)   { ANSEL_CLR; } \
+    static void CnpuSet(unsigned int uiMask)    { CNPU##x##SET = uiMask; } \
+    static void CnpuClr(unsigned int uiMask)    { CNPU##x##CLR = uiMask; } \
+    static void CnpdSet(unsigned int uiMask)    { CNPD##x##SET = uiMask; } \
+    static void CnpdClr(unsigned int uiMask)    { CNPD##x##CLR = uiMask; } \
+};
+
+// the ports without analog pins used on the board do not access ANSELx (see gpio.c)
+LIBPACK_PORT_REGS(A, (void)uiMask)
+LIBPACK_PORT_REGS(B, ANSELBCLR = uiMask)
+LIBPACK_PORT_REGS(C, (void)uiMask)
+LIBPACK_PORT_REGS(D, ANSELDCLR = uiMask)
+LIBPACK_PORT_REGS(E, ANSELECLR = uiMask)
+LIBPACK_PORT_REGS(F, (void)uiMask)
+LIBPACK_PORT_REGS(G, ANSELGCLR = uiMask)
+
+#undef LIBPACK_PORT_REGS
+
+// converts a config.h pin descriptor ({GPIO_PORT_x, bit}) to a constant expression
+constexpr GPIO_PIN PinOf(GPIO_PIN pin)
+{
+    return pin;
+}
+
+// a digital pin
+template<unsigned char P, unsigned char Bit>
+struct Pin {
+    static_assert(P < GPIO_NO_PORTS, "invalid port");
+    static_assert(Bit < 16, "invalid bit");
+    typedef PortRegs<P> Regs;
+    static constexpr unsigned int uiMask = 1u << Bit;
+
+    static bool Read()      { return (Regs::Read() & uiMask) != 0; }
+    static void Set()       { Regs::LatSet(uiMask); }
+    static void Clear()     { Regs::LatClr(uiMask); }
+    static void Toggle()    { Regs::LatInv(uiMask); }
+    static void Write(bool fVal)
+    {
+        if(fVal)
+        {
+            Set();
+        }
+        else
+        {
+            Clear();
+        }
+    }
+    static void MakeOutput()
+    {
+        Regs::AnselClr(uiMask);
+        Regs::TrisClr(uiMask);
+    }
+    static void MakeInput(bool fPullup = false, bool fPulldown = false)
+    {
+        Regs::AnselClr(uiMask);
+        Regs::TrisSet(uiMask);
+        if(fPullup)
+        {
+            Regs::CnpuSet(uiMask);
+        }
+        else
+        {
+            Regs::CnpuClr(uiMask);
+        }
+        if(fPulldown)
+        {
+            Regs::CnpdSet(uiMask);
+        }
+        else
+        {
+            Regs::CnpdClr(uiMask);
+        }
+    }
+};
+
+// the board pins
+typedef LIBPACK_PIN(pin_BTN_BTNU)   BtnU;
+typedef LIBPACK_PIN(pin_BTN_BTNL)   BtnL;
+typedef LIBPACK_PIN(pin_BTN_BTNC)   BtnC;
+typedef LIBPACK_PIN(pin_BTN_BTNR)   BtnR;
+typedef LIBPACK_PIN(pin_BTN_BTND)   BtnD;
+typedef LIBPACK_PIN(pin_SWT_SWT0)   Swt0;
+typedef LIBPACK_PIN(pin_SWT_SWT1)   Swt1;
+typedef LIBPACK_PIN(pin_SWT_SWT2)   Swt2;
+typedef LIBPACK_PIN(pin_SWT_SWT3)   Swt3;
+typedef LIBPACK_PIN(pin_SWT_SWT4)   Swt4;
+typedef LIBPACK_PIN(pin_SWT_SWT5)   Swt5;
+typedef LIBPACK_PIN(pin_SWT_SWT6)   Swt6;
+typedef LIBPACK_PIN(pin_SWT_SWT7)   Swt7;
+
+/* ------------------------------------------------------------ */
+/*                          SPI                                 */
+/* ------------------------------------------------------------ */
+
+// the registers of an SPI module (N is 1 or 2)
+template<int N> struct SpiRegs;
+
+#define LIBPACK_SPI_REGS(N) \
+template<> struct SpiRegs<N> { \
+    static volatile unsigned int &Con()     { return SPI##N##CON; } \
+    static volatile unsigned int &Con2()    { return SPI##N##CON2; } \
+    static volatile unsigned int &Stat()    { return SPI##N##STAT; } \
+    static volatile unsigned int &Buf()     { return SPI##N##BUF; } \
+    static volatile unsigned int &Brg()     { return SPI##N##BRG; } \
+};
+
+LIBPACK_SPI_REGS(1)
+LIBPACK_SPI_REGS(2)
+
+#undef LIBPACK_SPI_REGS
+
+// an SPI master, 8 bits transfers, at Hz (the closest lower frequency available)
+template<int N, unsigned long Hz>
+struct Spi {
+    typedef SpiRegs<N> Regs;
+    static_assert(Hz > 0 && Hz <= PB_FRQ / 2, "SPI frequency out of range");
+    static constexpr unsigned int uiBrg = (PB_FRQ + 2 * Hz - 1) / (2 * Hz) - 1;
+    static_assert(uiBrg <= 0x1FF, "SPI frequency too low for the BRG register");
+
+    // bPol - the clock polarity (CKP), bEdge - the clock edge (CKE), as in SPIJA_ConfigureSPI
+    static void Open(unsigned char bPol = 0, unsigned char bEdge = 1)
+    {
+        Regs::Con() = 0;                        // off, 8 bits, SMP = 0
+        Regs::Con2() = 0;                       // audio protocol disabled
+        Regs::Brg() = uiBrg;
+        Regs::Con() = _SPI1CON_MSTEN_MASK | (bPol ? _SPI1CON_CKP_MASK : 0) | (bEdge ? _SPI1CON_CKE_MASK : 0);
+        Regs::Con() |= _SPI1CON_ON_MASK;
+    }
+    static unsigned char Transfer(unsigned char bVal)
+    {
+        while(!(Regs::Stat() & _SPI1STAT_SPITBE_MASK));    // wait for TX buffer to be empty
+        Regs::Buf() = bVal;
+        while(!(Regs::Stat() & _SPI1STAT_SPIRBF_MASK));    // wait for the received byte
+        return Regs::Buf();
+    }
+    static void Close()
+    {
+        Regs::Con() = 0;
+    }
+};
+
+/* ------------------------------------------------------------ */
+/*                          UART                                */
+/* ------------------------------------------------------------ */
+
+// the registers of a UART module (N is 1 - 5)
+template<int N> struct UartRegs;
+
+#define LIBPACK_UART_REGS(N) \
+template<> struct UartRegs<N> { \
+    static volatile unsigned int &Mode()    { return U##N##MODE; } \
+    static volatile unsigned int &Sta()     { return U##N##STA; } \
+    static volatile unsigned int &TxReg()   { return U##N##TXREG; } \
+    static volatile unsigned int &RxReg()   { return U##N##RXREG; } \
+    static volatile unsigned int &Brg()     { return U##N##BRG; } \
+};
+
+LIBPACK_UART_REGS(1)
+LIBPACK_UART_REGS(2)
+LIBPACK_UART_REGS(3)
+LIBPACK_UART_REGS(4)
+LIBPACK_UART_REGS(5)
+
+#undef LIBPACK_UART_REGS
+
+// the rounded PB_FRQ / (divider * baud) (divider 16 when BRGH = 0, 4 when BRGH = 1), the BRG value + 1
+constexpr unsigned long UartBrgDiv(unsigned long ulBaud, unsigned long ulDiv)
+{
+    return (PB_FRQ + ulDiv * ulBaud / 2) / (ulDiv * ulBaud);
+}
+
+// the BRG value for a divider, limited to the register range (as UARTDRV_ComputeBrg)
+constexpr unsigned long UartBrg(unsigned long ulBaud, unsigned long ulDiv)
+{
+    return UartBrgDiv(ulBaud, ulDiv) == 0 ? 0 :
+            UartBrgDiv(ulBaud, ulDiv) > 0x10000 ? 0xFFFF : UartBrgDiv(ulBaud, ulDiv) - 1;
+}
+
+// the baud rate error for a divider, in baud
+constexpr unsigned long UartErr(unsigned long ulBaud, unsigned long ulDiv)
+{
+    return PB_FRQ / (ulDiv * (UartBrg(ulBaud, ulDiv) + 1)) > ulBaud ?
+                PB_FRQ / (ulDiv * (UartBrg(ulBaud, ulDiv) + 1)) - ulBaud :
+                ulBaud - PB_FRQ / (ulDiv * (UartBrg(ulBaud, ulDiv) + 1));
+}
+
+// a UART, 8 data bits, no parity, 1 stop bit, no flow control.
+// The divider with the smallest error is selected, the standard speed mode (BRGH = 0) when the errors are equal,
+// as UARTDRV_ComputeBrg does. Above PB_FRQ / 16 only the high speed mode (BRGH = 1) can reach the baud rate.
+template<int N, unsigned long Baud>
+struct Uart {
+    typedef UartRegs<N> Regs;
+    static_assert(Baud > 0 && Baud <= PB_FRQ / 4, "baud rate out of range: it must be 1 - PB_FRQ / 4");
+    // the baud rate used for the computations, kept in range so that only the static_assert above reports a bad value
+    static constexpr unsigned long ulBaud = Baud > 0 && Baud <= PB_FRQ / 4 ? Baud : PB_FRQ / 4;
+    static_assert(UartBrgDiv(ulBaud, 16) <= 0x10000, "baud rate too low for the BRG register");
+    static constexpr bool fBrgh = ulBaud > PB_FRQ / 16 || UartErr(ulBaud, 4) < UartErr(ulBaud, 16);
+    static constexpr unsigned long uiBrg = UartBrg(ulBaud, fBrgh ? 4 : 16);
+    static constexpr unsigned long uiErrPermille = UartErr(ulBaud, fBrgh ? 4 : 16) * 1000 / ulBaud;
+    static_assert(UartErr(ulBaud, fBrgh ? 4 : 16) <= ulBaud * LIBPACK_UART_MAX_ERR_PERMILLE / 1000,
+                  "baud rate error above LIBPACK_UART_MAX_ERR_PERMILLE for both BRGH settings");
+
+    static void Open()
+    {
+        Regs::Mode() = fBrgh ? _U1MODE_BRGH_MASK : 0;
+        Regs::Brg() = uiBrg;
+        Regs::Sta() = _U1STA_UTXEN_MASK | _U1STA_URXEN_MASK;
+        Regs::Mode() |= _U1MODE_ON_MASK;
+    }
+    static void PutChar(char ch)
+    {
+        while(Regs::Sta() & _U1STA_UTXBF_MASK);  // wait for space in the TX buffer
+        Regs::TxReg() = ch;
+    }
+    static bool IsRxAvailable()
+    {
+        return (Regs::Sta() & _U1STA_URXDA_MASK) != 0;
+    }
+    static unsigned char GetChar()
+    {
+        while(!IsRxAvailable());
+        return Regs::RxReg();
+    }
+    static void Close()
+    {
+        Regs::Mode() = 0;
+    }
+};
+
+// the board UARTs
+template<unsigned long Baud> struct UartUsb : Uart<4, Baud> {};     // UART library, over the USB - UART bridge
+template<unsigned long Baud> struct UartJb : Uart<1, Baud> {};      // UARTJB library, over JB2 / JB3
+template<unsigned long Baud> struct UartIrda : Uart<5, Baud> {};    // IRDA library
+
+} // namespace libpack
+
+#endif /* _LIBPACK_HPP */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,338 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    load.c
+
+  @Description
+        This file groups the functions that implement the LOAD library.
+        The library measures the CPU load: the main loop calls LOAD_Idle each time it has nothing to do
+        (SCHED_Run does it), and the number of calls in a LOAD_WINDOW_MS window is compared with the number
+        of calls measured by LOAD_Init on an idle CPU, with interrupts disabled, running the same idle loop
+        iteration as the main loop (for example SCHED_RunOnce followed by LOAD_Idle).
+        When PROF_ENABLE is defined, the time spent in the instrumented interrupt handlers is also accumulated
+        for each window (nested handlers are counted in both handlers).
+        The percentages are updated once per window, and can be shown on the SSD or on the LCD.
+        The core timer (see utils.c) is used as time base.
+        Include the file in the project, together with config.h and utils.c, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stdio.h>
+#include "config.h"
+#include "load.h"
+#include "utils.h"
+#include "prof.h"
+#include "ssd.h"
+#include "lcd.h"
+
+/* ************************************************************************** */
+
+#define LOAD_WINDOW_TICKS   (LOAD_WINDOW_MS * 1000 * TIME_TICKS_PER_US)
+#define LOAD_CALIB_TICKS    (LOAD_CALIB_MS * 1000 * TIME_TICKS_PER_US)
+
+unsigned int cntLoadIdle = 0;           // LOAD_Idle calls in the current window
+unsigned int cntLoadIdleBase = 0;       // LOAD_Idle calls in a window, on an idle CPU
+unsigned int uiLoadWindowStart;
+unsigned long long ullLoadIsrStart;
+unsigned char bLoadCpu = LOAD_UNKNOWN, bLoadIsr = LOAD_UNKNOWN;
+unsigned char fLoadUpdated = 0;
+unsigned char bLoadOverlay = LOAD_OVERLAY_NONE;
+
+/* ------------------------------------------------------------ */
+/***	LOAD_Init
+**
+**	Parameters:
+**		LOAD_IDLE_STEP pfIdleStep   - the function called by the main loop before LOAD_Idle (SCHED_RunOnce when
+**                                    the main loop is SCHED_Run), 0 if the main loop only calls LOAD_Idle
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function calibrates the idle baseline: the idle loop iteration of the main loop (pfIdleStep, then
+**      LOAD_Idle when pfIdleStep returns 0) runs during LOAD_CALIB_MS with interrupts disabled, and the number of
+**      LOAD_Idle calls is scaled to the window length. So an idle CPU is measured at 0 %, whatever the cost of
+**      pfIdleStep. Then the first measurement window is started.
+**      It should be called from main, after the other libraries are initialized and before events are posted.
+**
+*/
+void LOAD_Init(LOAD_IDLE_STEP pfIdleStep)
+{
+    unsigned int uiStatus, uiStart;
+
+    uiStatus = __builtin_disable_interrupts();
+    cntLoadIdle = 0;
+    uiStart = TimeGetTicks();
+    uiLoadWindowStart = uiStart;        // the window will not close during the calibration
+    while(TimeGetTicks() - uiStart < LOAD_CALIB_TICKS)
+    {
+        if(!pfIdleStep || !(*pfIdleStep)())
+        {
+            LOAD_Idle();
+        }
+    }
+    cntLoadIdleBase = cntLoadIdle * (LOAD_WINDOW_MS / LOAD_CALIB_MS);
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+
+    bLoadCpu = LOAD_UNKNOWN;
+    bLoadIsr = LOAD_UNKNOWN;
+    fLoadUpdated = 0;
+    cntLoadIdle = 0;
+    ullLoadIsrStart = LOAD_GetIsrTicks();
+    uiLoadWindowStart = TimeGetTicks();
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_Idle
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function counts an idle loop iteration, and closes the measurement window when it has elapsed.
+**      It must be called from the main loop, each time there is nothing to do
+**      (for example when SCHED_RunOnce returns 0). It must not be called from interrupt handlers.
+**
+*/
+void LOAD_Idle()
+{
+    unsigned int uiNow = TimeGetTicks();
+    cntLoadIdle++;
+    if(uiNow - uiLoadWindowStart >= LOAD_WINDOW_TICKS)
+    {
+        LOAD_CloseWindow(uiNow);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_GetCpuPercent
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - the CPU load of the last window, 0 - 100 %
+**                        LOAD_UNKNOWN before the first window ends
+**
+**	Description:
+**		This function returns the CPU load measured in the last window: the share of time not spent in LOAD_Idle.
+**      It includes the interrupt handlers and the main loop work.
+**
+*/
+unsigned char LOAD_GetCpuPercent()
+{
+    return bLoadCpu;
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_GetIsrPercent
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - the share of the last window spent in the instrumented interrupt handlers, 0 - 100 %
+**                        LOAD_UNKNOWN before the first window ends, or if PROF_ENABLE is not defined
+**
+**	Description:
+**		This function returns the interrupt handlers load measured in the last window,
+**      computed from the durations collected by the PROF library.
+**
+*/
+unsigned char LOAD_GetIsrPercent()
+{
+    return bLoadIsr;
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_IsUpdated
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - 1 if a window ended since the previous call, 0 otherwise
+**
+**	Description:
+**		This function can be used to print the percentages once per window.
+**
+*/
+unsigned char LOAD_IsUpdated()
+{
+    unsigned char fUpdated = fLoadUpdated;
+    fLoadUpdated = 0;
+    return fUpdated;
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_SetOverlay
+**
+**	Parameters:
+**		unsigned char bOverlay      - LOAD_OVERLAY_NONE, LOAD_OVERLAY_SSD or LOAD_OVERLAY_LCD
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function selects where the percentages are shown at the end of each window.
+**      The corresponding library (SSD or LCD) must be initialized by the user.
+**      The display is written from LOAD_Idle, in the main context.
+**
+*/
+void LOAD_SetOverlay(unsigned char bOverlay)
+{
+    bLoadOverlay = bOverlay;
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_CloseWindow
+**
+**	Parameters:
+**		unsigned int uiNow          - the core timer value at the end of the window
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function computes the percentages of the ended window, shows them if an overlay is selected,
+**      and starts a new window.
+**      This is a low-level function called by LOAD_Idle, so user should avoid calling it directly.
+**
+*/
+void LOAD_CloseWindow(unsigned int uiNow)
+{
+    unsigned int cntTicks = uiNow - uiLoadWindowStart;
+    unsigned long long ullIsr = LOAD_GetIsrTicks();
+    unsigned long long ullIdle;
+#ifdef PROF_ENABLE
+    unsigned long long ullPercent;
+#endif
+
+    // scale the baseline to the actual window length (the window may end late, after a long task)
+    ullIdle = (unsigned long long)cntLoadIdle * 100 * LOAD_WINDOW_TICKS / cntTicks;
+    if(!cntLoadIdleBase)
+    {
+        bLoadCpu = LOAD_UNKNOWN;
+    }
+    else
+    {
+        ullIdle /= cntLoadIdleBase;
+        bLoadCpu = ullIdle >= 100 ? 0 : 100 - ullIdle;
+    }
+#ifdef PROF_ENABLE
+    // PROF_Reset may have been called during the window
+    ullPercent = ullIsr >= ullLoadIsrStart ? (ullIsr - ullLoadIsrStart) * 100 / cntTicks : 0;
+    bLoadIsr = ullPercent >= 100 ? 100 : ullPercent;
+#endif
+    ullLoadIsrStart = ullIsr;
+    fLoadUpdated = 1;
+    LOAD_ShowOverlay();
+
+    // the overlay time is accounted in the new window
+    cntLoadIdle = 0;
+    uiLoadWindowStart = uiNow;
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_ShowOverlay
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function shows the percentages on the selected display:
+**      - SSD: C followed by the CPU load, for example "C 45"
+**      - LCD: "CPU xxx% ISR xxx%" on the second line ("--" for unknown values).
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void LOAD_ShowOverlay()
+{
+    char szLine[20], szIsr[5];
+    unsigned char bCpu = bLoadCpu;
+
+    if(bLoadOverlay == LOAD_OVERLAY_SSD)
+    {
+        if(bCpu == LOAD_UNKNOWN)
+        {
+            SSD_WriteDigits(0xFF, 0xFF, 0xFF, 12, 0, 0, 0, 0);
+        }
+        else
+        {
+            SSD_WriteDigits(bCpu % 10, bCpu >= 10 ? (bCpu / 10) % 10 : 0xFF, bCpu >= 100 ? 1 : 0xFF, 12, 0, 0, 0, 0);
+        }
+    }
+    else if(bLoadOverlay == LOAD_OVERLAY_LCD)
+    {
+        if(bLoadIsr == LOAD_UNKNOWN)
+        {
+            sprintf(szIsr, " --");
+        }
+        else
+        {
+            sprintf(szIsr, "%3u", bLoadIsr);
+        }
+        if(bCpu == LOAD_UNKNOWN)
+        {
+            sprintf(szLine, "CPU  --%% ISR%s%%", szIsr);
+        }
+        else
+        {
+            sprintf(szLine, "CPU %3u%% ISR%s%%", bCpu, szIsr);
+        }
+        LCD_WriteStringAtPos(szLine, 1, 0);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	LOAD_GetIsrTicks
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned long long  - the total time spent in the instrumented interrupt handlers, in core timer ticks
+**                            0 if PROF_ENABLE is not defined
+**
+**	Description:
+**		This function sums the durations collected by the PROF library for all the interrupt handlers.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned long long LOAD_GetIsrTicks()
+{
+    unsigned long long ullSum = 0;
+#ifdef PROF_ENABLE
+    PROF_STATS stats;
+    int i;
+    for(i = 0; i < PROF_NO_IDS; i++)
+    {
+        PROF_GetStats(i, &stats);
+        ullSum += stats.ullDurSum;
+    }
+#endif
+    return ullSum;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,53 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    load.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the LOAD library (defined in load.c).
+        Include the file in the project when this library is needed.
+        Use #include "load.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _LOAD_H    /* Guard against multiple inclusion */
+#define _LOAD_H
+
+// the measurement window
+#define LOAD_WINDOW_MS          1000
+// the calibration duration (the window baseline is extrapolated from it)
+#define LOAD_CALIB_MS           10
+
+// the value returned when a percentage is not available
+#define LOAD_UNKNOWN            0xFF
+
+// overlays
+#define LOAD_OVERLAY_NONE       0
+#define LOAD_OVERLAY_SSD        1   // the CPU load percentage, on the SSD
+#define LOAD_OVERLAY_LCD        2   // "CPU xxx% ISR xxx%", on the second LCD line
+
+// the work of the main loop before LOAD_Idle is called, for example SCHED_RunOnce: returns 0 when there was nothing to do
+typedef unsigned char (*LOAD_IDLE_STEP)();
+
+void LOAD_Init(LOAD_IDLE_STEP pfIdleStep);
+void LOAD_Idle();
+unsigned char LOAD_GetCpuPercent();
+unsigned char LOAD_GetIsrPercent();
+unsigned char LOAD_IsUpdated();
+void LOAD_SetOverlay(unsigned char bOverlay);
+
+//private functions:
+void LOAD_CloseWindow(unsigned int uiNow);
+void LOAD_ShowOverlay();
+unsigned long long LOAD_GetIsrTicks();
+
+#endif /* _LOAD_H */
+
+/* *****************************************************************************
+ End of File
+ */
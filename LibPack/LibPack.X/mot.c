@@ -38,6 +38,7 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "mot.h"
+#include "hwres.h"
 
 
 #define ROR( val, steps, noBits ) ( ( val >> steps ) | ( val << (noBits - steps ) ) ) 
@@ -52,7 +53,8 @@ unsigned char bMode = -1, bStepCfg = 0, bStepCfgNoBits = 1;
 **                                  0 - IN/IN mode
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if the initialization succeeded
+**                        HWRES_ERR_CONFLICT if, in PH/EN mode, Timer3, OC2 or OC3 are used by another library
 **
 **	Description:
 **		This function initializes the hardware involved in the MOT module, in a specific mode (PH/EN or IN/IN).   
@@ -61,8 +63,9 @@ unsigned char bMode = -1, bStepCfg = 0, bStepCfgNoBits = 1;
 **      For IN/IN mode, the stepper is initialized to work with 0b1100 value rotated one position over 4 bits, .
 **          
 */
-void MOT_Init(unsigned char bMode1)
+unsigned char MOT_Init(unsigned char bMode1)
 {
+    unsigned char bResult = HWRES_OK;
     bMode = bMode1;
     MOT_ConfigurePins();
     lat_MOT_MODE = bMode ? 1: 0;
@@ -72,8 +75,7 @@ void MOT_Init(unsigned char bMode1)
         // PH/EN mode
         rp_MOT_AIN2 = 0x0B; // AIN2 is set on OC2
         rp_MOT_BIN2 = 0x0B; // BIN2 is set on OC3
-        MOT_ConfigureOCs();
-
+        bResult = MOT_ConfigureOCs();
     }
     else
     {
@@ -84,6 +86,7 @@ void MOT_Init(unsigned char bMode1)
         // Step motor IN/IN mode
         MOT_InInInitStep (0x0C, 4); // 0b1100 rotated one position over 4 bits
     }
+    return bResult;
 }
 
 /* ------------------------------------------------------------ */
@@ -124,24 +127,36 @@ void MOT_ConfigurePins()
 **		
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if the initialization succeeded
+**                        HWRES_ERR_CONFLICT if Timer3, OC2 or OC3 are used by another library
 **
 **	Description:
 **		This function configures the OC2 and OC3 to work together with Timer3 
 **      in order to generate PWM in PH/EN mode.
 **      This is a low-level function called by MOT_Init(), so user should avoid calling it directly.
-        MOT library in mode PH/EN shares the Timer3 with AUDIO library.
-**      If the Timer3 is ON (initialized by AUDIO module), then Timer3 is not altered. 
+**      MOT library in mode PH/EN shares the Timer3 with AUDIO library.
+**      Timer3 is allocated using the HWRES library, accepting any period.
+**      If the Timer3 is used by AUDIO library, then Timer3 is not altered. 
 **      The MOT library will use the AUDIO timer frequencies (16 kHz or 48 kHz).
-**      If the Timer3 is OFF, then Timer3 is initialized at a frequency of 20kHz.
+**      Otherwise Timer3 is initialized at a frequency of 20kHz.
 **      The timer period constant is computed using TMR_FREQ_MOT definition (located in this source file)
 **      and peripheral bus frequency definition (PB_FRQ, located in config.h).
 **
 */
-void MOT_ConfigureOCs()
+unsigned char MOT_ConfigureOCs()
 {
-    unsigned char fTimer3Initialized = T3CONbits.ON;
-    if(!fTimer3Initialized)
+    unsigned int uiPR3 = (int)((float)((float)PB_FRQ/TMR_FREQ_MOT) + 0.5);
+    unsigned char bResult = HWRES_AllocTimer(3, HWRES_OWNER_MOT, HWRES_ANYPERIOD, 0, uiPR3);
+    if(bResult == HWRES_ERR_CONFLICT)
+    {
+        return HWRES_ERR_CONFLICT;
+    }
+    if(HWRES_AllocOC(2, HWRES_OWNER_MOT, 3) != HWRES_OK || HWRES_AllocOC(3, HWRES_OWNER_MOT, 3) != HWRES_OK)
+    {
+        MOT_Close();
+        return HWRES_ERR_CONFLICT;
+    }
+    if(bResult == HWRES_OK)
     {
         // configure Timer3
         T3CONbits.TCKPS = 0;    // 1:1 prescale value
@@ -149,8 +164,7 @@ void MOT_ConfigureOCs()
         T3CONbits.TCS = 0;      // PCBLK input (the default)
         T3CONbits.ON = 1;       // turn on Timer3
 
-        PR3 = (int)((float)((float)PB_FRQ/TMR_FREQ_MOT) + 0.5);               
-
+        PR3 = uiPR3;
     }
     // Configure Output Compare Module 2
    OC2CONbits.ON = 0;       // Turn off OC2 while doing setup.
@@ -163,6 +177,7 @@ void MOT_ConfigureOCs()
    OC3CONbits.OCM = 6;      // PWM mode on OC3; Fault pin is disabled
    OC3CONbits.OCTSEL = 1;   // Timer3 is the clock source for this Output Compare module
    OC3CONbits.ON = 1;       // Start the OC3 module
+   return HWRES_OK;
 }
 
 /* ------------------------------------------------------------ */
@@ -338,16 +353,27 @@ void MOT_InInPerformStep(int noSteps, unsigned char bDir)
 **	Description:
 **		This functions releases the hardware involved in MOT library: 
 **      it turns off the OC2, OC3 and Timer3 interfaces.
-**      
+**      Timer3 is turned off only if it is not used by other libraries (AUDIO).
 **          
 */
 void MOT_Close()
 {
     if(bMode)
     {
-        OC2CONbits.ON = 0;       // Stop the OC2 module
-        OC3CONbits.ON = 0;       // Stop the OC3 module   
-        T3CONbits.ON = 0;        // turn off Timer3
+        if(HWRES_GetOCOwner(2) == HWRES_OWNER_MOT)
+        {
+            OC2CONbits.ON = 0;       // Stop the OC2 module
+            HWRES_ReleaseOC(2, HWRES_OWNER_MOT);
+        }
+        if(HWRES_GetOCOwner(3) == HWRES_OWNER_MOT)
+        {
+            OC3CONbits.ON = 0;       // Stop the OC3 module   
+            HWRES_ReleaseOC(3, HWRES_OWNER_MOT);
+        }
+        if((HWRES_GetTimerOwners(3) & HWRES_OWNER_MOT) && !HWRES_ReleaseTimer(3, HWRES_OWNER_MOT))
+        {
+            T3CONbits.ON = 0;        // turn off Timer3
+        }
     }
 }
 /* *****************************************************************************
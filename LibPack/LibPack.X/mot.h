@@ -18,7 +18,7 @@
 #ifndef _MOT_H    /* Guard against multiple inclusion */
 #define _MOT_H
 
-void MOT_Init(unsigned char bMode1);
+unsigned char MOT_Init(unsigned char bMode1);
 void MOT_SetPhEnMotor1(unsigned char bDir, unsigned char bSpeed);
 void MOT_SetPhEnMotor2(unsigned char bDir, unsigned char bSpeed);
 void MOT_SetMode(unsigned char bMode);
@@ -27,7 +27,7 @@ void MOT_InInPerformStep(int noSteps, unsigned char bDir);
 void MOT_Close();
 
 //Private functions
-void MOT_ConfigureOCs();
+unsigned char MOT_ConfigureOCs();
 void MOT_ConfigurePins();
 unsigned short MOT_PhEnComputeOCFromSpeed(unsigned char bSpeed);
 
@@ -11,7 +11,7 @@
         This file groups the functions that implement the PMODS library.
         Pins from PMODA and PMODB can be initialized as digital input / output pins, 
         their value can be accessed using set / get functions
-        Include the file in the project, together with config.h when this library is needed.
+        Include the file in the project, together with config.h and gpio.c when this library is needed.
  
   @Author
     Cristian Fatu 
@@ -28,6 +28,19 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "pmods.h"
+#include "gpio.h"
+
+// the pins of PMODA and PMODB, in the order of the group values: 1, 2, 3, 4, 7, 8, 9, 10
+const GPIO_PIN rgPmodsPins[2][8] = {
+    {pin_PMODS_JA1, pin_PMODS_JA2, pin_PMODS_JA3, pin_PMODS_JA4, pin_PMODS_JA7, pin_PMODS_JA8, pin_PMODS_JA9, pin_PMODS_JA10},
+    {pin_PMODS_JB1, pin_PMODS_JB2, pin_PMODS_JB3, pin_PMODS_JB4, pin_PMODS_JB7, pin_PMODS_JB8, pin_PMODS_JB9, pin_PMODS_JB10}
+};
+
+// the remappable output registers of the pins
+volatile unsigned int * const rgPmodsRP[2][8] = {
+    {&rp_PMODS_JA1, &rp_PMODS_JA2, &rp_PMODS_JA3, &rp_PMODS_JA4, &rp_PMODS_JA7, &rp_PMODS_JA8, &rp_PMODS_JA9, &rp_PMODS_JA10},
+    {&rp_PMODS_JB1, &rp_PMODS_JB2, &rp_PMODS_JB3, &rp_PMODS_JB4, &rp_PMODS_JB7, &rp_PMODS_JB8, &rp_PMODS_JB9, &rp_PMODS_JB10}
+};
 
 
 /**------------------------------------------------------------ */
@@ -67,144 +80,19 @@
 */
 void PMODS_InitPin(unsigned char bPmod, unsigned char bPos, unsigned char bDir, unsigned char pullup, unsigned char pulldown)
 {
-    switch (bPmod)
+    int idx = PMODS_GetPinIndex(bPmod, bPos);
+    if(idx < 0)
+    {
+        return;
+    }
+    if(rgPmodsPins[bPmod][idx].bPort == GPIO_PORT_C &&
+        (rgPmodsPins[bPmod][idx].bBit == 13 || rgPmodsPins[bPmod][idx].bBit == 14))
     {
-        case 0: 
-            // JA
-        {
-            switch (bPos)
-            {
-                case 1: 
-                // JA1
-                    rp_PMODS_JA1 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA1 = bDir;
-                    cnpu_PMODS_JA1 = pullup;        
-                    cnpd_PMODS_JA1 = pulldown;                            
-                    break;
-                break;
-                case 2: 
-                // JA2
-                    rp_PMODS_JA2 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA2 = bDir;
-                    cnpu_PMODS_JA2 = pullup;        
-                    cnpd_PMODS_JA2 = pulldown;        
-                break;
-                case 3: 
-                // JA3
-                    rp_PMODS_JA3 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA3 = bDir;
-                    cnpu_PMODS_JA3 = pullup;        
-                    cnpd_PMODS_JA3 = pulldown;        
-                break;
-                case 4: 
-                // JA4
-                    ansel_PMODS_JA4 = 0;    // set pin as digital
-                    rp_PMODS_JA4 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA4 = bDir;
-                    cnpu_PMODS_JA4 = pullup;        
-                    cnpd_PMODS_JA4 = pulldown;        
-                break;
-                case 7: 
-                // JA7
-                    rp_PMODS_JA7 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA7 = bDir;
-                    cnpu_PMODS_JA7 = pullup;        
-                    cnpd_PMODS_JA7 = pulldown;        
-                break;
-                case 8:
-                // JA8
-                    ansel_PMODS_JA8 = 0;    // set pin as digital
-                    rp_PMODS_JA8 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA8 = bDir;
-                    cnpu_PMODS_JA8 = pullup;        
-                    cnpd_PMODS_JA8 = pulldown;        
-                break;
-                case 9: 
-                // JA9
-                    ansel_PMODS_JA9 = 0;    // set pin as digital
-                    rp_PMODS_JA9 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA9 = bDir;
-                    cnpu_PMODS_JA9 = pullup;        
-                    cnpd_PMODS_JA9 = pulldown;        
-                break;
-                case 10: 
-                // JA10
-                    ansel_PMODS_JA10 = 0;    // set pin as digital
-                    rp_PMODS_JA10 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JA10 = bDir;
-                    cnpu_PMODS_JA10 = pullup;        
-                    cnpd_PMODS_JA10 = pulldown;        
-                break;            
-            }
-        }
-        break;        
-        case 1: 
-            // JB
-        {
-            switch (bPos)
-            {
-                case 1: 
-                // JB1
-                    rp_PMODS_JB1 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB1 = bDir;
-                    cnpu_PMODS_JB1 = pullup;        
-                    cnpd_PMODS_JB1 = pulldown;        
-                break;
-                case 2: 
-                // JB2
-                    rp_PMODS_JB2 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB2 = bDir;
-                    cnpu_PMODS_JB2 = pullup;        
-                    cnpd_PMODS_JB2 = pulldown;        
-                break;
-                case 3: 
-                // JB3
-                    rp_PMODS_JB3 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB3 = bDir;
-                    cnpu_PMODS_JB3 = pullup;        
-                    cnpd_PMODS_JB3 = pulldown;        
-                break;
-                case 4: 
-                // JB4
-                    rp_PMODS_JB4 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB4 = bDir;
-                    cnpu_PMODS_JB4 = pullup;        
-                    cnpd_PMODS_JB4 = pulldown;        
-                break;
-                case 7: 
-                // JB7
-                    OSCCONbits.SOSCEN = 0;
-                    rp_PMODS_JB7 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB7 = bDir;
-                    cnpu_PMODS_JB7 = pullup;        
-                    cnpd_PMODS_JB7 = pulldown;        
-                break;
-                case 8: 
-                // JB8
-                    rp_PMODS_JB8 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB8 = bDir;
-                    cnpu_PMODS_JB8 = pullup;        
-                    cnpd_PMODS_JB8 = pulldown;        
-                break;
-                case 9: 
-                // JB9
-                    ansel_PMODS_JB9 = 0;    // set pis as digital
-                    rp_PMODS_JB9 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB9 = bDir;
-                    cnpu_PMODS_JB9 = pullup;        
-                    cnpd_PMODS_JB9 = pulldown;        
-                break;
-                case 10: 
-                // JB10
-                    OSCCONbits.SOSCEN = 0;
-                    rp_PMODS_JB10 = 0;   // default pin function (no remapable)
-                    tris_PMODS_JB10 = bDir;
-                    cnpu_PMODS_JB10 = pullup;        
-                    cnpd_PMODS_JB10 = pulldown;        
-                break;            
-            }
-        }
+        // JB10 (RC13) and JB7 (RC14) are shared with the secondary oscillator (SOSCI, SOSCO)
+        OSCCONbits.SOSCEN = 0;
     }
+    *rgPmodsRP[bPmod][idx] = 0;     // default pin function (no remapable)
+    GPIO_ConfigurePin(rgPmodsPins[bPmod][idx], bDir, pullup, pulldown);
 }
 
 /**------------------------------------------------------------ */
@@ -240,91 +128,12 @@ void PMODS_InitPin(unsigned char bPmod, unsigned char bPos, unsigned char bDir,
 */
 unsigned char PMODS_GetValue(unsigned char bPmod, unsigned char bPos)
 {
-    unsigned bResult = 0xFF;
-    
-    switch (bPmod)
+    int idx = PMODS_GetPinIndex(bPmod, bPos);
+    if(idx < 0)
     {
-        case 0: 
-            // JA
-        {
-            switch (bPos)
-            {
-                case 1: 
-                // JA1
-                    bResult = prt_PMODS_JA1;
-                break;
-                case 2: 
-                // JA2
-                    bResult = prt_PMODS_JA2;
-                break;
-                case 3: 
-                // JA3
-                    bResult = prt_PMODS_JA3;
-                break;
-                case 4: 
-                // JA4
-                    bResult = prt_PMODS_JA4;
-                break;
-                case 7: 
-                // JA7
-                    bResult = prt_PMODS_JA7;
-                break;
-                case 8: 
-                // JA8
-                    bResult = prt_PMODS_JA8;
-                break;
-                case 9: 
-                // JA9
-                    bResult = prt_PMODS_JA9;
-                break;
-                case 10: 
-                // JA10
-                    bResult = prt_PMODS_JA10;
-                break;            
-            }
-        }
-        break;
-        case 1: 
-            // JB
-        {
-            switch (bPos)
-            {
-                case 1: 
-                // JB1
-                    bResult = prt_PMODS_JB1;
-                break;
-                case 2: 
-                // JB2
-                    bResult = prt_PMODS_JB2;
-                break;
-                case 3: 
-                // JB3
-                    bResult = prt_PMODS_JB3;
-                break;
-                case 4: 
-                // JB4
-                    bResult = prt_PMODS_JB4;
-                break;
-                case 7: 
-                // JB7
-                    bResult = prt_PMODS_JB7;
-                break;
-                case 8: 
-                // JB8
-                    bResult = prt_PMODS_JB8;
-                break;
-                case 9: 
-                // JB9
-                    bResult = prt_PMODS_JB9;
-                break;
-                case 10: 
-                // JB10
-                    bResult = prt_PMODS_JB10;
-                break;            
-            }
-        }
+        return 0xFF;
     }
-    return bResult;
+    return GPIO_GetValue(rgPmodsPins[bPmod][idx]);
 }
 
         
@@ -360,89 +169,12 @@ unsigned char PMODS_GetValue(unsigned char bPmod, unsigned char bPos)
 */
 void PMODS_SetValue(unsigned char bPmod, unsigned char bPos, unsigned char bVal)
 {
-    unsigned char bVald = bVal ? 1: 0;
-    switch (bPmod)
+    int idx = PMODS_GetPinIndex(bPmod, bPos);
+    if(idx < 0)
     {
-        case 0: 
-            // JA
-        {
-            switch (bPos)
-            {
-                case 1: 
-                // JA1
-                    lat_PMODS_JA1 = bVald;
-                break;
-                case 2: 
-                // JA2
-                    lat_PMODS_JA2 = bVald;
-                break;
-                case 3: 
-                // JA3
-                    lat_PMODS_JA3 = bVald;
-                break;
-                case 4: 
-                // JA4
-                    lat_PMODS_JA4 = bVald;
-                break;
-                case 7: 
-                // JA7
-                    lat_PMODS_JA7 = bVald;
-                break;
-                case 8: 
-                // JA8
-                    lat_PMODS_JA8 = bVald;
-                break;
-                case 9: 
-                // JA9
-                    lat_PMODS_JA9 = bVald;
-                break;
-                case 10: 
-                // JA10
-                    lat_PMODS_JA10 = bVald;
-                break;            
-            }
-        }
-        break;
-        case 1: 
-            // JB
-        {
-            switch (bPos)
-            {
-                case 1: 
-                // JB1
-                    lat_PMODS_JB1 = bVald;
-                break;
-                case 2: 
-                // JB2
-                    lat_PMODS_JB2 = bVald;
-                break;
-                case 3: 
-                // JB3
-                    lat_PMODS_JB3 = bVald;
-                break;
-                case 4: 
-                // JB4
-                    lat_PMODS_JB4 = bVald;
-                break;
-                case 7: 
-                // JB7
-                    lat_PMODS_JB7 = bVald;
-                break;
-                case 8: 
-                // JB8
-                    lat_PMODS_JB8 = bVald;
-                break;
-                case 9: 
-                // JB9
-                    lat_PMODS_JB9 = bVald;
-                break;
-                case 10: 
-                // JB10
-                    lat_PMODS_JB10 = bVald;
-                break;            
-            }
-        }
+        return;
     }
+    GPIO_SetValue(rgPmodsPins[bPmod][idx], bVal);
 }
 
 /*
@@ -485,19 +217,83 @@ void PMODS_SetValue(unsigned char bPmod, unsigned char bPos, unsigned char bVal)
 **	Description:
 **      This function assigns a digital value to all the digital pins of the PMOD specified by bPmod.
 **      Each bit from bVal is assigned to a pin in the PMOD, as shown above.
+**      The pins of each port are written at once, using the LATxSET / LATxCLR registers.
 */
 
 void PMODS_SetGroupValue(unsigned char bPmod, unsigned char bVal)
 {
-    int i, j;
-    for(i = 1; i <= 8; i++)
+    if(bPmod > 1)
     {
-        j = (i >= 5) ? (i+2): i;
-        PMODS_SetValue(bPmod, j, bVal & (1<<(i-1))); // the bit corresponding to the Pmod pin
-    }    
+        return;
+    }
+    GPIO_SetGroupValue(rgPmodsPins[bPmod], 8, bVal);
 }
 
 
+/**------------------------------------------------------------ */
+/**	PMODS_GetGroupValue
+**
+**	Parameters:
+**		unsigned char bPmod     - the PMOD
+**                                 0 - PMODA
+**                                 1 - PMODB
+**
+**	Return Value:
+**      unsigned char - the values of the digital pins: each bit corresponds to a Pmod pin:
+**                                 bit 0 (LSB)  - JA1 (if bPmod = 0), JB1 (if bPmod = 1)
+**                                 bit 1        - JA2 (if bPmod = 0), JB2 (if bPmod = 1)
+**                                 bit 2        - JA3 (if bPmod = 0), JB3 (if bPmod = 1)
+**                                 bit 3        - JA4 (if bPmod = 0), JB4 (if bPmod = 1)
+**                                 bit 4        - JA7 (if bPmod = 0), JB7 (if bPmod = 1)
+**                                 bit 5        - JA8 (if bPmod = 0), JB8 (if bPmod = 1)
+**                                 bit 6        - JA9 (if bPmod = 0), JB9 (if bPmod = 1)
+**                                 bit 7        - JA10(if bPmod = 0), JB10(if bPmod = 1)
+**                      0xFF if bPmod is not valid
+**
+**	Description:
+**      This function returns the values of all the digital pins of the PMOD specified by bPmod.
+**      Each involved port is read once (see GPIO_GetGroupValue).
+*/
+unsigned char PMODS_GetGroupValue(unsigned char bPmod)
+{
+    if(bPmod > 1)
+    {
+        return 0xFF;
+    }
+    return GPIO_GetGroupValue(rgPmodsPins[bPmod], 8);
+}
+
+/**------------------------------------------------------------ */
+/**	PMODS_GetPinIndex
+**
+**	Parameters:
+**		unsigned char bPmod     - the PMOD where the pin is located (0 - PMODA, 1 - PMODB)
+**      unsigned char bPos      - the pin position in the Pmod (allowed values 1-4, 7-10)
+**
+**	Return Value:
+**      int - the index of the pin in the pin tables (0 - 7), -1 if bPmod and bPos do not specify a valid pin
+**
+**	Description:
+**      This function converts a pin position to the index of the pin in the pin tables.
+**      This is a low-level function, so user should avoid calling it directly.
+*/
+int PMODS_GetPinIndex(unsigned char bPmod, unsigned char bPos)
+{
+    if(bPmod > 1)
+    {
+        return -1;
+    }
+    if(bPos >= 1 && bPos <= 4)
+    {
+        return bPos - 1;
+    }
+    if(bPos >= 7 && bPos <= 10)
+    {
+        return bPos - 3;
+    }
+    return -1;
+}
+
 /* *****************************************************************************
  End of File
  */
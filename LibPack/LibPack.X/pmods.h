@@ -22,6 +22,10 @@ void PMODS_InitPin(unsigned char bPmod, unsigned char bPos, unsigned char bDir,
 unsigned char PMODS_GetValue(unsigned char bPmod, unsigned char bPos);
 void PMODS_SetValue(unsigned char bPmod, unsigned char bPos, unsigned char bVal);
 void PMODS_SetGroupValue(unsigned char bPmod, unsigned char bVal);
+unsigned char PMODS_GetGroupValue(unsigned char bPmod);
+
+//private functions:
+int PMODS_GetPinIndex(unsigned char bPmod, unsigned char bPos);
 #endif /* _PMODS_H */
 
 /* *****************************************************************************
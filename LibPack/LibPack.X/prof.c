@@ -0,0 +1,250 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    prof.c
+
+  @Description
+        This file groups the functions that implement the PROF library.
+        The library collects, for each instrumented interrupt handler, the number of calls,
+        the entry latency and the execution duration, measured with the core timer (CP0 Count register):
+        minimum, maximum, mean and log2 histograms.
+        The durations include the time spent in higher priority interrupts that preempted the handler.
+        The statistics can be printed over a UART using PROF_Dump.
+        The library is enabled by defining PROF_ENABLE in config.h.
+        Include the file in the project, together with config.h, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "prof.h"
+
+#ifdef PROF_ENABLE
+/* ************************************************************************** */
+
+PROF_STATS rgProfStats[PROF_NO_IDS];
+
+const char *rgszProfNames[PROF_NO_IDS] = {"TMR1", "TMR3", "TMR4", "TMR5", "UART4", "UART1", "CORETMR",
+    "UART5", "DMA2", "DMA3", "I2C1", "CN", "DMA0", "DMA1", "SPI2", "USER"};
+
+/* ------------------------------------------------------------ */
+/***	PROF_Reset
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function clears the statistics of all the interrupt handlers.
+**
+*/
+void PROF_Reset()
+{
+    int i;
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    memset(rgProfStats, 0, sizeof(rgProfStats));
+    for(i = 0; i < PROF_NO_IDS; i++)
+    {
+        rgProfStats[i].uiDurMin = 0xFFFFFFFF;
+        rgProfStats[i].uiLatMin = 0xFFFFFFFF;
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	PROF_GetStats
+**
+**	Parameters:
+**		unsigned char idVector      - the interrupt handler, one of PROF_ID_xxx
+**		PROF_STATS *pStats          - the structure where the statistics are copied
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function copies the statistics of an interrupt handler, with interrupts disabled,
+**      so that the copy is consistent.
+**
+*/
+void PROF_GetStats(unsigned char idVector, PROF_STATS *pStats)
+{
+    unsigned int uiStatus;
+    if(idVector >= PROF_NO_IDS)
+    {
+        return;
+    }
+    uiStatus = __builtin_disable_interrupts();
+    *pStats = rgProfStats[idVector];
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	PROF_Dump
+**
+**	Parameters:
+**		void (*pfPutString)(char *)     - the function used to send the text, for example UART_PutString or UARTJB_PutString
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function prints the statistics of the interrupt handlers that were called at least once.
+**      For each handler, two or three lines are sent (times are in core timer ticks, SYS_FRQ / 2):
+**          PROF <name> calls=<n> dur=<min>/<mean>/<max> lat=<min>/<mean>/<max>
+**          DHIST <name> <bin 0> ... <bin 15>
+**          LHIST <name> <bin 0> ... <bin 15>      (only when the latency is measured)
+**      The histogram bin i counts the values between 2^(i-1) and 2^i - 1 ticks.
+**      The lines can be parsed by a host script, or read directly in a terminal.
+**
+*/
+void PROF_Dump(void (*pfPutString)(char *))
+{
+    PROF_STATS stats;
+    char szLine[128];
+    int i, j, cch;
+
+    for(i = 0; i < PROF_NO_IDS; i++)
+    {
+        PROF_GetStats(i, &stats);
+        if(!stats.cntCalls)
+        {
+            continue;
+        }
+        cch = sprintf(szLine, "PROF %s calls=%u dur=%u/%u/%u", rgszProfNames[i], stats.cntCalls,
+                stats.uiDurMin, (unsigned int)(stats.ullDurSum / stats.cntCalls), stats.uiDurMax);
+        if(stats.cntLat)
+        {
+            sprintf(szLine + cch, " lat=%u/%u/%u", stats.uiLatMin,
+                (unsigned int)(stats.ullLatSum / stats.cntLat), stats.uiLatMax);
+        }
+        strcat(szLine, "\r\n");
+        (*pfPutString)(szLine);
+
+        cch = sprintf(szLine, "DHIST %s", rgszProfNames[i]);
+        for(j = 0; j < PROF_HIST_BINS; j++)
+        {
+            cch += sprintf(szLine + cch, " %u", stats.rgDurHist[j]);
+        }
+        strcat(szLine, "\r\n");
+        (*pfPutString)(szLine);
+
+        if(stats.cntLat)
+        {
+            cch = sprintf(szLine, "LHIST %s", rgszProfNames[i]);
+            for(j = 0; j < PROF_HIST_BINS; j++)
+            {
+                cch += sprintf(szLine + cch, " %u", stats.rgLatHist[j]);
+            }
+            strcat(szLine, "\r\n");
+            (*pfPutString)(szLine);
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	PROF_RecordLatency
+**
+**	Parameters:
+**		unsigned char idVector      - the interrupt handler, one of PROF_ID_xxx
+**		unsigned int cntTicks       - the entry latency, in core timer ticks
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function accounts an entry latency. It is called by the PROF_ISR_ENTER_LAT macro.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void PROF_RecordLatency(unsigned char idVector, unsigned int cntTicks)
+{
+    PROF_STATS *pStats = &rgProfStats[idVector];
+    if(!pStats->cntLat || cntTicks < pStats->uiLatMin)
+    {
+        pStats->uiLatMin = cntTicks;
+    }
+    if(cntTicks > pStats->uiLatMax)
+    {
+        pStats->uiLatMax = cntTicks;
+    }
+    pStats->ullLatSum += cntTicks;
+    pStats->cntLat++;
+    pStats->rgLatHist[PROF_GetHistBin(cntTicks)]++;
+}
+
+/* ------------------------------------------------------------ */
+/***	PROF_RecordDuration
+**
+**	Parameters:
+**		unsigned char idVector      - the interrupt handler, one of PROF_ID_xxx
+**		unsigned int cntTicks       - the execution duration, in core timer ticks
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function accounts a call of an interrupt handler. It is called by the PROF_ISR_EXIT macro.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void PROF_RecordDuration(unsigned char idVector, unsigned int cntTicks)
+{
+    PROF_STATS *pStats = &rgProfStats[idVector];
+    if(!pStats->cntCalls || cntTicks < pStats->uiDurMin)
+    {
+        pStats->uiDurMin = cntTicks;
+    }
+    if(cntTicks > pStats->uiDurMax)
+    {
+        pStats->uiDurMax = cntTicks;
+    }
+    pStats->ullDurSum += cntTicks;
+    pStats->cntCalls++;
+    pStats->rgDurHist[PROF_GetHistBin(cntTicks)]++;
+}
+
+/* ------------------------------------------------------------ */
+/***	PROF_GetHistBin
+**
+**	Parameters:
+**		unsigned int cntTicks       - a time, in core timer ticks
+**
+**	Return Value:
+**		unsigned char   - the log2 histogram bin: the number of significant bits of cntTicks,
+**                        limited to PROF_HIST_BINS - 1
+**
+**	Description:
+**		This function computes the histogram bin of a time, using the count leading zeros instruction.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char PROF_GetHistBin(unsigned int cntTicks)
+{
+    unsigned char bBin = cntTicks ? 32 - __builtin_clz(cntTicks) : 0;
+    return bBin < PROF_HIST_BINS ? bBin : PROF_HIST_BINS - 1;
+}
+
+#endif /* PROF_ENABLE */
+
+/* *****************************************************************************
+ End of File
+ */
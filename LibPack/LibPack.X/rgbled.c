@@ -11,6 +11,9 @@
         This file groups the functions that implement the RGBLed library.
         The colors are generated using PDM method, using accumulators updated 
         periodically (Timer5 is used).
+        The library also implements a fade engine: fades to a color over a specified time and 
+        sequences of key frames are performed from the Timer5 interrupt, using linear or HSV
+        fixed point interpolation and gamma correction (no floating point computing is involved).
         The source file also contains (commented) the PWM implementation, using 
         OC3, OC4, OC5 and Timer2.
         Include the file in the project, together with config.h, when this library is needed.
@@ -25,10 +28,53 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "rgbled.h"
+#include "hwres.h"
+#include "prof.h"
+#include "trace.h"
 
 // global variables to store R, G, B color values
 volatile unsigned char bColR, bColG, bColB;
 
+// gamma correction table (gamma 2.2), used by the fade engine to translate perceptual 
+// brightness values into PDM values: rgGammaLUT[i] = round(255 * (i / 255)^2.2)
+const unsigned char rgGammaLUT[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+// the fade engine state. Each color component is kept as a fixed point 16.16 value.
+// In linear mode the components are R, G, B (perceptual values, before gamma correction), 
+// in HSV mode they are H (0 - 1535), S (0 - 255), V (0 - 255).
+volatile int rgFadeVal[3], rgFadeInc[3];
+volatile unsigned int cntFadeSteps;         // remaining steps of the current fade segment (0 - no fade in progress)
+volatile int rgFadeDst[3];                  // the exact values reached at the end of the current fade segment
+volatile unsigned char bFadeMode;           // RGBLED_FADE_LINEAR or RGBLED_FADE_HSV
+const RGBLED_KEYFRAME *pFadeFrames;         // key frames sequence, 0 if a single fade is performed
+volatile unsigned char cntFadeFrames, idxFadeFrame, fFadeLoop;
+
+// Timer period in seconds
+#define TMR_TIME    0.0003 // the nominal tick used to compute the period register, see TMR_PR
+// Timer5 period register value. TCKPS = 3 selects a 1:8 prescaler for Timer5 (not 1:256),
+// so the actual tick is (TMR_PR + 1) * 8 / PB_FRQ, about 9.6 us, which keeps the PDM free of flicker.
+#define TMR_PR      (int)(((float)(TMR_TIME * PB_FRQ) / 256) + 0.5)
+#define TMR_PRESCALER   8
+// the number of Timer5 ticks between two fade engine steps
+#define FADE_TICKS  (int)(((float)RGBLED_FADE_STEP_MS * 0.001 * PB_FRQ / (TMR_PRESCALER * (TMR_PR + 1))) + 0.5)
+
 
 /***	Timer5ISR
 **
@@ -40,11 +86,15 @@ volatile unsigned char bColR, bColG, bColB;
 **      The resulted carry bits are assigned to the digital pins corresponding to each color (LED8_R, LED8_G and LED8_B) 
 **      Carry occurs often for large values and rarely for small values.
 **      Carry bit is cleared in the accumulator.
+**      When a fade is in progress, the fade engine is advanced every RGBLED_FADE_STEP_MS milliseconds.
 **          
 */
 void __ISR(_TIMER_5_VECTOR, ipl2) Timer5ISR(void) 
 {  
    static unsigned short sAccR = 0, sAccG = 0, sAccB = 0;
+   static unsigned short wFadeTick = 0;
+   PROF_ISR_ENTER_TMR(PROF_ID_TMR5, TMR5, TMR_PRESCALER);
+   TRACE_BEGIN(TRACE_SRC_TMR5, 0);
     
     // add 8 bit color values over the accumulators
     sAccR += bColR;
@@ -60,13 +110,19 @@ void __ISR(_TIMER_5_VECTOR, ipl2) Timer5ISR(void)
     sAccR &= 0xFF;
     sAccG &= 0xFF;
     sAccB &= 0xFF;
+
+    // advance the fade engine every FADE_TICKS ticks
+    if(cntFadeSteps && (++wFadeTick >= FADE_TICKS))
+    {
+        wFadeTick = 0;
+        RGBLED_FadeStep();
+    }
     
     IFS0bits.T5IF = 0;     // clear interrupt flag
+    TRACE_END(TRACE_SRC_TMR5, 0);
+    PROF_ISR_EXIT(PROF_ID_TMR5);
 }
 
-// Timer period in seconds
-#define TMR_TIME    0.0003 // 300 us for each tick
-
 /* ------------------------------------------------------------ */
 /***	Timer5Setup
 **
@@ -74,20 +130,25 @@ void __ISR(_TIMER_5_VECTOR, ipl2) Timer5ISR(void)
 **		
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if Timer5 was allocated, HWRES_ERR_CONFLICT if Timer5 is used by another library
 **
 **	Description:
 **		This function configures the Timer5 to be used by RGBLED module.
-**      The timer will generate interrupts every 300 microseconds.
+**      The timer will generate interrupts every 9.6 microseconds (TMR_PR computed from TMR_TIME, with a 1:8 prescaler).
 **      The period constant is computed using TMR_TIME definition (located in this source file)
 **      and peripheral bus frequency definition (PB_FRQ, located in config.h).
+**      Timer5 is allocated exclusively using the HWRES library. If Timer5 is used by another library, it is not altered.
 **          
 */
-void RGBLED_Timer5Setup()
+unsigned char RGBLED_Timer5Setup()
 {
-   PR5 = (int)(((float)(TMR_TIME * PB_FRQ) / 256) + 0.5);   //set period register, generates one interrupt every 300 us                     //             set period register, generates one interrupt every 300 us
+  if(HWRES_AllocTimer(5, HWRES_OWNER_RGBLED, HWRES_EXCLUSIVE, 3, TMR_PR) != HWRES_OK)
+  {
+      return HWRES_ERR_CONFLICT;
+  }
+  PR5 = TMR_PR;                       //    set period register
   TMR5 = 0;                           //    initialize count to 0
-  T5CONbits.TCKPS = 3;                //    1:256 prescaler value
+  T5CONbits.TCKPS = 3;                //    1:8 prescaler value
   T5CONbits.TGATE = 0;                //    not gated input (the default)
   T5CONbits.TCS = 0;                  //    PCBLK input (the default)
   IPC5bits.T5IP = 2;                  //    INT step 4: priority
@@ -96,6 +157,7 @@ void RGBLED_Timer5Setup()
   IEC0bits.T5IE = 1;                  //    enable interrupt
   T5CONbits.ON = 1;                   //    turn on Timer5
   macro_enable_interrupts();          //    enable interrupts at CPU
+  return HWRES_OK;
 }
 
 /* ------------------------------------------------------------ */
@@ -105,17 +167,19 @@ void RGBLED_Timer5Setup()
 **		
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if the initialization succeeded
+**                        HWRES_ERR_CONFLICT if Timer5 is used by another library
 **
 **	Description:
 **		This function initializes the hardware involved in the RGBLED module: 
 **      the pins corresponding to R, G and B colors are initialized as digital outputs and Timer 5 in configured.
 **          
 */
-void RGBLED_Init()
+unsigned char RGBLED_Init()
 {
+    unsigned char bResult;
     RGBLED_ConfigurePins();
-    RGBLED_Timer5Setup();
+    bResult = RGBLED_Timer5Setup();
     lat_LED8_R = 0;
     lat_LED8_G = 0;
     lat_LED8_B = 0;
@@ -147,6 +211,7 @@ void RGBLED_Init()
    OC5CONbits.OCTSEL = 0;   // Timer2 is the clock source for this Output Compare module
    OC5CONbits.ON = 1;       // Start the OC5 module  
      */
+    return bResult;
 }
 
 /* ------------------------------------------------------------ */
@@ -201,10 +266,15 @@ void RGBLED_ConfigurePins()
 **	Description:
 **		This function sets the color value by providing the values for the 3 components
 **          R, G and B, as 3 separate 8 bits values. 
+**      The values are used as PDM values, no gamma correction is applied.
+**      If a fade is in progress, it is stopped.
 **          
 */
 void RGBLED_SetValue(unsigned char bValR, unsigned char bValG, unsigned char bValB)
 {
+    // a color set directly overrides any fade in progress
+    pFadeFrames = 0;
+    cntFadeSteps = 0;
     bColR = bValR;
     bColG = bValG;
     bColB = bValB;
@@ -242,6 +312,391 @@ void RGBLED_SetValueGrouped(unsigned int uiValRGB)
     RGBLED_SetValue(pBCol[2], pBCol[1], pBCol[0]);
 }
 
+/* ------------------------------------------------------------ */
+/***	RGBLED_FadeToValue
+**
+**	Parameters:
+**		unsigned char bValR   - the R component of the destination color (perceptual value, 0 - 255)
+**		unsigned char bValG   - the G component of the destination color (perceptual value, 0 - 255)
+**		unsigned char bValB   - the B component of the destination color (perceptual value, 0 - 255)
+**		unsigned int msTime   - the fade duration, in milliseconds
+**		unsigned char bMode   - the interpolation mode:
+**                                  RGBLED_FADE_LINEAR - R, G and B are interpolated independently
+**                                  RGBLED_FADE_HSV    - hue, saturation and value are interpolated, 
+**                                                       the hue following the shortest path on the color wheel
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function starts a fade from the currently displayed color to the specified color, 
+**      over the specified time. The function returns immediately, the fade is performed
+**      from the Timer5 interrupt, every RGBLED_FADE_STEP_MS milliseconds, using fixed point interpolation.
+**      The destination values are perceptual values: they are gamma corrected (using rgGammaLUT) 
+**      before being used as PDM values.
+**      Any fade or key frames sequence in progress is replaced.
+**          
+*/
+void RGBLED_FadeToValue(unsigned char bValR, unsigned char bValG, unsigned char bValB, unsigned int msTime, unsigned char bMode)
+{
+    RGBLED_FadeToValueGrouped(((unsigned int)bValR << 16) | ((unsigned int)bValG << 8) | bValB, msTime, bMode);
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_FadeToValueGrouped
+**
+**	Parameters:
+**		unsigned int uiValRGB - the destination color, grouped in the 3 LSB bytes 
+**                                  in this pattern xxxxxxxxRRRRRRRRGGGGGGGGBBBBBBBB
+**		unsigned int msTime   - the fade duration, in milliseconds
+**		unsigned char bMode   - the interpolation mode: RGBLED_FADE_LINEAR or RGBLED_FADE_HSV
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function starts a fade from the currently displayed color to the color specified 
+**      as a 24 bits value, over the specified time. See RGBLED_FadeToValue.
+**          
+*/
+void RGBLED_FadeToValueGrouped(unsigned int uiValRGB, unsigned int msTime, unsigned char bMode)
+{
+    unsigned char fIntEnabled = IEC0bits.T5IE;
+    IEC0bits.T5IE = 0;      // keep the Timer5 interrupt away while the fade is set up
+    pFadeFrames = 0;
+    RGBLED_FadeStartSegment(uiValRGB, msTime, bMode);
+    IEC0bits.T5IE = fIntEnabled;
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_PlayKeyFrames
+**
+**	Parameters:
+**		const RGBLED_KEYFRAME *pFrames  - pointer to the array of key frames. The array must remain 
+**                                          valid while the sequence is played.
+**		unsigned char cntFrames         - the number of key frames in the array
+**		unsigned char fLoop             - 1 to restart the sequence after the last key frame, 0 to stop
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function starts playing a sequence of key frames. For each key frame, 
+**      a fade to the key frame color is performed over the key frame duration, 
+**      using the key frame interpolation mode (see RGBLED_FadeToValue).
+**      The sequence is played from the Timer5 interrupt, without main loop involvement.
+**      Any fade or key frames sequence in progress is replaced.
+**          
+*/
+void RGBLED_PlayKeyFrames(const RGBLED_KEYFRAME *pFrames, unsigned char cntFrames, unsigned char fLoop)
+{
+    unsigned char fIntEnabled = IEC0bits.T5IE;
+    if(!cntFrames)
+    {
+        return;
+    }
+    IEC0bits.T5IE = 0;      // keep the Timer5 interrupt away while the fade is set up
+    pFadeFrames = pFrames;
+    cntFadeFrames = cntFrames;
+    idxFadeFrame = 0;
+    fFadeLoop = fLoop;
+    RGBLED_FadeStartSegment(pFrames[0].uiValRGB, pFrames[0].wTimeMs, pFrames[0].bMode);
+    IEC0bits.T5IE = fIntEnabled;
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_StopFade
+**
+**	Parameters:
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function stops the fade or key frames sequence in progress. 
+**      The currently displayed color is kept.
+**          
+*/
+void RGBLED_StopFade()
+{
+    pFadeFrames = 0;
+    cntFadeSteps = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_IsFading
+**
+**	Parameters:
+**
+**	Return Value:
+**		unsigned char   - 1 if a fade or key frames sequence is in progress, 0 otherwise
+**
+**	Description:
+**		This function returns the fade engine status.
+**          
+*/
+unsigned char RGBLED_IsFading()
+{
+    return cntFadeSteps != 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_FadeStartSegment
+**
+**	Parameters:
+**		unsigned int uiValRGB - the destination color: xxxxxxxxRRRRRRRRGGGGGGGGBBBBBBBB
+**		unsigned int msTime   - the fade duration, in milliseconds
+**		unsigned char bMode   - the interpolation mode: RGBLED_FADE_LINEAR or RGBLED_FADE_HSV
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function prepares the fade engine for a fade segment: the start point is the currently
+**      displayed color, converted back to perceptual values, and the per step fixed point 
+**      (16.16) increments are computed for each component.
+**      This is a low-level function called with the Timer5 interrupt disabled or from the Timer5 interrupt, 
+**      so user should avoid calling it directly.
+**          
+*/
+void RGBLED_FadeStartSegment(unsigned int uiValRGB, unsigned int msTime, unsigned char bMode)
+{
+    int rgCur[3], rgDst[3], i;
+    int cntSteps = msTime / RGBLED_FADE_STEP_MS;
+    if(cntSteps == 0)
+    {
+        cntSteps = 1;
+    }
+
+    // the start point is the currently displayed color
+    rgCur[0] = RGBLED_GammaInverse(bColR);
+    rgCur[1] = RGBLED_GammaInverse(bColG);
+    rgCur[2] = RGBLED_GammaInverse(bColB);
+    rgDst[0] = (uiValRGB >> 16) & 0xFF;
+    rgDst[1] = (uiValRGB >> 8) & 0xFF;
+    rgDst[2] = uiValRGB & 0xFF;
+
+    if(bMode == RGBLED_FADE_HSV)
+    {
+        RGBLED_RGBToHSV(rgCur);
+        RGBLED_RGBToHSV(rgDst);
+        // follow the shortest path on the color wheel
+        if(rgDst[0] - rgCur[0] > 768)
+        {
+            rgDst[0] -= 1536;
+        }
+        else if(rgDst[0] - rgCur[0] < -768)
+        {
+            rgDst[0] += 1536;
+        }
+    }
+
+    for(i = 0; i < 3; i++)
+    {
+        rgFadeVal[i] = rgCur[i] << 16;
+        rgFadeInc[i] = ((rgDst[i] - rgCur[i]) * 65536) / cntSteps;
+        rgFadeDst[i] = rgDst[i];
+    }
+    bFadeMode = bMode;
+    cntFadeSteps = cntSteps;
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_FadeStep
+**
+**	Parameters:
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function performs one step of the fade engine: each component is advanced 
+**      by its increment, converted to R, G, B (if needed), gamma corrected and used as the new PDM value.
+**      When the last step of a segment is performed, the exact destination values are used, 
+**      and the next key frame (if any) is started.
+**      This is a low-level function called from the Timer5 interrupt, so user should avoid calling it directly.
+**          
+*/
+void RGBLED_FadeStep()
+{
+    int rgVal[3], i;
+
+    if(--cntFadeSteps)
+    {
+        for(i = 0; i < 3; i++)
+        {
+            rgFadeVal[i] += rgFadeInc[i];
+            rgVal[i] = rgFadeVal[i] >> 16;
+        }
+    }
+    else
+    {
+        for(i = 0; i < 3; i++)
+        {
+            rgVal[i] = rgFadeDst[i];
+        }
+    }
+
+    if(bFadeMode == RGBLED_FADE_HSV)
+    {
+        // bring the hue back on the color wheel
+        rgVal[0] %= 1536;
+        if(rgVal[0] < 0)
+        {
+            rgVal[0] += 1536;
+        }
+        RGBLED_HSVToRGB(rgVal);
+    }
+
+    bColR = rgGammaLUT[rgVal[0] & 0xFF];
+    bColG = rgGammaLUT[rgVal[1] & 0xFF];
+    bColB = rgGammaLUT[rgVal[2] & 0xFF];
+
+    if(!cntFadeSteps && pFadeFrames)
+    {
+        // move to the next key frame
+        if(++idxFadeFrame == cntFadeFrames)
+        {
+            if(!fFadeLoop)
+            {
+                pFadeFrames = 0;
+                return;
+            }
+            idxFadeFrame = 0;
+        }
+        RGBLED_FadeStartSegment(pFadeFrames[idxFadeFrame].uiValRGB, 
+                pFadeFrames[idxFadeFrame].wTimeMs, pFadeFrames[idxFadeFrame].bMode);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_GammaInverse
+**
+**	Parameters:
+**		unsigned char bVal  - a PDM value
+**
+**	Return Value:
+**		int                 - the smallest perceptual value whose gamma corrected value is at least bVal
+**
+**	Description:
+**		This function inverts the gamma correction, using a binary search in rgGammaLUT.
+**      It is used to start a fade from the currently displayed color.
+**      This is a low-level function, so user should avoid calling it directly.
+**          
+*/
+int RGBLED_GammaInverse(unsigned char bVal)
+{
+    int lo = 0, hi = 255, mid;
+    while(lo < hi)
+    {
+        mid = (lo + hi) >> 1;
+        if(rgGammaLUT[mid] < bVal)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_RGBToHSV
+**
+**	Parameters:
+**		int *rgVal  - array of 3 values: R, G, B (0 - 255) on input, H (0 - 1535), S (0 - 255), V (0 - 255) on output
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function converts a color from RGB to HSV, in place, using integer arithmetic only.
+**      The hue is represented on 6 sectors of 256 values each.
+**      This is a low-level function, so user should avoid calling it directly.
+**          
+*/
+void RGBLED_RGBToHSV(int *rgVal)
+{
+    int r = rgVal[0], g = rgVal[1], b = rgVal[2];
+    int max = r, min = r, delta, h = 0;
+    if(g > max) max = g;
+    if(b > max) max = b;
+    if(g < min) min = g;
+    if(b < min) min = b;
+    delta = max - min;
+
+    if(delta)
+    {
+        if(max == r)
+        {
+            h = (256 * (g - b)) / delta;
+            if(h < 0)
+            {
+                h += 1536;
+            }
+        }
+        else if(max == g)
+        {
+            h = 512 + (256 * (b - r)) / delta;
+        }
+        else
+        {
+            h = 1024 + (256 * (r - g)) / delta;
+        }
+    }
+    rgVal[0] = h;
+    rgVal[1] = max ? (255 * delta) / max : 0;
+    rgVal[2] = max;
+}
+
+/* ------------------------------------------------------------ */
+/***	RGBLED_HSVToRGB
+**
+**	Parameters:
+**		int *rgVal  - array of 3 values: H (0 - 1535), S (0 - 255), V (0 - 255) on input, R, G, B (0 - 255) on output
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function converts a color from HSV to RGB, in place, using integer arithmetic only.
+**      The hue is represented on 6 sectors of 256 values each.
+**      This is a low-level function, so user should avoid calling it directly.
+**          
+*/
+void RGBLED_HSVToRGB(int *rgVal)
+{
+    int h = rgVal[0], s = rgVal[1], v = rgVal[2];
+    int f = h & 0xFF;
+    int p = (v * (255 - s)) / 255;
+    int q = (v * (255 - (s * f) / 255)) / 255;
+    int t = (v * (255 - (s * (255 - f)) / 255)) / 255;
+
+    switch(h >> 8)
+    {
+        case 0:
+            rgVal[0] = v; rgVal[1] = t; rgVal[2] = p;
+            break;
+        case 1:
+            rgVal[0] = q; rgVal[1] = v; rgVal[2] = p;
+            break;
+        case 2:
+            rgVal[0] = p; rgVal[1] = v; rgVal[2] = t;
+            break;
+        case 3:
+            rgVal[0] = p; rgVal[1] = q; rgVal[2] = v;
+            break;
+        case 4:
+            rgVal[0] = t; rgVal[1] = p; rgVal[2] = v;
+            break;
+        default:
+            rgVal[0] = v; rgVal[1] = p; rgVal[2] = q;
+            break;
+    }
+}
+
 /* ------------------------------------------------------------ */
 /***	RGBLED_Close
 **
@@ -252,13 +707,20 @@ void RGBLED_SetValueGrouped(unsigned int uiValRGB)
 **
 **	Description:
 **		This function can be called when RGBLED library is no longer needed: 
-**      it stops the Timer5 and turns off the RGBLED.
+**      it stops the fade engine and the Timer5 and turns off the RGBLED.
 **          
 */
 void RGBLED_Close()
 {
+    // stop any fade in progress
+    RGBLED_StopFade();
     // stop the timer
-      T5CONbits.ON = 0;   // turn off Timer5
+    if(HWRES_GetTimerOwners(5) & HWRES_OWNER_RGBLED)
+    {
+        T5CONbits.ON = 0;   // turn off Timer5
+        IEC0bits.T5IE = 0;
+        HWRES_ReleaseTimer(5, HWRES_OWNER_RGBLED);
+    }
     // turn off colors
     lat_LED8_R = 0;
     lat_LED8_G = 0;
@@ -18,14 +18,38 @@
 #ifndef _RGBLED_H    /* Guard against multiple inclusion */
 #define _RGBLED_H
 
-void RGBLED_Init();
+// the period of the fade engine steps, in milliseconds
+#define RGBLED_FADE_STEP_MS     10
+
+// fade interpolation modes
+#define RGBLED_FADE_LINEAR      0   // R, G and B are interpolated independently
+#define RGBLED_FADE_HSV         1   // hue, saturation and value are interpolated
+
+// a key frame of a fade sequence
+typedef struct {
+    unsigned int uiValRGB;      // the key frame color: xxxxxxxxRRRRRRRRGGGGGGGGBBBBBBBB
+    unsigned short wTimeMs;     // the duration of the fade to this key frame, in milliseconds
+    unsigned char bMode;        // RGBLED_FADE_LINEAR or RGBLED_FADE_HSV
+} RGBLED_KEYFRAME;
+
+unsigned char RGBLED_Init();
 void RGBLED_SetValue(unsigned char bValR, unsigned char bValG, unsigned char bValB);
 void RGBLED_SetValueGrouped(unsigned int uiValRGB);
+void RGBLED_FadeToValue(unsigned char bValR, unsigned char bValG, unsigned char bValB, unsigned int msTime, unsigned char bMode);
+void RGBLED_FadeToValueGrouped(unsigned int uiValRGB, unsigned int msTime, unsigned char bMode);
+void RGBLED_PlayKeyFrames(const RGBLED_KEYFRAME *pFrames, unsigned char cntFrames, unsigned char fLoop);
+void RGBLED_StopFade();
+unsigned char RGBLED_IsFading();
 void RGBLED_Close();
 
 //private functions:
 void RGBLED_ConfigurePins();
-void RGBLED_Timer5Setup();
+unsigned char RGBLED_Timer5Setup();
+void RGBLED_FadeStartSegment(unsigned int uiValRGB, unsigned int msTime, unsigned char bMode);
+void RGBLED_FadeStep();
+int RGBLED_GammaInverse(unsigned char bVal);
+void RGBLED_RGBToHSV(int *rgVal);
+void RGBLED_HSVToRGB(int *rgVal);
 
 #endif /* _RGBLED_H */
 
@@ -0,0 +1,356 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    sched.c
+
+  @Description
+        This file groups the functions that implement the SCHED library.
+        The library is a cooperative, run-to-completion task scheduler:
+        - the interrupt handlers only post events (an event number and a parameter) to the tasks, using SCHED_Post.
+          Each task has a bounded event queue, posting is lock-free, so it can be done from any interrupt priority.
+        - the main loop calls SCHED_Run, that calls the handler of the highest priority task having pending events,
+          one event at a time. The handlers run with interrupts enabled and are never preempted by other tasks.
+        State machine tables (like the one of statemachine.c) can be run as tasks using SCHED_AddStateMachine:
+        the state functions are called in the main context, on each SCHED_EVT_TICK event.
+        Include the file in the project, together with config.h, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include "config.h"
+#include "sched.h"
+#include "trace.h"
+#include "load.h"
+
+/* ************************************************************************** */
+
+#define QUEUE_MASK  (SCHED_QUEUE_SIZE - 1)
+
+// an event queue entry. fReady is set after the entry is written, so the consumer never reads a partial entry
+typedef struct {
+    volatile unsigned char fReady;
+    unsigned char bEvent;
+    unsigned int uiParam;
+} SCHED_EVENT;
+
+// a task
+typedef struct {
+    SCHED_HANDLER pfHandler;
+    void *pCtx;
+    unsigned char bPrio;
+    volatile unsigned int idxHead;      // the next entry to be written, changed by the producers
+    volatile unsigned int idxTail;      // the next entry to be read, changed by the consumer (main)
+    volatile unsigned int cntLost;      // the number of events dropped because the queue was full
+    SCHED_EVENT rgEvents[SCHED_QUEUE_SIZE];
+} SCHED_TASK;
+
+SCHED_TASK rgSchedTasks[SCHED_NO_TASKS];
+unsigned char cntSchedTasks = 0;
+
+/* ------------------------------------------------------------ */
+/***	SCHED_AddTask
+**
+**	Parameters:
+**		unsigned char bPrio         - the task priority, 0 (SCHED_PRIO_HIGH) is the highest priority
+**		SCHED_HANDLER pfHandler     - the function called for each event posted to the task
+**		void *pCtx                  - the context pointer passed to the handler
+**
+**	Return Value:
+**		unsigned char   - the task id, to be used with SCHED_Post
+**                        SCHED_ERR_FULL if SCHED_NO_TASKS tasks are already added
+**
+**	Description:
+**		This function adds a task to the scheduler. It should be called from the main context,
+**      before the events are posted to the task.
+**
+*/
+unsigned char SCHED_AddTask(unsigned char bPrio, SCHED_HANDLER pfHandler, void *pCtx)
+{
+    SCHED_TASK *pTask;
+    if(cntSchedTasks >= SCHED_NO_TASKS)
+    {
+        return SCHED_ERR_FULL;
+    }
+    pTask = &rgSchedTasks[cntSchedTasks];
+    pTask->pfHandler = pfHandler;
+    pTask->pCtx = pCtx;
+    pTask->bPrio = bPrio;
+    pTask->idxHead = 0;
+    pTask->idxTail = 0;
+    pTask->cntLost = 0;
+    return cntSchedTasks++;
+}
+
+/* ------------------------------------------------------------ */
+/***	SCHED_AddStateMachine
+**
+**	Parameters:
+**		unsigned char bPrio             - the task priority, 0 (SCHED_PRIO_HIGH) is the highest priority
+**		SCHED_SM *pSM                   - the state machine control block (memory provided by the caller)
+**		const SCHED_SMELEM *pElems      - the state table
+**		unsigned int cntElems           - the number of states in the table
+**
+**	Return Value:
+**		unsigned char   - the task id, SCHED_EVT_TICK events must be posted to this task (usually from a timer interrupt)
+**                        SCHED_ERR_FULL if SCHED_NO_TASKS tasks are already added
+**
+**	Description:
+**		This function adds a task that runs a state machine table, with the same semantics as the statemachine.c engine:
+**      - the Init function of the first state is called when the task handles the SCHED_EVT_START event, posted by this function
+**      - if the Step function and step counter value are defined, the Step function is called every cntStepTimer ticks
+**      - after cntStateTimer ticks, the Exit function is called and the next state (in a circular manner) is entered.
+**      All the functions are called in the main context, from SCHED_Run.
+**
+*/
+unsigned char SCHED_AddStateMachine(unsigned char bPrio, SCHED_SM *pSM, const SCHED_SMELEM *pElems, unsigned int cntElems)
+{
+    unsigned char idTask;
+    pSM->pElems = pElems;
+    pSM->cntElems = cntElems;
+    pSM->idxState = 0;
+    pSM->idxStep = 0;
+    pSM->idxTimerWithinState = 0;
+    pSM->idxTimerWithinStep = 0;
+    idTask = SCHED_AddTask(bPrio, SCHED_StateMachineHandler, pSM);
+    if(idTask != SCHED_ERR_FULL)
+    {
+        SCHED_Post(idTask, SCHED_EVT_START, 0);
+    }
+    return idTask;
+}
+
+/* ------------------------------------------------------------ */
+/***	SCHED_Post
+**
+**	Parameters:
+**		unsigned char idTask        - the task id, returned by SCHED_AddTask or SCHED_AddStateMachine
+**		unsigned char bEvent        - the event number
+**		unsigned int uiParam        - the event parameter
+**
+**	Return Value:
+**		unsigned char   - SCHED_OK if the event was queued
+**                        SCHED_ERR_FULL if the task queue is full (the event is counted as lost)
+**                        SCHED_ERR_PARAM if the task id is not valid
+**
+**	Description:
+**		This function posts an event to a task. The event will be handled in the main context by SCHED_Run.
+**      The function is lock-free: a queue entry is reserved by atomically advancing the queue head,
+**      then it is written and marked as ready. It can be called from the main context and from
+**      interrupt handlers of any priority, without disabling the interrupts.
+**
+*/
+unsigned char SCHED_Post(unsigned char idTask, unsigned char bEvent, unsigned int uiParam)
+{
+    SCHED_TASK *pTask;
+    SCHED_EVENT *pEvent;
+    unsigned int idxHead, idxNext;
+
+    if(idTask >= cntSchedTasks)
+    {
+        return SCHED_ERR_PARAM;
+    }
+    pTask = &rgSchedTasks[idTask];
+
+    // reserve an entry
+    do
+    {
+        idxHead = pTask->idxHead;
+        idxNext = (idxHead + 1) & QUEUE_MASK;
+        if(idxNext == pTask->idxTail)
+        {
+            __sync_fetch_and_add(&pTask->cntLost, 1);
+            return SCHED_ERR_FULL;
+        }
+    } while(!__sync_bool_compare_and_swap(&pTask->idxHead, idxHead, idxNext));
+
+    // write the entry, then publish it
+    pEvent = &pTask->rgEvents[idxHead];
+    pEvent->bEvent = bEvent;
+    pEvent->uiParam = uiParam;
+    __sync_synchronize();
+    pEvent->fReady = 1;
+    return SCHED_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	SCHED_RunOnce
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - 1 if an event was handled, 0 if no task has pending events
+**
+**	Description:
+**		This function handles one event: among the tasks having pending events, the one with the highest priority
+**      is selected (the first added, for equal priorities) and its handler is called with the oldest event.
+**      It must be called only from the main context.
+**
+*/
+unsigned char SCHED_RunOnce()
+{
+    SCHED_TASK *pTask, *pSel = 0;
+    SCHED_EVENT *pEvent;
+    unsigned char bEvent;
+    unsigned int uiParam;
+    int i;
+
+    for(i = 0; i < cntSchedTasks; i++)
+    {
+        pTask = &rgSchedTasks[i];
+        if(pTask->rgEvents[pTask->idxTail].fReady && (!pSel || pTask->bPrio < pSel->bPrio))
+        {
+            pSel = pTask;
+        }
+    }
+    if(!pSel)
+    {
+        return 0;
+    }
+
+    // read the entry, then free it
+    pEvent = &pSel->rgEvents[pSel->idxTail];
+    bEvent = pEvent->bEvent;
+    uiParam = pEvent->uiParam;
+    pEvent->fReady = 0;
+    __sync_synchronize();
+    pSel->idxTail = (pSel->idxTail + 1) & QUEUE_MASK;
+
+    TRACE_BEGIN(TRACE_SRC_TASK + (pSel - rgSchedTasks), bEvent);
+    (*pSel->pfHandler)(pSel->pCtx, bEvent, uiParam);
+    TRACE_END(TRACE_SRC_TASK + (pSel - rgSchedTasks), bEvent);
+    return 1;
+}
+
+/* ------------------------------------------------------------ */
+/***	SCHED_Run
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function runs the scheduler: the pending events are handled forever, by priority.
+**      When no task has pending events, LOAD_Idle is called, so the CPU load can be measured (see load.c,
+**      LOAD_Init(SCHED_RunOnce) calibrates the same loop).
+**      It is aimed to be called at the end of main, it never returns.
+**
+*/
+void SCHED_Run()
+{
+    while(1)
+    {
+        if(!SCHED_RunOnce())
+        {
+            LOAD_Idle();
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SCHED_GetLostEvents
+**
+**	Parameters:
+**		unsigned char idTask        - the task id
+**
+**	Return Value:
+**		unsigned int    - the number of events dropped because the task queue was full
+**
+**	Description:
+**		This function returns the number of events that could not be posted to a task.
+**      A growing value means the task handlers take too long for the rate of the events.
+**
+*/
+unsigned int SCHED_GetLostEvents(unsigned char idTask)
+{
+    if(idTask >= cntSchedTasks)
+    {
+        return 0;
+    }
+    return rgSchedTasks[idTask].cntLost;
+}
+
+/* ------------------------------------------------------------ */
+/***	SCHED_StateMachineHandler
+**
+**	Parameters:
+**		void *pCtx                  - the state machine control block (SCHED_SM)
+**		unsigned char bEvent        - the event number
+**		unsigned int uiParam        - the event parameter (not used)
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the handler of the tasks added with SCHED_AddStateMachine.
+**      On SCHED_EVT_START it enters the first state, on SCHED_EVT_TICK it advances the step and state counters,
+**      calling the Step, Exit and Init functions of the state table.
+**      This is a low-level function called by SCHED_Run, so user should avoid calling it directly.
+**
+*/
+void SCHED_StateMachineHandler(void *pCtx, unsigned char bEvent, unsigned int uiParam)
+{
+    SCHED_SM *pSM = (SCHED_SM *)pCtx;
+    const SCHED_SMELEM *pElem = &pSM->pElems[pSM->idxState];
+
+    if(bEvent == SCHED_EVT_START)
+    {
+        if(pElem->pfInitTestFnc)
+        {
+            (*pElem->pfInitTestFnc)();
+        }
+        return;
+    }
+    if(bEvent != SCHED_EVT_TICK)
+    {
+        return;
+    }
+
+    if(pElem->pfStepTestFnc &&
+            (++pSM->idxTimerWithinStep >= pElem->cntStepTimer))
+    {
+        // call the step function
+        (*pElem->pfStepTestFnc)(pSM->idxStep++);
+        // reset counter within step
+        pSM->idxTimerWithinStep = 0;
+    }
+
+    if(++pSM->idxTimerWithinState >= pElem->cntStateTimer)
+    {
+        // exit the old state
+        if(pElem->pfExitTestFnc)
+        {
+            (*pElem->pfExitTestFnc)();
+        }
+        if(++pSM->idxState == pSM->cntElems)
+        {
+            // loop within states
+            pSM->idxState = 0;
+        }
+        // init the new state
+        pElem = &pSM->pElems[pSM->idxState];
+        if(pElem->pfInitTestFnc)
+        {
+            (*pElem->pfInitTestFnc)();
+        }
+        // reset counters within state and step
+        pSM->idxTimerWithinState = 0;
+        pSM->idxTimerWithinStep = 0;
+        pSM->idxStep = 0;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
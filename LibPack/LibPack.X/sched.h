@@ -0,0 +1,78 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    sched.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the SCHED library (defined in sched.c).
+        Include the file in the project when this library is needed.
+        Use #include "sched.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _SCHED_H    /* Guard against multiple inclusion */
+#define _SCHED_H
+
+// the maximum number of tasks
+#define SCHED_NO_TASKS          8
+
+// the number of events each task queue can hold (must be a power of 2). One entry is always kept free.
+#define SCHED_QUEUE_SIZE        16
+
+// task priorities: 0 is the highest priority
+#define SCHED_PRIO_HIGH         0
+#define SCHED_PRIO_NORMAL       4
+#define SCHED_PRIO_LOW          7
+
+// events
+#define SCHED_EVT_TICK          0x01    // a timer tick, used by the state machine tasks
+#define SCHED_EVT_START         0x02    // posted when a state machine task is added, the first state is entered
+#define SCHED_EVT_USER          0x10    // the first event number available for the user tasks
+
+// return values
+#define SCHED_OK                0x00
+#define SCHED_ERR_FULL          0xFE    // the task table or the event queue is full
+#define SCHED_ERR_PARAM         0xFC    // invalid task
+
+// the task handler, called in the main context for each event posted to the task
+typedef void (*SCHED_HANDLER)(void *pCtx, unsigned char bEvent, unsigned int uiParam);
+
+// a state of a state machine task, same layout as the StateMachinesElem used by statemachine.c
+typedef struct {
+    unsigned int cntStateTimer;         // the number of ticks spent in the state
+    unsigned int cntStepTimer;          // the number of ticks between two step function calls
+    void (*pfInitTestFnc)();            // called when the state is entered (optional)
+    void (*pfStepTestFnc)(unsigned int);// called every cntStepTimer ticks, with the step index (optional)
+    void (*pfExitTestFnc)();            // called when the state is left (optional)
+} SCHED_SMELEM;
+
+// a state machine task control block. The memory is provided by the user, the fields are private.
+typedef struct {
+    const SCHED_SMELEM *pElems;
+    unsigned int cntElems;
+    unsigned int idxState;
+    unsigned int idxStep;
+    unsigned int idxTimerWithinState;
+    unsigned int idxTimerWithinStep;
+} SCHED_SM;
+
+unsigned char SCHED_AddTask(unsigned char bPrio, SCHED_HANDLER pfHandler, void *pCtx);
+unsigned char SCHED_AddStateMachine(unsigned char bPrio, SCHED_SM *pSM, const SCHED_SMELEM *pElems, unsigned int cntElems);
+unsigned char SCHED_Post(unsigned char idTask, unsigned char bEvent, unsigned int uiParam);
+unsigned char SCHED_RunOnce();
+void SCHED_Run();
+unsigned int SCHED_GetLostEvents(unsigned char idTask);
+
+//private functions:
+void SCHED_StateMachineHandler(void *pCtx, unsigned char bEvent, unsigned int uiParam);
+
+#endif /* _SCHED_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,452 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    softtmr.c
+
+  @Description
+        This file groups the functions that implement the SOFTTMR library.
+        The library provides any number of software timers (one-shot or periodic),
+        all driven by the MIPS core timer, so that periodic jobs do not need a hardware timer and an interrupt each.
+        The timers are kept in a hashed timing wheel of SOFTTMR_WHEEL_SIZE slots, advanced every SOFTTMR_TICK_MS:
+        a timer expiring after N ticks is placed in the slot (current + N) modulo SOFTTMR_WHEEL_SIZE,
+        together with the number of full wheel rotations left. Starting and stopping a timer is O(1),
+        each tick only visits the timers hashed in one slot.
+        The callbacks are called either from the core timer interrupt, or from the low priority
+        core software interrupt 0, so that long callbacks do not delay the other interrupts.
+        The library uses the core timer compare register, so it must not be used by other libraries.
+        Include the file in the project, together with config.h, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include "config.h"
+#include "softtmr.h"
+#include "prof.h"
+#include "trace.h"
+
+/* ************************************************************************** */
+
+// the number of core timer counts in a tick. The core timer is incremented at SYS_FRQ / 2.
+#define CORE_TICKS_PER_TICK     ((SYS_FRQ / 2 / 1000) * SOFTTMR_TICK_MS)
+
+#define WHEEL_MASK              (SOFTTMR_WHEEL_SIZE - 1)
+
+// the slots of the timing wheel, each is the head of a circular list of timers
+SOFTTMR_NODE rgSoftTmrWheel[SOFTTMR_WHEEL_SIZE];
+
+// the number of processed ticks, the current wheel slot is given by its low bits
+volatile unsigned int cntSoftTmrTicks = 0;
+
+// the number of elapsed ticks not yet processed (SOFTTMR_CTX_DEFERRED)
+volatile unsigned int cntSoftTmrPending = 0;
+
+unsigned int uiSoftTmrCompare;
+unsigned char bSoftTmrCtx = SOFTTMR_CTX_ISR;
+unsigned char fSoftTmrInit = 0;
+
+/* ------------------------------------------------------------ */
+/***	CoreTimerISR
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the interrupt handler for the core timer, called every SOFTTMR_TICK_MS.
+**      The compare register is advanced by whole ticks, so there is no drift. If ticks were missed
+**      (interrupts disabled for a long time), all of them are accounted.
+**      The ticks are processed here (SOFTTMR_CTX_ISR) or in the core software interrupt 0 (SOFTTMR_CTX_DEFERRED).
+**
+*/
+void __ISR(_CORE_TIMER_VECTOR, IPL3AUTO) CoreTimerISR(void)
+{
+    unsigned int cntTicks = 0;
+    PROF_ISR_ENTER_LAT(PROF_ID_CORETMR, _CP0_GET_COUNT() - uiSoftTmrCompare);
+    TRACE_BEGIN(TRACE_SRC_CORETMR, 0);
+    do
+    {
+        uiSoftTmrCompare += CORE_TICKS_PER_TICK;
+        cntTicks++;
+        _CP0_SET_COMPARE(uiSoftTmrCompare);    // also clears the core timer interrupt request
+    } while((int)(_CP0_GET_COUNT() - uiSoftTmrCompare) >= 0);
+    IFS0bits.CTIF = 0;                  // clear interrupt flag
+
+    if(bSoftTmrCtx == SOFTTMR_CTX_DEFERRED)
+    {
+        cntSoftTmrPending += cntTicks;
+        _CP0_BIS_CAUSE(_CP0_CAUSE_IP0_MASK);   // request core software interrupt 0
+    }
+    else
+    {
+        while(cntTicks--)
+        {
+            SOFTTMR_ProcessTick();
+        }
+    }
+    TRACE_END(TRACE_SRC_CORETMR, 0);
+    PROF_ISR_EXIT(PROF_ID_CORETMR);
+}
+
+/* ------------------------------------------------------------ */
+/***	CoreSoftware0ISR
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the interrupt handler for the core software interrupt 0, requested by the core timer
+**      interrupt handler when the library is initialized with SOFTTMR_CTX_DEFERRED.
+**      It processes the pending ticks at a low priority.
+**
+*/
+void __ISR(_CORE_SOFTWARE_0_VECTOR, IPL1AUTO) CoreSoftware0ISR(void)
+{
+    unsigned int uiStatus;
+    _CP0_BIC_CAUSE(_CP0_CAUSE_IP0_MASK);
+    IFS0bits.CS0IF = 0;                 // clear interrupt flag
+    while(cntSoftTmrPending)
+    {
+        uiStatus = __builtin_disable_interrupts();
+        cntSoftTmrPending--;
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+        SOFTTMR_ProcessTick();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_Init
+**
+**	Parameters:
+**		unsigned char bCtx  - the context where the callbacks are called:
+**                              SOFTTMR_CTX_ISR         - from the core timer interrupt (priority 3)
+**                              SOFTTMR_CTX_DEFERRED    - from the core software interrupt 0 (priority 1)
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function initializes the SOFTTMR library: the timing wheel is emptied and
+**      the core timer is configured to generate an interrupt every SOFTTMR_TICK_MS.
+**      The tick period is computed using the system frequency definition (SYS_FRQ, located in config.h).
+**      If the library is already initialized, only the callbacks context is changed, the running timers are kept.
+**
+*/
+void SOFTTMR_Init(unsigned char bCtx)
+{
+    int i;
+    bSoftTmrCtx = bCtx;
+    if(!fSoftTmrInit)
+    {
+        for(i = 0; i < SOFTTMR_WHEEL_SIZE; i++)
+        {
+            rgSoftTmrWheel[i].pNext = &rgSoftTmrWheel[i];
+            rgSoftTmrWheel[i].pPrev = &rgSoftTmrWheel[i];
+        }
+        cntSoftTmrPending = 0;
+        fSoftTmrInit = 1;
+
+        macro_disable_interrupts;           // disable interrupts at CPU
+        uiSoftTmrCompare = _CP0_GET_COUNT() + CORE_TICKS_PER_TICK;
+        _CP0_SET_COMPARE(uiSoftTmrCompare);
+        IPC0bits.CTIP = 3;                  // priority
+        IPC0bits.CTIS = 0;                  // subpriority
+        IFS0bits.CTIF = 0;                  // clear interrupt flag
+        IEC0bits.CTIE = 1;                  // enable interrupt
+    }
+    else
+    {
+        macro_disable_interrupts;           // disable interrupts at CPU
+    }
+    IPC0bits.CS0IP = 1;                 // priority
+    IPC0bits.CS0IS = 0;                 // subpriority
+    IFS0bits.CS0IF = 0;                 // clear interrupt flag
+    IEC0bits.CS0IE = (bCtx == SOFTTMR_CTX_DEFERRED);
+    macro_enable_interrupts();          // enable interrupts at CPU
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_Start
+**
+**	Parameters:
+**		SOFTTMR_TIMER *pTmr             - the timer. The memory must remain valid while the timer is active.
+**		unsigned int msDelay            - the time until the first expiration, in milliseconds
+**		unsigned int msPeriod           - the period in milliseconds for periodic timers, 0 for one-shot timers
+**		SOFTTMR_CALLBACK pfCallback     - the function called when the timer expires
+**		void *pArg                      - the argument passed to the callback
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function starts a soft timer. If the timer is already active, it is restarted.
+**      The times are rounded up to SOFTTMR_TICK_MS, and are at least one tick.
+**      A periodic timer is rescheduled before its callback is called, so the callback may stop it.
+**      The function can be called from the main loop, from interrupts or from the callbacks.
+**
+*/
+void SOFTTMR_Start(SOFTTMR_TIMER *pTmr, unsigned int msDelay, unsigned int msPeriod, SOFTTMR_CALLBACK pfCallback, void *pArg)
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    if(pTmr->node.pNext)
+    {
+        SOFTTMR_Unlink(&pTmr->node);
+    }
+    pTmr->msPeriod = msPeriod;
+    pTmr->pfCallback = pfCallback;
+    pTmr->pArg = pArg;
+    SOFTTMR_Insert(pTmr, (msDelay + SOFTTMR_TICK_MS - 1) / SOFTTMR_TICK_MS);
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_Stop
+**
+**	Parameters:
+**		SOFTTMR_TIMER *pTmr     - the timer
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function stops a soft timer. Nothing happens if the timer is not active.
+**
+*/
+void SOFTTMR_Stop(SOFTTMR_TIMER *pTmr)
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    if(pTmr->node.pNext)
+    {
+        SOFTTMR_Unlink(&pTmr->node);
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_IsActive
+**
+**	Parameters:
+**		SOFTTMR_TIMER *pTmr     - the timer
+**
+**	Return Value:
+**		unsigned char   - 1 if the timer is started and did not expire (or is periodic), 0 otherwise
+**
+**	Description:
+**		This function returns the state of a soft timer.
+**
+*/
+unsigned char SOFTTMR_IsActive(SOFTTMR_TIMER *pTmr)
+{
+    return pTmr->node.pNext != 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_GetTicks
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned int    - the number of ticks processed since the library was initialized
+**
+**	Description:
+**		This function returns the number of SOFTTMR_TICK_MS ticks processed since the library was initialized.
+**
+*/
+unsigned int SOFTTMR_GetTicks()
+{
+    return cntSoftTmrTicks;
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_Close
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function releases the hardware involved in the SOFTTMR library:
+**      the core timer and core software interrupt 0 are disabled. The active timers are dropped.
+**
+*/
+void SOFTTMR_Close()
+{
+    int i;
+    IEC0bits.CTIE = 0;
+    IEC0bits.CS0IE = 0;
+    for(i = 0; i < SOFTTMR_WHEEL_SIZE; i++)
+    {
+        while(rgSoftTmrWheel[i].pNext != &rgSoftTmrWheel[i])
+        {
+            SOFTTMR_Unlink(rgSoftTmrWheel[i].pNext);
+        }
+    }
+    fSoftTmrInit = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_Insert
+**
+**	Parameters:
+**		SOFTTMR_TIMER *pTmr         - the timer
+**		unsigned int cntTicks       - the number of ticks until expiration
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function places a timer in the timing wheel slot where it expires,
+**      and computes the number of full wheel rotations until expiration.
+**      Must be called with interrupts disabled.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SOFTTMR_Insert(SOFTTMR_TIMER *pTmr, unsigned int cntTicks)
+{
+    SOFTTMR_NODE *pSlot;
+    if(!cntTicks)
+    {
+        cntTicks = 1;
+    }
+    pSlot = &rgSoftTmrWheel[(cntSoftTmrTicks + cntTicks) & WHEEL_MASK];
+    pTmr->cntRounds = (cntTicks - 1) / SOFTTMR_WHEEL_SIZE;
+
+    // link at the head of the slot list
+    pTmr->node.pNext = pSlot->pNext;
+    pTmr->node.pPrev = pSlot;
+    pSlot->pNext->pPrev = &pTmr->node;
+    pSlot->pNext = &pTmr->node;
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_Unlink
+**
+**	Parameters:
+**		SOFTTMR_NODE *pNode     - the timer node
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function removes a timer from the list it belongs to, and marks it as inactive.
+**      Must be called with interrupts disabled.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SOFTTMR_Unlink(SOFTTMR_NODE *pNode)
+{
+    pNode->pPrev->pNext = pNode->pNext;
+    pNode->pNext->pPrev = pNode->pPrev;
+    pNode->pNext = 0;
+    pNode->pPrev = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	SOFTTMR_ProcessTick
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function advances the timing wheel by one tick and processes the timers of the new slot:
+**      the timers with rotations left are kept in the slot, the other timers expire:
+**      they are rescheduled (periodic timers) or become inactive (one-shot timers), then their callback is called.
+**      The slot list is first moved to a local list, so the callbacks may start or stop any timer.
+**      The lists are only changed with interrupts disabled, the callbacks are called with interrupts enabled.
+**      This is a low-level function called by the interrupt handlers, so user should avoid calling it directly.
+**
+*/
+void SOFTTMR_ProcessTick()
+{
+    static SOFTTMR_NODE lstExpiring;
+    SOFTTMR_NODE *pSlot;
+    SOFTTMR_TIMER *pTmr;
+    SOFTTMR_CALLBACK pfCallback;
+    unsigned int uiStatus;
+
+    uiStatus = __builtin_disable_interrupts();
+    cntSoftTmrTicks++;
+    pSlot = &rgSoftTmrWheel[cntSoftTmrTicks & WHEEL_MASK];
+    if(pSlot->pNext == pSlot)
+    {
+        // empty slot
+        lstExpiring.pNext = &lstExpiring;
+        lstExpiring.pPrev = &lstExpiring;
+    }
+    else
+    {
+        // move the slot list to the local list
+        lstExpiring.pNext = pSlot->pNext;
+        lstExpiring.pPrev = pSlot->pPrev;
+        lstExpiring.pNext->pPrev = &lstExpiring;
+        lstExpiring.pPrev->pNext = &lstExpiring;
+        pSlot->pNext = pSlot;
+        pSlot->pPrev = pSlot;
+    }
+
+    while(lstExpiring.pNext != &lstExpiring)
+    {
+        pTmr = (SOFTTMR_TIMER *)lstExpiring.pNext;
+        SOFTTMR_Unlink(&pTmr->node);
+        if(pTmr->cntRounds)
+        {
+            // not this rotation, put it back in the slot
+            pTmr->cntRounds--;
+            pTmr->node.pNext = pSlot->pNext;
+            pTmr->node.pPrev = pSlot;
+            pSlot->pNext->pPrev = &pTmr->node;
+            pSlot->pNext = &pTmr->node;
+            continue;
+        }
+        if(pTmr->msPeriod)
+        {
+            SOFTTMR_Insert(pTmr, (pTmr->msPeriod + SOFTTMR_TICK_MS - 1) / SOFTTMR_TICK_MS);
+        }
+        pfCallback = pTmr->pfCallback;
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+        if(pfCallback)
+        {
+            (*pfCallback)(pTmr->pArg);
+        }
+        uiStatus = __builtin_disable_interrupts();
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
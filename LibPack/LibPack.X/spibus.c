@@ -0,0 +1,883 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spibus.c
+
+  @Description
+        This file groups the functions that implement the SPIBUS library.
+        The library shares the SPI1 and SPI2 modules between several devices, each one having its own
+        settings (clock frequency, polarity, edge, frame width) and chip select pin:
+        - the transactions of each bus are queued, and executed in order. The SPIxCON and SPIxBRG registers
+          are written only when the next transaction needs different settings than the ones already loaded.
+        - the modules work in enhanced buffer mode (16 bytes FIFOs). The polled transfers keep the transmit FIFO
+          filled while they read the received frames, so there is no idle time between the frames.
+        - on SPI2, the data phases of at least SPIBUS_DMA_MIN_BYTES (with a transmit or a receive buffer) are moved by two DMA channels
+          (SPIBUS_DMA_TX, SPIBUS_DMA_RX) triggered by the FIFO events, and the transaction is completed
+          from the DMA interrupt (or, without receive buffer, from the SPI2 interrupt, when the last frame is
+          shifted out). The shorter transactions, and all the SPI1 transactions, are polled: they are executed
+          by SPIBUS_Submit, or, when they are queued behind a DMA transaction, from the low priority core
+          software interrupt 1 (or by SPIBUS_Wait), so the interrupts never execute polled transfers.
+        The SPIJA and SPIFLASH libraries are built on this library. Other devices can share a bus by adding
+        their own chip select pin, for example a second Pmod on JA using JA7 as chip select, after SPIJA_Init.
+        The remappable pins of the buses are configured by SPIJA_ConfigurePins and SPIFLASH_ConfigurePins.
+        Include the file in the project, together with config.h, gpio.c and hwres.c, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include <sys/kmem.h>
+#include <string.h>
+#include "config.h"
+#include "spibus.h"
+#include "gpio.h"
+#include "hwres.h"
+#include "prof.h"
+
+/* ************************************************************************** */
+
+#define SPIBUS_QUEUE_MASK   (SPIBUS_QUEUE_SIZE - 1)
+
+// the registers of a bus
+typedef struct {
+    volatile unsigned int *pCON;
+    volatile unsigned int *pCONSET;
+    volatile unsigned int *pCON2;
+    volatile unsigned int *pSTAT;
+    volatile unsigned int *pSTATCLR;
+    volatile unsigned int *pBUF;
+    volatile unsigned int *pBRG;
+    unsigned char bTxIrq;               // the FIFO events, used as DMA triggers
+    unsigned char bRxIrq;
+    unsigned char fDMA;                 // the bus uses the DMA channels
+} SPIBUS_REGS;
+
+const SPIBUS_REGS rgSpiBusRegs[SPIBUS_NO_BUSES] = {
+    {&SPI1CON, &SPI1CONSET, &SPI1CON2, &SPI1STAT, &SPI1STATCLR, &SPI1BUF, &SPI1BRG, _SPI1_TX_IRQ, _SPI1_RX_IRQ, 0},
+    {&SPI2CON, &SPI2CONSET, &SPI2CON2, &SPI2STAT, &SPI2STATCLR, &SPI2BUF, &SPI2BRG, _SPI2_TX_IRQ, _SPI2_RX_IRQ, 1}
+};
+
+// a device
+typedef struct {
+    unsigned char bBus;
+    unsigned char bFrameBytes;          // 1, 2 or 4, 0 for a free entry
+    GPIO_PIN pinCS;                     // chip select, active low
+    unsigned int uiCon;                 // the SPIxCON value (without ON)
+    unsigned int uiBrg;                 // the SPIxBRG value
+} SPIBUS_DEVICE;
+
+SPIBUS_DEVICE rgSpiBusDevs[SPIBUS_NO_DEVICES];
+
+// the state of a bus. The free running queue indexes are changed by SPIBUS_Submit with interrupts disabled (head),
+// and by the owner of the bus (tail). The transaction in progress is the one at the tail.
+typedef struct {
+    SPIBUS_XFER *rgQueue[SPIBUS_QUEUE_SIZE];
+    volatile unsigned int idxHead, idxTail;
+    volatile unsigned char fActive;     // a transaction is in progress
+    unsigned char cntDevices;
+    unsigned char fConfigured;          // the settings below are loaded in the SPI module
+    unsigned int uiCon;
+    unsigned int uiBrg;
+} SPIBUS_STATE;
+
+SPIBUS_STATE rgSpiBuses[SPIBUS_NO_BUSES];
+
+// the DMA state (SPI2)
+unsigned char fSpiBusDMA = 0;           // the DMA channels are allocated
+unsigned char fSpiBusRxDMA;             // the RX channel is used by the transfer in progress
+
+/* ------------------------------------------------------------ */
+/***	Dma0ISR, Dma1ISR
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		The interrupt handlers of the DMA channels (block transfer complete). Only the channel that finishes
+**      last has the interrupt enabled. The priority is SPIBUS_DMA_IPL (the IPL values below must match it).
+**
+*/
+void __ISR(_DMA_0_VECTOR, IPL3AUTO) Dma0ISR(void)
+{
+    PROF_ISR_ENTER(PROF_ID_DMA0);
+    DCH0INTCLR = _DCH0INT_CHBCIF_MASK;
+    IFS2bits.DMA0IF = 0;                // clear interrupt flag
+    SPIBUS_DMADone();
+    PROF_ISR_EXIT(PROF_ID_DMA0);
+}
+
+void __ISR(_DMA_1_VECTOR, IPL3AUTO) Dma1ISR(void)
+{
+    PROF_ISR_ENTER(PROF_ID_DMA1);
+    DCH1INTCLR = _DCH1INT_CHBCIF_MASK;
+    IFS2bits.DMA1IF = 0;                // clear interrupt flag
+    SPIBUS_DMADone();
+    PROF_ISR_EXIT(PROF_ID_DMA1);
+}
+
+/* ------------------------------------------------------------ */
+/***	Spi2ISR
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		The interrupt handler of SPI2, enabled by SPIBUS_DMADone for a DMA transaction without receive buffer:
+**      the transmit interrupt is generated when the last frame is shifted out. The priority is SPIBUS_DMA_IPL.
+**
+*/
+void __ISR(_SPI_2_VECTOR, IPL3AUTO) Spi2ISR(void)
+{
+    PROF_ISR_ENTER(PROF_ID_SPI2);
+    IEC1bits.SPI2TXIE = 0;
+    SPI2CONbits.STXISEL = 3;            // TX event while the transmit FIFO is not full, for the next DMA transfers
+    IFS1bits.SPI2TXIF = 0;              // clear interrupt flag
+    SPIBUS_DrainRx(SPIBUS_2);
+    SPIBUS_Complete(SPIBUS_2);
+    SPIBUS_RequestProcess();
+    PROF_ISR_EXIT(PROF_ID_SPI2);
+}
+
+/* ------------------------------------------------------------ */
+/***	CoreSoftware1ISR
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		The interrupt handler of the core software interrupt 1, requested when a DMA transaction completes:
+**      the transactions queued behind it are executed here, at priority 1, so the long polled transfers
+**      only delay the main context.
+**
+*/
+void __ISR(_CORE_SOFTWARE_1_VECTOR, IPL1AUTO) CoreSoftware1ISR(void)
+{
+    _CP0_BIC_CAUSE(_CP0_CAUSE_IP1_MASK);
+    IFS0bits.CS1IF = 0;                 // clear interrupt flag
+    SPIBUS_Process(SPIBUS_2);
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_AddDevice
+**
+**	Parameters:
+**		unsigned char bBus          - the bus: SPIBUS_1 or SPIBUS_2
+**		GPIO_PIN pinCS              - the chip select pin (active low), for example pin_SPIJA_CE
+**		unsigned int uiFreq         - SPI clock frequency (Hz)
+**		unsigned char bPol          - SPI Clock Polarity, similar to CKP field of SPIxCON
+**		unsigned char bEdge         - SPI Clock Edge, similar to CKE field of SPIxCON
+**		unsigned char bBits         - the frame width: 8, 16 or 32 bits
+**
+**	Return Value:
+**		unsigned char   - the device, to be used in the transactions
+**                        SPIBUS_ERR_FULL if SPIBUS_NO_DEVICES devices are already added
+**                        SPIBUS_ERR_PARAM if the bus or the frame width is invalid
+**
+**	Description:
+**		This function adds a device on a bus. The chip select pin is configured as digital output, inactive (high).
+**      The SPI module is configured at the first transaction. When the first device is added on SPI2, the DMA
+**      channels are allocated; if they are used by another library, all the transfers are polled.
+**
+*/
+unsigned char SPIBUS_AddDevice(unsigned char bBus, GPIO_PIN pinCS, unsigned int uiFreq, unsigned char bPol, unsigned char bEdge, unsigned char bBits)
+{
+    unsigned char bDevice;
+    if(bBus >= SPIBUS_NO_BUSES)
+    {
+        return SPIBUS_ERR_PARAM;
+    }
+    for(bDevice = 0; bDevice < SPIBUS_NO_DEVICES && rgSpiBusDevs[bDevice].bFrameBytes; bDevice++);
+    if(bDevice == SPIBUS_NO_DEVICES)
+    {
+        return SPIBUS_ERR_FULL;
+    }
+    rgSpiBusDevs[bDevice].bBus = bBus;
+    rgSpiBusDevs[bDevice].pinCS = pinCS;
+    if(SPIBUS_SetDeviceConfig(bDevice, uiFreq, bPol, bEdge, bBits) != SPIBUS_OK)
+    {
+        return SPIBUS_ERR_PARAM;
+    }
+    GPIO_SetValue(pinCS, 1);
+    GPIO_ConfigurePin(pinCS, GPIO_DIR_OUTPUT, 0, 0);
+    if(!rgSpiBuses[bBus].cntDevices++ && rgSpiBusRegs[bBus].fDMA)
+    {
+        fSpiBusDMA = (SPIBUS_AllocDMA() == HWRES_OK);
+    }
+    return bDevice;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_SetDeviceConfig
+**
+**	Parameters:
+**		unsigned char bDevice       - the device
+**		unsigned int uiFreq         - SPI clock frequency (Hz)
+**		unsigned char bPol          - SPI Clock Polarity, similar to CKP field of SPIxCON
+**		unsigned char bEdge         - SPI Clock Edge, similar to CKE field of SPIxCON
+**		unsigned char bBits         - the frame width: 8, 16 or 32 bits
+**
+**	Return Value:
+**		unsigned char   - SPIBUS_OK
+**                        SPIBUS_ERR_PARAM if the frame width is invalid
+**
+**	Description:
+**		This function changes the settings of a device. The SPIxCON and SPIxBRG values are computed here,
+**      and loaded in the SPI module by the next transaction of the device.
+**      It must not be called while a transaction of the device is queued.
+**
+*/
+unsigned char SPIBUS_SetDeviceConfig(unsigned char bDevice, unsigned int uiFreq, unsigned char bPol, unsigned char bEdge, unsigned char bBits)
+{
+    SPIBUS_DEVICE *pDev;
+    if(bDevice >= SPIBUS_NO_DEVICES || (bBits != 8 && bBits != 16 && bBits != 32) || !uiFreq)
+    {
+        return SPIBUS_ERR_PARAM;
+    }
+    pDev = &rgSpiBusDevs[bDevice];
+    pDev->uiCon = _SPI1CON_MSTEN_MASK |                         // Master
+                  _SPI1CON_ENHBUF_MASK |                        // Enhanced buffer mode (16 bytes FIFOs)
+                  (3 << _SPI1CON_STXISEL_POSITION) |            // TX event while the transmit FIFO is not full
+                  (1 << _SPI1CON_SRXISEL_POSITION) |            // RX event while the receive FIFO is not empty
+                  (bPol ? _SPI1CON_CKP_MASK : 0) |              // SPI Clock Polarity
+                  (bEdge ? _SPI1CON_CKE_MASK : 0) |             // SPI Clock Edge
+                  (bBits == 16 ? _SPI1CON_MODE16_MASK : 0) |
+                  (bBits == 32 ? _SPI1CON_MODE32_MASK : 0);
+    pDev->uiBrg = PB_FRQ / (2 * uiFreq) - 1;
+    pDev->bFrameBytes = bBits >> 3;
+    return SPIBUS_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_RemoveDevice
+**
+**	Parameters:
+**		unsigned char bDevice       - the device
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function removes a device. When the last device of a bus is removed, the SPI module is turned off
+**      and the DMA channels are released.
+**      It must not be called while a transaction of the device is queued.
+**
+*/
+void SPIBUS_RemoveDevice(unsigned char bDevice)
+{
+    unsigned char bBus;
+    if(bDevice >= SPIBUS_NO_DEVICES || !rgSpiBusDevs[bDevice].bFrameBytes)
+    {
+        return;
+    }
+    bBus = rgSpiBusDevs[bDevice].bBus;
+    rgSpiBusDevs[bDevice].bFrameBytes = 0;
+    if(!--rgSpiBuses[bBus].cntDevices)
+    {
+        *rgSpiBusRegs[bBus].pCON = 0;   // disable SPI
+        rgSpiBuses[bBus].fConfigured = 0;
+        if(rgSpiBusRegs[bBus].fDMA && fSpiBusDMA)
+        {
+            IEC2bits.DMA0IE = 0;
+            IEC2bits.DMA1IE = 0;
+            IEC1bits.SPI2TXIE = 0;
+            IEC0bits.CS1IE = 0;
+            DCH0CONbits.CHEN = 0;
+            DCH1CONbits.CHEN = 0;
+            HWRES_ReleaseDMA(SPIBUS_DMA_TX, HWRES_OWNER_SPIBUS);
+            HWRES_ReleaseDMA(SPIBUS_DMA_RX, HWRES_OWNER_SPIBUS);
+            fSpiBusDMA = 0;
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_Submit
+**
+**	Parameters:
+**		SPIBUS_XFER *pXfer  - the transaction. The bDevice, pbCmd, cbCmd, pWr, pRd, cbData, pfCallback and pArg
+**                            fields must be filled by the caller.
+**
+**	Return Value:
+**      unsigned char   SPIBUS_OK           the transaction was queued
+**                      SPIBUS_ERR_FULL     the queue of the bus is full (SPIBUS_QUEUE_SIZE transactions)
+**                      SPIBUS_ERR_PARAM    the device is invalid, or a length is not a multiple of the frame size
+**
+**	Description:
+**		This function queues a transaction, and executes the queued transactions if the bus is idle.
+**      The transaction status is SPIBUS_PENDING until it completes, then it is set to SPIBUS_OK
+**      and the callback is called. A polled transaction completes before the function returns, a DMA transaction
+**      completes from the DMA interrupt.
+**      The function can be called from the main context, from interrupt handlers and from the callbacks.
+**
+*/
+unsigned char SPIBUS_Submit(SPIBUS_XFER *pXfer)
+{
+    SPIBUS_DEVICE *pDev;
+    SPIBUS_STATE *pBus;
+    unsigned int uiStatus;
+    if(pXfer->bDevice >= SPIBUS_NO_DEVICES || !rgSpiBusDevs[pXfer->bDevice].bFrameBytes)
+    {
+        return SPIBUS_ERR_PARAM;
+    }
+    pDev = &rgSpiBusDevs[pXfer->bDevice];
+    if((pXfer->cbCmd % pDev->bFrameBytes) || (pXfer->cbData % pDev->bFrameBytes))
+    {
+        return SPIBUS_ERR_PARAM;
+    }
+    pBus = &rgSpiBuses[pDev->bBus];
+    uiStatus = __builtin_disable_interrupts();
+    if(pBus->idxHead - pBus->idxTail >= SPIBUS_QUEUE_SIZE)
+    {
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+        return SPIBUS_ERR_FULL;
+    }
+    pXfer->bStatus = SPIBUS_PENDING;
+    pBus->rgQueue[pBus->idxHead++ & SPIBUS_QUEUE_MASK] = pXfer;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    SPIBUS_Process(pDev->bBus);
+    return SPIBUS_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_Wait
+**
+**	Parameters:
+**		SPIBUS_XFER *pXfer  - a transaction queued using SPIBUS_Submit
+**
+**	Return Value:
+**      unsigned char   - the transaction status: SPIBUS_OK
+**
+**	Description:
+**		This function waits until the transaction completes, and returns its status. While it waits, it executes
+**      the queued transactions of the bus when it is idle, so it also works from contexts that the core software
+**      interrupt 1 cannot preempt.
+**      It must not be called from the callbacks or from interrupt handlers with priority SPIBUS_DMA_IPL or higher.
+**
+*/
+unsigned char SPIBUS_Wait(SPIBUS_XFER *pXfer)
+{
+    while(pXfer->bStatus == SPIBUS_PENDING)
+    {
+        SPIBUS_Process(rgSpiBusDevs[pXfer->bDevice].bBus);
+    }
+    return pXfer->bStatus;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_Transfer
+**
+**	Parameters:
+**		unsigned char bDevice       - the device
+**		const unsigned char *pbCmd  - the command phase frames, or 0
+**		unsigned char cbCmd         - the command phase length, in bytes
+**		const void *pWr             - the data phase frames to be transmitted, or 0 to transmit 0xFF bytes
+**		void *pRd                   - the data phase received frames, or 0 to discard them
+**		unsigned int cbData         - the data phase length, in bytes
+**
+**	Return Value:
+**      unsigned char   - SPIBUS_OK, SPIBUS_ERR_FULL or SPIBUS_ERR_PARAM (see SPIBUS_Submit)
+**
+**	Description:
+**		This function queues a transaction and waits until it completes (see SPIBUS_Submit and SPIBUS_Wait).
+**
+*/
+unsigned char SPIBUS_Transfer(unsigned char bDevice, const unsigned char *pbCmd, unsigned char cbCmd,
+                        const void *pWr, void *pRd, unsigned int cbData)
+{
+    SPIBUS_XFER xfer;
+    unsigned char bResult;
+    xfer.bDevice = bDevice;
+    xfer.pbCmd = pbCmd;
+    xfer.cbCmd = cbCmd;
+    xfer.pWr = pWr;
+    xfer.pRd = pRd;
+    xfer.cbData = cbData;
+    xfer.pfCallback = 0;
+    xfer.pArg = 0;
+    bResult = SPIBUS_Submit(&xfer);
+    if(bResult != SPIBUS_OK)
+    {
+        return bResult;
+    }
+    return SPIBUS_Wait(&xfer);
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_IsIdle
+**
+**	Parameters:
+**		unsigned char bBus          - the bus: SPIBUS_1 or SPIBUS_2
+**
+**	Return Value:
+**      unsigned char   - 1 if no transaction is queued or in progress on the bus, 0 otherwise
+**
+**	Description:
+**		This function checks if a bus is idle.
+**
+*/
+unsigned char SPIBUS_IsIdle(unsigned char bBus)
+{
+    return !rgSpiBuses[bBus].fActive && rgSpiBuses[bBus].idxHead == rgSpiBuses[bBus].idxTail;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_Process
+**
+**	Parameters:
+**		unsigned char bBus          - the bus
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function executes the queued transactions of a bus, until the queue is empty or a DMA transfer
+**      is started. If a transaction is already in progress (for example the caller interrupted a polled
+**      transaction), it returns immediately: the owner of the bus executes the new transactions.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_Process(unsigned char bBus)
+{
+    SPIBUS_STATE *pBus = &rgSpiBuses[bBus];
+    SPIBUS_XFER *pXfer;
+    SPIBUS_DEVICE *pDev;
+    unsigned int uiStatus;
+    while(1)
+    {
+        uiStatus = __builtin_disable_interrupts();
+        if(pBus->fActive || pBus->idxHead == pBus->idxTail)
+        {
+            if(uiStatus & 1)
+            {
+                __builtin_enable_interrupts();
+            }
+            return;
+        }
+        pBus->fActive = 1;
+        if(uiStatus & 1)
+        {
+            __builtin_enable_interrupts();
+        }
+        pXfer = pBus->rgQueue[pBus->idxTail & SPIBUS_QUEUE_MASK];
+        pDev = &rgSpiBusDevs[pXfer->bDevice];
+        SPIBUS_Configure(bBus, pXfer->bDevice);
+        GPIO_SetValue(pDev->pinCS, 0);      // Activate SS
+        if(pXfer->cbCmd)
+        {
+            SPIBUS_PolledTransfer(bBus, pDev->bFrameBytes, pXfer->pbCmd, 0, pXfer->cbCmd);
+        }
+        // without any buffer there is no memory to transmit the 0xFF frames from: the data phase is polled
+        if(rgSpiBusRegs[bBus].fDMA && fSpiBusDMA && (pXfer->pWr || pXfer->pRd) &&
+            pXfer->cbData >= SPIBUS_DMA_MIN_BYTES && pXfer->cbData <= SPIBUS_DMA_MAX_BYTES)
+        {
+            SPIBUS_StartDMA(bBus, pDev->bFrameBytes, pXfer->pWr, pXfer->pRd, pXfer->cbData);
+            return;                         // completed by SPIBUS_DMADone
+        }
+        if(pXfer->cbData)
+        {
+            SPIBUS_PolledTransfer(bBus, pDev->bFrameBytes, pXfer->pWr, pXfer->pRd, pXfer->cbData);
+        }
+        SPIBUS_Complete(bBus);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_Complete
+**
+**	Parameters:
+**		unsigned char bBus          - the bus
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function deactivates the chip select of the transaction in progress, removes it from the queue,
+**      sets its status and calls its callback. Then the bus is free for the next transaction.
+**      The callbacks of the DMA transactions are called at SPIBUS_DMA_IPL, the other ones from the context that
+**      executes the transaction (SPIBUS_Submit, SPIBUS_Wait or the core software interrupt 1).
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_Complete(unsigned char bBus)
+{
+    SPIBUS_STATE *pBus = &rgSpiBuses[bBus];
+    SPIBUS_XFER *pXfer = pBus->rgQueue[pBus->idxTail & SPIBUS_QUEUE_MASK];
+    GPIO_SetValue(rgSpiBusDevs[pXfer->bDevice].pinCS, 1);    // Deactivate SS
+    pBus->idxTail++;
+    pXfer->bStatus = SPIBUS_OK;
+    if(pXfer->pfCallback)
+    {
+        (*pXfer->pfCallback)(pXfer);
+    }
+    pBus->fActive = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_Configure
+**
+**	Parameters:
+**		unsigned char bBus          - the bus
+**		unsigned char bDevice       - the device of the next transaction
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function loads the settings of a device in the SPI module, only if they are different
+**      from the settings already loaded. The module is disabled while it is configured.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_Configure(unsigned char bBus, unsigned char bDevice)
+{
+    const SPIBUS_REGS *pRegs = &rgSpiBusRegs[bBus];
+    SPIBUS_STATE *pBus = &rgSpiBuses[bBus];
+    SPIBUS_DEVICE *pDev = &rgSpiBusDevs[bDevice];
+    if(pBus->fConfigured && pBus->uiCon == pDev->uiCon && pBus->uiBrg == pDev->uiBrg)
+    {
+        return;
+    }
+    *pRegs->pCON = 0;               // disable SPI, this also empties the FIFOs
+    *pRegs->pCON2 = 0;              // Audio protocol is disabled
+    *pRegs->pBRG = pDev->uiBrg;
+    *pRegs->pCON = pDev->uiCon;
+    *pRegs->pCONSET = _SPI1CON_ON_MASK;     // enable SPI
+    pBus->uiCon = pDev->uiCon;
+    pBus->uiBrg = pDev->uiBrg;
+    pBus->fConfigured = 1;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_PolledTransfer
+**
+**	Parameters:
+**		unsigned char bBus          - the bus
+**		unsigned char bFrameBytes   - the frame size (1, 2 or 4)
+**		const void *pWr             - the frames to be transmitted, or 0 to transmit 0xFF bytes
+**		void *pRd                   - the received frames, or 0 to discard them
+**		unsigned int cbLen          - the length, in bytes
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function transfers frames without handling the chip select. The transmit FIFO is kept filled,
+**      at most SPIBUS_FIFO_BYTES ahead of the received frames, so the receive FIFO cannot overflow.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_PolledTransfer(unsigned char bBus, unsigned char bFrameBytes, const void *pWr, void *pRd, unsigned int cbLen)
+{
+    const SPIBUS_REGS *pRegs = &rgSpiBusRegs[bBus];
+    unsigned int cntFrames = cbLen / bFrameBytes;
+    unsigned int cntFifo = SPIBUS_FIFO_BYTES / bFrameBytes;
+    unsigned int idxTx = 0, idxRx = 0;
+    unsigned int uiVal;
+    while(idxRx < cntFrames)
+    {
+        if(idxTx < cntFrames && idxTx - idxRx < cntFifo && !(*pRegs->pSTAT & _SPI1STAT_SPITBF_MASK))
+        {
+            *pRegs->pBUF = pWr ? SPIBUS_GetFrame(pWr, bFrameBytes, idxTx) : 0xFFFFFFFF;
+            idxTx++;
+        }
+        if(!(*pRegs->pSTAT & _SPI1STAT_SPIRBE_MASK))
+        {
+            uiVal = *pRegs->pBUF;
+            if(pRd)
+            {
+                SPIBUS_PutFrame(pRd, bFrameBytes, idxRx, uiVal);
+            }
+            idxRx++;
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_StartDMA
+**
+**	Parameters:
+**		unsigned char bBus          - the bus (SPIBUS_2)
+**		unsigned char bFrameBytes   - the frame size (1, 2 or 4)
+**		const void *pWr             - the frames to be transmitted, or 0 to transmit 0xFF bytes:
+**                                    in this case pRd is filled with 0xFF and used as transmit buffer as well
+**		void *pRd                   - the received frames, or 0 to discard them (only when pWr is not 0)
+**		unsigned int cbLen          - the length, in bytes, at most SPIBUS_DMA_MAX_BYTES
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function starts the DMA transfer of a data phase. The transmit channel is triggered while the transmit
+**      FIFO is not full, the receive channel while the receive FIFO is not empty. The transfer is complete when
+**      the last frame is received (or, without receive buffer, when the last frame is written in the FIFO).
+**      pWr and pRd must not be both 0: a DMA transfer block ends after the larger of its source and destination
+**      sizes, so the transmit channel needs a source buffer of cbLen bytes. SPIBUS_Process polls these transfers.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_StartDMA(unsigned char bBus, unsigned char bFrameBytes, const void *pWr, void *pRd, unsigned int cbLen)
+{
+    const SPIBUS_REGS *pRegs = &rgSpiBusRegs[bBus];
+    fSpiBusRxDMA = (pRd != 0);
+    if(!pWr)
+    {
+        // the frames are transmitted before the received ones overwrite them
+        memset(pRd, 0xFF, cbLen);
+        pWr = pRd;
+    }
+
+    // transmit channel: buffer -> SPIxBUF, one frame for each TX event
+    DCH0CON = 0;
+    DCH0ECON = (pRegs->bTxIrq << _DCH0ECON_CHSIRQ_POSITION) | _DCH0ECON_SIRQEN_MASK;
+    DCH0SSA = KVA_TO_PA(pWr);
+    DCH0DSA = KVA_TO_PA(pRegs->pBUF);
+    DCH0SSIZ = cbLen;
+    DCH0DSIZ = bFrameBytes;
+    DCH0CSIZ = bFrameBytes;
+    DCH0INT = 0;
+
+    // receive channel: SPIxBUF -> buffer, one frame for each RX event
+    DCH1CON = 0;
+    DCH1ECON = (pRegs->bRxIrq << _DCH1ECON_CHSIRQ_POSITION) | _DCH1ECON_SIRQEN_MASK;
+    DCH1SSA = KVA_TO_PA(pRegs->pBUF);
+    DCH1DSA = KVA_TO_PA(pRd);
+    DCH1SSIZ = bFrameBytes;
+    DCH1DSIZ = cbLen;
+    DCH1CSIZ = bFrameBytes;
+    DCH1INT = 0;
+
+    // the completion interrupt: the last channel to finish
+    IFS2bits.DMA0IF = 0;
+    IFS2bits.DMA1IF = 0;
+    if(fSpiBusRxDMA)
+    {
+        DCH1INTbits.CHBCIE = 1;
+        IEC2bits.DMA1IE = 1;
+    }
+    else
+    {
+        DCH0INTbits.CHBCIE = 1;
+        IEC2bits.DMA0IE = 1;
+    }
+
+    SPIBUS_DrainRx(bBus);
+    if(fSpiBusRxDMA)
+    {
+        DCH1CONbits.CHEN = 1;
+    }
+    DCH0CONbits.CHEN = 1;
+    DCH0ECONbits.CFORCE = 1;    // the first frame, the next ones are triggered by the FIFO events
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_DMADone
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function completes a DMA transaction. Without receive channel, the frames still in the transmit FIFO
+**      (at most SPIBUS_FIFO_BYTES) are not shifted out yet: the SPI2 transmit interrupt is switched to the end of
+**      the transmission, and Spi2ISR completes the transaction. The next queued transactions are executed from
+**      the core software interrupt 1.
+**      This is a low-level function called from the DMA interrupts, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_DMADone()
+{
+    const SPIBUS_REGS *pRegs = &rgSpiBusRegs[SPIBUS_2];
+    IEC2bits.DMA0IE = 0;
+    IEC2bits.DMA1IE = 0;
+    if(!fSpiBusRxDMA)
+    {
+        SPI2CONbits.STXISEL = 0;        // TX event when the last frame is shifted out
+        IFS1bits.SPI2TXIF = 0;
+        IEC1bits.SPI2TXIE = 1;
+        if((*pRegs->pSTAT & _SPI1STAT_SPITBE_MASK) && !(*pRegs->pSTAT & _SPI1STAT_SPIBUSY_MASK))
+        {
+            IFS1bits.SPI2TXIF = 1;      // already shifted out, the event may have been cleared above
+        }
+        return;
+    }
+    SPIBUS_Complete(SPIBUS_2);
+    SPIBUS_RequestProcess();
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_RequestProcess
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function requests the core software interrupt 1, which executes the queued transactions of SPI2.
+**      This is a low-level function called from the interrupts, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_RequestProcess()
+{
+    _CP0_BIS_CAUSE(_CP0_CAUSE_IP1_MASK);
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_AllocDMA
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - HWRES_OK
+**                        HWRES_ERR_CONFLICT if a DMA channel is used by another library
+**
+**	Description:
+**		This function allocates the DMA channels (SPIBUS_DMA_TX, SPIBUS_DMA_RX), enables the DMA controller
+**      and configures the priority of the DMA and SPI2 interrupts, and of the core software interrupt 1.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char SPIBUS_AllocDMA()
+{
+    if(HWRES_AllocDMA(SPIBUS_DMA_TX, HWRES_OWNER_SPIBUS) != HWRES_OK)
+    {
+        return HWRES_ERR_CONFLICT;
+    }
+    if(HWRES_AllocDMA(SPIBUS_DMA_RX, HWRES_OWNER_SPIBUS) != HWRES_OK)
+    {
+        HWRES_ReleaseDMA(SPIBUS_DMA_TX, HWRES_OWNER_SPIBUS);
+        return HWRES_ERR_CONFLICT;
+    }
+    DMACONbits.ON = 1;
+    IEC2bits.DMA0IE = 0;
+    IEC2bits.DMA1IE = 0;
+    IPC10bits.DMA0IP = SPIBUS_DMA_IPL;
+    IPC10bits.DMA0IS = 0;
+    IPC10bits.DMA1IP = SPIBUS_DMA_IPL;
+    IPC10bits.DMA1IS = 0;
+    IEC1bits.SPI2TXIE = 0;
+    IPC8bits.SPI2IP = SPIBUS_DMA_IPL;
+    IPC8bits.SPI2IS = 0;
+    IPC0bits.CS1IP = 1;
+    IPC0bits.CS1IS = 0;
+    IFS0bits.CS1IF = 0;
+    IEC0bits.CS1IE = 1;
+    return HWRES_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_DrainRx
+**
+**	Parameters:
+**		unsigned char bBus          - the bus
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function empties the receive FIFO and clears the receive overflow flag.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_DrainRx(unsigned char bBus)
+{
+    const SPIBUS_REGS *pRegs = &rgSpiBusRegs[bBus];
+    while(!(*pRegs->pSTAT & _SPI1STAT_SPIRBE_MASK))
+    {
+        (void)*pRegs->pBUF;
+    }
+    *pRegs->pSTATCLR = _SPI1STAT_SPIROV_MASK;
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_GetFrame
+**
+**	Parameters:
+**		const void *pData           - the frames buffer
+**		unsigned char bFrameBytes   - the frame size (1, 2 or 4)
+**		unsigned int idx            - the frame index
+**
+**	Return Value:
+**		unsigned int    - the frame
+**
+**	Description:
+**		This function reads a frame from a buffer: an array of unsigned char, unsigned short or unsigned int.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned int SPIBUS_GetFrame(const void *pData, unsigned char bFrameBytes, unsigned int idx)
+{
+    switch(bFrameBytes)
+    {
+        case 2:
+            return ((const unsigned short *)pData)[idx];
+        case 4:
+            return ((const unsigned int *)pData)[idx];
+        default:
+            return ((const unsigned char *)pData)[idx];
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	SPIBUS_PutFrame
+**
+**	Parameters:
+**		void *pData                 - the frames buffer
+**		unsigned char bFrameBytes   - the frame size (1, 2 or 4)
+**		unsigned int idx            - the frame index
+**		unsigned int uiVal          - the frame
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function writes a frame in a buffer: an array of unsigned char, unsigned short or unsigned int.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void SPIBUS_PutFrame(void *pData, unsigned char bFrameBytes, unsigned int idx, unsigned int uiVal)
+{
+    switch(bFrameBytes)
+    {
+        case 2:
+            ((unsigned short *)pData)[idx] = uiVal;
+            break;
+        case 4:
+            ((unsigned int *)pData)[idx] = uiVal;
+            break;
+        default:
+            ((unsigned char *)pData)[idx] = uiVal;
+            break;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
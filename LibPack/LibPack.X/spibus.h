@@ -0,0 +1,93 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spibus.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the SPIBUS library (defined in spibus.c).
+        Include the file in the project when this library is needed.
+        Use #include "spibus.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _SPIBUS_H    /* Guard against multiple inclusion */
+#define _SPIBUS_H
+
+#include "gpio.h"
+
+// buses
+#define SPIBUS_1            0   // SPI1: the on-board SPI Flash (SPIFLASH library)
+#define SPIBUS_2            1   // SPI2: Pmod connector JA (SPIJA library)
+#define SPIBUS_NO_BUSES     2
+
+// transaction status values, and return values
+#define SPIBUS_OK           0
+#define SPIBUS_PENDING      0x01    // the transaction is queued or in progress
+#define SPIBUS_ERR_FULL     0xFC    // the queue or the device table is full
+#define SPIBUS_ERR_PARAM    0xFB    // invalid bus, device, frame width or transfer length
+
+// the number of devices, on all the buses
+#define SPIBUS_NO_DEVICES   8
+// the number of transactions that can be queued on each bus (must be a power of 2)
+#define SPIBUS_QUEUE_SIZE   8
+// the depth of the SPI FIFOs (enhanced buffer mode), in bytes
+#define SPIBUS_FIFO_BYTES   16
+
+// the DMA channels used by the data phase of the SPI2 transactions (allocated using the HWRES library)
+#define SPIBUS_DMA_TX       0
+#define SPIBUS_DMA_RX       1
+// the priority of the DMA and SPI2 interrupts, the completion callbacks of the DMA transactions are called at this priority
+#define SPIBUS_DMA_IPL      3
+// the data phases of at least this length are moved by DMA (shorter ones are faster polled)
+#define SPIBUS_DMA_MIN_BYTES    32
+// the data phases longer than this are polled
+#define SPIBUS_DMA_MAX_BYTES    65535
+
+// a transaction: with chip select active, the frames of pbCmd are written (the received frames are discarded),
+// then the frames of pWr are written while the received frames are stored in pRd. Both phases use the frame
+// width of the device, the lengths are in bytes (multiples of the frame size).
+// The memory (including the buffers) is provided by the caller and must be valid until the transaction completes.
+typedef struct SPIBUS_XFER {
+    unsigned char bDevice;                          // returned by SPIBUS_AddDevice
+    const unsigned char *pbCmd;                     // command phase, may be 0 (cbCmd is 0)
+    unsigned char cbCmd;
+    const void *pWr;                                // data phase: 0 to transmit 0xFF bytes
+    void *pRd;                                      // data phase: 0 to discard the received frames
+    unsigned int cbData;
+    void (*pfCallback)(struct SPIBUS_XFER *pXfer);  // called when the transaction completes (may be 0)
+    void *pArg;                                     // user data, not used by the library
+    volatile unsigned char bStatus;                 // SPIBUS_PENDING, then SPIBUS_OK
+} SPIBUS_XFER;
+
+unsigned char SPIBUS_AddDevice(unsigned char bBus, GPIO_PIN pinCS, unsigned int uiFreq, unsigned char bPol, unsigned char bEdge, unsigned char bBits);
+unsigned char SPIBUS_SetDeviceConfig(unsigned char bDevice, unsigned int uiFreq, unsigned char bPol, unsigned char bEdge, unsigned char bBits);
+void SPIBUS_RemoveDevice(unsigned char bDevice);
+unsigned char SPIBUS_Submit(SPIBUS_XFER *pXfer);
+unsigned char SPIBUS_Wait(SPIBUS_XFER *pXfer);
+unsigned char SPIBUS_Transfer(unsigned char bDevice, const unsigned char *pbCmd, unsigned char cbCmd,
+                        const void *pWr, void *pRd, unsigned int cbData);
+unsigned char SPIBUS_IsIdle(unsigned char bBus);
+
+//private functions:
+void SPIBUS_Process(unsigned char bBus);
+void SPIBUS_Complete(unsigned char bBus);
+void SPIBUS_Configure(unsigned char bBus, unsigned char bDevice);
+void SPIBUS_PolledTransfer(unsigned char bBus, unsigned char bFrameBytes, const void *pWr, void *pRd, unsigned int cbLen);
+void SPIBUS_StartDMA(unsigned char bBus, unsigned char bFrameBytes, const void *pWr, void *pRd, unsigned int cbLen);
+void SPIBUS_DMADone();
+void SPIBUS_RequestProcess();
+unsigned char SPIBUS_AllocDMA();
+void SPIBUS_DrainRx(unsigned char bBus);
+unsigned int SPIBUS_GetFrame(const void *pData, unsigned char bFrameBytes, unsigned int idx);
+void SPIBUS_PutFrame(void *pData, unsigned char bFrameBytes, unsigned int idx, unsigned int uiVal);
+
+#endif /* _SPIBUS_H */
+
+/* *****************************************************************************
+ End of File
+ */
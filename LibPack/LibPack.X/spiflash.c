@@ -12,7 +12,8 @@
         The library implements SPI access to the onboard SPI Flash memory and 
         provides basic functions to configure the SPI Flash memory, write and read 
         functions to access SPI Flash memory bytes.
-        Include the file in the project, together with config.h, when this library is needed.	
+        The memory is a device of the SPIBUS library (bus SPIBUS_1), each command is an SPIBUS transaction.
+        Include the file in the project, together with config.h, spibus.c, gpio.c and hwres.c, when this library is needed.	
 
   @Author
     Cristian Fatu 
@@ -28,11 +29,15 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "spiflash.h"
+#include "spibus.h"
 
 /* ************************************************************************** */
 
 unsigned char rd[10], wr[10];
 
+// the SPIBUS device
+unsigned char bSpiflashDevice = SPIBUS_ERR_FULL;
+
 /***	SPIFLASH_Init
 **
 **	Parameters:
@@ -46,14 +51,14 @@ unsigned char rd[10], wr[10];
 **      The following digital pins are configured as digital outputs (SPIFLASH_CE, SPIFLASH_SCK, SPIFLASH_SI).
 **      The following digital pins are configured as digital inputs (SPIFLASH_SO).
 **      The SPIFLASH_SI and SPIFLASH_SO are mapped over the SPI1 interface.
-**      The SPI1 module of PIC32 is configured to work at 1 Mhz, polarity 0 and edge 1.
+**      The device is added on the SPIBUS_1 bus, with SPIFLASH_CE as chip select, to work at 1 Mhz, polarity 0 and edge 1.
 **      
 **          
 */
 void SPIFLASH_Init()
 {
     SPIFLASH_ConfigurePins();
-    SPIFLASH_ConfigureSPI(1000000, 0, 1);
+    bSpiflashDevice = SPIBUS_AddDevice(SPIBUS_1, (GPIO_PIN)pin_SPIFLASH_CE, 1000000, 0, 1, 8);
 }
 
 /***	SPIFLASH_ConfigureSPI
@@ -72,23 +77,14 @@ void SPIFLASH_Init()
 **		
 **
 **	Description:
-**		This function configures the SPI1 hardware interface of PIC32, according to the provided parameters.
-**      In order to compute the baud rate value, it uses the peripheral bus frequency definition (PB_FRQ, located in config.h)
+**		This function changes the SPI settings of the SPI Flash device, according to the provided parameters.
+**      The settings are loaded in the SPI1 module by the next command (see SPIBUS_SetDeviceConfig).
 **      
 **          
 */
 void SPIFLASH_ConfigureSPI(unsigned int spiFreq, unsigned char pol, unsigned char edge)
 {
-    // configures SPI1
-    SPI1BRG = PB_FRQ / (2 * spiFreq) - 1;
-    SPI1CONbits.CKP = pol;    // SPI Clock Polarity
-    SPI1CONbits.CKE = edge;   // SPI Clock Edge  
-    SPI1CONbits.SMP = 0;      // SPI Data Input Sample Phase 
-    SPI1CONbits.MSTEN = 1;    // Master
-    SPI1CONbits.MODE16 = 0;   // 8 bit transfer
-    SPI1CONbits.MODE32 = 0;   // 8 bit transfer
-    SPI1CON2bits.AUDEN = 0;   // Audio protocol is disabled
-    SPI1CONbits.ON = 1;       // enable SPI
+    SPIBUS_SetDeviceConfig(bSpiflashDevice, spiFreq, pol, edge, 8);
 }
 
 /***	SPIFLASH_ConfigurePins
@@ -101,9 +97,10 @@ void SPIFLASH_ConfigureSPI(unsigned int spiFreq, unsigned char pol, unsigned cha
 **
 **	Description:
 **		This function configures the digital pins involved in the SPIFLASH module: 
-**      The following digital pins are configured as digital outputs: SPIFLASH_CE, SPIFLASH_SCK, SPIFLASH_SI
+**      The following digital pins are configured as digital outputs: SPIFLASH_SCK, SPIFLASH_SI
 **      The following digital pins are configured as digital inputs: SPIFLASH_SO.
 **      The SPIFLASH_SI and SPIFLASH_SO are mapped over the SPI1 interface.
+**      The chip select SPIFLASH_CE is configured by the SPIBUS library, when the device is added.
 **      The function uses pin related definitions from config.h file.
 **      
 **          
@@ -111,7 +108,6 @@ void SPIFLASH_ConfigureSPI(unsigned int spiFreq, unsigned char pol, unsigned cha
 void SPIFLASH_ConfigurePins()
 {
     // Configure SPIFLASH signals as digital outputs.
-    tris_SPIFLASH_CE = 0;
     tris_SPIFLASH_SCK = 0;
     tris_SPIFLASH_SI = 0;
     
@@ -124,30 +120,6 @@ void SPIFLASH_ConfigurePins()
 
 }
 
-/***	SPIFLASH_RawTransferByte
-**
-**	Parameters:
-**		unsigned char bVal  - the byte to be transmitted over SPI
-**
-**	Return Value:
-**		unsigned char       - the byte received over SPI
-**
-**	Description:
-**		This function implements basic byte transfer over SPI1. 
-**      It transmits the parameter bVal and returns the received byte.
-**      This function does not handle Slave Select (SS) pin, 
-**      use SPIFLASH_TransferBytes for SPI transfer.
-**      
-**          
-*/
-unsigned char SPIFLASH_RawTransferByte(unsigned char bVal)
-{
-    while(!SPI1STATbits.SPITBE);	// wait for TX buffer to be empty
-    SPI1BUF = bVal;
-    while(!SPI1STATbits.SPIRBF);	// wait for RX buffer to be empty
-    return SPI1BUF;
-}
-
 /***	SPIFLASH_TransferBytes
 **
 **	Parameters:
@@ -166,13 +138,7 @@ unsigned char SPIFLASH_RawTransferByte(unsigned char bVal)
 */
 void SPIFLASH_TransferBytes(unsigned char bytesNumber, unsigned char *pbRdData, unsigned char *pbWrData)
 {
-    int i;
-    lat_SPIFLASH_CE = 0; // Activate SS
-    for(i = 0; i< bytesNumber; i++)
-    {
-        pbRdData[i] = SPIFLASH_RawTransferByte(pbWrData[i]);
-    }
-    lat_SPIFLASH_CE = 1; // Deactivate SS
+    SPIBUS_Transfer(bSpiflashDevice, 0, 0, pbWrData, pbRdData, bytesNumber);
 }
 
 /***	SPIFLASH_ReleasePowerDownGetDeviceID
@@ -214,9 +180,7 @@ unsigned char SPIFLASH_ReleasePowerDownGetDeviceID()
 */
 void SPIFLASH_SendOneByteCmd(unsigned char bCmd)
 {
-    lat_SPIFLASH_CE = 0; // Activate SS
-    SPIFLASH_RawTransferByte(bCmd);
-    lat_SPIFLASH_CE = 1; // Deactivate SS
+    SPIBUS_Transfer(bSpiflashDevice, &bCmd, 1, 0, 0, 0);
 }
 
 /***	SPIFLASH_GetStatus
@@ -233,11 +197,8 @@ void SPIFLASH_SendOneByteCmd(unsigned char bCmd)
 */
 unsigned char SPIFLASH_GetStatus()
 {
-    unsigned char bResult;
-    lat_SPIFLASH_CE = 0; // Activate SS
-    SPIFLASH_RawTransferByte(SPIFLASH_CMD_RDSR);
-    bResult = SPIFLASH_RawTransferByte(0);
-    lat_SPIFLASH_CE = 1; // Deactivate SS
+    unsigned char bCmd = SPIFLASH_CMD_RDSR, bResult;
+    SPIBUS_Transfer(bSpiflashDevice, &bCmd, 1, 0, &bResult, 1);
     return bResult;
 }
 
@@ -388,21 +349,14 @@ void SPIFLASH_EraseAll()
 */
 void SPIFLASH_ProgramPage(unsigned int addr, unsigned char *pBuf, unsigned int len)
 {
-    int i;
     SPIFLASH_WaitUntilNoBusy();
     SPIFLASH_WriteEnable();
     
-    lat_SPIFLASH_CE = 0; // Activate SS
-    
-    SPIFLASH_RawTransferByte(SPIFLASH_CMD_PROGRAMPAGE);
-    SPIFLASH_RawTransferByte(addr >> 16);
-    SPIFLASH_RawTransferByte(addr >> 8);
-    SPIFLASH_RawTransferByte(addr & 0xFF);
-    for(i = 0; i< len; i++)
-    {
-        SPIFLASH_RawTransferByte(pBuf[i]);
-    }
-    lat_SPIFLASH_CE = 1; // Deactivate SS
+    wr[0] = SPIFLASH_CMD_PROGRAMPAGE;
+    wr[1] = addr >> 16;
+    wr[2] = addr >> 8;
+    wr[3] = addr & 0xFF;
+    SPIBUS_Transfer(bSpiflashDevice, wr, 4, pBuf, 0, len);
     SPIFLASH_WaitUntilNoBusy();
 }
 
@@ -424,19 +378,11 @@ void SPIFLASH_ProgramPage(unsigned int addr, unsigned char *pBuf, unsigned int l
 */
 void SPIFLASH_Read(unsigned int addr, unsigned char *pBuf, unsigned int len)
 {
-    int i;
-    
-    lat_SPIFLASH_CE = 0; // Activate SS
-    
-    SPIFLASH_RawTransferByte(SPIFLASH_CMD_READ);
-    SPIFLASH_RawTransferByte(addr >> 16);
-    SPIFLASH_RawTransferByte(addr >> 8);
-    SPIFLASH_RawTransferByte(addr & 0xFF);
-    for(i = 0; i< len; i++)
-    {
-        pBuf[i] = SPIFLASH_RawTransferByte(0);
-    }
-    lat_SPIFLASH_CE = 1; // Deactivate SS
+    wr[0] = SPIFLASH_CMD_READ;
+    wr[1] = addr >> 16;
+    wr[2] = addr >> 8;
+    wr[3] = addr & 0xFF;
+    SPIBUS_Transfer(bSpiflashDevice, wr, 4, 0, pBuf, len);
 }
 
 /***	SPIFLASH_Close
@@ -449,13 +395,15 @@ void SPIFLASH_Read(unsigned int addr, unsigned char *pBuf, unsigned int len)
 **
 **	Description:
 **		This functions releases the hardware involved in SPIFLASH library: 
-**      it turns off the SPI1 interface.
+**      it removes the device from the SPIBUS_1 bus. When no other device uses the bus,
+**      the SPI1 interface is turned off.
 **      
 **          
 */
 void SPIFLASH_Close()
 {
-    SPI1CONbits.ON = 0; // disable SPI
+    SPIBUS_RemoveDevice(bSpiflashDevice);
+    bSpiflashDevice = SPIBUS_ERR_FULL;
 }
 
 /* *****************************************************************************
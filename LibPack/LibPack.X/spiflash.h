@@ -47,7 +47,6 @@ void SPIFLASH_Close();
 // private
 
 void SPIFLASH_ConfigurePins();
-unsigned char SPIFLASH_TransferByte(unsigned char bVal);
 void SPIFLASH_TransferBytes(unsigned char bytesNumber, unsigned char *pbRdData, unsigned char *pbWrData);
 
 
@@ -14,8 +14,16 @@
         SPIJA_SI   ->   JA2 (RC1)
         SPIJA_SO   ->   JA3 (RC4)
         SPIJA_SCK  ->   JA4 (RG6)
+        The library is a device of the SPIBUS library (bus SPIBUS_2), so other devices can share SPI2,
+        using other JA pins as chip select. The frames can be 8, 16 or 32 bits wide:
+        - SPIJA_TransferBytes keeps the SPI2 transmit FIFO filled while it reads the received frames,
+          so there is no idle time between the frames.
+        - SPIJA_TransferAsync queues the transfer. Long transfers are moved by DMA, and the callback
+          is called from the DMA (or SPI2) interrupt when the transfer is complete. The CPU is free during the transfer.
+        For 16 and 32 bits frames the buffers are arrays of unsigned short / unsigned int (aligned),
+        and each frame is transmitted MSB first.
         
-        Include the file in the project, together with config.h, when this library is needed.	
+        Include the file in the project, together with config.h, spibus.c, gpio.c and hwres.c, when this library is needed.	
 
   @Author
     Cristian Fatu 
@@ -32,6 +40,18 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "spija.h"
+#include "spibus.h"
+
+/* ************************************************************************** */
+
+// the SPIBUS device, and its settings
+unsigned char bSpijaDevice = SPIBUS_ERR_FULL;
+unsigned int uiSpijaFreq = 1000000;
+unsigned char bSpijaPol = 0, bSpijaEdge = 1, bSpijaBits = 8;
+
+// the asynchronous transfer
+SPIBUS_XFER xferSpija;
+SPIJA_CALLBACK pfnSpijaDone;
 
 /* ************************************************************************** */
 /***	SPIJA_Init
@@ -47,14 +67,20 @@
 **      The following digital pins are configured as digital outputs: SPIJA_CE (JA1), SPIJA_SCK(JA2), SPIJA_SI(JA3)
 **      The following digital pins are configured as digital inputs: SPIJA_SO(JA4).
 **      The SPIJA_SI and SPIJA_SO are mapped over the SPI2 interface.
-**      The SPI2 module of PIC32 is configured to work at 1 Mhz, polarity 0 and edge 1.
+**      The device is added on the SPIBUS_2 bus, with SPIJA_CE as chip select, to work at 1 Mhz, polarity 0,
+**      edge 1 and 8 bits frames.
 **      
 **          
 */
 void SPIJA_Init()
 {
     SPIJA_ConfigurePins();
-    SPIJA_ConfigureSPI(1000000, 0, 1); // configures SPI to work at 1 Mhz, polarity 0 and edge 1.
+    uiSpijaFreq = 1000000;
+    bSpijaPol = 0;
+    bSpijaEdge = 1;
+    bSpijaBits = 8;
+    bSpijaDevice = SPIBUS_AddDevice(SPIBUS_2, (GPIO_PIN)pin_SPIJA_CE, uiSpijaFreq, bSpijaPol, bSpijaEdge, bSpijaBits);
+    xferSpija.bStatus = SPIBUS_OK;
 }
 
 /* ************************************************************************** */
@@ -74,24 +100,50 @@ void SPIJA_Init()
 **		
 **
 **	Description:
-**		This function configures the SPI2 hardware interface of PIC32, according to the provided parameters.
-**      In order to compute the baud rate value, it uses the peripheral bus frequency definition (PB_FRQ, located in config.h)
-**      This is a low-level function called by initialization functions, so user should avoid calling it directly.
+**		This function changes the SPI settings of the SPIJA device, according to the provided parameters.
+**      The frame width set by SPIJA_SetFrameWidth (8 bits by default) is kept.
+**      The settings are loaded in the SPI2 module by the next transfer (see SPIBUS_SetDeviceConfig).
+**      It must not be called while an asynchronous transfer is in progress.
 **      
 **          
 */
 void SPIJA_ConfigureSPI(unsigned int spiFreq, unsigned char pol, unsigned char edge)
 {
-    SPI2BRG = PB_FRQ / (2 * spiFreq) - 1;
-    // configures SPI2
-    SPI2CONbits.CKP = pol;    // SPI Clock Polarity
-    SPI2CONbits.CKE = edge;   // SPI Clock Edge    
-    SPI2CONbits.SMP = 0;      // SPI Data Input Sample Phase 
-    SPI2CONbits.MSTEN = 1;    // Master
-    SPI2CONbits.MODE16 = 0;   // 8 bit transfer
-    SPI2CONbits.MODE32 = 0;   // 8 bit transfer
-    SPI2CON2bits.AUDEN = 0;   // Audio protocol is disabled
-    SPI2CONbits.ON = 1;       // enable SPI
+    uiSpijaFreq = spiFreq;
+    bSpijaPol = pol;
+    bSpijaEdge = edge;
+    SPIBUS_SetDeviceConfig(bSpijaDevice, uiSpijaFreq, bSpijaPol, bSpijaEdge, bSpijaBits);
+}
+
+/* ************************************************************************** */
+/***	SPIJA_SetFrameWidth
+**
+**	Parameters:
+**		unsigned char bBits - the frame width: 8, 16 or 32 bits
+**
+**	Return Value:
+**		unsigned char       - SPIJA_OK
+**                            SPIJA_ERR_PARAM if bBits is not 8, 16 or 32
+**                            SPIJA_ERR_BUSY if an asynchronous transfer is in progress
+**
+**	Description:
+**		This function sets the frame width of the SPIJA transfers (MODE16 / MODE32 fields of SPI2CON).
+**      The transfer lengths must be multiples of the frame size.
+**          
+*/
+unsigned char SPIJA_SetFrameWidth(unsigned char bBits)
+{
+    if(bBits != 8 && bBits != 16 && bBits != 32)
+    {
+        return SPIJA_ERR_PARAM;
+    }
+    if(SPIJA_IsBusy())
+    {
+        return SPIJA_ERR_BUSY;
+    }
+    bSpijaBits = bBits;
+    SPIBUS_SetDeviceConfig(bSpijaDevice, uiSpijaFreq, bSpijaPol, bSpijaEdge, bSpijaBits);
+    return SPIJA_OK;
 }
 
 /* ************************************************************************** */
@@ -105,9 +157,10 @@ void SPIJA_ConfigureSPI(unsigned int spiFreq, unsigned char pol, unsigned char e
 **
 **	Description:
 **		This function configures the digital pins involved in the SPIJA module: 
-**      The following digital pins are configured as digital outputs: SPIJA_CE (JA1), SPIJA_SCK(JA2), SPIJA_SI(JA3)
+**      The following digital pins are configured as digital outputs: SPIJA_SCK(JA2), SPIJA_SI(JA3)
 **      The following digital pins are configured as digital inputs: SPIJA_SO(JA4).
 **      The SPIJA_SI and SPIJA_SO are mapped over the SPI2 interface.
+**      The chip select SPIJA_CE (JA1) is configured by the SPIBUS library, when the device is added.
 **      The function uses pin related definitions from config.h file.
 **      This is a low-level function called by SPIJA_Init(), so user should avoid calling it directly.     
 **      
@@ -116,7 +169,6 @@ void SPIJA_ConfigureSPI(unsigned int spiFreq, unsigned char pol, unsigned char e
 void SPIJA_ConfigurePins()
 {
     // Configure SPIJA signals as digital outputs.
-    tris_SPIJA_CE = 0;
     tris_SPIJA_SCK = 0;
     tris_SPIJA_SI = 0;
     
@@ -135,55 +187,104 @@ void SPIJA_ConfigurePins()
 }
 
 /* ************************************************************************** */
-/***	SPIJA_RawTransferByte
+/***	SPIJA_TransferBytes
 **
 **	Parameters:
-**		unsigned char bVal  - the byte to be transmitted over SPI
+**      int bytesNumber         - Number of bytes to be transfered, a multiple of the frame size.
+**      unsigned char *pbRdData - Pointer to a buffer storing the received bytes (frames). 
+**                                0 if the received frames are not needed.
+**      unsigned char *pbWrData - Pointer to a buffer storing the bytes (frames) to be transmitted.
+**                                0 to transmit 0xFF bytes (for example when only reading).
 **
 **	Return Value:
-**		unsigned char       - the byte received over SPI	
 **
 **	Description:
-**		This function implements basic byte transfer over SPI2. 
-**      It transmits the parameter bVal and returns the received byte.
-**      This function does not handle Slave Select (SPIJA_CE) pin. 
-**      This is a low-level function called by SPIJA_TransferBytes(), so user should avoid calling it directly.     
- **          
+**		This function implements transfer of a number of bytes over SPI2, and returns when the transfer is complete. 
+**      It transmits the bytes from pbWrData and receives the bytes in pbRdData.
+**      For 16 and 32 bits frames, the buffers are arrays of unsigned short / unsigned int.
+**      This function properly handles Slave Select (SPIJA_CE) pin.
+**      It must not be called while an asynchronous transfer is in progress, or from its callback.
+**      
+**          
 */
-unsigned char SPIJA_RawTransferByte(unsigned char bVal)
+void SPIJA_TransferBytes(int bytesNumber, unsigned char *pbRdData, unsigned char *pbWrData)
 {
-    while(!SPI2STATbits.SPITBE);	// wait for TX buffer to be empty
-    SPI2BUF = bVal;
-    while(!SPI2STATbits.SPIRBF);	// wait for RX buffer to be empty
-    return SPI2BUF;
+    SPIBUS_Transfer(bSpijaDevice, 0, 0, pbWrData, pbRdData, bytesNumber);
 }
 
 /* ************************************************************************** */
-/***	SPIJA_TransferBytes
+/***	SPIJA_TransferAsync
 **
 **	Parameters:
-**      int bytesNumber         - Number of bytes to be transfered.
-**      unsigned char *pbRdData - Pointer to a buffer storing the received bytes.
-**      unsigned char *pbWrData - Pointer to a buffer storing the bytes to be transmitted.
+**      int bytesNumber         - Number of bytes to be transfered, a multiple of the frame size.
+**      void *pRdData           - Pointer to a buffer storing the received frames. 
+**                                0 if the received frames are not needed.
+**      const void *pWrData     - Pointer to a buffer storing the frames to be transmitted.
+**                                0 to transmit 0xFF bytes: in this case pRdData may be filled with 0xFF
+**                                and used as transmit buffer as well.
+**      SPIJA_CALLBACK pfnDone  - the function called when the transfer is complete, or 0
+**      void *pArg              - the parameter of pfnDone
 **
 **	Return Value:
+**		unsigned char       - SPIJA_OK if the transfer was queued
+**                            SPIJA_ERR_BUSY if an asynchronous transfer is in progress,
+**                            or the SPIBUS_2 queue is full
+**                            SPIJA_ERR_PARAM if the length is invalid, or both buffers are 0
 **
 **	Description:
-**		This function implements transfer of a number of bytes over SPI2. 
-**      It transmits the bytes from pbWrData and receives the bytes in pbRdData.
-**      This function properly handles Slave Select (SPIJA_CE) pin.
-**      
+**		This function queues a transfer over SPI2 and returns. The transfers of at least SPIBUS_DMA_MIN_BYTES
+**      are moved by DMA: pfnDone is called from the DMA interrupt, or from the SPI2 interrupt without receive
+**      buffer (priority SPIBUS_DMA_IPL). The shorter ones are polled, and may complete (and call pfnDone) before
+**      the function returns, or, when they wait for a DMA transfer of another device, from the core software
+**      interrupt 1.
+**      The buffers must not be accessed until the transfer is complete.
 **          
 */
-void SPIJA_TransferBytes(int bytesNumber, unsigned char *pbRdData, unsigned char *pbWrData)
+unsigned char SPIJA_TransferAsync(int bytesNumber, void *pRdData, const void *pWrData, SPIJA_CALLBACK pfnDone, void *pArg)
 {
-    int i;
-    lat_SPIJA_CE = 0; // Activate SS
-    for(i = 0; i< bytesNumber; i++)
+    if(SPIJA_IsBusy())
+    {
+        return SPIJA_ERR_BUSY;
+    }
+    if(bytesNumber <= 0 || (!pRdData && !pWrData))
+    {
+        return SPIJA_ERR_PARAM;
+    }
+    pfnSpijaDone = pfnDone;
+    xferSpija.bDevice = bSpijaDevice;
+    xferSpija.pbCmd = 0;
+    xferSpija.cbCmd = 0;
+    xferSpija.pWr = pWrData;
+    xferSpija.pRd = pRdData;
+    xferSpija.cbData = bytesNumber;
+    xferSpija.pfCallback = SPIJA_XferDone;
+    xferSpija.pArg = pArg;
+    switch(SPIBUS_Submit(&xferSpija))
     {
-        pbRdData[i] = SPIJA_RawTransferByte(pbWrData[i]);
+        case SPIBUS_OK:
+            return SPIJA_OK;
+        case SPIBUS_ERR_FULL:
+            return SPIJA_ERR_BUSY;
+        default:
+            return SPIJA_ERR_PARAM;
     }
-    lat_SPIJA_CE = 1; // Deactivate SS
+}
+
+/* ************************************************************************** */
+/***	SPIJA_IsBusy
+**
+**	Parameters:
+**
+**	Return Value:
+**		unsigned char       - 1 if an asynchronous transfer is in progress, 0 otherwise
+**
+**	Description:
+**		This function returns the state of the asynchronous transfers.
+**          
+*/
+unsigned char SPIJA_IsBusy()
+{
+    return xferSpija.bStatus == SPIBUS_PENDING;
 }
 
 /* ************************************************************************** */
@@ -197,13 +298,37 @@ void SPIJA_TransferBytes(int bytesNumber, unsigned char *pbRdData, unsigned char
 **
 **	Description:
 **		This functions releases the hardware involved in SPIJA library: 
-**      it turns off the SPI2 interface.
+**      it removes the device from the SPIBUS_2 bus. When no other device uses the bus,
+**      the SPI2 interface is turned off.
+**      It must not be called while an asynchronous transfer is in progress.
 **      
 **          
 */
 void SPIJA_Close()
 {
-    SPI2CONbits.ON = 0; // disable SPI
+    SPIBUS_RemoveDevice(bSpijaDevice);
+    bSpijaDevice = SPIBUS_ERR_FULL;
+}
+
+/* ************************************************************************** */
+/***	SPIJA_XferDone
+**
+**	Parameters:
+**		SPIBUS_XFER *pXfer  - the completed transaction
+**
+**	Return Value:
+**
+**	Description:
+**		This is the completion callback of the asynchronous transfers: it calls the user callback.
+**      This is a low-level function called by the SPIBUS library, so user should avoid calling it directly.
+**          
+*/
+void SPIJA_XferDone(SPIBUS_XFER *pXfer)
+{
+    if(pfnSpijaDone)
+    {
+        pfnSpijaDone(pXfer->pArg);
+    }
 }
 
 
@@ -9,7 +9,7 @@
 
   @Description
         This file groups the declarations of the functions that implement
-        the SPIFLASH library (defined in spija.c).
+        the SPIJA library (defined in spija.c).
         Include the file in the project when this library is needed.
         Use #include "spija.h" in the source files where the functions are needed.
  */
@@ -18,15 +18,28 @@
 #ifndef _SPIJA_H    /* Guard against multiple inclusion */
 #define _SPIJA_H
 
+#include "spibus.h"
+
+// return values
+#define SPIJA_OK            0
+#define SPIJA_ERR_BUSY      0xFE    // an asynchronous transfer is in progress
+#define SPIJA_ERR_PARAM     0xFC    // invalid frame width, or invalid transfer length
+
+// the completion callback of an asynchronous transfer
+typedef void (*SPIJA_CALLBACK)(void *pArg);
+
 void SPIJA_Init();
 
 void SPIJA_ConfigureSPI(unsigned int spiFreq, unsigned char pol, unsigned char edge);
-unsigned char SPIJA_TransferByte(unsigned char bVal);
+unsigned char SPIJA_SetFrameWidth(unsigned char bBits);
 void SPIJA_TransferBytes(int bytesNumber, unsigned char *pbRdData, unsigned char *pbWrData);
+unsigned char SPIJA_TransferAsync(int bytesNumber, void *pRdData, const void *pWrData, SPIJA_CALLBACK pfnDone, void *pArg);
+unsigned char SPIJA_IsBusy();
 void SPIJA_Close();
 
 //private functions
 void SPIJA_ConfigurePins();
+void SPIJA_XferDone(SPIBUS_XFER *pXfer);
 
 //#ifdef __cplusplus
 //extern "C" {
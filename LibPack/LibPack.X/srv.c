@@ -29,6 +29,7 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "srv.h"
+#include "hwres.h"
 // FPB = 80000000
 // Timer period 20 ms = 0.02
 // Prescaler 16
@@ -42,7 +43,8 @@ unsigned int sPR2 = 0;
 **		
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if the initialization succeeded
+**                        HWRES_ERR_CONFLICT if Timer2, OC4 or OC5 are used by another library
 **
 **	Description:
 **		This function initializes the hardware involved in the SRV module: 
@@ -50,10 +52,10 @@ unsigned int sPR2 = 0;
 **      The OC5 and OC4 module of PIC32 are configured with a period of 20 ms given by Timer2.
 **          
 */
-void SRV_Init()
+unsigned char SRV_Init()
 {
     SRV_ConfigurePins();
-    SRV_ConfigureOCs();
+    return SRV_ConfigureOCs();
 }
 
 /* ------------------------------------------------------------ */
@@ -63,24 +65,41 @@ void SRV_Init()
 **		
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if the initialization succeeded
+**                        HWRES_ERR_CONFLICT if Timer2, OC4 or OC5 are used by another library
 **
 **	Description:
 **		This function configures the output compares and timer involved in the SRV module.
 **      The OC5 and OC4 module of PIC32 are configured with a period of 20 ms given by Timer2.
+**      Timer2 is allocated using the HWRES library and it can be shared with other libraries using the same 20 ms period.
+**      If Timer2 is already running with the same period, it is not altered.
 **      This is a low-level function called by SRV_Init(), so user should avoid calling it directly.
 **          
 */
-void SRV_ConfigureOCs()
+unsigned char SRV_ConfigureOCs()
 {
-   // configure Timer2
-    T2CONbits.TCKPS = 4;                // 1:16 prescale value
-    T2CONbits.TGATE = 0;                // not gated input (the default)
-    T2CONbits.TCS = 0;                  // PCBLK input (the default)
-    T2CONbits.ON = 1;                   // turn on Timer2
-    
+    unsigned char bResult;
     sPR2 = (int)(((float)(TMR_TIME * PB_FRQ) / 16) + 0.5);
-    PR2 = sPR2;
+    bResult = HWRES_AllocTimer(2, HWRES_OWNER_SRV, HWRES_SHARED, 4, sPR2);
+    if(bResult == HWRES_ERR_CONFLICT)
+    {
+        return HWRES_ERR_CONFLICT;
+    }
+    if(bResult == HWRES_OK)
+    {
+        // Timer2 is not already configured by another library
+        // configure Timer2
+        T2CONbits.TCKPS = 4;                // 1:16 prescale value
+        T2CONbits.TGATE = 0;                // not gated input (the default)
+        T2CONbits.TCS = 0;                  // PCBLK input (the default)
+        T2CONbits.ON = 1;                   // turn on Timer2
+        PR2 = sPR2;
+    }
+    if(HWRES_AllocOC(5, HWRES_OWNER_SRV, 2) != HWRES_OK || HWRES_AllocOC(4, HWRES_OWNER_SRV, 2) != HWRES_OK)
+    {
+        SRV_Close();
+        return HWRES_ERR_CONFLICT;
+    }
 
     // Configure Output Compare Module 2
    OC5CONbits.ON = 0;       // Turn off OC5 while doing setup.
@@ -93,6 +112,7 @@ void SRV_ConfigureOCs()
    OC4CONbits.OCM = 6;      // PWM mode on OC4; Fault pin is disabled
    OC4CONbits.OCTSEL = 0;   // Timer2 is the clock source for this Output Compare module
    OC4CONbits.ON = 1;       // Start the OC4 module
+   return HWRES_OK;
 }
 
 /* ------------------------------------------------------------ */
@@ -178,14 +198,25 @@ void SRV_SetPulseMicroseconds2(unsigned short usVal)
 **	Description:
 **		This functions releases the hardware involved in the SRV library: 
 **      it turns off the OC5, OC4 and Timer 2 modules.
-**      
+**      Timer2 is turned off only if it is not used by other libraries.
 **          
 */
 void SRV_Close()
 {
-    OC5CONbits.ON = 0;       // Stop the OC2 module
-    OC4CONbits.ON = 0;       // Stop the OC3 module   
-    T2CONbits.ON = 0;        // turn off Timer2
+    if(HWRES_GetOCOwner(5) == HWRES_OWNER_SRV)
+    {
+        OC5CONbits.ON = 0;       // Stop the OC5 module
+        HWRES_ReleaseOC(5, HWRES_OWNER_SRV);
+    }
+    if(HWRES_GetOCOwner(4) == HWRES_OWNER_SRV)
+    {
+        OC4CONbits.ON = 0;       // Stop the OC4 module
+        HWRES_ReleaseOC(4, HWRES_OWNER_SRV);
+    }
+    if((HWRES_GetTimerOwners(2) & HWRES_OWNER_SRV) && !HWRES_ReleaseTimer(2, HWRES_OWNER_SRV))
+    {
+        T2CONbits.ON = 0;        // turn off Timer2
+    }
 }
 /* *****************************************************************************
  End of File
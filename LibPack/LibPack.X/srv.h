@@ -18,13 +18,13 @@
 #ifndef _SRV_H    /* Guard against multiple inclusion */
 #define _SRV_H
 
-void SRV_Init();
+unsigned char SRV_Init();
 void SRV_SetPulseMicroseconds1(unsigned short usVal);
 void SRV_SetPulseMicroseconds2(unsigned short usVal);
 void SRV_Close();
 
 // private functions
-void SRV_ConfigureOCs();
+unsigned char SRV_ConfigureOCs();
 void SRV_ConfigurePins();
 
 #endif /* _SRV_H */
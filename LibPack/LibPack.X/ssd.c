@@ -29,6 +29,9 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "ssd.h"
+#include "hwres.h"
+#include "prof.h"
+#include "trace.h"
 
 
 /* ************************************************************************** */
@@ -80,6 +83,8 @@ void __ISR(_TIMER_1_VECTOR, ipl7) Timer1ISR(void)
 {  
     static unsigned char idxCurrDigit = 0;
     unsigned char currDigit, idx;
+    PROF_ISR_ENTER_TMR(PROF_ID_TMR1, TMR1, 64);
+    TRACE_BEGIN(TRACE_SRC_TMR1, 0);
 
     idx = (idxCurrDigit++) & 3;
     currDigit = digits[idx];
@@ -117,6 +122,8 @@ void __ISR(_TIMER_1_VECTOR, ipl7) Timer1ISR(void)
             break; 
     }    
     IFS0bits.T1IF = 0;       // clear interrupt flag
+    TRACE_END(TRACE_SRC_TMR1, 0);
+    PROF_ISR_EXIT(PROF_ID_TMR1);
 }
 
 /* ------------------------------------------------------------ */
@@ -126,19 +133,25 @@ void __ISR(_TIMER_1_VECTOR, ipl7) Timer1ISR(void)
 **		
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if Timer1 was allocated, HWRES_ERR_CONFLICT if Timer1 is used by another library
 **
 **	Description:
 **		This function configures the Timer1 to be used by SSD module.
 **      The timer will generate interrupts every 3 ms.
 **      The period constant is computed using TMR_TIME definition (located in this source file)
 **      and peripheral bus frequency definition (PB_FRQ, located in config.h).
+**      Timer1 is allocated exclusively using the HWRES library. If Timer1 is used by another library, it is not altered.
 **      This is a low-level function called by SSD_Init(), so user should avoid calling it directly. 
 **          
 */
-void SSD_Timer1Setup()
+unsigned char SSD_Timer1Setup()
 {
-  PR1 = (int)(((float)(TMR_TIME * PB_FRQ) / 256) + 0.5); //set period register, generates one interrupt every 3 ms
+  unsigned int uiPR1 = (int)(((float)(TMR_TIME * PB_FRQ) / 256) + 0.5);
+  if(HWRES_AllocTimer(1, HWRES_OWNER_SSD, HWRES_EXCLUSIVE, 2, uiPR1) != HWRES_OK)
+  {
+      return HWRES_ERR_CONFLICT;
+  }
+  PR1 = uiPR1;                        //    set period register, generates one interrupt every 3 ms
   TMR1 = 0;                           //    initialize count to 0
   T1CONbits.TCKPS = 2;                //    1:64 prescale value
   T1CONbits.TGATE = 0;                //    not gated input (the default)
@@ -149,6 +162,7 @@ void SSD_Timer1Setup()
   IFS0bits.T1IF = 0;                  //    clear interrupt flag
   IEC0bits.T1IE = 1;                  //    enable interrupt
   macro_enable_interrupts();          //    enable interrupts at CPU
+  return HWRES_OK;
 }
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -163,7 +177,8 @@ void SSD_Timer1Setup()
 **		
 **
 **	Return Value:
-**		
+**		unsigned char   - HWRES_OK if the initialization succeeded
+**                        HWRES_ERR_CONFLICT if Timer1 is used by another library
 **
 **	Description:
 **		This function initializes the hardware involved in the SSD module:
@@ -172,10 +187,10 @@ void SSD_Timer1Setup()
 **      
 **          
 */
-void SSD_Init()
+unsigned char SSD_Init()
 {
     SSD_ConfigurePins();
-    SSD_Timer1Setup();  
+    return SSD_Timer1Setup();
 }
 
 /* ------------------------------------------------------------ */
@@ -300,7 +315,8 @@ unsigned char SSD_GetDigitSegments(unsigned char d)
 void SSD_WriteDigits(unsigned char d1, unsigned char d2, unsigned char d3, unsigned char d4, \
         unsigned char dp1, unsigned char dp2, unsigned char dp3, unsigned char dp4)
 {
-      T1CONbits.ON = 0;                   // turn off Timer1
+    unsigned char fT1IE = IEC0bits.T1IE;
+    IEC0bits.T1IE = 0;                  // disable Timer1 interrupt while the digits are updated
     digits[0] = SSD_GetDigitSegments(d1);
     digits[1] = SSD_GetDigitSegments(d2);
     digits[2] = SSD_GetDigitSegments(d3);
@@ -322,7 +338,7 @@ void SSD_WriteDigits(unsigned char d1, unsigned char d2, unsigned char d3, unsig
     {
         digits[3] |= 0x80;
     }    
-  T1CONbits.ON = 1;                   //  turn on Timer1
+    IEC0bits.T1IE = fT1IE;              // restore Timer1 interrupt
 }
 
 /* ------------------------------------------------------------ */
@@ -360,7 +376,12 @@ void SSD_WriteDigitsGrouped(unsigned int val, unsigned char dp)
 void SSD_Close()
 {
     // stop the timer
-    T1CONbits.ON = 0;// turn off Timer1
+    if(HWRES_GetTimerOwners(1) & HWRES_OWNER_SSD)
+    {
+        T1CONbits.ON = 0;// turn off Timer1
+        IEC0bits.T1IE = 0;
+        HWRES_ReleaseTimer(1, HWRES_OWNER_SSD);
+    }
     // turn off digits
     lat_SSD_AN1 = 1; // deactivate digit 1;
     lat_SSD_AN2 = 1; // deactivate digit 2;    
@@ -30,15 +30,16 @@
     // *****************************************************************************
     // *****************************************************************************
 
-void SSD_Init();
+unsigned char SSD_Init();
 void SSD_WriteDigits(unsigned char d0, unsigned char d1, unsigned char d2, unsigned char d3, \
             unsigned char dp1, unsigned char dp2, unsigned char dp3, unsigned char dp4);
 void SSD_WriteDigitsGrouped(unsigned int val, unsigned char dp);
 unsigned char SSD_GetDigitSegments(unsigned char d);
+void SSD_Close();
 
 // private functions
 void SSD_ConfigurePins();
-void SSD_Timer1Setup();
+unsigned char SSD_Timer1Setup();
 
 
     /* Provide C++ Compatibility */
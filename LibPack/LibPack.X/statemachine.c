@@ -18,19 +18,17 @@
 #include "mot.h"
 #include "srv.h"
 #include "uart.h"
+#include "hwres.h"
+#include "sched.h"
+#include "prof.h"
+#include "trace.h"
 #include <xc.h>  
 #include <sys/attribs.h>
 #include <stdio.h>
 
 
-// the state structure definition
-typedef struct s_stateMachineElem{
-    unsigned int cntStateTimer;
-    unsigned int cntStepTimer;
-    void (*pfInitTestFnc)();
-    void (*pfStepTestFnc)(unsigned int);
-    void (*pfExitTestFnc)();
-}StateMachinesElem;
+// the state structure definition, run by the SCHED library state machine engine
+typedef SCHED_SMELEM StateMachinesElem;
 
 
 // the state function prototypes
@@ -83,6 +81,10 @@ StateMachinesElem stateMachinesElems[] =
 
 #define NO_STATES sizeof(stateMachinesElems)/sizeof(stateMachinesElems[0])
 
+// the state machine task
+SCHED_SM smCETest;
+unsigned char idCETestTask = SCHED_ERR_PARAM;
+
 char strMsg[20];
 
 /***	CETest_InitRGBLed
@@ -700,61 +702,20 @@ void CETest_ExitUART()
 **		none
 **
 **	Description:
-**		This is the ISR for the Timer4. It is trigggered every 100ms. 
- *      It implements the state machine engine:
- *      For every entry in the stateMachinesElems
- *          - the State Init function is called (if defined)
- *          - if the Step Function and step counter value are defined, at every step counter interval the Step Function  is called
- *          - after the time described by state counter value, the State Exit function is called (if defined), and the new state becomes active (in a circular manner)
+**		This is the ISR for the Timer4. It is trigggered every 10ms. 
+ *      It only posts a tick event to the state machine task. The state functions
+ *      (Init, Step and Exit functions of the stateMachinesElems entries) are called
+ *      by the SCHED library state machine engine, in the main context.
  **          
 */
 void __ISR(_TIMER_4_VECTOR, IPL2SRS) Timer4SR(void) 
 {
-    static unsigned int idxTimerWithinStep = 0, idxTimerWithinState = 0, idxState = 0, idxStep = 0;
-    if(stateMachinesElems[idxState].pfStepTestFnc && 
-            (++idxTimerWithinStep >= (stateMachinesElems[idxState].cntStepTimer)))
-    {
-        // call the step function
-        (*stateMachinesElems[idxState].pfStepTestFnc)(idxStep++);
-        
-        // reset counter within step
-        idxTimerWithinStep = 0;
-        
-    }
-            
-
-    if(++idxTimerWithinState >= (stateMachinesElems[idxState].cntStateTimer))
-    {
-
-        // move to next state
-        
-        // exit the old state
-        if(stateMachinesElems[idxState].pfExitTestFnc)
-        {
-            (*stateMachinesElems[idxState].pfExitTestFnc)();
-        }
-        if(++idxState == NO_STATES)
-        {
-            // loop within states
-            idxState = 0;
-        }
-        // init the new state
-        if(stateMachinesElems[idxState].pfInitTestFnc)
-        {
-            (*stateMachinesElems[idxState].pfInitTestFnc)();
-        }
-        
-
-        // reset counter within state
-        idxTimerWithinState = 0;
-        // reset counter within step
-        idxTimerWithinStep = 0;
-        idxStep = 0;
-    }
-    
-    
-//LATDINV = (1<<9);   //debug - toggle RD9 (JB1)  
+    PROF_ISR_ENTER_TMR(PROF_ID_TMR4, TMR4, 256);
+    TRACE_BEGIN(TRACE_SRC_TMR4, 0);
+    SCHED_Post(idCETestTask, SCHED_EVT_TICK, 0);
     IFS0bits.T4IF = 0;                  // clear interrupt flag
+    TRACE_END(TRACE_SRC_TMR4, 0);
+    PROF_ISR_EXIT(PROF_ID_TMR4);
 }
 
 #define TMR_TIME    0.01 // 10 ms for each tick
@@ -768,12 +729,14 @@ void __ISR(_TIMER_4_VECTOR, IPL2SRS) Timer4SR(void)
 **
 **	Description:
 **		This function configures Timer4 to generate in interrupt every 10ms, to be used for the state machine timing.
+**      Timer4 is allocated exclusively using the HWRES library. If Timer4 is used by another library, it is not altered.
 **          
 */
 void Timer4Setup()
 {
     static int fTimerInitialised = 0;
-    if(!fTimerInitialised)
+    if(!fTimerInitialised &&
+        HWRES_AllocTimer(4, HWRES_OWNER_STATEMACHINE, HWRES_EXCLUSIVE, 7, (int)(((float)(TMR_TIME * PB_FRQ) / 256) + 0.5)) == HWRES_OK)
     {
         macro_disable_interrupts;             // INT step 2: disable interrupts at CPU
                                           // INT step 3: setup peripheral
@@ -803,8 +766,9 @@ void Timer4Setup()
 **	Description:
 **		This function implements the CE Test. It is aimed to be called from main.
 **      The function firstt initializes the LCD and displays the intro message.
-**      Then it fires the state machine by configuring Timer4.
-**      Prior to this, the first state is initialized (needed because of the way state machine engine is implemented).
+**      Then it adds the state machine task to the scheduler, and fires the state machine by configuring Timer4.
+**      The first state is initialized by the scheduler, when the task handles its start event.
+**      The function runs the scheduler, so it never returns.
 **          
 */
 void STATEMACHINE_Main()
@@ -815,9 +779,10 @@ void STATEMACHINE_Main()
     LCD_WriteStringAtPos("BasysMX3 LibPack", 0, 0);
     LCD_WriteStringAtPos("", 1, 0);
  
-    // init the first state
-    (*stateMachinesElems[0].pfInitTestFnc)();
+    idCETestTask = SCHED_AddStateMachine(SCHED_PRIO_NORMAL, &smCETest, stateMachinesElems, NO_STATES);
 
     Timer4Setup();
 
+    SCHED_Run();
+
 }
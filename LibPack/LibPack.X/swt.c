@@ -10,7 +10,7 @@
   @Description
         This file groups the functions that implement the SWT library.
         The functions implement basic digital input functionality.
-        Include the file in the project, together with config.h, when this library is needed.
+        Include the file in the project, together with config.h and gpio.c, when this library is needed.
 
   @Author
     Cristian Fatu 
@@ -26,9 +26,13 @@
 #include <sys/attribs.h>
 #include "config.h"
 #include "swt.h"
+#include "gpio.h"
 
 /* ************************************************************************** */
 
+// the switch pins, SW0 - SW7
+const GPIO_PIN rgSwtPins[8] = {pin_SWT_SWT0, pin_SWT_SWT1, pin_SWT_SWT2, pin_SWT_SWT3,
+                                pin_SWT_SWT4, pin_SWT_SWT5, pin_SWT_SWT6, pin_SWT_SWT7};
 
 /***	SWT_Init
 **
@@ -99,37 +103,11 @@ void SWT_ConfigurePins()
 */
 unsigned char SWT_GetValue(unsigned char bNo)
 {
-    unsigned bResult = 0xFF;
-
-    switch (bNo)
+    if(bNo > 7)
     {
-        case 0: 
-            bResult = prt_SWT_SWT0;
-            break;
-        case 1: 
-            bResult = prt_SWT_SWT1;
-            break;
-        case 2: 
-            bResult = prt_SWT_SWT2;
-            break;
-        case 3: 
-            bResult = prt_SWT_SWT3;
-            break;
-        case 4: 
-            bResult = prt_SWT_SWT4;
-            break;
-        case 5: 
-            bResult = prt_SWT_SWT5;
-            break;
-        case 6: 
-            bResult = prt_SWT_SWT6;
-            break;
-        case 7: 
-            bResult = prt_SWT_SWT7;
-            break;
+        return 0xFF;
     }
-
-    return bResult;
+    return GPIO_GetValue(rgSwtPins[bNo]);
 }
 
 /***	SWT_GetGroupValue
@@ -145,20 +123,12 @@ unsigned char SWT_GetValue(unsigned char bNo)
 **	Description:
 **		This function gets the value of the all 8 switches as a single value on 8 bits.  
 **      Each bit from returned value corresponds to a switch: Bit 0 (LSB) corresponds to SW0, bit 7 (MSB) corresponds to SW7.
+**      The ports are read once (see GPIO_GetGroupValue).
 **          
 */
 unsigned char SWT_GetGroupValue()
 {
-    int i;
-    unsigned char bResult = 0;
-    for(i = 0; i < 8; i++)
-    {
-        if(SWT_GetValue(i))
-        {
-            bResult |= (1 << i);
-        }
-    }
-    return bResult;
+    return GPIO_GetGroupValue(rgSwtPins, 8);
 }
 /* *****************************************************************************
  End of File
@@ -0,0 +1,514 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    telem.c
+
+  @Description
+        This file groups the functions that implement the TELEM library.
+        The library streams typed sensor samples over a UART instance of the UARTDRV library, in binary packets
+        instead of formatted text: no float formatting, and each packet carries the samples of a single channel,
+        so the channel id and the timestamp are sent once for each packet.
+        - channels: TELEM_AddChannel registers a name, a value type and the sample period, and sends the channel
+          description packet, so the host decoder knows the channels (TELEM_SendChannels sends them again, for a
+          host that connects later). For a channel with fixed period (for example sampled by a timer), a record
+          is the value only: a 16 bit sample takes 2.25 bytes on the wire, including the framing, so at 115200 baud
+          about 5000 samples / s are sent. For a channel without fixed period, each record also has the time since the
+          previous sample (1 byte, in TELEM_DELTA_US units, up to 1 ms): about 3400 samples / s at 115200 baud.
+        - samples: TELEM_Put appends a record to the packet of the channel. The packet is sent (FRAME library:
+          COBS, CRC-16) when it is full, or when its first sample is older than TELEM_MAX_AGE_US, or by TELEM_Flush.
+        - the functions do not wait for the transmission: when the transmit queue of the instance has no room
+          for a packet, the packet is dropped and counted, the next packet carries the number of dropped samples.
+        The timestamps are computed from the core timer, so the samples must be put at least once every
+        100 s (the core timer period) for the timestamps to stay continuous.
+        The UARTDRV instance must be opened (for example by UART_Init or UARTJB_Init) before TELEM_Init is called.
+        The functions must be called from the context that writes to the instance (usually the main loop), they
+        are not interrupt safe: the samples taken by an interrupt handler are queued by the handler (for example
+        in a circular buffer) and put from the main loop.
+        The packets are decoded on the host by tools/telem_decode.py (CSV output).
+        Include the file in the project, together with frame.c, uartdrv.c, hwres.c, softtmr.c and utils.c, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <string.h>
+#include "config.h"
+#include "telem.h"
+#include "uartdrv.h"
+#include "frame.h"
+#include "utils.h"
+
+/* ************************************************************************** */
+
+// the header of the samples packets: type, sequence number, channel, dropped samples, timestamp
+#define TELEM_HDR_BYTES     9
+// the time delta escape of the channels without fixed period: 2 bytes follow
+#define TELEM_DELTA_ESC     0xFF
+
+// a channel, and its current samples packet (cbPkt is 0 when no sample was put since the last packet was sent)
+typedef struct {
+    char szName[TELEM_MAX_NAME + 1];
+    unsigned char bType;
+    unsigned int usPeriod;
+    unsigned char rgbPkt[TELEM_MAX_PAYLOAD];
+    unsigned int cbPkt;
+    unsigned int cntPktSamples;
+    unsigned int usFirst;           // the time of the first sample of the packet
+    unsigned int usLast;            // the time of the last sample, as computed by the decoder (sum of the deltas)
+    unsigned int cntDropped;        // the samples dropped since the last packet sent
+} TELEM_CHANNEL;
+
+// the size of the values, for each type
+const unsigned char rgbTelemSizes[TELEM_T_F32 + 1] = {1, 1, 2, 2, 4, 4, 4};
+
+TELEM_CHANNEL rgTelemChannels[TELEM_NO_CHANNELS];
+unsigned char cntTelemChannels;
+unsigned char bTelemInstance = UARTDRV_NO_INSTANCES;
+unsigned char bTelemSeq;
+unsigned int cntTelemLost;          // since TELEM_Init
+unsigned char rgbTelemFrame[FRAME_MAX_ENCODED];
+
+// the us clock: the core timer value of the last us counted, and the us count
+unsigned int uiTelemCount, usTelemNow;
+
+/* ------------------------------------------------------------ */
+/***	TELEM_Init
+**
+**	Parameters:
+**		unsigned char bInstance     - the UARTDRV instance (for example UARTDRV_4, the USB - UART interface)
+**
+**	Return Value:
+**		unsigned char   - TELEM_OK
+**                        TELEM_ERR_PARAM if the instance is not valid or not open
+**
+**	Description:
+**		This function selects the instance used to send the packets, and clears the channel table
+**      and the counters.
+**
+*/
+unsigned char TELEM_Init(unsigned char bInstance)
+{
+    if(bInstance >= UARTDRV_NO_INSTANCES || !UARTDRV_GetBaud(bInstance))
+    {
+        return TELEM_ERR_PARAM;
+    }
+    bTelemInstance = bInstance;
+    cntTelemChannels = 0;
+    bTelemSeq = 0;
+    cntTelemLost = 0;
+    uiTelemCount = _CP0_GET_COUNT();
+    usTelemNow = 0;
+    return TELEM_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_AddChannel
+**
+**	Parameters:
+**		const char *szName          - the channel name, truncated to TELEM_MAX_NAME characters
+**		unsigned char bType         - the value type: TELEM_T_U8, TELEM_T_I8, TELEM_T_U16, TELEM_T_I16,
+**                                    TELEM_T_U32, TELEM_T_I32 or TELEM_T_F32
+**		unsigned int usPeriod       - the sample period in us, when the samples are taken at a fixed rate (for example
+**                                    by a timer interrupt handler, which queues them for the main loop), 0 otherwise
+**
+**	Return Value:
+**		unsigned char   - the channel id (0 - TELEM_NO_CHANNELS - 1), used by TELEM_Put
+**                        TELEM_ERR_FULL if TELEM_NO_CHANNELS channels are registered
+**                        TELEM_ERR_PARAM if the type is not valid, the library is not initialized,
+**                        or the instance is not writable (closed, or used by a bridge)
+**
+**	Description:
+**		This function registers a channel and sends its description packet. It waits while the transmit
+**      queue is full, so the channels are usually registered once, at initialization.
+**      For a channel with fixed period, the timestamps of the samples are computed by the decoder from the
+**      timestamp of the first sample of each packet and the period, so no time is sent for the other samples.
+**      The samples of a timer interrupt handler must not be put by the handler (TELEM_Put is called from the
+**      main loop only): the handler queues them, and the main loop puts all the queued samples, in order.
+**
+*/
+unsigned char TELEM_AddChannel(const char *szName, unsigned char bType, unsigned int usPeriod)
+{
+    TELEM_CHANNEL *pChannel;
+    if(bTelemInstance >= UARTDRV_NO_INSTANCES || bType > TELEM_T_F32)
+    {
+        return TELEM_ERR_PARAM;
+    }
+    if(cntTelemChannels >= TELEM_NO_CHANNELS)
+    {
+        return TELEM_ERR_FULL;
+    }
+    pChannel = &rgTelemChannels[cntTelemChannels];
+    strncpy(pChannel->szName, szName, TELEM_MAX_NAME);
+    pChannel->szName[TELEM_MAX_NAME] = 0;
+    pChannel->bType = bType;
+    pChannel->usPeriod = usPeriod;
+    pChannel->cbPkt = 0;
+    pChannel->cntPktSamples = 0;
+    pChannel->cntDropped = 0;
+    if(TELEM_SendChannel(cntTelemChannels) != TELEM_OK)
+    {
+        return TELEM_ERR_PARAM;
+    }
+    return cntTelemChannels++;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_SendChannels
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned char   - TELEM_OK
+**                        TELEM_ERR_PARAM if the instance is not writable (closed, or used by a bridge)
+**
+**	Description:
+**		This function sends the description packets of all the channels, for example periodically or when the
+**      host decoder requests them. It waits while the transmit queue is full.
+**
+*/
+unsigned char TELEM_SendChannels()
+{
+    unsigned char bChannel;
+    for(bChannel = 0; bChannel < cntTelemChannels; bChannel++)
+    {
+        if(TELEM_SendChannel(bChannel) != TELEM_OK)
+        {
+            return TELEM_ERR_PARAM;
+        }
+    }
+    return TELEM_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_Put
+**
+**	Parameters:
+**		unsigned char bChannel      - the channel id, returned by TELEM_AddChannel
+**		const void *pValue          - the value, of the channel type
+**
+**	Return Value:
+**		unsigned char   - TELEM_OK
+**                        TELEM_ERR_FULL if a packet was dropped because the transmit queue was full
+**                        TELEM_ERR_PARAM if the channel is not valid
+**
+**	Description:
+**		This function appends a sample to the packet of the channel. The packet is sent before the sample when
+**      the sample does not fit, or (channel without fixed period) was taken too long after the previous one,
+**      and after the sample when its first sample is older than TELEM_MAX_AGE_US. The function does not wait.
+**
+*/
+unsigned char TELEM_Put(unsigned char bChannel, const void *pValue)
+{
+    TELEM_CHANNEL *pChannel;
+    unsigned char cbValue, cbDelta = 0;
+    unsigned int us, cntUnits = 0, cntLost = cntTelemLost;
+    if(bTelemInstance >= UARTDRV_NO_INSTANCES || bChannel >= cntTelemChannels)
+    {
+        return TELEM_ERR_PARAM;
+    }
+    pChannel = &rgTelemChannels[bChannel];
+    cbValue = rgbTelemSizes[pChannel->bType];
+    us = TELEM_GetMicros();
+    if(pChannel->cbPkt && !pChannel->usPeriod)
+    {
+        cntUnits = (us - pChannel->usLast) / TELEM_DELTA_US;
+        cbDelta = cntUnits < TELEM_DELTA_ESC ? 1 : 3;
+    }
+    if(pChannel->cbPkt && (pChannel->cbPkt + cbDelta + cbValue > TELEM_MAX_PAYLOAD || cntUnits > 0xFFFF))
+    {
+        TELEM_FlushChannel(bChannel);
+    }
+    if(!pChannel->cbPkt)
+    {
+        pChannel->rgbPkt[0] = TELEM_PKT_SAMPLES;
+        pChannel->rgbPkt[2] = bChannel;
+        pChannel->rgbPkt[5] = us;
+        pChannel->rgbPkt[6] = us >> 8;
+        pChannel->rgbPkt[7] = us >> 16;
+        pChannel->rgbPkt[8] = us >> 24;
+        pChannel->cbPkt = TELEM_HDR_BYTES;
+        pChannel->usFirst = us;
+        pChannel->usLast = us;
+        cntUnits = 0;
+        cbDelta = pChannel->usPeriod ? 0 : 1;
+    }
+    if(cbDelta == 1)
+    {
+        pChannel->rgbPkt[pChannel->cbPkt++] = cntUnits;
+    }
+    else if(cbDelta == 3)
+    {
+        pChannel->rgbPkt[pChannel->cbPkt++] = TELEM_DELTA_ESC;
+        pChannel->rgbPkt[pChannel->cbPkt++] = cntUnits;
+        pChannel->rgbPkt[pChannel->cbPkt++] = cntUnits >> 8;
+    }
+    // the decoder adds the rounded deltas: the rest of the division is kept for the next delta, so there is no drift
+    pChannel->usLast += cntUnits * TELEM_DELTA_US;
+    memcpy(pChannel->rgbPkt + pChannel->cbPkt, pValue, cbValue);
+    pChannel->cbPkt += cbValue;
+    pChannel->cntPktSamples++;
+    if(us - pChannel->usFirst >= TELEM_MAX_AGE_US)
+    {
+        TELEM_FlushChannel(bChannel);
+    }
+    return cntLost == cntTelemLost ? TELEM_OK : TELEM_ERR_FULL;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_PutInt
+**
+**	Parameters:
+**		unsigned char bChannel      - the channel id, returned by TELEM_AddChannel
+**		int iValue                  - the value
+**
+**	Return Value:
+**		unsigned char   - the TELEM_Put return value
+**
+**	Description:
+**		This function puts an integer sample: it is converted to float for a TELEM_T_F32 channel, and truncated
+**      to the channel size for the other channels.
+**
+*/
+unsigned char TELEM_PutInt(unsigned char bChannel, int iValue)
+{
+    float fValue;
+    if(bChannel < cntTelemChannels && rgTelemChannels[bChannel].bType == TELEM_T_F32)
+    {
+        fValue = iValue;
+        return TELEM_Put(bChannel, &fValue);
+    }
+    // little endian: the first bytes of the integer are the least significant ones
+    return TELEM_Put(bChannel, &iValue);
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_PutFloat
+**
+**	Parameters:
+**		unsigned char bChannel      - the channel id, returned by TELEM_AddChannel
+**		float fValue                - the value
+**
+**	Return Value:
+**		unsigned char   - the TELEM_Put return value
+**
+**	Description:
+**		This function puts a float sample: it is sent as is for a TELEM_T_F32 channel, and converted to an
+**      integer (truncated to the channel size) for the other channels.
+**
+*/
+unsigned char TELEM_PutFloat(unsigned char bChannel, float fValue)
+{
+    int iValue;
+    if(bChannel < cntTelemChannels && rgTelemChannels[bChannel].bType != TELEM_T_F32)
+    {
+        iValue = (int)fValue;
+        return TELEM_Put(bChannel, &iValue);
+    }
+    return TELEM_Put(bChannel, &fValue);
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_Flush
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function sends the packets of all the channels that have samples. When the transmit queue has no room
+**      for a packet, the packet is dropped, and its samples are counted as lost.
+**
+*/
+void TELEM_Flush()
+{
+    unsigned char bChannel;
+    for(bChannel = 0; bChannel < cntTelemChannels; bChannel++)
+    {
+        TELEM_FlushChannel(bChannel);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_GetLost
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned int    - the number of samples dropped since TELEM_Init
+**
+**	Description:
+**		This function returns the number of samples dropped because the transmit queue was full.
+**      A steadily increasing value means that the sample rate is too high for the baud rate.
+**
+*/
+unsigned int TELEM_GetLost()
+{
+    return cntTelemLost;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_Close
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function sends the current packets and releases the instance. The instance is not closed.
+**
+*/
+void TELEM_Close()
+{
+    if(bTelemInstance >= UARTDRV_NO_INSTANCES)
+    {
+        return;
+    }
+    TELEM_Flush();
+    bTelemInstance = UARTDRV_NO_INSTANCES;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_GetMicros
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned int    - the time since TELEM_Init, in us (modulo 2^32)
+**
+**	Description:
+**		This function adds the whole us elapsed since the last call to the us clock. The remaining core timer
+**      ticks are counted at the next call, so the clock does not drift.
+**      This is a low-level function called by TELEM_Put, so user should avoid calling it directly.
+**
+*/
+unsigned int TELEM_GetMicros()
+{
+    unsigned int cntUs = (_CP0_GET_COUNT() - uiTelemCount) / TIME_TICKS_PER_US;
+    uiTelemCount += cntUs * TIME_TICKS_PER_US;
+    usTelemNow += cntUs;
+    return usTelemNow;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_FlushChannel
+**
+**	Parameters:
+**		unsigned char bChannel      - the channel id
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function sends the packet of a channel, if it has samples. When the transmit queue has no room for it,
+**      the packet is dropped, its samples are counted as lost and reported in the next packet of the channel.
+**      This is a low-level function called by TELEM_Put and TELEM_Flush, so user should avoid calling it directly.
+**
+*/
+void TELEM_FlushChannel(unsigned char bChannel)
+{
+    TELEM_CHANNEL *pChannel = &rgTelemChannels[bChannel];
+    unsigned int cntDropped = pChannel->cntDropped > 0xFFFF ? 0xFFFF : pChannel->cntDropped;
+    if(!pChannel->cbPkt)
+    {
+        return;
+    }
+    pChannel->rgbPkt[1] = bTelemSeq;
+    pChannel->rgbPkt[3] = cntDropped;
+    pChannel->rgbPkt[4] = cntDropped >> 8;
+    if(TELEM_SendPacket(pChannel->rgbPkt, pChannel->cbPkt))
+    {
+        bTelemSeq++;
+        pChannel->cntDropped = 0;
+    }
+    else
+    {
+        pChannel->cntDropped += pChannel->cntPktSamples;
+        cntTelemLost += pChannel->cntPktSamples;
+    }
+    pChannel->cbPkt = 0;
+    pChannel->cntPktSamples = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_SendPacket
+**
+**	Parameters:
+**		const unsigned char *pbPkt  - the packet
+**		unsigned int cbPkt          - the packet length
+**
+**	Return Value:
+**		unsigned char   - 1 if the frame was queued, 0 if the transmit queue has no room for it
+**
+**	Description:
+**		This function encodes the frame of a packet and queues it, as a whole.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char TELEM_SendPacket(const unsigned char *pbPkt, unsigned int cbPkt)
+{
+    unsigned int cbFrame = FRAME_Encode(pbPkt, cbPkt, rgbTelemFrame);
+    if(UARTDRV_GetTxFree(bTelemInstance) < cbFrame)
+    {
+        return 0;
+    }
+    UARTDRV_Write(bTelemInstance, rgbTelemFrame, cbFrame);
+    return 1;
+}
+
+/* ------------------------------------------------------------ */
+/***	TELEM_SendChannel
+**
+**	Parameters:
+**		unsigned char bChannel      - the channel id
+**
+**	Return Value:
+**		unsigned char   - TELEM_OK
+**                        TELEM_ERR_PARAM if the instance is not writable (closed, or used by a bridge)
+**
+**	Description:
+**		This function sends the description packet of a channel, it waits while the transmit queue is full.
+**      An instance that has no free space while nothing is being transmitted is closed or bridged (UARTDRV_GetTxFree
+**      returns 0), so the function does not wait for it.
+**      This is a low-level function called by TELEM_AddChannel and TELEM_SendChannels, so user should avoid calling it directly.
+**
+*/
+unsigned char TELEM_SendChannel(unsigned char bChannel)
+{
+    TELEM_CHANNEL *pChannel = &rgTelemChannels[bChannel];
+    unsigned char rgbPkt[7 + TELEM_MAX_NAME];
+    unsigned int cchName = strlen(pChannel->szName);
+    rgbPkt[0] = TELEM_PKT_CHANNEL;
+    rgbPkt[1] = bChannel;
+    rgbPkt[2] = pChannel->bType;
+    rgbPkt[3] = pChannel->usPeriod;
+    rgbPkt[4] = pChannel->usPeriod >> 8;
+    rgbPkt[5] = pChannel->usPeriod >> 16;
+    rgbPkt[6] = pChannel->usPeriod >> 24;
+    memcpy(rgbPkt + 7, pChannel->szName, cchName);
+    while(!TELEM_SendPacket(rgbPkt, 7 + cchName))
+    {
+        if(!UARTDRV_GetTxFree(bTelemInstance) && UARTDRV_IsTxIdle(bTelemInstance))
+        {
+            return TELEM_ERR_PARAM;
+        }
+    }
+    return TELEM_OK;
+}
+
+/* *****************************************************************************
+ End of File
+ */
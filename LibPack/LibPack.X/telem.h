@@ -0,0 +1,91 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    telem.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the TELEM library (defined in telem.c).
+        Include the file in the project when this library is needed.
+        Use #include "telem.h" in the source files where the functions are needed.
+
+        Each packet is the payload of a FRAME library frame (COBS, CRC-16, 0x00 delimiter). Values are little endian.
+            byte 0          packet type: TELEM_PKT_CHANNEL or TELEM_PKT_SAMPLES
+        TELEM_PKT_CHANNEL (sent by TELEM_AddChannel and TELEM_SendChannels):
+            byte 1          channel id
+            byte 2          value type (TELEM_T_xxx)
+            bytes 3 - 6     the sample period in us, 0 for a channel without fixed period
+            bytes 7 ..      channel name (no terminator)
+        TELEM_PKT_SAMPLES (the samples of a single channel):
+            byte 1          packet sequence number (modulo 256, for all the channels), for the host to detect lost packets
+            byte 2          channel id
+            bytes 3 - 4     the number of samples of the channel dropped before this packet (saturated at 0xFFFF)
+            bytes 5 - 8     the timestamp of the first sample, in us (modulo 2^32)
+            records, until the end of the payload:
+                channel with fixed period: the value only, sample i is at timestamp + i * period
+                channel without fixed period: the time since the previous sample of the packet (0 for the first one),
+                    in TELEM_DELTA_US units: 1 byte if it is less than 0xFF, otherwise 0xFF followed by 2 bytes,
+                    then the value
+            value: 1, 2 or 4 bytes (TELEM_T_F32: IEEE 754 single precision)
+        A host decoder (tools/telem_decode.py) keeps the channel table from the TELEM_PKT_CHANNEL packets, then
+        writes a row (timestamp, channel name, value) for each sample.
+ */
+/* ************************************************************************** */
+
+#ifndef _TELEM_H    /* Guard against multiple inclusion */
+#define _TELEM_H
+
+// the number of channels (each channel has a packet buffer of TELEM_MAX_PAYLOAD bytes)
+#define TELEM_NO_CHANNELS       8
+// the maximum length of a channel name, in characters
+#define TELEM_MAX_NAME          16
+// the maximum payload length of a samples packet, in bytes (longer packets have less overhead, and more latency)
+#define TELEM_MAX_PAYLOAD       128
+// a samples packet is sent when its first sample is older than this, in us
+#define TELEM_MAX_AGE_US        50000
+// the unit of the time deltas of the channels without fixed period, in us
+#define TELEM_DELTA_US          4
+
+// packet types
+#define TELEM_PKT_CHANNEL       0x01
+#define TELEM_PKT_SAMPLES       0x02
+
+// value types
+#define TELEM_T_U8              0
+#define TELEM_T_I8              1
+#define TELEM_T_U16             2
+#define TELEM_T_I16             3
+#define TELEM_T_U32             4
+#define TELEM_T_I32             5
+#define TELEM_T_F32             6
+
+// return values
+#define TELEM_OK                0
+#define TELEM_ERR_FULL          0xFC    // the channel table is full, or the transmit queue is full (the samples were dropped)
+#define TELEM_ERR_PARAM         0xFB    // invalid instance, channel or type, or the instance is not writable
+
+unsigned char TELEM_Init(unsigned char bInstance);
+unsigned char TELEM_AddChannel(const char *szName, unsigned char bType, unsigned int usPeriod);
+unsigned char TELEM_SendChannels();
+unsigned char TELEM_Put(unsigned char bChannel, const void *pValue);
+unsigned char TELEM_PutInt(unsigned char bChannel, int iValue);
+unsigned char TELEM_PutFloat(unsigned char bChannel, float fValue);
+void TELEM_Flush();
+unsigned int TELEM_GetLost();
+void TELEM_Close();
+
+//private functions:
+unsigned int TELEM_GetMicros();
+void TELEM_FlushChannel(unsigned char bChannel);
+unsigned char TELEM_SendPacket(const unsigned char *pbPkt, unsigned int cbPkt);
+unsigned char TELEM_SendChannel(unsigned char bChannel);
+
+#endif /* _TELEM_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,251 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    trace.c
+
+  @Description
+        This file groups the functions that implement the TRACE library.
+        The library records timestamped events (8 bytes records) in a RAM buffer, and exports them
+        in a framed binary format over a UART (for example UART_PutChar or UARTJB_PutChar).
+        Recording is lock-free: a record is reserved by atomically advancing the buffer head,
+        then it is written and published by writing its event field last. So events can be recorded
+        from interrupt handlers of any priority and from the main loop, without disabling interrupts.
+        When the buffer is full, the new records are dropped and counted (the exporter must keep up).
+        The record and frame formats are described in trace.h.
+        Include the file in the project, together with config.h, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include "config.h"
+#include "trace.h"
+
+/* ************************************************************************** */
+
+#define TRACE_MASK              (TRACE_BUF_SIZE - 1)
+#define TRACE_RECORDS_PER_FRAME 31      // 248 bytes payload
+
+TRACE_RECORD rgTraceBuf[TRACE_BUF_SIZE];
+
+// free running indexes: the head is advanced by the writers, the tail by the exporter
+volatile unsigned int idxTraceHead = 0, idxTraceTail = 0;
+volatile unsigned int cntTraceLost = 0;
+unsigned int cntTraceLostSent = 0;
+
+/* ------------------------------------------------------------ */
+/***	TRACE_Event
+**
+**	Parameters:
+**		unsigned short wEvent       - the event: event type (TRACE_TYPE_xxx) OR-ed with the source. Must not be 0.
+**		unsigned short wArg         - the event argument
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function records an event, with the current core timer value as timestamp.
+**      It is lock-free, so it can be called from interrupt handlers of any priority and from the main loop.
+**      If the function is preempted by another event recording, the records may not be in timestamp order,
+**      the decoder must sort them.
+**      Usually called using the TRACE_BEGIN, TRACE_END, TRACE_INSTANT and TRACE_VALUE macros.
+**
+*/
+void TRACE_Event(unsigned short wEvent, unsigned short wArg)
+{
+    TRACE_RECORD *pRec;
+    unsigned int idxHead;
+
+    if(!wEvent)
+    {
+        return;
+    }
+    // reserve a record
+    do
+    {
+        idxHead = idxTraceHead;
+        if(idxHead - idxTraceTail >= TRACE_BUF_SIZE)
+        {
+            __sync_fetch_and_add(&cntTraceLost, 1);
+            return;
+        }
+    } while(!__sync_bool_compare_and_swap(&idxTraceHead, idxHead, idxHead + 1));
+
+    // write the record, then publish it
+    pRec = &rgTraceBuf[idxHead & TRACE_MASK];
+    pRec->uiTimestamp = _CP0_GET_COUNT();
+    pRec->wArg = wArg;
+    __sync_synchronize();
+    pRec->wEvent = wEvent;
+}
+
+/* ------------------------------------------------------------ */
+/***	TRACE_Export
+**
+**	Parameters:
+**		void (*pfPutChar)(char)     - the function used to send a byte, for example UART_PutChar or UARTJB_PutChar
+**		unsigned int cntMax         - the maximum number of records to be exported
+**
+**	Return Value:
+**		unsigned int    - the number of exported records
+**
+**	Description:
+**		This function sends the recorded events in TRACE_FRAME_RECORDS frames, of up to 31 records each,
+**      and frees the buffer space. If records were lost since the previous call, a TRACE_FRAME_LOST frame is sent.
+**      The export stops at the first record still being written.
+**      It must be called only from the main loop, periodically, to stream the trace.
+**
+*/
+unsigned int TRACE_Export(void (*pfPutChar)(char), unsigned int cntMax)
+{
+    unsigned char rgPayload[TRACE_RECORDS_PER_FRAME * sizeof(TRACE_RECORD)];
+    unsigned int cntExported = 0, cntLost;
+    unsigned char cntRecs;
+    TRACE_RECORD *pRec, *pDst;
+
+    while(cntExported < cntMax)
+    {
+        cntRecs = 0;
+        pDst = (TRACE_RECORD *)rgPayload;
+        while((cntRecs < TRACE_RECORDS_PER_FRAME) && (cntExported + cntRecs < cntMax) && (idxTraceTail != idxTraceHead))
+        {
+            pRec = &rgTraceBuf[idxTraceTail & TRACE_MASK];
+            if(!pRec->wEvent)
+            {
+                break;
+            }
+            *pDst++ = *pRec;
+            pRec->wEvent = 0;
+            __sync_synchronize();
+            idxTraceTail++;
+            cntRecs++;
+        }
+        if(!cntRecs)
+        {
+            break;
+        }
+        TRACE_SendFrame(pfPutChar, TRACE_FRAME_RECORDS, rgPayload, cntRecs * sizeof(TRACE_RECORD));
+        cntExported += cntRecs;
+    }
+
+    cntLost = cntTraceLost;
+    if(cntLost != cntTraceLostSent)
+    {
+        cntTraceLostSent = cntLost;
+        TRACE_SendFrame(pfPutChar, TRACE_FRAME_LOST, (unsigned char *)&cntLost, sizeof(cntLost));
+    }
+    return cntExported;
+}
+
+/* ------------------------------------------------------------ */
+/***	TRACE_ExportInfo
+**
+**	Parameters:
+**		void (*pfPutChar)(char)     - the function used to send a byte, for example UART_PutChar or UARTJB_PutChar
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function sends a TRACE_FRAME_INFO frame, containing the timestamp frequency (SYS_FRQ / 2).
+**      It should be sent once, when the trace export starts, so that the decoder can convert the timestamps.
+**
+*/
+void TRACE_ExportInfo(void (*pfPutChar)(char))
+{
+    unsigned int uiFreq = SYS_FRQ / 2;
+    TRACE_SendFrame(pfPutChar, TRACE_FRAME_INFO, (unsigned char *)&uiFreq, sizeof(uiFreq));
+}
+
+/* ------------------------------------------------------------ */
+/***	TRACE_GetLost
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**		unsigned int    - the number of records lost because the buffer was full
+**
+**	Description:
+**		This function returns the total number of records lost because the buffer was full.
+**
+*/
+unsigned int TRACE_GetLost()
+{
+    return cntTraceLost;
+}
+
+/* ------------------------------------------------------------ */
+/***	TRACE_Clear
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function drops all the records and clears the lost records counter.
+**
+*/
+void TRACE_Clear()
+{
+    int i;
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    for(i = 0; i < TRACE_BUF_SIZE; i++)
+    {
+        rgTraceBuf[i].wEvent = 0;
+    }
+    idxTraceHead = 0;
+    idxTraceTail = 0;
+    cntTraceLost = 0;
+    cntTraceLostSent = 0;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	TRACE_SendFrame
+**
+**	Parameters:
+**		void (*pfPutChar)(char)     - the function used to send a byte
+**		unsigned char bType         - the frame type (TRACE_FRAME_xxx)
+**		unsigned char *pPayload     - the payload
+**		unsigned char cbPayload     - the payload length in bytes
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function sends a frame: the sync bytes, type, length, payload and XOR checksum.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void TRACE_SendFrame(void (*pfPutChar)(char), unsigned char bType, unsigned char *pPayload, unsigned char cbPayload)
+{
+    unsigned char bChecksum = bType ^ cbPayload;
+    (*pfPutChar)(0xA5);
+    (*pfPutChar)(0x5A);
+    (*pfPutChar)(bType);
+    (*pfPutChar)(cbPayload);
+    while(cbPayload--)
+    {
+        bChecksum ^= *pPayload;
+        (*pfPutChar)(*pPayload++);
+    }
+    (*pfPutChar)(bChecksum);
+}
+
+/* *****************************************************************************
+ End of File
+ */
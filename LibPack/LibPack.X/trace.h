@@ -0,0 +1,99 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    trace.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the TRACE library (defined in trace.c), and the macros used to instrument the code.
+        The instrumentation macros are enabled by defining TRACE_ENABLE in config.h. When it is not defined,
+        they expand to nothing.
+        Include the file in the project when this library is needed.
+        Use #include "trace.h" in the source files where the functions are needed.
+
+        Trace record (8 bytes, little endian):
+            bytes 0 - 3     timestamp, core timer ticks (SYS_FRQ / 2)
+            bytes 4 - 5     event: bits 15 - 12 event type (TRACE_TYPE_xxx), bits 11 - 0 source (TRACE_SRC_xxx or user defined)
+            bytes 6 - 7     argument
+        Export frame:
+            byte 0          0xA5 (sync)
+            byte 1          0x5A (sync)
+            byte 2          frame type: TRACE_FRAME_INFO, TRACE_FRAME_RECORDS or TRACE_FRAME_LOST
+            byte 3          payload length N in bytes (TRACE_FRAME_RECORDS: multiple of 8, at most 248)
+            bytes 4 .. N+3  payload
+            byte N+4        checksum: XOR of bytes 2 .. N+3
+        Payloads:
+            TRACE_FRAME_INFO    4 bytes: the timestamp frequency in Hz (little endian)
+            TRACE_FRAME_RECORDS N / 8 records
+            TRACE_FRAME_LOST    4 bytes: the total number of records lost because the buffer was full
+        A host decoder maps TRACE_TYPE_BEGIN / TRACE_TYPE_END pairs of the same source to duration events,
+        and TRACE_TYPE_INSTANT to instant events (for example Chrome trace "B", "E" and "i" events).
+ */
+/* ************************************************************************** */
+
+#ifndef _TRACE_H    /* Guard against multiple inclusion */
+#define _TRACE_H
+
+// the number of records of the trace buffer (must be a power of 2)
+#define TRACE_BUF_SIZE      256
+
+// event types
+#define TRACE_TYPE_BEGIN    0x1000  // the source starts an activity (interrupt handler, task)
+#define TRACE_TYPE_END      0x2000  // the source ends the activity
+#define TRACE_TYPE_INSTANT  0x3000  // an instant event
+#define TRACE_TYPE_VALUE    0x4000  // a value (counter) sample
+
+// sources
+#define TRACE_SRC_TMR1      0x001   // Timer1ISR (SSD)
+#define TRACE_SRC_TMR3      0x003   // Timer3ISR (AUDIO)
+#define TRACE_SRC_TMR4      0x004   // Timer4SR (statemachine)
+#define TRACE_SRC_TMR5      0x005   // Timer5ISR (RGBLED)
+#define TRACE_SRC_UART4     0x010   // Uart4Handler (UARTDRV: UART)
+#define TRACE_SRC_UART1     0x011   // Uart1Handler (UARTDRV: UARTJB)
+#define TRACE_SRC_UART5     0x012   // Uart5Handler (UARTDRV: IRDA)
+#define TRACE_SRC_CORETMR   0x020   // CoreTimerISR (SOFTTMR)
+#define TRACE_SRC_I2C       0x030   // I2C transactions
+#define TRACE_SRC_TASK      0x100   // SCHED task handlers: TRACE_SRC_TASK + task id
+#define TRACE_SRC_USER      0x800   // the first source available for the user
+
+// export frame types
+#define TRACE_FRAME_INFO    0x01
+#define TRACE_FRAME_RECORDS 0x02
+#define TRACE_FRAME_LOST    0x03
+
+typedef struct {
+    unsigned int uiTimestamp;
+    volatile unsigned short wEvent;     // 0 while the record is being written
+    unsigned short wArg;
+} TRACE_RECORD;
+
+#ifdef TRACE_ENABLE
+#define TRACE_BEGIN(src, arg)       TRACE_Event(TRACE_TYPE_BEGIN | (src), arg)
+#define TRACE_END(src, arg)         TRACE_Event(TRACE_TYPE_END | (src), arg)
+#define TRACE_INSTANT(src, arg)     TRACE_Event(TRACE_TYPE_INSTANT | (src), arg)
+#define TRACE_VALUE(src, arg)       TRACE_Event(TRACE_TYPE_VALUE | (src), arg)
+#else
+#define TRACE_BEGIN(src, arg)
+#define TRACE_END(src, arg)
+#define TRACE_INSTANT(src, arg)
+#define TRACE_VALUE(src, arg)
+#endif
+
+void TRACE_Event(unsigned short wEvent, unsigned short wArg);
+unsigned int TRACE_Export(void (*pfPutChar)(char), unsigned int cntMax);
+void TRACE_ExportInfo(void (*pfPutChar)(char));
+unsigned int TRACE_GetLost();
+void TRACE_Clear();
+
+//private functions:
+void TRACE_SendFrame(void (*pfPutChar)(char), unsigned char bType, unsigned char *pPayload, unsigned char cbPayload);
+
+#endif /* _TRACE_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -11,9 +11,10 @@
         This file groups the functions that implement the UART library.
         This library implements the UART4 functionality connected to the USB - UART 
         interface labeled UART. It provides basic functions to configure UART and  
-        transmit / receive functions. The receive can be done both with interrupts and with 
-        polling method. 
-        Include the file in the project, together with config.h, when this library is needed.		
+        transmit / receive functions. The library is a wrapper over the UARTDRV_4 instance
+        of the UARTDRV library: the received bytes are stored in the receive queue (by DMA when
+        a DMA channel is available), and the transmitted bytes are queued.
+        Include the file in the project, together with config.h, uartdrv.c, hwres.c and softtmr.c, when this library is needed.
 
   @Author
     Cristian Fatu 
@@ -26,64 +27,13 @@
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
 #include <xc.h>
-#include <sys/attribs.h>
+#include <string.h>
 #include "config.h"
 #include "uart.h"
+#include "uartdrv.h"
 
-// global variables, to communicate between interrupt handler and other 
-volatile unsigned char fRxDone;
-volatile unsigned char ichRx;
-char rgchRx[cchRxMax];
 /* ************************************************************************** */
 
-/* ------------------------------------------------------------ */
-/***	Uart4Handler
-**
-**	Description:
-**		This is the interrupt handler for UART4 RX. It is used to receive strings using interrupt method. 
-**      The interrupt recognizes a string having up to cchRxMax - 2 characters, followed by a CRLF.
-**      When available received bytes are found they are placed in a global string rgchRx.
-**      When a carriage return and a line feed ("\r\n", CRLF) sequence is recognized, the interrupt handler 
-**      flags the success using the fRxDone global variable and then ignores the received bytes.
-**          
-*/
-void __ISR(_UART_4_VECTOR, ipl6) Uart4Handler (void)
-{
-	unsigned char bVal;
-	
-	//Read the Uart4 RX buffer while data is available
-	while(U4STAbits.URXDA)
-	{
-		bVal = (unsigned char)U4RXREG;
-		
-		if(!fRxDone)
-	    {
-	        // Do we have space to store another character?
-	        if (cchRxMax > ichRx)
-	        {
-	            // Yes.
-                rgchRx[ichRx] = bVal;
-	
-	            // Is this the last character of the command?
-	            if(('\n' == rgchRx[ichRx] ) && ('\r' == rgchRx[ichRx-1]))
-	            {
-	                // Yes.
-	                fRxDone = 1;
-	            }   
-	            ichRx++;
-	        }  
-	        else
-	        {
-	            // No, we don't have space to store anymore characters.
-	            // Mark the command as complete
-	            fRxDone = 1;
-	        }   
-    	}  	
-	}  
-	//Clear the Uart4 interrupt flag.
-	IFS2bits.U4RXIF = 0;
-}
-
 /***	UART_Init
 **
 **	Parameters:
@@ -91,22 +41,27 @@ void __ISR(_UART_4_VECTOR, ipl6) Uart4Handler (void)
 **                                     for example 115200 corresponds to 115200 baud			
 **
 **	Return Value:
-**		
+**		unsigned char   - UARTDRV_OK
+**                        UARTDRV_ERR_PARAM if the baud rate cannot be generated within UARTDRV_MAX_ERR_PERMILLE
+**                        (the UART is then left closed)
 **
 **	Description:
-**		This function initializes the hardware involved in the UART module, in 
-**      the UART receive with interrupt mode.
+**		This function initializes the hardware involved in the UART module.
 **      The UART_TX digital pin is configured as digital output.
 **      The UART_RX digital pin is configured as digital input.
 **      The UART_TX and UART_RX are mapped over the UART4 interface.
-**      The UART4 module of PIC32 is configured to work at the specified baud, no parity and 1 stop bit.
-**      
+**      The UART4 module of PIC32 is configured to work at the specified baud, no parity and 1 stop bit,
+**      using the DMA channels of the UARTDRV library when they are available.
+**      When the UART is already initialized, the queued bytes are transmitted, then it is closed and
+**      initialized again, so the function can be called again to change the baud rate.
 **          
 */
-void UART_Init(unsigned int baud)
+unsigned char UART_Init(unsigned int baud)
 {
     UART_ConfigurePins();
-    UART_ConfigureUartRXInt(baud);
+    UARTDRV_Flush(UARTDRV_4);
+    UARTDRV_Close(UARTDRV_4);
+    return UARTDRV_Open(UARTDRV_4, baud, UARTDRV_F_DMA);
 }
 
 /***	UART_InitPoll
@@ -116,98 +71,18 @@ void UART_Init(unsigned int baud)
 **                                     for example 115200 corresponds to 115200 baud			
 **
 **	Return Value:
-**		
-**
-**	Description:
-**		This function initializes the hardware involved in the UART module, in 
-**      the UART receive without interrupts (polling method).
-**      The UART_TX digital pin is configured as digital output.
-**      The UART_RX digital pin is configured as digital input.
-**      The UART_TX and UART_RX are mapped over the UART4 interface.
-**      The UART4 module of PIC32 is configured to work at the specified baud, no parity and 1 stop bit.
-**      
-**          
-*/
-void UART_InitPoll(unsigned int baud)
-{
-    UART_ConfigurePins();
-    UART_ConfigureUart(baud);
-}
-
-/***	UART_ConfigureUart
-**
-**	Parameters:
-**		unsigned int baud - UART baud rate.
-**                                     for example 115200 corresponds to 115200 baud
-**
-**	Return Value:
-**		
-**
-**	Description:
-**		This function configures the UART4 hardware interface of PIC32, according 
-**      to the provided baud rate, no parity and 1 stop bit, with no interrupts.
-**      In order to compute the baud rate value, it uses the peripheral bus frequency definition (PB_FRQ, located in config.h)
-**      This is a low-level function called by initialization functions, so user should avoid calling it directly.   
-**      
-**          
-*/
-void UART_ConfigureUart(unsigned int baud)
-{
-    U4MODEbits.ON     = 0;
-    U4MODEbits.SIDL   = 0;
-    U4MODEbits.IREN   = 0; 
-    U4MODEbits.RTSMD  = 0;
-    U4MODEbits.UEN0   = 0; 
-    U4MODEbits.UEN1   = 0;
-    U4MODEbits.WAKE   = 0;
-    U4MODEbits.LPBACK = 0; 
-    U4MODEbits.ABAUD  = 0;
-    U4MODEbits.RXINV  = 0; 
-    U4MODEbits.PDSEL1 = 0; 
-    U4MODEbits.PDSEL0 = 0; 
-    U4MODEbits.STSEL  = 0;  
-
-    
-    U4MODEbits.BRGH   = 0; 
-
-    U4BRG = (int)(((float)PB_FRQ/(16*baud) - 1) + 0.5); // add 0.5 just in order to implement the round using the floor approach
-
-    U4STAbits.UTXEN    = 1;
-    U4STAbits.URXEN    = 1;
-    U4MODEbits.ON      = 1; 
-    
-}
-
-/***	UART_ConfigureUartRXInt
-**
-**	Parameters:
-**		unsigned int baud - UART baud rate.
-**                                     for example 115200 corresponds to 115200 baud
-**
-**	Return Value:
-**		
+**		unsigned char   - the UART_Init return value
 **
 **	Description:
-**		This function configures the UART4 hardware interface of PIC32, according 
-**      to the provided baud rate, no parity and 1 stop bit (by calling the UART_ConfigureUart function)
-**      and additionally configures the interrupt on RX.
-**      This is a low-level function called by initialization functions, so user should avoid calling it directly.   
+**		This function initializes the hardware involved in the UART module, like UART_Init.
+**      The received bytes are always stored in the receive queue, so the polling functions
+**      (UART_GetCharPoll, UART_GetStringPoll) and UART_GetString can be used after either function.
 **      
 **          
 */
-void UART_ConfigureUartRXInt(unsigned int baud)
+unsigned char UART_InitPoll(unsigned int baud)
 {
-
-    UART_ConfigureUart(baud);
-
-    IPC9bits.U4IP = 6;
-    IPC9bits.U4IS = 3;
-
-	IFS2bits.U4RXIF = 0;    //Clear the Uart4 interrupt flag.
-    IEC2bits.U4RXIE = 1;    // enable RX interrupt
-    
-
-    macro_enable_interrupts();  // enable interrupts 
+    return UART_Init(baud);
 }
 
 /***	UART_ConfigurePins
@@ -236,9 +111,6 @@ void UART_ConfigurePins()
     rp_UART_RX = 9;     // 1001 RF13
 }
 
-
-
-
 /***	UART_PutChar
 **
 **	Parameters:
@@ -248,14 +120,14 @@ void UART_ConfigurePins()
 **		
 **
 **	Description:
-**		This function transmits a character over UART4. 
+**		This function queues a character to be transmitted over UART4.
+**      It waits while the transmit queue is full.
 **      
 **          
 */
 void UART_PutChar(char ch)
 {
-    while(U4STAbits.UTXBF == 1);
-    U4TXREG = ch;
+    while(!UARTDRV_Write(UARTDRV_4, &ch, 1));
 }
 
 /***	UART_PutString
@@ -267,42 +139,41 @@ void UART_PutChar(char ch)
 **		
 **
 **	Description:
-**		This function transmits all the characters from a zero terminated string over UART4. The terminator character is not sent.
+**		This function queues all the characters from a zero terminated string to be transmitted over UART4.
+**      The terminator character is not sent. It waits while the transmit queue is full.
 **      
 **          
 */
 void UART_PutString(char szData[])
 {
-    char *pData = szData;
-    while(*pData)
+    unsigned int cch = strlen(szData);
+    unsigned int ich = 0;
+    while(ich < cch)
     {
-        UART_PutChar((*(pData++)));
+        ich += UARTDRV_Write(UARTDRV_4, szData + ich, cch - ich);
     }
 }
 
-
-
 /***	UART_AvaliableRx
 **
 **	Parameters:
 **          
 **
 **	Return Value:
-**          - unsigned char - Receive Buffer Data Available bit 
-                    1 = Receive buffer has data, at least one more character can be read
-                    0 = Receive buffer is empty
+**          - unsigned char - receive data available
+                    1 = the receive queue has data, at least one more character can be read
+                    0 = the receive queue is empty
 **		
 **
 **	Description:
-**		This function returns UART4 Receive Buffer Data Available bit.
-**      It returns 1 if the receive buffer has data (at least one more character can be read).
-**      It returns 0 if the receive buffer is empty.
+**		This function returns 1 if the receive queue has data (at least one more character can be read).
+**      It returns 0 if the receive queue is empty.
 **      
 **          
 */
 unsigned char UART_AvaliableRx()
 {
-    return U4STAbits.URXDA;
+    return UARTDRV_GetRxCount(UARTDRV_4) != 0;
 }
 
 /***	UART_GetCharPoll
@@ -323,14 +194,15 @@ unsigned char UART_AvaliableRx()
 */
 unsigned char UART_GetCharPoll() 
 {
-    while (!UART_AvaliableRx());
-    return U4RXREG;
+    unsigned char bVal;
+    while(!UARTDRV_Read(UARTDRV_4, &bVal, 1));
+    return bVal;
 }
 
 /***	UART_GetStringPoll
 **
 **	Parameters:
-**          - unsigned char *pText - Pointer to a buffer to store the received bytes.
+**          - unsigned char *pText - Pointer to a buffer to store the received bytes (at least cchRxMax + 1 bytes).
 **          
 **
 **	Return Value:
@@ -339,18 +211,12 @@ unsigned char UART_GetCharPoll()
 **              0 if no received bytes are available 
 **
 **	Description:
-**		This function returns a zero terminated string received over UART4, using polling method.    
-**      While a received bytes is available, this function calls repeatedly UART_GetCharPoll 
-**      until no values are received over UART4.
+**		This function returns a zero terminated string containing the bytes received over UART4 (at most cchRxMax).
 **      It returns 0 if no received bytes are available, and returns 1 if at least one byte was received.
 */
 unsigned char UART_GetStringPoll(unsigned char *pText)
 {
-    int idx = 0;
-    while(UART_AvaliableRx())
-    {
-        pText[idx++] = UART_GetCharPoll();
-    }
+    unsigned int idx = UARTDRV_Read(UARTDRV_4, pText, cchRxMax);
     if(idx != 0)
     {
         pText[idx] = 0; // terminator
@@ -373,10 +239,9 @@ unsigned char UART_GetStringPoll(unsigned char *pText)
 **                  -3	- an invalid (0 char count) CR+LF terminated string was received  
 **
 **	Description:
-**		This function returns a zero terminated string to be received over UART4,  
-**      received using interrupt method. The interrupt recognizes a string 
+**		This function returns a zero terminated string received over UART4. It recognizes a string 
 **		having up to cchRxMax - 2 characters, followed by a carriage
-**		return and a line feed ("\r\n", CRLF). The CRLF is stripped
+**		return and a line feed ("\r\n", CRLF) or by a line feed. The terminator is stripped
 **		from the string and a NULL character ('\0') is appended.
 **		The number of characters contained in the zero terminated
 **		string is returned as a value greater than 0.
@@ -384,49 +249,18 @@ unsigned char UART_GetStringPoll(unsigned char *pText)
 */
 unsigned char UART_GetString( char* pchBuff, int cchBuff )
 {
-	unsigned char ich;
-	
-	// Have we finished receiving a CR+LF terminated string via UART4?
-	if(!fRxDone)
-	{
-		return 0;
-	}
-	// Does the user buffer have enough space to store the CR+LF terminated string?
-	if(cchBuff < ichRx - 1)
-	{
-		// A buffer underrun occured.
-		macro_disable_interrupts;
-		fRxDone = 0;
-		ichRx = 0;
-		macro_enable_interrupts();
-		
-		return -2;
-	}
-    // Was a 0 character CR+LF terminated string received?
-	if(2 == ichRx )
-	{
-		// A zero character length CR+LF terminated string was received.
-		macro_disable_interrupts;
-		fRxDone = 0;
-		ichRx = 0;
-		macro_enable_interrupts();
-		return -3;
-	}
-	
-    // copy the received chars to the destination location.
-	for(ich = 0; ich < ichRx - 2; ich++)
-	{
-		*pchBuff = rgchRx[ich]; 
-		pchBuff++;
-	}
-	*pchBuff = '\0';
-	
-	macro_disable_interrupts;
-	fRxDone = 0;
-	ichRx = 0;
-	macro_enable_interrupts();
-	return ich;
+    int cch = UARTDRV_ReadLine(UARTDRV_4, pchBuff, cchBuff, cchRxMax);
+    if(cch == -1)
+    {
+        return 0;
+    }
+    if(cch == 0)
+    {
+        return -3;
+    }
+    return cch;
 }
+
 /***	UART_Close
 **
 **	Parameters:
@@ -443,7 +277,7 @@ unsigned char UART_GetString( char* pchBuff, int cchBuff )
 */
 void UART_Close()
 {
-      U4MODEbits.ON = 0;   
+    UARTDRV_Close(UARTDRV_4);
 }
 /* *****************************************************************************
  End of File
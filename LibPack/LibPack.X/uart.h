@@ -19,11 +19,12 @@
 #define _UART_H
 
 #define	cchRxMax	0xFF	// maximum number of characters a CR+LF terminated string
-void UART_InitPoll(unsigned int baud);
-void UART_Init(unsigned int baud);
-void UART_CloseUART();
+unsigned char UART_InitPoll(unsigned int baud);
+unsigned char UART_Init(unsigned int baud);
+void UART_Close();
 
 
+void UART_PutChar(char ch);
 void UART_PutString(char szData[]);
 unsigned char UART_GetCharPoll();
 unsigned char UART_AvaliableRx();
@@ -32,8 +33,6 @@ unsigned char UART_GetStringPoll(unsigned char *pText);
 
 // private functions
 void UART_ConfigurePins();
-void UART_ConfigureUart(unsigned int baud);
-void UART_ConfigureUartRXInt(unsigned int baud);
 
 
 //#ifdef __cplusplus
@@ -0,0 +1,1642 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    uartdrv.c
+
+  @Description
+        This file groups the functions that implement the UARTDRV library.
+        The library is the UART engine shared by the UART (UART4), UARTJB (UART1) and IRDA (UART5) libraries.
+        Each instance has a receive queue and a transmit queue:
+        - receive: when a DMA channel is available, the channel copies the received bytes into the receive
+          queue used as a circular buffer (auto enable). The only interrupts are the half full and full events
+          of the buffer, used to count the received bytes. Without DMA channel, the UART receive interrupt copies
+          the bytes from the receive FIFO.
+        - transmit: UARTDRV_Write copies the bytes into the transmit queue, a DMA channel (or, without DMA channel,
+          the UART transmit interrupt) moves them into the transmit FIFO.
+        - message detection: a soft timer (SOFTTMR library) checks the receive queue every UARTDRV_POLL_MS, and calls
+          the user callback when the pattern byte (for example '\n') was received, or when the line is idle for
+          the idle time after the last received byte. The UART has no idle line interrupt, and the DMA pattern match
+          restarts the buffer, so both are detected in software, once for each message instead of once for each byte.
+        - bridge mode: two instances are connected (for example the USB - UART and Pmod JB), the transmit interrupt
+          of each instance sends the bytes directly from the receive queue of the other one (no copy), with
+          a high water mark and optional XON / XOFF flow control.
+        The baud rate generator uses integer math: the divider (BRGH = 0: 16, BRGH = 1: 4) and UxBRG with the smallest
+        error are selected, so rates up to PB_FRQ / 4 (for example 921600 or 2000000 baud) are reachable.
+        The DMA channels UARTDRV_DMA_FIRST ... are allocated using the HWRES library, in the order the instances are
+        opened with UARTDRV_F_DMA.
+        The SOFTTMR library must be initialized (SOFTTMR_Init) before the message detection or the bridge mode is enabled.
+        Include the file in the project, together with config.h, hwres.c and softtmr.c, when this library is needed.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <xc.h>
+#include <sys/attribs.h>
+#include <sys/kmem.h>
+#include "config.h"
+#include "uartdrv.h"
+#include "hwres.h"
+#include "softtmr.h"
+#include "prof.h"
+#include "trace.h"
+
+/* ************************************************************************** */
+
+#define UARTDRV_RX_MASK     (UARTDRV_RX_SIZE - 1)
+#define UARTDRV_TX_MASK     (UARTDRV_TX_SIZE - 1)
+
+// the registers of an instance
+typedef struct {
+    volatile unsigned int *pMODE;
+    volatile unsigned int *pSTA;
+    volatile unsigned int *pSTACLR;
+    volatile unsigned int *pSTASET;
+    volatile unsigned int *pTXREG;
+    volatile unsigned int *pRXREG;
+    volatile unsigned int *pBRG;
+    volatile unsigned int *pIFSCLR;
+    volatile unsigned int *pIEC;
+    volatile unsigned int *pIECSET;
+    volatile unsigned int *pIECCLR;
+    unsigned int uiIntMasks;            // all the UART interrupts (error, receive, transmit) in IFSx / IECx
+    unsigned int uiRxMask;
+    unsigned int uiTxMask;
+    volatile unsigned int *pIPCCLR;
+    volatile unsigned int *pIPCSET;
+    unsigned int uiIpcMask;             // the UxIP and UxIS fields
+    unsigned char bIpcPos;              // the position of the UxIP field
+    unsigned char bRxIrq;               // the DMA triggers
+    unsigned char bTxIrq;
+} UARTDRV_REGS;
+
+const UARTDRV_REGS rgUartDrvRegs[UARTDRV_NO_INSTANCES] = {
+    {&U1MODE, &U1STA, &U1STACLR, &U1STASET, &U1TXREG, &U1RXREG, &U1BRG, &IFS1CLR, &IEC1, &IEC1SET, &IEC1CLR,
+        _IFS1_U1EIF_MASK | _IFS1_U1RXIF_MASK | _IFS1_U1TXIF_MASK, _IFS1_U1RXIF_MASK, _IFS1_U1TXIF_MASK,
+        &IPC7CLR, &IPC7SET, _IPC7_U1IP_MASK | _IPC7_U1IS_MASK, _IPC7_U1IP_POSITION, _UART1_RX_IRQ, _UART1_TX_IRQ},
+    {&U4MODE, &U4STA, &U4STACLR, &U4STASET, &U4TXREG, &U4RXREG, &U4BRG, &IFS2CLR, &IEC2, &IEC2SET, &IEC2CLR,
+        _IFS2_U4EIF_MASK | _IFS2_U4RXIF_MASK | _IFS2_U4TXIF_MASK, _IFS2_U4RXIF_MASK, _IFS2_U4TXIF_MASK,
+        &IPC9CLR, &IPC9SET, _IPC9_U4IP_MASK | _IPC9_U4IS_MASK, _IPC9_U4IP_POSITION, _UART4_RX_IRQ, _UART4_TX_IRQ},
+    {&U5MODE, &U5STA, &U5STACLR, &U5STASET, &U5TXREG, &U5RXREG, &U5BRG, &IFS2CLR, &IEC2, &IEC2SET, &IEC2CLR,
+        _IFS2_U5EIF_MASK | _IFS2_U5RXIF_MASK | _IFS2_U5TXIF_MASK, _IFS2_U5RXIF_MASK, _IFS2_U5TXIF_MASK,
+        &IPC12CLR, &IPC12SET, _IPC12_U5IP_MASK | _IPC12_U5IS_MASK, _IPC12_U5IP_POSITION, _UART5_RX_IRQ, _UART5_TX_IRQ}
+};
+
+// the registers of the DMA channels used by the library
+typedef struct {
+    volatile unsigned int *pCON;
+    volatile unsigned int *pCONSET;
+    volatile unsigned int *pECON;
+    volatile unsigned int *pECONSET;
+    volatile unsigned int *pINT;
+    volatile unsigned int *pINTCLR;
+    volatile unsigned int *pSSA;
+    volatile unsigned int *pDSA;
+    volatile unsigned int *pSSIZ;
+    volatile unsigned int *pDSIZ;
+    volatile unsigned int *pCSIZ;
+    volatile unsigned int *pDPTR;
+    unsigned int uiIntMask;             // DMAxIF / DMAxIE in IFS2 / IEC2
+    unsigned int uiIpcMask;             // DMAxIP and DMAxIS in IPC10
+    unsigned char bIpcPos;
+} UARTDRV_DMA_REGS;
+
+const UARTDRV_DMA_REGS rgUartDrvDmaRegs[UARTDRV_NO_DMAS] = {
+    {&DCH2CON, &DCH2CONSET, &DCH2ECON, &DCH2ECONSET, &DCH2INT, &DCH2INTCLR, &DCH2SSA, &DCH2DSA, &DCH2SSIZ, &DCH2DSIZ, &DCH2CSIZ, &DCH2DPTR,
+        _IFS2_DMA2IF_MASK, _IPC10_DMA2IP_MASK | _IPC10_DMA2IS_MASK, _IPC10_DMA2IP_POSITION},
+    {&DCH3CON, &DCH3CONSET, &DCH3ECON, &DCH3ECONSET, &DCH3INT, &DCH3INTCLR, &DCH3SSA, &DCH3DSA, &DCH3SSIZ, &DCH3DSIZ, &DCH3CSIZ, &DCH3DPTR,
+        _IFS2_DMA3IF_MASK, _IPC10_DMA3IP_MASK | _IPC10_DMA3IS_MASK, _IPC10_DMA3IP_POSITION}
+};
+
+// the state of an instance. The free running queue indexes are changed by a single producer
+// (the head of the receive queue: the receive interrupt, the tail of the transmit queue: the transmit interrupt
+// or the DMA interrupt) and a single consumer (the caller of UARTDRV_Read / UARTDRV_Write).
+typedef struct {
+    unsigned char fOpen;
+    unsigned char bRxDma;               // the DMA channel (0 - UARTDRV_NO_DMAS - 1), UARTDRV_NO_DMAS if not used
+    unsigned char bTxDma;
+    unsigned char rgbRx[UARTDRV_RX_SIZE];
+    unsigned char rgbTx[UARTDRV_TX_SIZE];
+    volatile unsigned int idxRxHead;    // without receive DMA channel
+    volatile unsigned int cntRxHalves;  // with receive DMA channel: the halves of rgbRx filled by the channel
+    volatile unsigned int idxRxTail;
+    volatile unsigned int idxTxHead, idxTxTail;
+    volatile unsigned int cbTxDma;      // the length of the transmit DMA transfer in progress, 0 if none
+    volatile unsigned int cntLost;
+    // message detection
+    int iPattern;
+    unsigned int msIdle;
+    unsigned int msQuiet;               // the time since the last received byte
+    unsigned char fIdlePending;         // bytes were received since the last idle event
+    unsigned int idxPoll;               // the receive head at the last poll
+    unsigned int idxScan;               // the first byte not checked for the pattern
+    UARTDRV_CALLBACK pfCallback;
+    void *pCtx;
+    SOFTTMR_TIMER tmrPoll;
+    // bridge mode
+    unsigned char bBridgeDst;           // the instance transmitting the receive queue, UARTDRV_NO_INSTANCES if none
+    unsigned char bBridgeSrc;           // the instance whose receive queue is transmitted, UARTDRV_NO_INSTANCES if none
+    volatile unsigned char bFlowByte;   // XON / XOFF transmitted before the bridged bytes, 0 if none
+    unsigned char fHighWater;           // the receive queue reached the high water mark, and did not drop below half of it
+    volatile unsigned int cntBridged;
+    unsigned int cntHighWater;
+    unsigned int cbMaxFill;
+    unsigned char fBridgeRxDma;         // the receive DMA channel was allocated by UARTDRV_StartBridge
+    unsigned char fBridgeTxDma;         // the transmit DMA channel was released by UARTDRV_StartBridge
+} UARTDRV_STATE;
+
+UARTDRV_STATE rgUartDrvs[UARTDRV_NO_INSTANCES];
+
+// the instance using each DMA channel, UARTDRV_NO_INSTANCES if the channel is free
+unsigned char rgUartDrvDmaUse[UARTDRV_NO_DMAS] = {UARTDRV_NO_INSTANCES, UARTDRV_NO_INSTANCES};
+
+// the bridge settings, the instances are UARTDRV_NO_INSTANCES when the bridge is stopped
+unsigned char bUartDrvBridgeA = UARTDRV_NO_INSTANCES, bUartDrvBridgeB = UARTDRV_NO_INSTANCES;
+unsigned int cbUartDrvHighWater;
+unsigned char bUartDrvBridgeFlags;
+SOFTTMR_TIMER tmrUartDrvBridge;
+
+/* ------------------------------------------------------------ */
+/***	Uart1Handler, Uart4Handler, Uart5Handler
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		The interrupt handlers of the UART modules. The priority is UARTDRV_IPL (the IPL values below must match it).
+**
+*/
+void __ISR(_UART_1_VECTOR, IPL5AUTO) Uart1Handler(void)
+{
+    PROF_ISR_ENTER(PROF_ID_UART1);
+    TRACE_BEGIN(TRACE_SRC_UART1, 0);
+    UARTDRV_Handler(UARTDRV_1);
+    TRACE_END(TRACE_SRC_UART1, 0);
+    PROF_ISR_EXIT(PROF_ID_UART1);
+}
+
+void __ISR(_UART_4_VECTOR, IPL5AUTO) Uart4Handler(void)
+{
+    PROF_ISR_ENTER(PROF_ID_UART4);
+    TRACE_BEGIN(TRACE_SRC_UART4, 0);
+    UARTDRV_Handler(UARTDRV_4);
+    TRACE_END(TRACE_SRC_UART4, 0);
+    PROF_ISR_EXIT(PROF_ID_UART4);
+}
+
+void __ISR(_UART_5_VECTOR, IPL5AUTO) Uart5Handler(void)
+{
+    PROF_ISR_ENTER(PROF_ID_UART5);
+    TRACE_BEGIN(TRACE_SRC_UART5, 0);
+    UARTDRV_Handler(UARTDRV_5);
+    TRACE_END(TRACE_SRC_UART5, 0);
+    PROF_ISR_EXIT(PROF_ID_UART5);
+}
+
+/* ------------------------------------------------------------ */
+/***	Dma2ISR, Dma3ISR
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		The interrupt handlers of the DMA channels used by the library. The priority is UARTDRV_IPL
+**      (the IPL values below must match it).
+**
+*/
+void __ISR(_DMA_2_VECTOR, IPL5AUTO) Dma2ISR(void)
+{
+    PROF_ISR_ENTER(PROF_ID_DMA2);
+    UARTDRV_DMAHandler(0);
+    PROF_ISR_EXIT(PROF_ID_DMA2);
+}
+
+void __ISR(_DMA_3_VECTOR, IPL5AUTO) Dma3ISR(void)
+{
+    PROF_ISR_ENTER(PROF_ID_DMA3);
+    UARTDRV_DMAHandler(1);
+    PROF_ISR_EXIT(PROF_ID_DMA3);
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_Open
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance: UARTDRV_1, UARTDRV_4 or UARTDRV_5
+**		unsigned int uiBaud         - the baud rate, for example 115200 corresponds to 115200 baud
+**		unsigned char bFlags        - UARTDRV_F_DMA to use the DMA channels (if they are free),
+**                                    UARTDRV_F_IRDA to enable the IrDA encoder and decoder,
+**                                    UARTDRV_F_AUTOBAUD to measure the baud rate on the first received byte
+**
+**	Return Value:
+**		unsigned char   - UARTDRV_OK
+**                        UARTDRV_ERR_PARAM if the instance is not valid, or the baud rate error is above UARTDRV_MAX_ERR_PERMILLE
+**                        UARTDRV_ERR_BUSY if the instance is already open
+**
+**	Description:
+**		This function configures the UART module of the instance: the specified baud, 8 data bits, no parity
+**      and 1 stop bit, and starts receiving. The pins are mapped by the caller.
+**      When UARTDRV_F_DMA is set, the first free DMA channel is used for receive and the next one for transmit.
+**      If no channel is free, the direction uses the UART interrupt instead.
+**      In order to compute the baud rate value, it uses the peripheral bus frequency definition (PB_FRQ, located in config.h),
+**      the achieved baud rate is returned by UARTDRV_GetBaud.
+**
+*/
+unsigned char UARTDRV_Open(unsigned char bInstance, unsigned int uiBaud, unsigned char bFlags)
+{
+    const UARTDRV_REGS *pRegs;
+    UARTDRV_STATE *pDrv;
+    unsigned int uiBrg;
+    unsigned char fBrgh;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !uiBaud)
+    {
+        return UARTDRV_ERR_PARAM;
+    }
+    uiBrg = UARTDRV_ComputeBrg(uiBaud, &fBrgh);
+    if(uiBrg > 0xFFFF)
+    {
+        return UARTDRV_ERR_PARAM;
+    }
+    pRegs = &rgUartDrvRegs[bInstance];
+    pDrv = &rgUartDrvs[bInstance];
+    if(pDrv->fOpen)
+    {
+        return UARTDRV_ERR_BUSY;
+    }
+    pDrv->bRxDma = UARTDRV_NO_DMAS;
+    pDrv->bTxDma = UARTDRV_NO_DMAS;
+    pDrv->idxRxHead = 0;
+    pDrv->cntRxHalves = 0;
+    pDrv->idxRxTail = 0;
+    pDrv->idxTxHead = 0;
+    pDrv->idxTxTail = 0;
+    pDrv->cbTxDma = 0;
+    pDrv->cntLost = 0;
+    pDrv->pfCallback = 0;
+    pDrv->bBridgeDst = UARTDRV_NO_INSTANCES;
+    pDrv->bBridgeSrc = UARTDRV_NO_INSTANCES;
+
+    *pRegs->pIECCLR = pRegs->uiIntMasks;
+    *pRegs->pMODE = ((bFlags & UARTDRV_F_IRDA) ? _U1MODE_IREN_MASK : 0) | (fBrgh ? _U1MODE_BRGH_MASK : 0);
+    *pRegs->pBRG = uiBrg;
+    *pRegs->pSTA = _U1STA_UTXEN_MASK | _U1STA_URXEN_MASK | ((bFlags & UARTDRV_F_IRDA) ? _U1STA_UTXINV_MASK : 0);
+    *pRegs->pIPCCLR = pRegs->uiIpcMask;
+    *pRegs->pIPCSET = UARTDRV_IPL << pRegs->bIpcPos;
+    *pRegs->pIFSCLR = pRegs->uiIntMasks;
+
+    if((bFlags & UARTDRV_F_DMA) && UARTDRV_AllocDMA(bInstance, 1) == HWRES_OK)
+    {
+        UARTDRV_AllocDMA(bInstance, 0);
+    }
+    pDrv->fOpen = 1;
+    *pRegs->pMODE |= _U1MODE_ON_MASK;
+    if(pDrv->bRxDma < UARTDRV_NO_DMAS)
+    {
+        UARTDRV_StartRxDMA(bInstance);
+    }
+    else
+    {
+        *pRegs->pIECSET = pRegs->uiRxMask;
+    }
+    if(bFlags & UARTDRV_F_AUTOBAUD)
+    {
+        UARTDRV_StartAutoBaud(bInstance);
+    }
+    macro_enable_interrupts();  // enable interrupts
+    return UARTDRV_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_SetMessageDetect
+**
+**	Parameters:
+**		unsigned char bInstance         - the instance
+**		int iPattern                    - the byte that ends a message (for example '\n'), -1 for none
+**		unsigned int msIdle             - the idle time that ends a message, in ms, 0 for none
+**		UARTDRV_CALLBACK pfCallback     - the function called for each message, 0 to disable the detection
+**		void *pCtx                      - the first argument of the callback
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function configures the message detection of an open instance. The callback is called with
+**      UARTDRV_EVT_PATTERN when the pattern byte was received (once for each check, even if several pattern bytes
+**      were received), and with UARTDRV_EVT_IDLE when no byte was received for msIdle after the last received byte.
+**      The received bytes are checked every UARTDRV_POLL_MS, so the events are delayed by up to UARTDRV_POLL_MS.
+**      The callback is called from the SOFTTMR library context, it can read the received bytes (UARTDRV_Read),
+**      in this case the main loop must not read them.
+**      The SOFTTMR library must be already initialized.
+**
+*/
+void UARTDRV_SetMessageDetect(unsigned char bInstance, int iPattern, unsigned int msIdle, UARTDRV_CALLBACK pfCallback, void *pCtx)
+{
+    UARTDRV_STATE *pDrv;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen)
+    {
+        return;
+    }
+    pDrv = &rgUartDrvs[bInstance];
+    SOFTTMR_Stop(&pDrv->tmrPoll);
+    pDrv->iPattern = iPattern;
+    pDrv->msIdle = msIdle;
+    pDrv->pfCallback = pfCallback;
+    pDrv->pCtx = pCtx;
+    pDrv->msQuiet = 0;
+    pDrv->fIdlePending = 0;
+    pDrv->idxPoll = UARTDRV_GetRxHead(bInstance);
+    pDrv->idxScan = pDrv->idxPoll;
+    if(pfCallback && (iPattern >= 0 || msIdle))
+    {
+        SOFTTMR_Start(&pDrv->tmrPoll, UARTDRV_POLL_MS, UARTDRV_POLL_MS, UARTDRV_PollExpired, (void *)(unsigned int)bInstance);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_Write
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**		const void *pData           - the bytes to transmit
+**		unsigned int cbLen          - the number of bytes
+**
+**	Return Value:
+**		unsigned int    - the number of bytes copied in the transmit queue (less than cbLen when the queue is full)
+**
+**	Description:
+**		This function copies the bytes in the transmit queue, and starts the transmission if it is not in progress.
+**      It does not wait: the caller retries the bytes that were not queued.
+**      For each instance, the function must be called from a single context (for example the main loop).
+**      Nothing is queued while the instance transmits the bytes of a bridge.
+**
+*/
+unsigned int UARTDRV_Write(unsigned char bInstance, const void *pData, unsigned int cbLen)
+{
+    const unsigned char *pbData = (const unsigned char *)pData;
+    UARTDRV_STATE *pDrv;
+    unsigned int uiStatus, cb, i;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen || rgUartDrvs[bInstance].bBridgeSrc < UARTDRV_NO_INSTANCES)
+    {
+        return 0;
+    }
+    pDrv = &rgUartDrvs[bInstance];
+    cb = UARTDRV_TX_SIZE - (pDrv->idxTxHead - pDrv->idxTxTail);
+    if(cb > cbLen)
+    {
+        cb = cbLen;
+    }
+    for(i = 0; i < cb; i++)
+    {
+        pDrv->rgbTx[(pDrv->idxTxHead + i) & UARTDRV_TX_MASK] = pbData[i];
+    }
+    uiStatus = __builtin_disable_interrupts();
+    pDrv->idxTxHead += cb;
+    UARTDRV_StartTx(bInstance);
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return cb;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_IsTxIdle
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned char   - 1 if the transmit queue is empty and the last byte was shifted out, 0 otherwise
+**
+**	Description:
+**		This function checks if the transmission is complete.
+**
+*/
+unsigned char UARTDRV_IsTxIdle(unsigned char bInstance)
+{
+    UARTDRV_STATE *pDrv;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen)
+    {
+        return 1;
+    }
+    pDrv = &rgUartDrvs[bInstance];
+    return pDrv->idxTxHead == pDrv->idxTxTail && !pDrv->cbTxDma &&
+        (*rgUartDrvRegs[bInstance].pSTA & _U1STA_TRMT_MASK) != 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_GetTxFree
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned int    - the number of bytes that UARTDRV_Write can queue without waiting
+**
+**	Description:
+**		This function returns the free space of the transmit queue, so that a caller can queue a whole
+**      message or nothing. It returns 0 for an instance that is not open, or transmits the bytes of a bridge.
+**
+*/
+unsigned int UARTDRV_GetTxFree(unsigned char bInstance)
+{
+    UARTDRV_STATE *pDrv;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen || rgUartDrvs[bInstance].bBridgeSrc < UARTDRV_NO_INSTANCES)
+    {
+        return 0;
+    }
+    pDrv = &rgUartDrvs[bInstance];
+    return UARTDRV_TX_SIZE - (pDrv->idxTxHead - pDrv->idxTxTail);
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_Flush
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function waits until all the queued bytes are transmitted. It must not be called with interrupts disabled.
+**
+*/
+void UARTDRV_Flush(unsigned char bInstance)
+{
+    while(!UARTDRV_IsTxIdle(bInstance));
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_GetRxCount
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned int    - the number of bytes in the receive queue, 0 while the received bytes are bridged
+**
+**	Description:
+**		This function returns the number of received bytes that can be read. When the receive DMA channel
+**      overwrote bytes that were not read, the oldest half of the queue is dropped and counted as lost.
+**
+*/
+unsigned int UARTDRV_GetRxCount(unsigned char bInstance)
+{
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen || rgUartDrvs[bInstance].bBridgeDst < UARTDRV_NO_INSTANCES)
+    {
+        return 0;
+    }
+    return UARTDRV_GetRxFill(bInstance);
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_Read
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**		void *pData                 - the buffer where the received bytes are copied, 0 to discard them
+**		unsigned int cbMax          - the maximum number of bytes
+**
+**	Return Value:
+**		unsigned int    - the number of bytes removed from the receive queue
+**
+**	Description:
+**		This function removes the oldest received bytes from the receive queue. It does not wait.
+**      For each instance, the function must be called from a single context.
+**
+*/
+unsigned int UARTDRV_Read(unsigned char bInstance, void *pData, unsigned int cbMax)
+{
+    unsigned char *pbData = (unsigned char *)pData;
+    UARTDRV_STATE *pDrv;
+    unsigned int cb, i;
+    cb = UARTDRV_GetRxCount(bInstance);
+    if(!cb)
+    {
+        return 0;
+    }
+    pDrv = &rgUartDrvs[bInstance];
+    if(cb > cbMax)
+    {
+        cb = cbMax;
+    }
+    if(pbData)
+    {
+        for(i = 0; i < cb; i++)
+        {
+            pbData[i] = pDrv->rgbRx[(pDrv->idxRxTail + i) & UARTDRV_RX_MASK];
+        }
+    }
+    __sync_synchronize();
+    pDrv->idxRxTail += cb;
+    return cb;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_Peek
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**		unsigned int idx            - the position of the byte in the receive queue (0 for the oldest),
+**                                    less than UARTDRV_GetRxCount
+**
+**	Return Value:
+**		unsigned char   - the received byte
+**
+**	Description:
+**		This function returns a received byte without removing it from the receive queue.
+**
+*/
+unsigned char UARTDRV_Peek(unsigned char bInstance, unsigned int idx)
+{
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    return pDrv->rgbRx[(pDrv->idxRxTail + idx) & UARTDRV_RX_MASK];
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_FindByte
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**		unsigned char bVal          - the byte to search for
+**
+**	Return Value:
+**		int     - the position of the first occurrence in the receive queue (0 for the oldest byte), -1 if not found
+**
+**	Description:
+**		This function searches a byte (for example a message terminator) in the receive queue.
+**
+*/
+int UARTDRV_FindByte(unsigned char bInstance, unsigned char bVal)
+{
+    unsigned int cnt = UARTDRV_GetRxCount(bInstance);
+    unsigned int i;
+    for(i = 0; i < cnt; i++)
+    {
+        if(UARTDRV_Peek(bInstance, i) == bVal)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_ReadLine
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**		char *pchBuff               - the buffer where the zero terminated line is copied
+**		unsigned int cchBuff        - the size of the buffer
+**		unsigned int cchMax         - the maximum line length, including the terminator (at most UARTDRV_RX_SIZE)
+**
+**	Return Value:
+**		int     - the number of characters copied in pchBuff (without the terminator), 0 for an empty line
+**                -1 if no complete line was received
+**                -2 if the buffer is too small (the line is dropped)
+**
+**	Description:
+**		This function removes a line terminated by LF or CR+LF from the receive queue. The terminator is stripped
+**      and a NULL character ('\0') is appended. When cchMax bytes are received without LF, they are returned as a line.
+**
+*/
+int UARTDRV_ReadLine(unsigned char bInstance, char *pchBuff, unsigned int cchBuff, unsigned int cchMax)
+{
+    int idx = UARTDRV_FindByte(bInstance, '\n');
+    unsigned int cch, cchStrip;
+    if(idx < 0)
+    {
+        cch = UARTDRV_GetRxCount(bInstance);
+        if(!cch || cch < cchMax)
+        {
+            return -1;
+        }
+        cch = cchMax;
+        cchStrip = 0;
+    }
+    else
+    {
+        cch = idx + 1;
+        cchStrip = (idx > 0 && UARTDRV_Peek(bInstance, idx - 1) == '\r') ? 2 : 1;
+    }
+    if(cch - cchStrip + 1 > cchBuff)
+    {
+        UARTDRV_Read(bInstance, 0, cch);
+        return -2;
+    }
+    UARTDRV_Read(bInstance, pchBuff, cch - cchStrip);
+    UARTDRV_Read(bInstance, 0, cchStrip);
+    pchBuff[cch - cchStrip] = '\0';
+    return cch - cchStrip;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_GetLostBytes
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned int    - the number of received bytes dropped because the receive queue or FIFO was full
+**
+**	Description:
+**		This function returns the number of received bytes that were lost since the instance was opened.
+**      A receive FIFO overrun is counted as one lost byte.
+**
+*/
+unsigned int UARTDRV_GetLostBytes(unsigned char bInstance)
+{
+    if(bInstance >= UARTDRV_NO_INSTANCES)
+    {
+        return 0;
+    }
+    return rgUartDrvs[bInstance].cntLost;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_HasDMA
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned char   - bit 0: the receive direction uses a DMA channel, bit 1: the transmit direction uses a DMA channel
+**
+**	Description:
+**		This function returns the DMA channels allocated by an open instance. While a bridge is started, the
+**      transmit channels are used to receive (UARTDRV_StartBridge), and they are restored by UARTDRV_StopBridge.
+**
+*/
+unsigned char UARTDRV_HasDMA(unsigned char bInstance)
+{
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen)
+    {
+        return 0;
+    }
+    return (rgUartDrvs[bInstance].bRxDma < UARTDRV_NO_DMAS) | ((rgUartDrvs[bInstance].bTxDma < UARTDRV_NO_DMAS) << 1);
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_GetBaud
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned int    - the achieved baud rate, 0 if the instance is not open
+**
+**	Description:
+**		This function returns the baud rate generated with the current UxBRG and BRGH values: the rate requested
+**      in UARTDRV_Open (with the rounding error), or the rate measured by the auto-baud.
+**
+*/
+unsigned int UARTDRV_GetBaud(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen)
+    {
+        return 0;
+    }
+    pRegs = &rgUartDrvRegs[bInstance];
+    return PB_FRQ / (((*pRegs->pMODE & _U1MODE_BRGH_MASK) ? 4 : 16) * (*pRegs->pBRG + 1));
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_StartAutoBaud
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned char   - UARTDRV_OK
+**                        UARTDRV_ERR_PARAM if the instance is not valid or not open
+**
+**	Description:
+**		This function starts the baud rate measurement of the UART module (ABAUD): the next received byte must be
+**      the sync character 0x55 ('U'), its bit time is measured by the hardware and loaded in UxBRG, and the sync
+**      character is not stored in the receive queue. The measurement uses BRGH = 0.
+**      UARTDRV_IsAutoBaudDone returns 1 when the measurement is complete, then UARTDRV_GetBaud returns the measured rate.
+**
+*/
+unsigned char UARTDRV_StartAutoBaud(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen)
+    {
+        return UARTDRV_ERR_PARAM;
+    }
+    pRegs = &rgUartDrvRegs[bInstance];
+    *pRegs->pMODE &= ~_U1MODE_BRGH_MASK;
+    *pRegs->pMODE |= _U1MODE_ABAUD_MASK;
+    return UARTDRV_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_IsAutoBaudDone
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned char   - 1 if no baud rate measurement is in progress, 0 while waiting for the sync character
+**
+**	Description:
+**		This function checks the ABAUD bit, cleared by the hardware when the baud rate measurement is complete.
+**
+*/
+unsigned char UARTDRV_IsAutoBaudDone(unsigned char bInstance)
+{
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen)
+    {
+        return 1;
+    }
+    return (*rgUartDrvRegs[bInstance].pMODE & _U1MODE_ABAUD_MASK) == 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_Close
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function turns off the UART module of the instance, stops the message detection and the bridge,
+**      and releases the DMA channels. The bytes not yet transmitted are dropped.
+**
+*/
+void UARTDRV_Close(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs;
+    UARTDRV_STATE *pDrv;
+    unsigned char i;
+    if(bInstance >= UARTDRV_NO_INSTANCES || !rgUartDrvs[bInstance].fOpen)
+    {
+        return;
+    }
+    pRegs = &rgUartDrvRegs[bInstance];
+    pDrv = &rgUartDrvs[bInstance];
+    if(pDrv->bBridgeDst < UARTDRV_NO_INSTANCES)
+    {
+        UARTDRV_StopBridge();
+    }
+    SOFTTMR_Stop(&pDrv->tmrPoll);
+    *pRegs->pIECCLR = pRegs->uiIntMasks;
+    for(i = 0; i < UARTDRV_NO_DMAS; i++)
+    {
+        if(rgUartDrvDmaUse[i] == bInstance)
+        {
+            UARTDRV_ReleaseDMA(i);
+        }
+    }
+    pDrv->bRxDma = UARTDRV_NO_DMAS;
+    pDrv->bTxDma = UARTDRV_NO_DMAS;
+    *pRegs->pMODE = 0;
+    *pRegs->pIFSCLR = pRegs->uiIntMasks;
+    pDrv->pfCallback = 0;
+    pDrv->fOpen = 0;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_ComputeBrg
+**
+**	Parameters:
+**		unsigned int uiBaud         - the requested baud rate
+**		unsigned char *pfBrgh       - returns the BRGH value: 0 (the bit time is 16 BRG clocks) or 1 (4 BRG clocks)
+**
+**	Return Value:
+**		unsigned int    - the UxBRG value, 0x10000 if the baud rate error is above UARTDRV_MAX_ERR_PERMILLE
+**
+**	Description:
+**		This function computes the baud rate generator settings with integer math: for each divider,
+**      UxBRG = round(PB_FRQ / (divider * baud)) - 1, and the divider with the smallest error is selected
+**      (BRGH = 0 when the errors are equal, for the better noise immunity of the 16x sampling).
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned int UARTDRV_ComputeBrg(unsigned int uiBaud, unsigned char *pfBrgh)
+{
+    unsigned int rguiBrg[2], rguiErr[2], uiDiv, uiBaudReal;
+    int i;
+    *pfBrgh = 0;
+    if(uiBaud > PB_FRQ / 4)
+    {
+        return 0x10000;
+    }
+    for(i = 0; i < 2; i++)
+    {
+        uiDiv = i ? 4 : 16;
+        rguiBrg[i] = (PB_FRQ + uiDiv * uiBaud / 2) / (uiDiv * uiBaud);
+        if(rguiBrg[i])
+        {
+            rguiBrg[i]--;
+        }
+        if(rguiBrg[i] > 0xFFFF)
+        {
+            rguiBrg[i] = 0xFFFF;
+        }
+        uiBaudReal = PB_FRQ / (uiDiv * (rguiBrg[i] + 1));
+        rguiErr[i] = uiBaudReal > uiBaud ? uiBaudReal - uiBaud : uiBaud - uiBaudReal;
+    }
+    *pfBrgh = rguiErr[1] < rguiErr[0];
+    if(rguiErr[*pfBrgh] > uiBaud * UARTDRV_MAX_ERR_PERMILLE / 1000)
+    {
+        return 0x10000;
+    }
+    return rguiBrg[*pfBrgh];
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_Handler
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function serves the UART interrupt of an instance: without receive DMA channel, the receive FIFO
+**      is copied into the receive queue; without transmit DMA channel, the transmit FIFO is filled from
+**      the transmit queue (or, in bridge mode, from the receive queue of the other instance),
+**      and the transmit interrupt is disabled when the queue is empty.
+**      This is a low-level function called from the UART interrupts, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_Handler(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs = &rgUartDrvRegs[bInstance];
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    unsigned char bVal;
+    if(pDrv->bRxDma >= UARTDRV_NO_DMAS)
+    {
+        while(*pRegs->pSTA & _U1STA_URXDA_MASK)
+        {
+            bVal = (unsigned char)*pRegs->pRXREG;
+            if(pDrv->idxRxHead - pDrv->idxRxTail < UARTDRV_RX_SIZE)
+            {
+                pDrv->rgbRx[pDrv->idxRxHead & UARTDRV_RX_MASK] = bVal;
+                __sync_synchronize();
+                pDrv->idxRxHead++;
+            }
+            else
+            {
+                pDrv->cntLost++;
+            }
+        }
+        if(*pRegs->pSTA & _U1STA_OERR_MASK)
+        {
+            *pRegs->pSTACLR = _U1STA_OERR_MASK;
+            pDrv->cntLost++;
+        }
+        *pRegs->pIFSCLR = pRegs->uiRxMask;
+        if(pDrv->bBridgeDst < UARTDRV_NO_INSTANCES)
+        {
+            UARTDRV_BridgeKick(bInstance);
+        }
+    }
+    if((*pRegs->pIEC & pRegs->uiTxMask) && pDrv->bBridgeSrc < UARTDRV_NO_INSTANCES)
+    {
+        UARTDRV_BridgeTx(bInstance);
+    }
+    else if(*pRegs->pIEC & pRegs->uiTxMask)
+    {
+        while(!(*pRegs->pSTA & _U1STA_UTXBF_MASK) && pDrv->idxTxTail != pDrv->idxTxHead)
+        {
+            *pRegs->pTXREG = pDrv->rgbTx[pDrv->idxTxTail++ & UARTDRV_TX_MASK];
+        }
+        *pRegs->pIFSCLR = pRegs->uiTxMask;
+        if(pDrv->idxTxTail == pDrv->idxTxHead)
+        {
+            *pRegs->pIECCLR = pRegs->uiTxMask;
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_DMAHandler
+**
+**	Parameters:
+**		unsigned char bChannel      - the DMA channel, relative to UARTDRV_DMA_FIRST
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function serves the interrupt of a DMA channel: for a receive channel, the half full and full
+**      events of the circular buffer are counted (and, in bridge mode, the transmission of the other instance is
+**      started); for a transmit channel, the transferred bytes are removed
+**      from the transmit queue and the next transfer is started.
+**      This is a low-level function called from the DMA interrupts, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_DMAHandler(unsigned char bChannel)
+{
+    const UARTDRV_DMA_REGS *pDma = &rgUartDrvDmaRegs[bChannel];
+    unsigned char bInstance = rgUartDrvDmaUse[bChannel];
+    UARTDRV_STATE *pDrv;
+    unsigned int uiInt = *pDma->pINT & (_DCH2INT_CHDHIF_MASK | _DCH2INT_CHDDIF_MASK | _DCH2INT_CHBCIF_MASK);
+    *pDma->pINTCLR = uiInt;
+    IFS2CLR = pDma->uiIntMask;          // clear interrupt flag
+    if(bInstance >= UARTDRV_NO_INSTANCES)
+    {
+        return;
+    }
+    pDrv = &rgUartDrvs[bInstance];
+    if(pDrv->bRxDma == bChannel)
+    {
+        if(uiInt & _DCH2INT_CHDHIF_MASK)
+        {
+            pDrv->cntRxHalves++;
+        }
+        if(uiInt & _DCH2INT_CHDDIF_MASK)
+        {
+            pDrv->cntRxHalves++;
+        }
+        if(pDrv->bBridgeDst < UARTDRV_NO_INSTANCES)
+        {
+            UARTDRV_BridgeKick(bInstance);
+        }
+    }
+    else if(uiInt & _DCH2INT_CHBCIF_MASK)
+    {
+        pDrv->idxTxTail += pDrv->cbTxDma;
+        pDrv->cbTxDma = 0;
+        UARTDRV_StartTx(bInstance);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_AllocDMA
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**		unsigned char fRx           - 1 for the receive direction, 0 for the transmit direction
+**
+**	Return Value:
+**		unsigned char   - HWRES_OK
+**                        HWRES_ERR_CONFLICT if no DMA channel is free
+**
+**	Description:
+**		This function allocates the first free DMA channel of the library to a direction of an instance,
+**      enables the DMA controller and configures the priority of the channel interrupt.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned char UARTDRV_AllocDMA(unsigned char bInstance, unsigned char fRx)
+{
+    const UARTDRV_DMA_REGS *pDma;
+    unsigned char i;
+    for(i = 0; i < UARTDRV_NO_DMAS; i++)
+    {
+        if(rgUartDrvDmaUse[i] == UARTDRV_NO_INSTANCES &&
+            HWRES_AllocDMA(UARTDRV_DMA_FIRST + i, HWRES_OWNER_UARTDRV) == HWRES_OK)
+        {
+            pDma = &rgUartDrvDmaRegs[i];
+            rgUartDrvDmaUse[i] = bInstance;
+            if(fRx)
+            {
+                rgUartDrvs[bInstance].bRxDma = i;
+            }
+            else
+            {
+                rgUartDrvs[bInstance].bTxDma = i;
+            }
+            DMACONbits.ON = 1;
+            IEC2CLR = pDma->uiIntMask;
+            IPC10CLR = pDma->uiIpcMask;
+            IPC10SET = UARTDRV_IPL << pDma->bIpcPos;
+            return HWRES_OK;
+        }
+    }
+    return HWRES_ERR_CONFLICT;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_ReleaseDMA
+**
+**	Parameters:
+**		unsigned char bChannel      - the DMA channel, relative to UARTDRV_DMA_FIRST
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function stops and releases a DMA channel. The caller clears the channel in the instance state.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_ReleaseDMA(unsigned char bChannel)
+{
+    const UARTDRV_DMA_REGS *pDma = &rgUartDrvDmaRegs[bChannel];
+    IEC2CLR = pDma->uiIntMask;
+    *pDma->pCON = 0;
+    *pDma->pINT = 0;
+    IFS2CLR = pDma->uiIntMask;
+    HWRES_ReleaseDMA(UARTDRV_DMA_FIRST + bChannel, HWRES_OWNER_UARTDRV);
+    rgUartDrvDmaUse[bChannel] = UARTDRV_NO_INSTANCES;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_StartRxDMA
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function starts the receive DMA channel of an instance: one byte is moved from UxRXREG into the
+**      receive queue for each receive event, the channel is enabled again when the queue is full (auto enable),
+**      so the queue is used as a circular buffer. The half full and full interrupts count the received bytes.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_StartRxDMA(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs = &rgUartDrvRegs[bInstance];
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    const UARTDRV_DMA_REGS *pDma = &rgUartDrvDmaRegs[pDrv->bRxDma];
+    *pDma->pCON = 0;
+    *pDma->pECON = (pRegs->bRxIrq << _DCH2ECON_CHSIRQ_POSITION) | _DCH2ECON_SIRQEN_MASK;
+    *pDma->pSSA = KVA_TO_PA(pRegs->pRXREG);
+    *pDma->pDSA = KVA_TO_PA(pDrv->rgbRx);
+    *pDma->pSSIZ = 1;
+    *pDma->pDSIZ = UARTDRV_RX_SIZE;
+    *pDma->pCSIZ = 1;
+    *pDma->pINT = _DCH2INT_CHDHIE_MASK | _DCH2INT_CHDDIE_MASK;
+    IFS2CLR = pDma->uiIntMask;
+    IEC2SET = pDma->uiIntMask;
+    *pDma->pCON = _DCH2CON_CHAEN_MASK | _DCH2CON_CHEN_MASK;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_StartTx
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function starts the transmission of the queued bytes, if it is not already in progress:
+**      with transmit DMA channel, the bytes up to the end of the queue buffer are moved into UxTXREG, one byte for
+**      each transmit event; without transmit DMA channel, the transmit interrupt is enabled.
+**      It is called with interrupts disabled, or from the interrupts of the instance.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_StartTx(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs = &rgUartDrvRegs[bInstance];
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    const UARTDRV_DMA_REGS *pDma;
+    unsigned int idx, cb;
+    if(pDrv->cbTxDma || pDrv->idxTxTail == pDrv->idxTxHead)
+    {
+        return;
+    }
+    if(pDrv->bTxDma >= UARTDRV_NO_DMAS)
+    {
+        *pRegs->pIECSET = pRegs->uiTxMask;
+        return;
+    }
+    pDma = &rgUartDrvDmaRegs[pDrv->bTxDma];
+    idx = pDrv->idxTxTail & UARTDRV_TX_MASK;
+    cb = pDrv->idxTxHead - pDrv->idxTxTail;
+    if(cb > UARTDRV_TX_SIZE - idx)
+    {
+        cb = UARTDRV_TX_SIZE - idx;
+    }
+    pDrv->cbTxDma = cb;
+    *pDma->pCON = 0;
+    *pDma->pECON = (pRegs->bTxIrq << _DCH2ECON_CHSIRQ_POSITION) | _DCH2ECON_SIRQEN_MASK;
+    *pDma->pSSA = KVA_TO_PA(&pDrv->rgbTx[idx]);
+    *pDma->pDSA = KVA_TO_PA(pRegs->pTXREG);
+    *pDma->pSSIZ = cb;
+    *pDma->pDSIZ = 1;
+    *pDma->pCSIZ = 1;
+    *pDma->pINT = _DCH2INT_CHBCIE_MASK;
+    IFS2CLR = pDma->uiIntMask;
+    IEC2SET = pDma->uiIntMask;
+    *pRegs->pIFSCLR = pRegs->uiTxMask;
+    *pDma->pCONSET = _DCH2CON_CHEN_MASK;
+    *pDma->pECONSET = _DCH2ECON_CFORCE_MASK;    // the first byte, the next ones are triggered by the transmit events
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_GetRxHead
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned int    - the free running index of the next received byte
+**
+**	Description:
+**		This function returns the receive queue head. With receive DMA channel, the head is computed from
+**      the number of filled halves and the destination pointer of the channel. If the channel already crossed
+**      the next half, the difference is still below the queue size, so the result is correct.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned int UARTDRV_GetRxHead(unsigned char bInstance)
+{
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    unsigned int uiStatus, cntHalves, idxPtr, idxHead;
+    if(pDrv->bRxDma >= UARTDRV_NO_DMAS)
+    {
+        return pDrv->idxRxHead;
+    }
+    uiStatus = __builtin_disable_interrupts();
+    cntHalves = pDrv->cntRxHalves;
+    idxPtr = *rgUartDrvDmaRegs[pDrv->bRxDma].pDPTR;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    idxHead = cntHalves * (UARTDRV_RX_SIZE / 2);
+    return idxHead + ((idxPtr - idxHead) & UARTDRV_RX_MASK);
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_GetRxFill
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**		unsigned int    - the number of bytes in the receive queue
+**
+**	Description:
+**		This function returns the number of bytes in the receive queue. When the receive DMA channel
+**      overwrote bytes that were not read, the oldest half of the queue is dropped and counted as lost.
+**      It is called by the consumer of the receive queue: the caller of UARTDRV_Read, or the bridge.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+unsigned int UARTDRV_GetRxFill(unsigned char bInstance)
+{
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    unsigned int idxHead, cnt;
+    UARTDRV_CheckOverrun(bInstance);
+    idxHead = UARTDRV_GetRxHead(bInstance);
+    cnt = idxHead - pDrv->idxRxTail;
+    if(cnt > UARTDRV_RX_SIZE)
+    {
+        pDrv->cntLost += cnt - UARTDRV_RX_SIZE / 2;
+        cnt = UARTDRV_RX_SIZE / 2;
+        pDrv->idxRxTail = idxHead - cnt;
+    }
+    return cnt;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_CheckOverrun
+**
+**	Parameters:
+**		unsigned char bInstance     - the instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		With receive DMA channel, this function clears the receive FIFO overrun error (which stops the receiver),
+**      and counts it as a lost byte. Without receive DMA channel, the UART interrupt does it.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_CheckOverrun(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs = &rgUartDrvRegs[bInstance];
+    if(rgUartDrvs[bInstance].bRxDma < UARTDRV_NO_DMAS && (*pRegs->pSTA & _U1STA_OERR_MASK))
+    {
+        *pRegs->pSTACLR = _U1STA_OERR_MASK;
+        rgUartDrvs[bInstance].cntLost++;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_PollExpired
+**
+**	Parameters:
+**		void *pArg      - the instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the callback of the message detection soft timer: the bytes received since the last call
+**      are checked for the pattern byte, and the idle time is measured when no byte was received.
+**      This is a low-level function called by the SOFTTMR library, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_PollExpired(void *pArg)
+{
+    unsigned char bInstance = (unsigned char)(unsigned int)pArg;
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    unsigned int idxHead;
+    unsigned char fFound = 0;
+    UARTDRV_CheckOverrun(bInstance);
+    idxHead = UARTDRV_GetRxHead(bInstance);
+    if(idxHead != pDrv->idxPoll)
+    {
+        pDrv->idxPoll = idxHead;
+        pDrv->msQuiet = 0;
+        pDrv->fIdlePending = 1;
+        if(pDrv->iPattern >= 0)
+        {
+            if(idxHead - pDrv->idxScan > UARTDRV_RX_SIZE)
+            {
+                pDrv->idxScan = idxHead - UARTDRV_RX_SIZE;
+            }
+            while(pDrv->idxScan != idxHead)
+            {
+                if(pDrv->rgbRx[pDrv->idxScan++ & UARTDRV_RX_MASK] == (unsigned char)pDrv->iPattern)
+                {
+                    fFound = 1;
+                }
+            }
+            if(fFound)
+            {
+                pDrv->pfCallback(pDrv->pCtx, bInstance, UARTDRV_EVT_PATTERN);
+            }
+        }
+    }
+    else if(pDrv->fIdlePending && pDrv->msIdle)
+    {
+        pDrv->msQuiet += UARTDRV_POLL_MS;
+        if(pDrv->msQuiet >= pDrv->msIdle)
+        {
+            pDrv->fIdlePending = 0;
+            pDrv->pfCallback(pDrv->pCtx, bInstance, UARTDRV_EVT_IDLE);
+        }
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_StartBridge
+**
+**	Parameters:
+**		unsigned char bInstanceA    - the first instance, for example UARTDRV_4 (USB - UART)
+**		unsigned char bInstanceB    - the second instance, for example UARTDRV_1 (Pmod JB)
+**		unsigned int cbHighWater    - the high water mark of the receive queues, in bytes (at most UARTDRV_RX_SIZE)
+**		unsigned char bFlags        - UARTDRV_BRIDGE_F_XONXOFF to send XOFF to the peer when its bytes reach
+**                                    the high water mark, and XON when they drop below half of it
+**
+**	Return Value:
+**		unsigned char   - UARTDRV_OK
+**                        UARTDRV_ERR_PARAM if the instances are not valid or not open, or the high water mark is not valid
+**                        UARTDRV_ERR_BUSY if a bridge is already started
+**
+**	Description:
+**		This function connects two open instances: the bytes received by each instance are transmitted by the
+**      other one. The transmit interrupt of an instance reads the bytes directly from the receive queue of the
+**      other instance, when the transmit FIFO is empty (8 bytes for each interrupt).
+**      The transmit DMA channels of the instances are released, and used to receive, so that both receive
+**      queues are filled by DMA (UARTDRV_StopBridge restores the DMA channels). The bytes not read from the receive queues and the bytes not transmitted
+**      are dropped (UARTDRV_Flush can be called before).
+**      While the bridge is started, UARTDRV_Write and UARTDRV_Read do nothing for these instances.
+**      The SOFTTMR library must be already initialized.
+**
+*/
+unsigned char UARTDRV_StartBridge(unsigned char bInstanceA, unsigned char bInstanceB, unsigned int cbHighWater, unsigned char bFlags)
+{
+    unsigned char rgbInst[2] = {bInstanceA, bInstanceB};
+    const UARTDRV_REGS *pRegs;
+    UARTDRV_STATE *pDrv;
+    unsigned int uiStatus;
+    int i;
+    if(bInstanceA >= UARTDRV_NO_INSTANCES || bInstanceB >= UARTDRV_NO_INSTANCES || bInstanceA == bInstanceB ||
+        !rgUartDrvs[bInstanceA].fOpen || !rgUartDrvs[bInstanceB].fOpen || !cbHighWater || cbHighWater > UARTDRV_RX_SIZE)
+    {
+        return UARTDRV_ERR_PARAM;
+    }
+    if(bUartDrvBridgeA < UARTDRV_NO_INSTANCES)
+    {
+        return UARTDRV_ERR_BUSY;
+    }
+    cbUartDrvHighWater = cbHighWater;
+    bUartDrvBridgeFlags = bFlags;
+    uiStatus = __builtin_disable_interrupts();
+    for(i = 0; i < 2; i++)
+    {
+        pRegs = &rgUartDrvRegs[rgbInst[i]];
+        pDrv = &rgUartDrvs[rgbInst[i]];
+        *pRegs->pIECCLR = pRegs->uiTxMask;
+        pDrv->fBridgeTxDma = pDrv->bTxDma < UARTDRV_NO_DMAS;
+        if(pDrv->fBridgeTxDma)
+        {
+            UARTDRV_ReleaseDMA(pDrv->bTxDma);
+            pDrv->bTxDma = UARTDRV_NO_DMAS;
+        }
+        pDrv->idxTxTail = pDrv->idxTxHead;
+        pDrv->cbTxDma = 0;
+        // UTXISEL = 10: the transmit interrupt is generated while the transmit FIFO is empty
+        *pRegs->pSTACLR = _U1STA_UTXISEL_MASK;
+        *pRegs->pSTASET = 2 << _U1STA_UTXISEL_POSITION;
+        pDrv->bBridgeSrc = rgbInst[1 - i];
+        pDrv->bBridgeDst = rgbInst[1 - i];
+        pDrv->bFlowByte = 0;
+        pDrv->fHighWater = 0;
+        pDrv->cntBridged = 0;
+        pDrv->cntHighWater = 0;
+        pDrv->cbMaxFill = 0;
+        pDrv->cntLost = 0;
+    }
+    for(i = 0; i < 2; i++)
+    {
+        pRegs = &rgUartDrvRegs[rgbInst[i]];
+        pDrv = &rgUartDrvs[rgbInst[i]];
+        pDrv->fBridgeRxDma = pDrv->bRxDma >= UARTDRV_NO_DMAS && UARTDRV_AllocDMA(rgbInst[i], 1) == HWRES_OK;
+        if(pDrv->fBridgeRxDma)
+        {
+            *pRegs->pIECCLR = pRegs->uiRxMask;
+            pDrv->cntRxHalves = 0;
+            pDrv->idxRxTail = 0;
+            UARTDRV_StartRxDMA(rgbInst[i]);
+        }
+        else
+        {
+            pDrv->idxRxTail = UARTDRV_GetRxHead(rgbInst[i]);
+        }
+    }
+    bUartDrvBridgeA = bInstanceA;
+    bUartDrvBridgeB = bInstanceB;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    SOFTTMR_Start(&tmrUartDrvBridge, UARTDRV_POLL_MS, UARTDRV_POLL_MS, UARTDRV_BridgeExpired, 0);
+    return UARTDRV_OK;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_StopBridge
+**
+**	Parameters:
+**
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function disconnects the instances of the bridge. The bytes not yet transmitted stay in the receive
+**      queues and can be read. If XOFF was sent to a peer, XON is queued for it.
+**      The DMA channels used before UARTDRV_StartBridge are restored: the receive channels allocated by the bridge
+**      are released (the receive interrupt fills the queue again), then the transmit channels released by the
+**      bridge are allocated again, so UARTDRV_HasDMA returns the same value as before the bridge.
+**
+*/
+void UARTDRV_StopBridge()
+{
+    unsigned char rgbInst[2] = {bUartDrvBridgeA, bUartDrvBridgeB};
+    const UARTDRV_REGS *pRegs;
+    UARTDRV_STATE *pDrv;
+    unsigned char bXon = UARTDRV_XON;
+    unsigned int uiStatus;
+    int i;
+    if(bUartDrvBridgeA >= UARTDRV_NO_INSTANCES)
+    {
+        return;
+    }
+    SOFTTMR_Stop(&tmrUartDrvBridge);
+    uiStatus = __builtin_disable_interrupts();
+    for(i = 0; i < 2; i++)
+    {
+        pRegs = &rgUartDrvRegs[rgbInst[i]];
+        pDrv = &rgUartDrvs[rgbInst[i]];
+        *pRegs->pIECCLR = pRegs->uiTxMask;
+        *pRegs->pSTACLR = _U1STA_UTXISEL_MASK;
+        pDrv->bBridgeSrc = UARTDRV_NO_INSTANCES;
+        pDrv->bBridgeDst = UARTDRV_NO_INSTANCES;
+        pDrv->bFlowByte = 0;
+        if(pDrv->fBridgeRxDma)
+        {
+            // the channel is stopped before the head is read, the receive interrupt continues from the head
+            *rgUartDrvDmaRegs[pDrv->bRxDma].pCON = 0;
+            pDrv->idxRxHead = UARTDRV_GetRxHead(rgbInst[i]);
+            UARTDRV_ReleaseDMA(pDrv->bRxDma);
+            pDrv->bRxDma = UARTDRV_NO_DMAS;
+            pDrv->fBridgeRxDma = 0;
+            *pRegs->pIECSET = pRegs->uiRxMask;
+        }
+    }
+    for(i = 0; i < 2; i++)
+    {
+        pDrv = &rgUartDrvs[rgbInst[i]];
+        if(pDrv->fBridgeTxDma)
+        {
+            UARTDRV_AllocDMA(rgbInst[i], 0);
+            pDrv->fBridgeTxDma = 0;
+        }
+    }
+    bUartDrvBridgeA = UARTDRV_NO_INSTANCES;
+    bUartDrvBridgeB = UARTDRV_NO_INSTANCES;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    for(i = 0; i < 2; i++)
+    {
+        if(rgUartDrvs[rgbInst[i]].fHighWater && (bUartDrvBridgeFlags & UARTDRV_BRIDGE_F_XONXOFF))
+        {
+            UARTDRV_Write(rgbInst[i], &bXon, 1);
+        }
+        rgUartDrvs[rgbInst[i]].fHighWater = 0;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_GetBridgeStats
+**
+**	Parameters:
+**		unsigned char bInstance         - the instance receiving the bytes of the bridge direction
+**		UARTDRV_BRIDGE_STATS *pStats    - the structure where the counters are copied
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function returns the counters of a bridge direction, since the bridge was started.
+**
+*/
+void UARTDRV_GetBridgeStats(unsigned char bInstance, UARTDRV_BRIDGE_STATS *pStats)
+{
+    UARTDRV_STATE *pDrv;
+    if(bInstance >= UARTDRV_NO_INSTANCES)
+    {
+        return;
+    }
+    pDrv = &rgUartDrvs[bInstance];
+    pStats->cntBytes = pDrv->cntBridged;
+    pStats->cntLost = pDrv->cntLost;
+    pStats->cntHighWater = pDrv->cntHighWater;
+    pStats->cbMaxFill = pDrv->cbMaxFill;
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_BridgeTx
+**
+**	Parameters:
+**		unsigned char bInstance     - the transmitting instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function serves the transmit interrupt of a bridged instance: the pending XON / XOFF byte is sent
+**      first, then the transmit FIFO is filled directly from the receive queue of the other instance.
+**      The transmit interrupt is disabled when there is nothing to send.
+**      This is a low-level function called from the UART interrupts, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_BridgeTx(unsigned char bInstance)
+{
+    const UARTDRV_REGS *pRegs = &rgUartDrvRegs[bInstance];
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    unsigned char bSrc = pDrv->bBridgeSrc;
+    UARTDRV_STATE *pSrc = &rgUartDrvs[bSrc];
+    unsigned int cnt;
+    if(pDrv->bFlowByte && !(*pRegs->pSTA & _U1STA_UTXBF_MASK))
+    {
+        *pRegs->pTXREG = pDrv->bFlowByte;
+        pDrv->bFlowByte = 0;
+    }
+    cnt = UARTDRV_GetRxFill(bSrc);
+    UARTDRV_BridgeFlow(bSrc, cnt);
+    while(cnt && !(*pRegs->pSTA & _U1STA_UTXBF_MASK))
+    {
+        *pRegs->pTXREG = pSrc->rgbRx[pSrc->idxRxTail & UARTDRV_RX_MASK];
+        pSrc->idxRxTail++;
+        pSrc->cntBridged++;
+        cnt--;
+    }
+    *pRegs->pIFSCLR = pRegs->uiTxMask;
+    if(!cnt && !pDrv->bFlowByte)
+    {
+        *pRegs->pIECCLR = pRegs->uiTxMask;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_BridgeKick
+**
+**	Parameters:
+**		unsigned char bInstance     - the receiving instance
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function checks the receive queue of a bridged instance, and enables the transmit interrupt
+**      of the other instance when bytes are waiting. It is called when bytes are received: from the receive
+**      interrupt, the half full and full interrupts of the receive DMA channel, and the bridge soft timer.
+**      It is called with interrupts disabled, or from the interrupts of the library.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_BridgeKick(unsigned char bInstance)
+{
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    const UARTDRV_REGS *pDstRegs = &rgUartDrvRegs[pDrv->bBridgeDst];
+    unsigned int cnt = UARTDRV_GetRxHead(bInstance) - pDrv->idxRxTail;
+    UARTDRV_BridgeFlow(bInstance, cnt);
+    if(cnt)
+    {
+        *pDstRegs->pIECSET = pDstRegs->uiTxMask;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_BridgeFlow
+**
+**	Parameters:
+**		unsigned char bInstance     - the receiving instance
+**		unsigned int cbFill         - the number of bytes in its receive queue
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This function updates the counters of a bridge direction, and implements the high water mark:
+**      when the receive queue reaches it, the event is counted (and XOFF is sent to the peer, by the transmit
+**      interrupt of the same instance); when the receive queue drops below half of it, XON is sent.
+**      This is a low-level function, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_BridgeFlow(unsigned char bInstance, unsigned int cbFill)
+{
+    UARTDRV_STATE *pDrv = &rgUartDrvs[bInstance];
+    unsigned char bFlowByte = 0;
+    if(cbFill > pDrv->cbMaxFill)
+    {
+        pDrv->cbMaxFill = cbFill;
+    }
+    if(!pDrv->fHighWater && cbFill >= cbUartDrvHighWater)
+    {
+        pDrv->fHighWater = 1;
+        pDrv->cntHighWater++;
+        bFlowByte = UARTDRV_XOFF;
+    }
+    else if(pDrv->fHighWater && cbFill <= cbUartDrvHighWater / 2)
+    {
+        pDrv->fHighWater = 0;
+        bFlowByte = UARTDRV_XON;
+    }
+    if(bFlowByte && (bUartDrvBridgeFlags & UARTDRV_BRIDGE_F_XONXOFF))
+    {
+        pDrv->bFlowByte = bFlowByte;
+        *rgUartDrvRegs[bInstance].pIECSET = rgUartDrvRegs[bInstance].uiTxMask;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	UARTDRV_BridgeExpired
+**
+**	Parameters:
+**		void *pArg      - not used
+**
+**	Return Value:
+**
+**
+**	Description:
+**		This is the callback of the bridge soft timer: it starts the transmission of the bytes received by DMA
+**      since the last half full event, so short messages are forwarded within UARTDRV_POLL_MS.
+**      This is a low-level function called by the SOFTTMR library, so user should avoid calling it directly.
+**
+*/
+void UARTDRV_BridgeExpired(void *pArg)
+{
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    if(bUartDrvBridgeA < UARTDRV_NO_INSTANCES)
+    {
+        UARTDRV_BridgeKick(bUartDrvBridgeA);
+        UARTDRV_BridgeKick(bUartDrvBridgeB);
+    }
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,115 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    uartdrv.h
+
+  @Description
+        This file groups the declarations of the functions that implement
+        the UARTDRV library (defined in uartdrv.c).
+        Include the file in the project when this library is needed.
+        Use #include "uartdrv.h" in the source files where the functions are needed.
+ */
+/* ************************************************************************** */
+
+#ifndef _UARTDRV_H    /* Guard against multiple inclusion */
+#define _UARTDRV_H
+
+// instances
+#define UARTDRV_1           0   // UART1: Pmod connector JB (UARTJB library)
+#define UARTDRV_4           1   // UART4: the USB - UART interface (UART library)
+#define UARTDRV_5           2   // UART5: the IrDA module (IRDA library)
+#define UARTDRV_NO_INSTANCES    3
+
+// return values
+#define UARTDRV_OK          0
+#define UARTDRV_ERR_BUSY    0xFE    // the instance is already open
+#define UARTDRV_ERR_PARAM   0xFB    // invalid instance or baud rate
+
+// UARTDRV_Open flags
+#define UARTDRV_F_DMA       0x01    // use the DMA channels, if they are available
+#define UARTDRV_F_IRDA      0x02    // IrDA encoder and decoder, idle state of the TX pin is 1
+#define UARTDRV_F_AUTOBAUD  0x04    // measure the baud rate on the first received byte (UARTDRV_StartAutoBaud)
+
+// the maximum baud rate error accepted by UARTDRV_Open, in 1/1000
+#define UARTDRV_MAX_ERR_PERMILLE    25
+
+// the size of the receive and transmit queues of each instance, in bytes (must be a power of 2)
+#define UARTDRV_RX_SIZE     256
+#define UARTDRV_TX_SIZE     256
+
+// the DMA channels shared by the instances opened with UARTDRV_F_DMA (allocated using the HWRES library).
+// The receive direction of an instance takes the first free channel, then the transmit direction the next one.
+#define UARTDRV_DMA_FIRST   2
+#define UARTDRV_NO_DMAS     2
+// the priority of the UART and DMA interrupts (the IPL values in uartdrv.c must match it)
+#define UARTDRV_IPL         5
+
+// the period of the message detection (pattern byte and idle line), in ms
+#define UARTDRV_POLL_MS     1
+
+// UARTDRV_StartBridge flags
+#define UARTDRV_BRIDGE_F_XONXOFF    0x01    // software flow control: XOFF / XON sent to the peer at the high / low water marks
+#define UARTDRV_XON         0x11
+#define UARTDRV_XOFF        0x13
+
+// message events
+#define UARTDRV_EVT_PATTERN 1   // the pattern byte was received
+#define UARTDRV_EVT_IDLE    2   // no byte was received for the idle time, after the last received byte
+
+// the counters of a bridge direction (the bytes received by an instance and transmitted by the other one)
+typedef struct {
+    unsigned int cntBytes;              // the bytes transmitted
+    unsigned int cntLost;               // the received bytes dropped (receive queue or FIFO overrun)
+    unsigned int cntHighWater;          // the times the receive queue reached the high water mark
+    unsigned int cbMaxFill;             // the maximum number of bytes waiting in the receive queue
+} UARTDRV_BRIDGE_STATS;
+
+typedef void (*UARTDRV_CALLBACK)(void *pCtx, unsigned char bInstance, unsigned char bEvent);
+
+unsigned char UARTDRV_Open(unsigned char bInstance, unsigned int uiBaud, unsigned char bFlags);
+void UARTDRV_SetMessageDetect(unsigned char bInstance, int iPattern, unsigned int msIdle, UARTDRV_CALLBACK pfCallback, void *pCtx);
+unsigned int UARTDRV_Write(unsigned char bInstance, const void *pData, unsigned int cbLen);
+unsigned char UARTDRV_IsTxIdle(unsigned char bInstance);
+unsigned int UARTDRV_GetTxFree(unsigned char bInstance);
+void UARTDRV_Flush(unsigned char bInstance);
+unsigned int UARTDRV_GetRxCount(unsigned char bInstance);
+unsigned int UARTDRV_Read(unsigned char bInstance, void *pData, unsigned int cbMax);
+unsigned char UARTDRV_Peek(unsigned char bInstance, unsigned int idx);
+int UARTDRV_FindByte(unsigned char bInstance, unsigned char bVal);
+int UARTDRV_ReadLine(unsigned char bInstance, char *pchBuff, unsigned int cchBuff, unsigned int cchMax);
+unsigned int UARTDRV_GetLostBytes(unsigned char bInstance);
+unsigned char UARTDRV_HasDMA(unsigned char bInstance);
+unsigned int UARTDRV_GetBaud(unsigned char bInstance);
+unsigned char UARTDRV_StartAutoBaud(unsigned char bInstance);
+unsigned char UARTDRV_IsAutoBaudDone(unsigned char bInstance);
+unsigned char UARTDRV_StartBridge(unsigned char bInstanceA, unsigned char bInstanceB, unsigned int cbHighWater, unsigned char bFlags);
+void UARTDRV_StopBridge();
+void UARTDRV_GetBridgeStats(unsigned char bInstance, UARTDRV_BRIDGE_STATS *pStats);
+void UARTDRV_Close(unsigned char bInstance);
+
+//private functions:
+unsigned int UARTDRV_ComputeBrg(unsigned int uiBaud, unsigned char *pfBrgh);
+void UARTDRV_Handler(unsigned char bInstance);
+void UARTDRV_DMAHandler(unsigned char bChannel);
+unsigned char UARTDRV_AllocDMA(unsigned char bInstance, unsigned char fRx);
+void UARTDRV_ReleaseDMA(unsigned char bChannel);
+void UARTDRV_StartRxDMA(unsigned char bInstance);
+void UARTDRV_StartTx(unsigned char bInstance);
+unsigned int UARTDRV_GetRxHead(unsigned char bInstance);
+unsigned int UARTDRV_GetRxFill(unsigned char bInstance);
+void UARTDRV_CheckOverrun(unsigned char bInstance);
+void UARTDRV_PollExpired(void *pArg);
+void UARTDRV_BridgeTx(unsigned char bInstance);
+void UARTDRV_BridgeKick(unsigned char bInstance);
+void UARTDRV_BridgeFlow(unsigned char bInstance, unsigned int cbFill);
+void UARTDRV_BridgeExpired(void *pArg);
+
+#endif /* _UARTDRV_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -19,12 +19,13 @@
 #define _UARTJB_H
 
 #define	cchRxMax	0xFF	// maximum number of characters a CR+LF terminated string
-void UARTJB_InitPoll(unsigned int baud);
-void UARTJB_Init(unsigned int baud);
+unsigned char UARTJB_InitPoll(unsigned int baud);
+unsigned char UARTJB_Init(unsigned int baud);
 
-void UARTJB_CloseUART();
+void UARTJB_Close();
 
 
+void UARTJB_PutChar(char ch);
 void UARTJB_PutString(char szData[]);
 unsigned char UARTJB_GetCharPoll();
 unsigned char UARTJB_AvaliableRx();
@@ -33,8 +34,6 @@ unsigned char UARTJB_GetStringPoll(unsigned char *pText);
 
 // private functions
 void UARTJB_ConfigurePins();
-void UARTJB_ConfigureUart(unsigned int baud);
-void UARTJB_ConfigureUartRXInt(unsigned int baud);
 
 //#ifdef __cplusplus
 //extern "C" {
@@ -8,10 +8,13 @@
     utils.c
 
   @Description
-        This library implements the delay functionality used in other libraries.  
-        The delay is implemented using loop, so the delay time is not exact. 
-        For exact timing use timers.
-        Include the file in the project, together with utils.h, when this library is needed	
+        This library implements the delay and time functionality used in other libraries.  
+        The delays and timestamps are based on the MIPS core timer (CP0 Count register),
+        incremented at SYS_FRQ / 2 (every 25 ns at 80 MHz), so they do not depend on the optimization level,
+        cache or interrupt load (interrupts can only make a delay longer).
+        The 32 bits core timer wraps around every 107 seconds. TimeGetTicks64 extends it to a 64 bits monotonic
+        counter, provided that it is called at least once every 107 seconds.
+        Include the file in the project, together with utils.h and config.h, when this library is needed	
  */
 /* ************************************************************************** */
 
@@ -26,13 +29,13 @@
 /* ************************************************************************** */
 
 /* ------------------------------------------------------------ */
-/***    Delay100Us
+/***    DelayAprox10Us
 **
 **	Synopsis:
-**		Delay100Us(100)
+**		DelayAprox10Us(100)
 **
 **	Parameters:
-**		t100usDelay - the amount of time you wish to delay in hundreds of microseconds
+**		t10usDelay - the amount of time you wish to delay in tens of microseconds
 **
 **	Return Values:
 **      none
@@ -42,30 +45,182 @@
 **
 **	Description:
 **		This procedure delays program execution for the specified number
-**      of microseconds. This delay is not precise.
+**      of tens of microseconds. It is kept for compatibility, new code should use DelayUs or DelayMs.
 **		
-**	Note:
-**		This routine is written with the assumption that the
-**		system clock is 40 MHz.
 */
-void DelayAprox10Us( unsigned int  t100usDelay )
+void DelayAprox10Us( unsigned int  t10usDelay )
 {
-    int j;
-    while ( 0 < t100usDelay )
+    DelayMs(t10usDelay / 100);
+    DelayUs((t10usDelay % 100) * 10);
+}
+
+/* ------------------------------------------------------------ */
+/***    DelayUs
+**
+**	Synopsis:
+**		DelayUs(100)
+**
+**	Parameters:
+**		usDelay - the amount of time you wish to delay in microseconds (maximum 100000000)
+**
+**	Return Values:
+**      none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		This procedure delays program execution for the specified number
+**      of microseconds, by polling the core timer. The delay is exact within a few core timer ticks,
+**      it is longer if interrupts occur at the end of the delay.
+**		
+*/
+void DelayUs(unsigned int usDelay)
+{
+    unsigned int uiStart = _CP0_GET_COUNT();
+    unsigned int cntTicks = usDelay * TIME_TICKS_PER_US;
+    while((_CP0_GET_COUNT() - uiStart) < cntTicks);
+}
+
+/* ------------------------------------------------------------ */
+/***    DelayMs
+**
+**	Synopsis:
+**		DelayMs(40)
+**
+**	Parameters:
+**		msDelay - the amount of time you wish to delay in milliseconds
+**
+**	Return Values:
+**      none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		This procedure delays program execution for the specified number
+**      of milliseconds, by polling the core timer. 
+**      The target is advanced by exactly one millisecond for each millisecond, so the error does not accumulate.
+**		
+*/
+void DelayMs(unsigned int msDelay)
+{
+    unsigned int uiTarget = _CP0_GET_COUNT();
+    while(msDelay--)
+    {
+        uiTarget += 1000 * TIME_TICKS_PER_US;
+        while((int)(_CP0_GET_COUNT() - uiTarget) < 0);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***    TimeGetTicks
+**
+**	Parameters:
+**
+**	Return Values:
+**      unsigned int - the core timer value
+**
+**	Description:
+**		This function returns the core timer value (TIME_TICKS_PER_US ticks per microsecond).
+**      Use it for short intervals: (TimeGetTicks() - uiStart) is correct across the wrap around, 
+**      for intervals shorter than 107 seconds.
+**		
+*/
+unsigned int TimeGetTicks()
+{
+    return _CP0_GET_COUNT();
+}
+
+/* ------------------------------------------------------------ */
+/***    TimeGetTicks64
+**
+**	Parameters:
+**
+**	Return Values:
+**      unsigned long long - the 64 bits monotonic core timer value
+**
+**	Description:
+**		This function returns the core timer value extended to 64 bits: each time a wrap around
+**      is detected since the previous call, the high 32 bits are incremented.
+**      It must be called at least once every 107 seconds. It can be called from interrupts.
+**		
+*/
+unsigned long long TimeGetTicks64()
+{
+    static unsigned int uiHigh = 0, uiLast = 0;
+    unsigned long long ullTicks;
+    unsigned int uiCount;
+    unsigned int uiStatus = __builtin_disable_interrupts();
+    uiCount = _CP0_GET_COUNT();
+    if(uiCount < uiLast)
     {
-        t100usDelay--;
-        j = 14;
-        while ( 0 < j )
-        {
-            j--;
-        }   // end while 
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-         
-    }   // end while
+        uiHigh++;
+    }
+    uiLast = uiCount;
+    ullTicks = ((unsigned long long)uiHigh << 32) | uiCount;
+    if(uiStatus & 1)
+    {
+        __builtin_enable_interrupts();
+    }
+    return ullTicks;
+}
+
+/* ------------------------------------------------------------ */
+/***    TimeGetUs64
+**
+**	Parameters:
+**
+**	Return Values:
+**      unsigned long long - the monotonic time in microseconds
+**
+**	Description:
+**		This function returns the time in microseconds, computed from TimeGetTicks64.
+**		
+*/
+unsigned long long TimeGetUs64()
+{
+    return TimeGetTicks64() / TIME_TICKS_PER_US;
+}
+
+/* ------------------------------------------------------------ */
+/***    TimeDeadlineUs
+**
+**	Parameters:
+**		usTimeout - the timeout in microseconds (maximum 100000000)
+**
+**	Return Values:
+**      unsigned int - the deadline, to be checked with TimeDeadlineExpired
+**
+**	Description:
+**		This function computes the core timer value corresponding to a timeout from now.
+**      Usage:
+**          unsigned int uiDeadline = TimeDeadlineUs(500);
+**          while(!ready && !TimeDeadlineExpired(uiDeadline));
+**		
+*/
+unsigned int TimeDeadlineUs(unsigned int usTimeout)
+{
+    return _CP0_GET_COUNT() + usTimeout * TIME_TICKS_PER_US;
+}
+
+/* ------------------------------------------------------------ */
+/***    TimeDeadlineExpired
+**
+**	Parameters:
+**		uiDeadline - the deadline returned by TimeDeadlineUs
+**
+**	Return Values:
+**      unsigned char - 1 if the deadline is reached, 0 otherwise
+**
+**	Description:
+**		This function checks if a deadline is reached. The check is correct across the core timer wrap around,
+**      for deadlines closer than 53 seconds.
+**		
+*/
+unsigned char TimeDeadlineExpired(unsigned int uiDeadline)
+{
+    return (int)(_CP0_GET_COUNT() - uiDeadline) >= 0;
 }
 
 /* *****************************************************************************
@@ -18,7 +18,17 @@
 #ifndef _UTILS_H    /* Guard against multiple inclusion */
 #define _UTILS_H
 
+// the number of core timer ticks in a microsecond. The core timer is incremented at SYS_FRQ / 2.
+#define TIME_TICKS_PER_US   (SYS_FRQ / 2 / 1000000)
+
 void DelayAprox10Us( unsigned int tusDelay );
+void DelayUs(unsigned int usDelay);
+void DelayMs(unsigned int msDelay);
+unsigned int TimeGetTicks();
+unsigned long long TimeGetTicks64();
+unsigned long long TimeGetUs64();
+unsigned int TimeDeadlineUs(unsigned int usTimeout);
+unsigned char TimeDeadlineExpired(unsigned int uiDeadline);
 
 #endif /* _UTILS_H */
 
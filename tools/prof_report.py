@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Summarize the PROF library statistics (LibPack/LibPack.X/prof.h) printed by PROF_Dump.
+
+The input is the text written by PROF_Dump: a capture file, stdin ("-"), or
+a serial port (--port, requires pyserial, stop with Ctrl+C). The other lines
+are ignored, and when the capture holds several dumps the last one of each
+interrupt handler is used. The report has one row per interrupt handler,
+sorted by the total time spent in it (calls * mean duration):
+
+    vector  calls  total  dur min/mean/max  lat min/mean/max
+
+followed by the log2 duration and latency histograms. The times are core
+timer ticks (SYS_FRQ / 2), or microseconds with --us.
+
+Usage:
+    prof_report.py capture.txt
+    prof_report.py --port /dev/ttyUSB0 --baud 115200 --us
+"""
+
+import argparse
+import re
+import sys
+
+# the core timer frequency (SYS_FRQ / 2)
+DEFAULT_FREQ = 40000000
+
+RE_PROF = re.compile(r'PROF (\S+) calls=(\d+) dur=(\d+)/(\d+)/(\d+)(?: lat=(\d+)/(\d+)/(\d+))?')
+RE_HIST = re.compile(r'([DL])HIST (\S+)((?: \d+)+)')
+
+
+class Vector:
+    def __init__(self, name):
+        self.name = name
+        self.calls = 0
+        self.dur = None         # (min, mean, max)
+        self.lat = None         # (min, mean, max), None without latency records
+        self.dur_hist = []
+        self.lat_hist = []
+
+    def total(self):
+        return self.calls * self.dur[1]
+
+
+def parse(lines):
+    """Return the Vector of each interrupt handler found in the PROF_Dump lines."""
+    vectors = {}
+    for line in lines:
+        m = RE_PROF.search(line)
+        if m:
+            v = vectors[m.group(1)] = Vector(m.group(1))
+            v.calls = int(m.group(2))
+            v.dur = tuple(int(x) for x in m.group(3, 4, 5))
+            if m.group(6):
+                v.lat = tuple(int(x) for x in m.group(6, 7, 8))
+            continue
+        m = RE_HIST.search(line)
+        if m and m.group(2) in vectors:
+            bins = [int(x) for x in m.group(3).split()]
+            if m.group(1) == 'D':
+                vectors[m.group(2)].dur_hist = bins
+            else:
+                vectors[m.group(2)].lat_hist = bins
+    return vectors
+
+
+def bin_label(i, last):
+    """The range of histogram bin i, as PROF_GetHistBin: bin i counts 2^(i-1) .. 2^i - 1 ticks."""
+    if i == 0:
+        return '0'
+    if i == last:
+        return '>=%d' % (1 << (i - 1))
+    if i == 1:
+        return '1'
+    return '%d-%d' % (1 << (i - 1), (1 << i) - 1)
+
+
+def print_hist(title, bins, width=40):
+    # the empty bins above the largest value are not printed
+    used = [i for i, n in enumerate(bins) if n]
+    if not used:
+        return
+    peak = max(bins)
+    print('  %s' % title)
+    for i in range(used[0], used[-1] + 1):
+        print('  %12s %8d %s' % (bin_label(i, len(bins) - 1), bins[i], '#' * ((bins[i] * width + peak - 1) // peak)))
+
+
+def report(vectors, scale, unit):
+    # the ticks are integers, the microseconds are printed with 2 decimals
+    num = '%d' if scale == 1 else '%.2f'
+
+    def fmt3(t):
+        return '/'.join(num % (x * scale) for x in t) if t else '-'
+
+    rows = sorted(vectors.values(), key=Vector.total, reverse=True)
+    print('%-8s %10s %14s %24s %24s' % ('vector', 'calls', 'total ' + unit, 'dur min/mean/max', 'lat min/mean/max'))
+    for v in rows:
+        print('%-8s %10d %14s %24s %24s' % (v.name, v.calls, num % (v.total() * scale), fmt3(v.dur), fmt3(v.lat)))
+    for v in rows:
+        print()
+        print('%s (histogram bins in ticks)' % v.name)
+        print_hist('duration', v.dur_hist)
+        print_hist('latency', v.lat_hist)
+
+
+def read_lines(args):
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            try:
+                while True:
+                    line = port.readline()
+                    if line:
+                        yield line.decode('ascii', 'replace')
+            except KeyboardInterrupt:
+                return
+    else:
+        f = sys.stdin if args.input == '-' else open(args.input, errors='replace')
+        with f:
+            yield from f
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Summarize the PROF_Dump statistics.')
+    parser.add_argument('input', nargs='?', default='-', help='the capture file, - for stdin (default)')
+    parser.add_argument('--port', help='read from a serial port instead (requires pyserial)')
+    parser.add_argument('--baud', type=int, default=115200, help='the serial port baud rate (default 115200)')
+    parser.add_argument('--freq', type=int, default=DEFAULT_FREQ,
+                        help='the core timer frequency in Hz, for --us (default %d)' % DEFAULT_FREQ)
+    parser.add_argument('--us', action='store_true', help='print the times in microseconds instead of ticks')
+    args = parser.parse_args()
+
+    vectors = parse(read_lines(args))
+    if not vectors:
+        print('no PROF lines found', file=sys.stderr)
+        sys.exit(1)
+    if args.us:
+        report(vectors, 1e6 / args.freq, 'us')
+    else:
+        report(vectors, 1, 'ticks')
+
+
+if __name__ == '__main__':
+    main()
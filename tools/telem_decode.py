@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Decode the TELEM library packets (LibPack/LibPack.X/telem.h) into CSV.
+
+The input is the raw byte stream of the UART: a capture file, stdin ("-"),
+or a serial port (--port, requires pyserial). Each row is one sample:
+
+    timestamp_us,channel,value
+
+Lost packets (sequence number gaps), samples dropped by the board and bad
+frames are reported on stderr.
+
+Usage:
+    telem_decode.py capture.bin > samples.csv
+    telem_decode.py --port /dev/ttyUSB0 --baud 115200 > samples.csv
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+PKT_CHANNEL = 0x01
+PKT_SAMPLES = 0x02
+
+DELTA_US = 4
+DELTA_ESC = 0xFF
+
+# TELEM_T_xxx: struct format of the value
+TYPES = {0: '<B', 1: '<b', 2: '<H', 3: '<h', 4: '<I', 5: '<i', 6: '<f'}
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as FRAME_Crc16."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    """Return the decoded bytes of a COBS frame (without the delimiter), None if it is not valid."""
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(chunks, stats):
+    """Yield the payloads of the valid FRAME library frames of a byte stream."""
+    buf = bytearray()
+    for chunk in chunks:
+        buf += chunk
+        while True:
+            end = buf.find(0)
+            if end < 0:
+                break
+            raw = bytes(buf[:end])
+            del buf[:end + 1]
+            if not raw:
+                continue
+            data = cobs_decode(raw)
+            if data is None or len(data) < 2:
+                stats['format'] += 1
+            elif crc16(data[:-2]) != (data[-2] << 8 | data[-1]):
+                stats['crc'] += 1
+            else:
+                yield data[:-2]
+
+
+class Decoder:
+    def __init__(self, writer, log):
+        self.writer = writer
+        self.log = log
+        self.channels = {}
+        self.seq = None
+        self.ts = None          # the last packet timestamp, unwrapped
+        self.stats = {'crc': 0, 'format': 0, 'lost_packets': 0, 'dropped': 0, 'samples': 0}
+
+    def unwrap(self, ts):
+        # the packets of different channels are not sent in timestamp order: take the nearest value
+        if self.ts is None:
+            self.ts = ts
+        else:
+            diff = (ts - self.ts + 0x80000000) % 0x100000000 - 0x80000000
+            self.ts += diff
+        return self.ts
+
+    def packet(self, pkt):
+        if not pkt:
+            self.stats['format'] += 1
+        elif pkt[0] == PKT_CHANNEL and len(pkt) >= 7 and pkt[2] in TYPES:
+            period, = struct.unpack_from('<I', pkt, 3)
+            name = pkt[7:].decode('ascii', 'replace')
+            self.channels[pkt[1]] = (name, TYPES[pkt[2]], period)
+        elif pkt[0] == PKT_SAMPLES and len(pkt) >= 9:
+            self.samples(pkt)
+        else:
+            self.stats['format'] += 1
+
+    def samples(self, pkt):
+        seq, channel, dropped, ts = struct.unpack_from('<BBHI', pkt, 1)
+        if self.seq is not None and seq != (self.seq + 1) & 0xFF:
+            lost = (seq - self.seq - 1) & 0xFF
+            self.stats['lost_packets'] += lost
+            self.log('%d packet(s) lost before sequence number %d' % (lost, seq))
+        self.seq = seq
+        if dropped:
+            self.stats['dropped'] += dropped
+            self.log('%d sample(s) of channel %d dropped by the board' % (dropped, channel))
+        if channel not in self.channels:
+            # the channel description was not received yet (TELEM_SendChannels sends it again)
+            self.log('samples of unknown channel %d skipped' % channel)
+            return
+        name, fmt, period = self.channels[channel]
+        size = struct.calcsize(fmt)
+        ts = self.unwrap(ts)
+        i = 9
+        n = 0
+        while i < len(pkt):
+            if not period:
+                delta = pkt[i]
+                i += 1
+                if delta == DELTA_ESC:
+                    if i + 2 > len(pkt):
+                        break
+                    delta, = struct.unpack_from('<H', pkt, i)
+                    i += 2
+                ts += delta * DELTA_US
+            if i + size > len(pkt):
+                break
+            value, = struct.unpack_from(fmt, pkt, i)
+            i += size
+            self.writer.writerow([ts + n * period if period else ts, name,
+                                  '%.7g' % value if fmt == '<f' else value])
+            n += 1
+        if i != len(pkt):
+            self.stats['format'] += 1
+            self.log('truncated record in a packet of channel %d' % channel)
+        self.stats['samples'] += n
+
+
+def read_chunks(args):
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            try:
+                while True:
+                    yield port.read(4096)
+            except KeyboardInterrupt:
+                return
+    else:
+        f = sys.stdin.buffer if args.input == '-' else open(args.input, 'rb')
+        with f:
+            while True:
+                chunk = f.read(65536)
+                if not chunk:
+                    return
+                yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode TELEM packets into CSV (timestamp_us,channel,value).')
+    parser.add_argument('input', nargs='?', default='-', help='the capture file, - for stdin (default)')
+    parser.add_argument('--port', help='read from a serial port instead (requires pyserial)')
+    parser.add_argument('--baud', type=int, default=115200, help='the serial port baud rate (default 115200)')
+    parser.add_argument('-o', '--output', help='the CSV file (default stdout)')
+    parser.add_argument('-q', '--quiet', action='store_true', help='do not report the lost packets on stderr')
+    args = parser.parse_args()
+
+    out = open(args.output, 'w', newline='') if args.output else sys.stdout
+    writer = csv.writer(out, lineterminator='\n')
+    writer.writerow(['timestamp_us', 'channel', 'value'])
+    log = (lambda msg: None) if args.quiet else (lambda msg: print(msg, file=sys.stderr))
+    dec = Decoder(writer, log)
+    for pkt in frames(read_chunks(args), dec.stats):
+        dec.packet(pkt)
+    if args.output:
+        out.close()
+    s = dec.stats
+    print('%d samples, %d packets lost, %d samples dropped by the board, %d CRC errors, %d format errors'
+          % (s['samples'], s['lost_packets'], s['dropped'], s['crc'], s['format']), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
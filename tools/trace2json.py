@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Convert the TRACE library export (LibPack/LibPack.X/trace.h) into Chrome trace-event JSON.
+
+The input is the byte stream written by TRACE_ExportInfo / TRACE_Export: a
+capture file, stdin ("-"), or a serial port (--port, requires pyserial).
+The output loads in chrome://tracing or https://ui.perfetto.dev:
+    TRACE_TYPE_BEGIN / TRACE_TYPE_END   "B" / "E" duration events
+    TRACE_TYPE_INSTANT                  "i" instant events
+    TRACE_TYPE_VALUE                    "C" counter events
+Each source is shown as its own track, so the nested interrupt handlers do
+not break the begin / end pairs. Lost records (TRACE_FRAME_LOST) are marked
+with global instant events.
+
+Usage:
+    trace2json.py capture.bin -o trace.json
+    trace2json.py --port /dev/ttyUSB0 --baud 115200 -o trace.json
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+SYNC = b'\xa5\x5a'
+
+FRAME_INFO = 0x01
+FRAME_RECORDS = 0x02
+FRAME_LOST = 0x03
+
+TYPE_BEGIN = 0x1
+TYPE_END = 0x2
+TYPE_INSTANT = 0x3
+TYPE_VALUE = 0x4
+
+# the default timestamp frequency (SYS_FRQ / 2), used until a TRACE_FRAME_INFO frame is received
+DEFAULT_FREQ = 40000000
+
+SRC_TASK = 0x100
+SRC_USER = 0x800
+SOURCES = {
+    0x001: 'Timer1ISR (SSD)',
+    0x003: 'Timer3ISR (AUDIO)',
+    0x004: 'Timer4ISR (statemachine)',
+    0x005: 'Timer5ISR (RGBLED)',
+    0x010: 'Uart4Handler (UART)',
+    0x011: 'Uart1Handler (UARTJB)',
+    0x012: 'Uart5Handler (IRDA)',
+    0x020: 'CoreTimerISR (SOFTTMR)',
+    0x030: 'I2C',
+}
+
+
+def source_name(src):
+    if src in SOURCES:
+        return SOURCES[src]
+    if SRC_TASK <= src < SRC_USER:
+        return 'task %d' % (src - SRC_TASK)
+    if src >= SRC_USER:
+        return 'user %d' % (src - SRC_USER)
+    return 'source 0x%03x' % src
+
+
+def frames(chunks, stats):
+    """Yield (type, payload) for the valid export frames of a byte stream."""
+    buf = bytearray()
+    for chunk in chunks:
+        buf += chunk
+        while True:
+            start = buf.find(SYNC)
+            if start < 0:
+                # keep a trailing 0xA5, it may be the first sync byte
+                del buf[:max(len(buf) - 1, 0)]
+                break
+            if start:
+                stats['skipped'] += start
+                del buf[:start]
+            if len(buf) < 4 or len(buf) < buf[3] + 5:
+                break
+            ftype, cb = buf[2], buf[3]
+            payload = bytes(buf[4:4 + cb])
+            chk = ftype ^ cb
+            for b in payload:
+                chk ^= b
+            if chk != buf[4 + cb]:
+                # not a frame: resynchronize after the first sync byte
+                stats['checksum'] += 1
+                del buf[:1]
+                continue
+            del buf[:cb + 5]
+            yield ftype, payload
+
+
+class Converter:
+    def __init__(self, freq):
+        self.freq = freq
+        self.events = []
+        self.ticks = None       # the last timestamp, unwrapped
+        self.t0 = None          # the first timestamp: the trace starts at 0
+        self.open = {}          # source -> the number of unmatched begin events
+        self.tracks = set()
+        self.stats = {'records': 0, 'lost': 0, 'skipped': 0, 'checksum': 0, 'unmatched': 0}
+
+    def unwrap(self, ts):
+        # the core timer wraps every 2^32 ticks, and an interrupt can write its record between the timestamp
+        # and the record of the interrupted code: take the nearest value, so the timestamps may go backwards
+        if self.ticks is None:
+            self.ticks = self.t0 = ts
+        else:
+            self.ticks += (ts - self.ticks + 0x80000000) % 0x100000000 - 0x80000000
+        return self.ticks
+
+    def us(self):
+        return (self.ticks - self.t0) * 1e6 / self.freq
+
+    def track(self, src):
+        if src not in self.tracks:
+            self.tracks.add(src)
+            self.events.append({'ph': 'M', 'name': 'thread_name', 'pid': 1, 'tid': src,
+                                'args': {'name': source_name(src)}})
+
+    def frame(self, ftype, payload):
+        if ftype == FRAME_INFO and len(payload) == 4:
+            self.freq, = struct.unpack('<I', payload)
+        elif ftype == FRAME_RECORDS and len(payload) % 8 == 0:
+            for i in range(0, len(payload), 8):
+                self.record(*struct.unpack_from('<IHH', payload, i))
+        elif ftype == FRAME_LOST and len(payload) == 4:
+            total, = struct.unpack('<I', payload)
+            self.stats['lost'] = total
+            if self.ticks is not None:
+                self.events.append({'ph': 'i', 'name': 'records lost', 's': 'g', 'pid': 1, 'tid': 0,
+                                    'ts': self.us(), 'args': {'total': total}})
+
+    def record(self, ts, event, arg):
+        etype, src = event >> 12, event & 0xFFF
+        self.unwrap(ts)
+        self.stats['records'] += 1
+        self.track(src)
+        ev = {'pid': 1, 'tid': src, 'ts': self.us(), 'name': source_name(src)}
+        if etype == TYPE_BEGIN:
+            self.open[src] = self.open.get(src, 0) + 1
+            ev.update(ph='B', args={'arg': arg})
+        elif etype == TYPE_END:
+            if not self.open.get(src):
+                # the begin event was recorded before the capture started, or lost
+                self.stats['unmatched'] += 1
+                return
+            self.open[src] -= 1
+            ev.update(ph='E', args={'arg': arg})
+        elif etype == TYPE_INSTANT:
+            ev.update(ph='i', s='t', args={'arg': arg})
+        elif etype == TYPE_VALUE:
+            ev.update(ph='C', args={'value': arg})
+        else:
+            return
+        self.events.append(ev)
+
+
+def read_chunks(args):
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            try:
+                while True:
+                    yield port.read(4096)
+            except KeyboardInterrupt:
+                return
+    else:
+        f = sys.stdin.buffer if args.input == '-' else open(args.input, 'rb')
+        with f:
+            while True:
+                chunk = f.read(65536)
+                if not chunk:
+                    return
+                yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert a TRACE export into Chrome trace-event JSON.')
+    parser.add_argument('input', nargs='?', default='-', help='the capture file, - for stdin (default)')
+    parser.add_argument('--port', help='read from a serial port instead (requires pyserial)')
+    parser.add_argument('--baud', type=int, default=115200, help='the serial port baud rate (default 115200)')
+    parser.add_argument('--freq', type=int, default=DEFAULT_FREQ,
+                        help='the timestamp frequency in Hz, when the capture has no TRACE_FRAME_INFO frame')
+    parser.add_argument('-o', '--output', help='the JSON file (default stdout)')
+    args = parser.parse_args()
+
+    conv = Converter(args.freq)
+    for ftype, payload in frames(read_chunks(args), conv.stats):
+        conv.frame(ftype, payload)
+    doc = {'traceEvents': conv.events, 'displayTimeUnit': 'ns'}
+    if args.output:
+        with open(args.output, 'w') as out:
+            json.dump(doc, out)
+    else:
+        json.dump(doc, sys.stdout)
+    s = conv.stats
+    print('%d records, %d lost on the board, %d end events without begin, %d bytes skipped, %d checksum errors'
+          % (s['records'], s['lost'], s['unmatched'], s['skipped'], s['checksum']), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()